@@ -8,7 +8,7 @@ DOCS      = docs/README.md
 SOURCES   = src/maths3d.cpp tests/tests.cpp examples/examples.pro 3rdparty/3rdparty.pro
 INCLUDES  = include
 
-LIBRARIES = m
+LIBRARIES = m pthread
 CFLAGS    = -Wall -ffast-math -O2
 CXXFLAGS  = -std=c++11 -fno-exceptions
 
@@ -22,6 +22,38 @@ check_code_gen: .build/optimization_test.S
 	@echo checking the compiler is optimizing to use inverse sqrt instruction
 	grep rsqrtss .build/optimization_test.S > /dev/null
 
-test: check_code_gen
+# Also build and run the tests with the plain C++ backend so that the fallback is tested as well as SSE
+.build/tests_scalar: src/maths3d.cpp tests/tests.cpp include/maths3d.h include/maths3d_ext.h
+	$(CXX) $(CXX_FLAGS) -DMATHS3D_SCALAR src/maths3d.cpp tests/tests.cpp $(wildcard .modules/TestFramework/*.cpp) -o $@ -lm -lpthread
+
+check_scalar_backend: .build/tests_scalar
+	@echo running the tests with the scalar backend
+	./.build/tests_scalar
+
+# And with the expression template versions of the C++ operators
+.build/tests_expression_templates: src/maths3d.cpp tests/tests.cpp include/maths3d.h include/maths3d_ext.h include/maths3d_pp.h
+	$(CXX) $(CXX_FLAGS) -DMATHS3D_EXPRESSION_TEMPLATES src/maths3d.cpp tests/tests.cpp $(wildcard .modules/TestFramework/*.cpp) -o $@ -lm -lpthread
+
+check_expression_templates: .build/tests_expression_templates
+	@echo running the tests with the expression template operators
+	./.build/tests_expression_templates
+
+# And as C++17, which makes the basic functions constexpr
+.build/tests_cxx17: src/maths3d.cpp tests/tests.cpp include/maths3d.h include/maths3d_ext.h include/maths3d_pp.h
+	$(CXX) $(CXX_FLAGS) -std=c++17 src/maths3d.cpp tests/tests.cpp $(wildcard .modules/TestFramework/*.cpp) -o $@ -lm -lpthread
+
+check_constexpr: .build/tests_cxx17
+	@echo running the tests built as C++17 with the constexpr functions
+	./.build/tests_cxx17
+
+# And tuned for the build machine, which lets the compiler use AVX and AVX-512 encodings in all of the code
+.build/tests_native: src/maths3d.cpp tests/tests.cpp include/maths3d.h include/maths3d_ext.h include/maths3d_pp.h
+	$(CXX) $(CXX_FLAGS) -march=native src/maths3d.cpp tests/tests.cpp $(wildcard .modules/TestFramework/*.cpp) -o $@ -lm -lpthread
+
+check_native: .build/tests_native
+	@echo running the tests built with -march=native
+	./.build/tests_native
+
+test: check_code_gen check_scalar_backend check_expression_templates check_constexpr check_native
 
 
@@ -112,9 +112,17 @@ Vector4f RayDirection(const Ray& ray)
   return ~(ray.lookAt - ray.origin);
 }
 
-Vector4f PointOfClosestIntercept(const Vector4f& origin, const Vector4f& rayDirection, const Vector4f& point)
+/// Returns the normal of the face of the cube which contains the point on its surface, which is the axis along which
+/// the point is furthest from the center.
+Vector4f CubeNormal(const Cube& cube, const Vector4f& point)
 {
-  return origin + (rayDirection * Scalar1f(rayDirection ^ (point - origin)));
+  const Vector4f offset = point - cube.center;
+  const Vector4f size = Vector4f_Absolute(offset);
+  if (size.x > size.y && size.x > size.z)
+    return Vector4f{ offset.x < 0.0f ? -1.0f : 1.0f, 0.0f, 0.0f, 0.0f };
+  if (size.y > size.z)
+    return Vector4f{ 0.0f, offset.y < 0.0f ? -1.0f : 1.0f, 0.0f, 0.0f };
+  return Vector4f{ 0.0f, 0.0f, offset.z < 0.0f ? -1.0f : 1.0f, 0.0f };
 }
 
 template <size_t width, size_t height, int viewDistance>
@@ -123,11 +131,11 @@ uint32_t TraceRay(int i, int j, const Scene& scene)
   const Vector4f eye{ 0.0f, 0.0f, -viewDistance, 0.0f };
   const Vector4f lookAt{ i - 0.5f * width, j - 0.5f * height, 0.0f, 0.0f };
   const Ray ray{ eye, lookAt };
-  const Vector4f rayDirection = RayDirection(ray);
-  float closestDistance = 1e10f;
-  int closestObjectIndex = -1;
-  Vector4f closestIntersection;
+  const Ray4f ray4f = Ray4f_Set(ray.origin, RayDirection(ray));
 
+  // Find the nearest object along the ray. The hit keeps the nearest one so far, and each object only replaces
+  // it if it is nearer.
+  RayHit4f hit = RayHit4f_None();
   for (int i = 0; i < scene.objects.size(); ++i)
   {
     switch (scene.objects[i].type)
@@ -135,69 +143,41 @@ uint32_t TraceRay(int i, int j, const Scene& scene)
       case ObjectType::Sphere:
       {
         const Sphere& sphere = scene.objects[i].sphere;
-        const Vector4f pointOnRayPerpendicularToSphereCenter = PointOfClosestIntercept(ray.origin, rayDirection, sphere.center);
-        const Vector4f vectorFromSphereCenterToRay = pointOnRayPerpendicularToSphereCenter - sphere.center;
-        const Scalar1f distanceFromSphereCenterToRay = vectorFromSphereCenterToRay;
-
-        // See if our point of closest intercept between the ray and the center of the sphere is less than the radius of the sphere.
-        if (distanceFromSphereCenterToRay < sphere.radius)
-        {
-          // Now use Pythagoras' theorem to work out the distance back to the intersection point
-          float distanceBack = sqrt(sphere.radius * sphere.radius - distanceFromSphereCenterToRay * distanceFromSphereCenterToRay);
-
-          // Now we trace back along the ray this distance from the closest intercept point
-          const Vector4f intersectionPoint = pointOnRayPerpendicularToSphereCenter - (rayDirection * distanceBack);
-
-          float distanceToIntersection = intersectionPoint - ray.origin;
-
-          if (distanceToIntersection < closestDistance)
-          {
-            closestIntersection = intersectionPoint;;
-            closestDistance = distanceToIntersection;
-            closestObjectIndex = i;
-          }
-        }
+        Ray4f_IntersectSphere(ray4f, BoundingSphere4f_Set(sphere.center, sphere.radius), i, hit);
         break;
       }
       case ObjectType::Cube:
       {
-        // TODO: add cube support
-        // if (RayIntersectsCube(ray, scene.spheres[i]))
+        const Cube& cube = scene.objects[i].cube;
+        const Vector4f corner{ cube.radius, cube.radius, cube.radius, 0.0f };
+        Ray4f_IntersectAabb(ray4f, Aabb4f_Set(cube.center - corner, cube.center + corner), i, hit);
         break;
       }
     }
   }
 
-  if (closestObjectIndex != -1)
+  if (hit.primitive != RayHit4f_NoPrimitive)
   {
-    switch (scene.objects[closestObjectIndex].type)
+    const Object& object = scene.objects[hit.primitive];
+    // The points of the scene have a w of zero, like the eye
+    const Vector4f intersection = Vector4f_SetW(Ray4f_PointAt(ray4f, hit.t), 0.0f);
+    const Vector4f normal = (object.type == ObjectType::Sphere) ? ~(intersection - object.sphere.center) : CubeNormal(object.cube, intersection);
+    const Vector4f objectColor = (object.type == ObjectType::Sphere) ? object.sphere.color : object.cube.color;
+    Vector4f color = Vector4f_Zero();
+    for (const Light& light : scene.lights)
     {
-      case ObjectType::Sphere:
-      {
-        const Sphere& sphere = scene.objects[closestObjectIndex].sphere;
-        Vector4f normal = ~(closestIntersection - sphere.center);
-        Vector4f color = Vector4f_Zero();
-        for (const Light& light : scene.lights)
-        {
-          Vector4f toLight = ~(closestIntersection - light.position);
-          Scalar1f lightIntensity = toLight ^ normal;
-
-          if (lightIntensity < 0.0)
-            lightIntensity = 0.0;
-          lightIntensity += 0.2;
-          if (lightIntensity > 1.0)
-            lightIntensity = 1.0;
-
-          color = color + (sphere.color * lightIntensity);
-        }
-        return ((uint32_t(color.x*255.0)&0xFF) << 16) | ((uint32_t(color.y*255.0)&0xff) << 8) | (uint32_t(color.z*255.0)&0xff); 
-      }
-      case ObjectType::Cube:
-      {
-        // TODO: trace ray to the light to do basic lighting
-        break;
-      }
+      Vector4f toLight = ~(intersection - light.position);
+      Scalar1f lightIntensity = toLight ^ normal;
+
+      if (lightIntensity < 0.0)
+        lightIntensity = 0.0;
+      lightIntensity += 0.2;
+      if (lightIntensity > 1.0)
+        lightIntensity = 1.0;
+
+      color = color + (objectColor * lightIntensity);
     }
+    return ((uint32_t(color.x*255.0)&0xFF) << 16) | ((uint32_t(color.y*255.0)&0xff) << 8) | (uint32_t(color.z*255.0)&0xff); 
   }
 
   // If don't intersect any objects, then draw a black pixel.
@@ -232,7 +212,8 @@ int main(int argc, const char* argv[])
     {
       Object{ ObjectType::Sphere, .sphere = { { -50, -50,  90 }, { 1.0, 0.0, 0.0 }, 50 } },
       Object{ ObjectType::Sphere, .sphere = { {  60,  20,  50 }, { 0.0, 1.0, 0.0 }, 50 } },
-      Object{ ObjectType::Sphere, .sphere = { {   0,  30, 100 }, { 0.0, 0.0, 1.0 }, 70 } }
+      Object{ ObjectType::Sphere, .sphere = { {   0,  30, 100 }, { 0.0, 0.0, 1.0 }, 70 } },
+      Object{ ObjectType::Cube,   .cube   = { { -90,  60,  40 }, { 1.0, 1.0, 0.0 }, 25 } }
     },
     .lights =
     {
@@ -82,18 +82,14 @@ void Object_LineHelper(const Object<N>& obj, int pnt1, int pnt2, uint32_t color,
 using Cube = Object<8>;
 
 
+// The unit shapes are constant tables, so these are initialized at compile time and not rebuilt on each call
 Cube Cube_Unit()
 {
-  Cube cube;
-  for (int pnt = 0; pnt < 8; ++pnt)
-  {
-    Vector4f point = { 0.0, 0.0, 0.0, 0.0 };
-    point.x += (pnt & 1) ? 0.5 : -0.5;
-    point.y += (pnt & 2) ? 0.5 : -0.5;
-    point.z += (pnt & 4) ? 0.5 : -0.5;
-    point.w  = 1.0;
-    cube.points[pnt] = point;
-  }
+  // Bits 0, 1 and 2 of the point index select the x, y and z side of the cube
+  static const Cube cube = { {
+    { -0.5, -0.5, -0.5, 1.0 }, {  0.5, -0.5, -0.5, 1.0 }, { -0.5,  0.5, -0.5, 1.0 }, {  0.5,  0.5, -0.5, 1.0 },
+    { -0.5, -0.5,  0.5, 1.0 }, {  0.5, -0.5,  0.5, 1.0 }, { -0.5,  0.5,  0.5, 1.0 }, {  0.5,  0.5,  0.5, 1.0 }
+  } };
   return cube;
 }
 
@@ -128,11 +124,12 @@ using Axes = Object<4>;
 
 Axes Axes_Unit()
 {
-  Axes axes;
-  axes.points[0] = { 0.0, 0.0, 0.0, 1.0 };
-  axes.points[1] = { 1.0, 0.0, 0.0, 1.0 };
-  axes.points[2] = { 0.0, 1.0, 0.0, 1.0 };
-  axes.points[3] = { 0.0, 0.0, 1.0, 1.0 };
+  static const Axes axes = { {
+    { 0.0, 0.0, 0.0, 1.0 },
+    { 1.0, 0.0, 0.0, 1.0 },
+    { 0.0, 1.0, 0.0, 1.0 },
+    { 0.0, 0.0, 1.0, 1.0 }
+  } };
   return axes;
 }
 
@@ -166,18 +163,19 @@ using Frustum = Object<9>;
 
 Frustum Frustum_Unit()
 {
-  Frustum frustum;
-  frustum.points[0] = {  0.0,  0.0, -3.0, 1.0 };
-  
-  frustum.points[1] = {  0.5,  0.5, -1.0, 1.0 };
-  frustum.points[2] = { -0.5,  0.5, -1.0, 1.0 };
-  frustum.points[3] = { -0.5, -0.5, -1.0, 1.0 };
-  frustum.points[4] = {  0.5, -0.5, -1.0, 1.0 };
-
-  frustum.points[5] = {  1.0,  1.0,  1.0, 1.0 };
-  frustum.points[6] = { -1.0,  1.0,  1.0, 1.0 };
-  frustum.points[7] = { -1.0, -1.0,  1.0, 1.0 };
-  frustum.points[8] = {  1.0, -1.0,  1.0, 1.0 };
+  static const Frustum frustum = { {
+    {  0.0,  0.0, -3.0, 1.0 },
+
+    {  0.5,  0.5, -1.0, 1.0 },
+    { -0.5,  0.5, -1.0, 1.0 },
+    { -0.5, -0.5, -1.0, 1.0 },
+    {  0.5, -0.5, -1.0, 1.0 },
+
+    {  1.0,  1.0,  1.0, 1.0 },
+    { -1.0,  1.0,  1.0, 1.0 },
+    { -1.0, -1.0,  1.0, 1.0 },
+    {  1.0, -1.0,  1.0, 1.0 }
+  } };
   return frustum;
 }
 
@@ -222,8 +220,8 @@ Camera Camera_Create(Scalar1f scale, const Rotation& rotation, const Vector4f& t
 // Returns the view transformation matrix (world space -> view/camera space)
 Matrix4x4f Camera_ViewMatrix(const Camera& camera)
 {
-  // The rotation matrix is orthonormal so we can use the transpose instead of a full inverse here.
-  Matrix4x4f invRotation = Matrix4x4f_Transposed(Matrix4x4f_RotateXYZ(camera.rotation));
+  // The rotation matrix is orthonormal so we can use the cheap inverse (the transpose) instead of a full inverse here.
+  Matrix4x4f invRotation = Matrix4x4f_OrthonormalInversed(Matrix4x4f_RotateXYZ(camera.rotation));
 
   // We subtract the translation / camera position to move the world relative to the position of the camera.
   return invRotation * Matrix4x4f_TranslateXYZ(camera.translation * -1.0f) * Matrix4x4f_Scale(camera.scale);
@@ -249,13 +247,13 @@ int main(int argc, const char* argv[])
   Matrix4x4f viewMatrix = Camera_ViewMatrix(camera);
 
   // Transforms view to NDC (normalized device coords / clip space).
-  Matrix4x4f perspective = Matrix4x4f_PerspectiveFrustum(fieldOfView, aspectRatio, 0.1, 10000.0);
+  PerspectiveMatrix perspective = PerspectiveMatrix_PerspectiveFrustum(fieldOfView, aspectRatio, 0.1, 10000.0);
 
   // Then we go from clip space to window/screen space
-  Matrix4x4f screenScale = Matrix4x4f_ScaleXYZ({ w, -h, 1.0f, 1.0f });   // For SVG, +y goes down the image, so we flip it.
-  Matrix4x4f screenCenter = Matrix4x4f_TranslateXYZ({ w * 0.5f, h * 0.5f, 0.0f, 0.0f }); // scale and trans converts NDC in to screen space (device coords)
+  DiagonalMatrix screenScale = DiagonalMatrix_ScaleXYZ({ w, -h, 1.0f, 1.0f });   // For SVG, +y goes down the image, so we flip it.
+  TranslationMatrix screenCenter = TranslationMatrix_TranslateXYZ({ w * 0.5f, h * 0.5f, 0.0f, 0.0f }); // scale and trans converts NDC in to screen space (device coords)
 
-  // Combine the transforms.
+  // Combine the transforms. The typed matrices skip the known zeros in all but the last product.
   Matrix4x4f xform = screenCenter * screenScale * perspective * viewMatrix;
 
   std::vector<Shape> shapeList;
@@ -268,17 +266,35 @@ int main(int argc, const char* argv[])
   Vector4f_SSETransformCoordStream(frustum.points, frustum.points, xform);
   Frustum_Lines(frustum, 0xA0A0A0, shapeList);
 
+  // The bounding spheres of the cubes, so that the ones outside the view can be skipped before transforming them
+  const Scalar1f cubeScale = 2.0;
   int gridSize = 1;
+  std::vector<float> centerX, centerY, centerZ, radius;
   for (int j = 0; j < gridSize; ++j)
   {
     for (int i = 0; i < gridSize; ++i)
     {
-      Cube cube = Cube_Transform(Cube_Unit(), { 2.0, 2.0, 2.0, 1.0 }, { 20.0, 40.0, 0.0 }, { i*5.0f, 0.0, j*5.0f, 0.0 });
-      Vector4f_SSETransformCoordStream(cube.points, cube.points, xform);
-      Cube_Lines(cube, 0x000000, shapeList);
+      centerX.push_back(i*5.0f);
+      centerY.push_back(0.0f);
+      centerZ.push_back(j*5.0f);
+      radius.push_back(cubeScale * 0.8660254f);  // Half the diagonal of the cube is sqrt(3) / 2 times the size
     }
   }
 
+  // The planes of the view frustum in world space, before the screen transform is applied
+  Frustum4f viewFrustum = Frustum4f_FromMatrix4x4f(perspective * viewMatrix);
+  std::vector<unsigned> visible(centerX.size());
+  unsigned visibleCount = Frustum4f_CullSpheresStream(visible.data(), nullptr, viewFrustum, centerX.data(), centerY.data(), centerZ.data(),
+                                                      radius.data(), unsigned(centerX.size()));
+
+  for (unsigned n = 0; n < visibleCount; ++n)
+  {
+    unsigned i = visible[n];
+    Cube cube = Cube_Transform(Cube_Unit(), { cubeScale, cubeScale, cubeScale, 1.0 }, { 20.0, 40.0, 0.0 }, { centerX[i], centerY[i], centerZ[i], 0.0 });
+    Vector4f_SSETransformCoordStream(cube.points, cube.points, xform);
+    Cube_Lines(cube, 0x000000, shapeList);
+  }
+
   SVG_Create("example5.svg", w, h, shapeList);
 }
 
@@ -103,11 +103,27 @@
 /// a Vector4f.  This is because when dealing with arrays of these, we will be
 /// able to optimize better the 4 wide version, particularly if it can be
 /// aligned to 128-bits and used with a SIMD optimized function to transform an
-/// array of them. For all the provided functions below, we don't bother
-/// providing SIMD optimizations as most compilers can auto-vectorize this code
-/// just fine and so it only will make the code more error prone, and not able
-/// to be re-compiled with different compiler flags to target different machine
-/// types or with or without different levels of SIMD support (eg MMX, SSE3, SSE4).
+/// array of them.
+///
+/// When the compiler targets SSE, Vector4f also contains a native __m128 and
+/// the basic vector operations below are implemented with SSE intrinsics
+/// instead of relying on the compiler to auto-vectorize the plain C++ code.
+/// Defining MATHS3D_SCALAR before including this file selects the plain C++
+/// implementation instead, which is also what is used on other platforms. The
+/// tests are built and run with both so that the fallback stays tested.
+///
+/// When built as C++17 (and the compiler can tell when it is evaluating at compile time), the basic vector
+/// and matrix constructors, arithmetic, products and the angle and distance conversions are constexpr, so
+/// constant transforms can be computed at compile time. At runtime these still use the SSE versions.
+/// \see MATHS3D_HAS_CONSTEXPR
+///
+/// The exception is Vector3f, which is a packed storage only type. For large
+/// arrays of positions or directions, the w component of a Vector4f is 25%
+/// wasted memory and bandwidth, so these can be stored as arrays of Vector3f and
+/// transformed with the Vector3f stream functions in maths3d_ext.h. Individual
+/// values are converted to a Vector4f to do any maths on them. Similarly Vector4h
+/// stores the four components as 16-bit half precision values, and Vector4s,
+/// Vector4us and Vector2s hold 16-bit quantized positions and octahedral normals.
 ///
 /// For some special cases where performance is important, see the maths3d_ext.h
 /// file which contains SSE optimizations for transforming arrays of vectors. The
@@ -119,9 +135,51 @@
 ///////////////////////////////////////////////////////////////////////////////////
 // Includes
 
+#include <cfloat>
 #include <cmath>
+#include <cstdint>
 #include <type_traits>
 
+// Selects the backend for the vector operations. \see MATHS3D_SCALAR
+#if !defined(MATHS3D_SCALAR) && (defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+#  define MATHS3D_SSE 1
+#  include <xmmintrin.h>
+#else
+#  define MATHS3D_SSE 0
+#endif
+
+// Selects if the basic constructors, conversions and products are constexpr. This needs C++17, and when SSE is used
+// it also needs a way to tell when it is being evaluated at compile time, as the intrinsics are not constexpr.
+// Then MATHS3D_HAS_CONSTEXPR is 1, otherwise these functions are just inline. \see MATHS3D_CONSTEXPR
+#if defined(__cpp_lib_is_constant_evaluated)
+#  define MATHS3D_IS_CONSTANT_EVALUATED() std::is_constant_evaluated()
+#elif defined(__has_builtin)
+#  if __has_builtin(__builtin_is_constant_evaluated)
+#    define MATHS3D_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#  endif
+#elif defined(_MSC_VER) && _MSC_VER >= 1925
+#  define MATHS3D_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+#if (__cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)) && (!MATHS3D_SSE || defined(MATHS3D_IS_CONSTANT_EVALUATED))
+#  define MATHS3D_HAS_CONSTEXPR 1
+#  define MATHS3D_CONSTEXPR constexpr
+#else
+#  define MATHS3D_HAS_CONSTEXPR 0
+#  define MATHS3D_CONSTEXPR inline
+#endif
+#if !defined(MATHS3D_IS_CONSTANT_EVALUATED) || !MATHS3D_HAS_CONSTEXPR
+#  undef MATHS3D_IS_CONSTANT_EVALUATED
+#  define MATHS3D_IS_CONSTANT_EVALUATED() false
+#endif
+
+// Hides the value in an SSE register from the optimizer, so that -ffast-math can't reassociate the calculations on
+// either side of it, or replace them with approximations. \see Precision
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__SSE__) || defined(__x86_64__))
+#  define MATHS3D_OPAQUE(reg)   __asm__("" : "+x"(reg))
+#else
+#  define MATHS3D_OPAQUE(reg)
+#endif
+
 
 ///////////////////////////////////////////////////////////////////////////////////
 // 3D Maths - Scalar
@@ -131,24 +189,87 @@
 using Scalar1f = float;
 
 /// If redefine Scalar1f to something other than float, update this function as applicable.
-inline Scalar1f Scalar1f_Zero()
+MATHS3D_CONSTEXPR Scalar1f Scalar1f_Zero()
 {
   return 0.0f;
 }
 
 /// If redefine Scalar1f to something other than float, update this function as applicable.
-inline Scalar1f Scalar1f_One()
+MATHS3D_CONSTEXPR Scalar1f Scalar1f_One()
 {
   return 1.0f;
 }
 
 /// If redefine Scalar1f to something other than float, update this function as applicable.
-inline Scalar1f Scalar1f_Two()
+MATHS3D_CONSTEXPR Scalar1f Scalar1f_Two()
 {
   return 2.0f;
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////
+// 3D Maths - Precision
+
+/// \brief
+/// The accuracy of the reciprocals and square roots used by the functions which take it as a template argument,
+/// such as normalizing, and dividing by w in projections and the transform streams of maths3d_ext.h. Choosing one of
+/// these is the trade-off between speed and accuracy, which otherwise is decided by whether -ffast-math is used.
+/// \note
+/// The approximations use the SSE estimate instructions. Without SSE they are calculated exactly, which is within
+/// their bounds.
+enum class Precision
+{
+  Exact,      /// Full square roots and divides, within 2 ULP, even when compiled with -ffast-math.
+  Fast,       /// The reciprocal estimate refined with a Newton-Raphson step, a relative error below 2^-21.
+  Fastest,    /// The reciprocal estimate alone, a relative error below 1.5 * 2^-12.
+};
+
+/// Calculates 1/x with the given precision.
+template <Precision precision>
+inline Scalar1f Scalar1f_Reciprocal(Scalar1f x)
+{
+#if MATHS3D_SSE
+  if (precision != Precision::Exact)
+  {
+    const __m128 v = _mm_set_ss(x);
+    const __m128 estimate = _mm_rcp_ss(v);
+    if (precision == Precision::Fastest)
+    {
+      return _mm_cvtss_f32(estimate);
+    }
+    // One Newton-Raphson step, e' = e * (2 - x * e), roughly doubles the number of correct bits
+    return _mm_cvtss_f32(_mm_mul_ss(estimate, _mm_sub_ss(_mm_set_ss(2.0f), _mm_mul_ss(v, estimate))));
+  }
+#endif
+  // -ffast-math only approximates vector divides, so a scalar divide is exact
+  return Scalar1f_One() / x;
+}
+
+/// Calculates 1/sqrt(x) with the given precision.
+template <Precision precision>
+inline Scalar1f Scalar1f_ReciprocalSqrt(Scalar1f x)
+{
+#if MATHS3D_SSE
+  if (precision != Precision::Exact)
+  {
+    const __m128 v = _mm_set_ss(x);
+    const __m128 estimate = _mm_rsqrt_ss(v);
+    if (precision == Precision::Fastest)
+    {
+      return _mm_cvtss_f32(estimate);
+    }
+    // One Newton-Raphson step, e' = e * (1.5 - 0.5 * x * e * e)
+    const __m128 halfX = _mm_mul_ss(v, _mm_set_ss(0.5f));
+    return _mm_cvtss_f32(_mm_mul_ss(estimate, _mm_sub_ss(_mm_set_ss(1.5f), _mm_mul_ss(halfX, _mm_mul_ss(estimate, estimate)))));
+  }
+#endif
+  // Hiding the square root stops -ffast-math turning 1/sqrt in to the estimate and a Newton-Raphson step
+  Scalar1f root = ::sqrt(x);
+  MATHS3D_OPAQUE(root);
+  return Scalar1f_One() / root;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////////
 // 3D Maths - Angles
 
@@ -163,7 +284,7 @@ struct Radians;
 struct Degrees
 {
   Scalar1f value;             /// The value in degrees.
-  operator Radians() const;   /// Function to convert from degrees to radians.
+  MATHS3D_CONSTEXPR operator Radians() const;   /// Function to convert from degrees to radians.
 };
 
 /// \brief
@@ -173,16 +294,16 @@ struct Degrees
 struct Radians
 {
   Scalar1f value;             /// The value in radians.
-  operator Degrees() const;   /// Function to convert from radians to degrees.
+  MATHS3D_CONSTEXPR operator Degrees() const;   /// Function to convert from radians to degrees.
 };
 
-inline Degrees::operator Radians() const
+MATHS3D_CONSTEXPR Degrees::operator Radians() const
 {
   constexpr float deg2rad = 0.01745329251f; // pi / 180
   return Radians{ value * deg2rad };
 }
 
-inline Radians::operator Degrees() const
+MATHS3D_CONSTEXPR Radians::operator Degrees() const
 {
   constexpr float rad2deg = 57.2957795131f; // 180 / pi
   return Degrees{ value * rad2deg };
@@ -197,6 +318,115 @@ struct Rotation
   Degrees z;
 };
 
+/// \brief
+/// The sine and cosine of an angle.
+struct SinCos1f
+{
+  Scalar1f sin;
+  Scalar1f cos;
+};
+
+
+/// Calculates the sine and cosine of angle together, which costs about the same as calculating just one of them.
+/// This uses a polynomial approximation instead of libm, which is the same as the SIMD versions in maths3d_ext.h
+/// use. The error is within 2 ULP (and the absolute error is less than 1e-7) for angles between -8192
+/// and 8192. Larger angles lose precision. \see Radians_SinCos<Precision> for faster approximations.
+SinCos1f Radians_SinCos(Radians angle);
+
+/// Calculates the sine of angle. \see Radians_SinCos for the accuracy.
+inline Scalar1f Radians_Sin(Radians angle)
+{
+  return Radians_SinCos(angle).sin;
+}
+
+/// Calculates the cosine of angle. \see Radians_SinCos for the accuracy.
+inline Scalar1f Radians_Cos(Radians angle)
+{
+  return Radians_SinCos(angle).cos;
+}
+
+/// Calculates the tangent of angle. This is within 4 ULP, except close to the poles where it is infinite.
+inline Scalar1f Radians_Tan(Radians angle)
+{
+  const SinCos1f sinCos = Radians_SinCos(angle);
+  return sinCos.sin / sinCos.cos;
+}
+
+/// \brief
+/// Calculates the sine and cosine of angle with the given precision. The angle is reduced to the range -pi/4 to pi/4
+/// in the same way for all of them, so it is the polynomials which are cheaper:
+/// - Precision::Exact is Radians_SinCos, within 2 ULP.
+/// - Precision::Fast drops a term from each polynomial, an absolute error below 2e-6.
+/// - Precision::Fastest drops another, an absolute error below 4e-4.
+/// \see Precision
+template <Precision precision>
+inline SinCos1f Radians_SinCos(Radians angle)
+{
+  // This is the single precision sin and cos from the Cephes library, with minimax fits of fewer terms for the faster
+  // precisions. The polynomials for sin and cos are swapped and negated based on the octant the angle is in.
+  const Scalar1f x = ::fabs(angle.value);
+  const int octant = (int(x * 1.27323954473516f) + 1) & ~1;  // x * 4/pi rounded up to even
+  // The reduction is done in double precision as -ffast-math is allowed to reassociate the usual float version
+  // which subtracts pi/4 split in to 3 parts, and that loses most of the precision.
+  const Scalar1f r = Scalar1f(double(x) - double(octant) * 0.78539816339744830962);
+  const Scalar1f z = r * r;
+  Scalar1f s, c;
+  if (precision == Precision::Exact)
+  {
+    s = ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f) * z * r + r;
+    c = ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z + 4.166664568298827e-2f) * z * z - 0.5f * z + 1.0f;
+  }
+  else if (precision == Precision::Fast)
+  {
+    s = (8.1533752e-3f * z - 1.6662850e-1f) * z * r + r;
+    c = (-1.3652966e-3f * z + 4.1661302e-2f) * z * z - 0.5f * z + 1.0f;
+  }
+  else
+  {
+    s = -1.6226767e-1f * z * r + r;
+    c = (4.0491350e-2f * z - 4.9977723e-1f) * z + 1.0f;
+  }
+  const bool swap = (octant & 2) != 0;
+  SinCos1f ret = { (swap) ? c : s, (swap) ? s : c };
+  if (((octant & 4) != 0) != (angle.value < Scalar1f_Zero()))
+  {
+    ret.sin = -ret.sin;
+  }
+  if (((octant - 2) & 4) == 0)
+  {
+    ret.cos = -ret.cos;
+  }
+  return ret;
+}
+
+/// Calculates the sine of angle with the given precision. \see Radians_SinCos for the accuracy.
+template <Precision precision>
+inline Scalar1f Radians_Sin(Radians angle)
+{
+  return Radians_SinCos<precision>(angle).sin;
+}
+
+/// Calculates the cosine of angle with the given precision. \see Radians_SinCos for the accuracy.
+template <Precision precision>
+inline Scalar1f Radians_Cos(Radians angle)
+{
+  return Radians_SinCos<precision>(angle).cos;
+}
+
+/// Calculates the tangent of angle with the given precision, dividing by the cosine with Scalar1f_Reciprocal for the
+/// faster precisions. Where the cosine is above 0.01 the relative error is within 4 ULP for Precision::Exact, below
+/// 4e-6 for Precision::Fast and below 1e-3 for Precision::Fastest.
+template <Precision precision>
+inline Scalar1f Radians_Tan(Radians angle)
+{
+  const SinCos1f sinCos = Radians_SinCos<precision>(angle);
+  if (precision == Precision::Exact)
+  {
+    return sinCos.sin / sinCos.cos;
+  }
+  return sinCos.sin * Scalar1f_Reciprocal<precision>(sinCos.cos);
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////////
 // 3D Maths - Distances
@@ -218,7 +448,7 @@ struct Feet;
 struct Metres
 {
   Scalar1f value;            /// The value in meters.
-  operator Feet() const;     /// Function to convert from meters to Feet.
+  MATHS3D_CONSTEXPR operator Feet() const;     /// Function to convert from meters to Feet.
 };
 
 /// \brief
@@ -229,16 +459,16 @@ struct Metres
 struct Feet
 {
   Scalar1f value;            /// The value in feet.
-  operator Metres() const;   /// Function to convert from feet to meters.
+  MATHS3D_CONSTEXPR operator Metres() const;   /// Function to convert from feet to meters.
 };
 
-inline Metres::operator Feet() const
+MATHS3D_CONSTEXPR Metres::operator Feet() const
 {
   constexpr float m2ft= 3.2808398950131;
   return Feet{ value * m2ft };
 }
 
-inline Feet::operator Metres() const
+MATHS3D_CONSTEXPR Feet::operator Metres() const
 {
   constexpr float ft2m = 0.3048;
   return Metres{ value * ft2m };
@@ -248,72 +478,115 @@ inline Feet::operator Metres() const
 ///////////////////////////////////////////////////////////////////////////////////
 // 3D Maths - Vector
 
+template <typename Expression> struct VectorExpression4f;   // \see maths3d_pp.h
+
 /// \brief
 /// A four component vector suitable as a 3D vector in a 3D graphics pipeline.
 struct Vector4f
 {
   union
   {
-    Scalar1f v[4];            /// The 4 components accessible as an array.
+    // The named components are first, as they are the member which is initialized and read by the constexpr functions
     struct
     {
       Scalar1f x, y, z, w;    /// The named components, x, y, z and w accessible by name.
     };
+    Scalar1f v[4];            /// The 4 components accessible as an array.
+#if MATHS3D_SSE
+    __m128 m;                 /// The components as a native SSE register.
+#endif
   };
 
   operator Scalar1f() const;
   Vector4f& operator=(Scalar1f value);
+  // Declared whether or not MATHS3D_EXPRESSION_TEMPLATES is defined, so that Vector4f is the same in every file
+  template <typename Expression>
+  Vector4f& operator=(const VectorExpression4f<Expression>& expression);
 };
 
 // Check that Vector4f is still a POD type even with the operator member function
 static_assert(std::is_pod<Vector4f>(), "Vector4f is non-POD type");
 
+#if MATHS3D_SSE
+/// Internal helper for returning the result of SSE intrinsics from the constexpr functions.
+inline Vector4f Vectori4f_FromSSE(__m128 m)
+{
+  Vector4f ret;
+  ret.m = m;
+  return ret;
+}
+#endif
 
 /// Assigns x, y, z and w to the corresponding components of the vector.
-inline Vector4f Vector4f_Set(Scalar1f x, Scalar1f y, Scalar1f z, Scalar1f w)
+MATHS3D_CONSTEXPR Vector4f Vector4f_Set(Scalar1f x, Scalar1f y, Scalar1f z, Scalar1f w)
 {
+#if MATHS3D_SSE
+  if (!MATHS3D_IS_CONSTANT_EVALUATED())
+    return Vectori4f_FromSSE(_mm_setr_ps(x, y, z, w));
+#endif
   return Vector4f{ { { x, y, z, w } } };
 }
 
 /// Assigns v to all four of the components of the vector.
-inline Vector4f Vector4f_Replicate(Scalar1f v)
+MATHS3D_CONSTEXPR Vector4f Vector4f_Replicate(Scalar1f v)
 {
+#if MATHS3D_SSE
+  if (!MATHS3D_IS_CONSTANT_EVALUATED())
+    return Vectori4f_FromSSE(_mm_set1_ps(v));
+#endif
   return Vector4f_Set(v, v, v, v);
 }
 
 /// Assigns zero to all four of the components of the vector.
-inline Vector4f Vector4f_Zero()
+MATHS3D_CONSTEXPR Vector4f Vector4f_Zero()
 {
   return Vector4f_Replicate(Scalar1f_Zero());
 }
 
 /// Copies vec and sets the x component of the vector to x.
-inline Vector4f Vector4f_SetX(const Vector4f& vec, Scalar1f x)
+MATHS3D_CONSTEXPR Vector4f Vector4f_SetX(const Vector4f& vec, Scalar1f x)
 {
   return Vector4f_Set(x, vec.y, vec.z, vec.w);
 }
 
 /// Copies vec and sets the y component of the vector to y.
-inline Vector4f Vector4f_SetY(const Vector4f& vec, Scalar1f y)
+MATHS3D_CONSTEXPR Vector4f Vector4f_SetY(const Vector4f& vec, Scalar1f y)
 {
   return Vector4f_Set(vec.x, y, vec.z, vec.w);
 }
 
 /// Copies vec and sets the z component of the vector to z.
-inline Vector4f Vector4f_SetZ(const Vector4f& vec, Scalar1f z)
+MATHS3D_CONSTEXPR Vector4f Vector4f_SetZ(const Vector4f& vec, Scalar1f z)
 {
   return Vector4f_Set(vec.x, vec.y, z, vec.w);
 }
 
 /// Copies vec and sets the w component of the vector to w.
-inline Vector4f Vector4f_SetW(const Vector4f& vec, Scalar1f w)
+MATHS3D_CONSTEXPR Vector4f Vector4f_SetW(const Vector4f& vec, Scalar1f w)
 {
   return Vector4f_Set(vec.x, vec.y, vec.z, w);
 }
 
+#if MATHS3D_SSE
+/// Internal helper for the SSE version of Vector4f_CrossProduct.
+inline Vector4f Vectori4f_CrossProduct(const Vector4f& v1, const Vector4f& v2)
+{
+  const __m128 a = _mm_sub_ps(_mm_mul_ps(_mm_shuffle_ps(v1.m, v1.m, _MM_SHUFFLE(3,0,2,1)), _mm_shuffle_ps(v2.m, v2.m, _MM_SHUFFLE(3,1,0,2))),
+                              _mm_mul_ps(_mm_shuffle_ps(v1.m, v1.m, _MM_SHUFFLE(3,1,0,2)), _mm_shuffle_ps(v2.m, v2.m, _MM_SHUFFLE(3,0,2,1))));
+  // Replace w with one
+  Vector4f ret;
+  ret.m = _mm_shuffle_ps(a, _mm_unpackhi_ps(a, _mm_set1_ps(Scalar1f_One())), _MM_SHUFFLE(1,0,1,0));
+  return ret;
+}
+#endif
+
 /// Calculates the cross-product of v1 and v2.
-inline Vector4f Vector4f_CrossProduct(const Vector4f& v1, const Vector4f& v2)
+MATHS3D_CONSTEXPR Vector4f Vector4f_CrossProduct(const Vector4f& v1, const Vector4f& v2)
 {
+#if MATHS3D_SSE
+  if (!MATHS3D_IS_CONSTANT_EVALUATED())
+    return Vectori4f_CrossProduct(v1, v2);
+#endif
   return Vector4f_Set(v1.y * v2.z - v1.z * v2.y,
                       v1.z * v2.x - v1.x * v2.z,
                       v1.x * v2.y - v1.y * v2.x,
@@ -321,43 +594,88 @@ inline Vector4f Vector4f_CrossProduct(const Vector4f& v1, const Vector4f& v2)
 }
 
 /// Multiplies vec1 with vec2.
-inline Vector4f Vector4f_Multiply(const Vector4f& vec1, const Vector4f& vec2)
+MATHS3D_CONSTEXPR Vector4f Vector4f_Multiply(const Vector4f& vec1, const Vector4f& vec2)
 {
+#if MATHS3D_SSE
+  if (!MATHS3D_IS_CONSTANT_EVALUATED())
+    return Vectori4f_FromSSE(_mm_mul_ps(vec1.m, vec2.m));
+#endif
   return Vector4f_Set(vec1.x*vec2.x, vec1.y*vec2.y, vec1.z*vec2.z, vec1.w*vec2.w);
 }
 
 /// Adds vec1 and vec2.
-inline Vector4f Vector4f_Add(const Vector4f& vec1, const Vector4f& vec2)
+MATHS3D_CONSTEXPR Vector4f Vector4f_Add(const Vector4f& vec1, const Vector4f& vec2)
 {
+#if MATHS3D_SSE
+  if (!MATHS3D_IS_CONSTANT_EVALUATED())
+    return Vectori4f_FromSSE(_mm_add_ps(vec1.m, vec2.m));
+#endif
   return Vector4f_Set(vec1.x+vec2.x, vec1.y+vec2.y, vec1.z+vec2.z, vec1.w+vec2.w);
 }
 
 /// Subtracts vec2 from vec1.
-inline Vector4f Vector4f_Subtract(const Vector4f& vec1, const Vector4f& vec2)
+MATHS3D_CONSTEXPR Vector4f Vector4f_Subtract(const Vector4f& vec1, const Vector4f& vec2)
 {
+#if MATHS3D_SSE
+  if (!MATHS3D_IS_CONSTANT_EVALUATED())
+    return Vectori4f_FromSSE(_mm_sub_ps(vec1.m, vec2.m));
+#endif
   return Vector4f_Set(vec1.x-vec2.x, vec1.y-vec2.y, vec1.z-vec2.z, vec1.w-vec2.w);
 }
 
+/// Returns the smaller of each of the components of vec1 and vec2.
+MATHS3D_CONSTEXPR Vector4f Vector4f_Minimum(const Vector4f& vec1, const Vector4f& vec2)
+{
+#if MATHS3D_SSE
+  if (!MATHS3D_IS_CONSTANT_EVALUATED())
+    return Vectori4f_FromSSE(_mm_min_ps(vec1.m, vec2.m));
+#endif
+  return Vector4f_Set((vec1.x < vec2.x) ? vec1.x : vec2.x, (vec1.y < vec2.y) ? vec1.y : vec2.y,
+                      (vec1.z < vec2.z) ? vec1.z : vec2.z, (vec1.w < vec2.w) ? vec1.w : vec2.w);
+}
+
+/// Returns the larger of each of the components of vec1 and vec2.
+MATHS3D_CONSTEXPR Vector4f Vector4f_Maximum(const Vector4f& vec1, const Vector4f& vec2)
+{
+#if MATHS3D_SSE
+  if (!MATHS3D_IS_CONSTANT_EVALUATED())
+    return Vectori4f_FromSSE(_mm_max_ps(vec1.m, vec2.m));
+#endif
+  return Vector4f_Set((vec1.x > vec2.x) ? vec1.x : vec2.x, (vec1.y > vec2.y) ? vec1.y : vec2.y,
+                      (vec1.z > vec2.z) ? vec1.z : vec2.z, (vec1.w > vec2.w) ? vec1.w : vec2.w);
+}
+
+/// Copies vec with each component made positive.
+MATHS3D_CONSTEXPR Vector4f Vector4f_Absolute(const Vector4f& vec)
+{
+#if MATHS3D_SSE
+  if (!MATHS3D_IS_CONSTANT_EVALUATED())
+    return Vectori4f_FromSSE(_mm_andnot_ps(_mm_set1_ps(-0.0f), vec.m));
+#endif
+  return Vector4f_Set((vec.x < 0.0f) ? -vec.x : vec.x, (vec.y < 0.0f) ? -vec.y : vec.y,
+                      (vec.z < 0.0f) ? -vec.z : vec.z, (vec.w < 0.0f) ? -vec.w : vec.w);
+}
+
 /// Copies vec and multiplies each component by scale.
-inline Vector4f Vector4f_Scaled(const Vector4f& vec, Scalar1f scale)
+MATHS3D_CONSTEXPR Vector4f Vector4f_Scaled(const Vector4f& vec, Scalar1f scale)
 {
   return Vector4f_Multiply(vec, Vector4f_Replicate(scale));
 }
 
 /// Returns the sum of the components of vec.
-inline Scalar1f Vector4f_SumComponents(const Vector4f& vec)
+MATHS3D_CONSTEXPR Scalar1f Vector4f_SumComponents(const Vector4f& vec)
 {
   return vec.x + vec.y + vec.z + vec.w;
 }
 
 /// Calculates the dot-product of vec1 and vec2.
-inline Scalar1f Vector4f_DotProduct(const Vector4f& vec1, const Vector4f& vec2)
+MATHS3D_CONSTEXPR Scalar1f Vector4f_DotProduct(const Vector4f& vec1, const Vector4f& vec2)
 {
   return Vector4f_SumComponents(Vector4f_Multiply(vec1, vec2));
 }
 
 /// Calculates the length squared of vec.
-inline Scalar1f Vector4f_LengthSquared(const Vector4f& vec)
+MATHS3D_CONSTEXPR Scalar1f Vector4f_LengthSquared(const Vector4f& vec)
 {
   return Vector4f_DotProduct(vec, vec);
 }
@@ -371,7 +689,12 @@ inline Scalar1f Vector4f_Length(const Vector4f& vec)
 /// Calculates 1/length of vec.
 inline Scalar1f Vector4f_ReciprocalLength(const Vector4f& vec)
 {
+#if MATHS3D_SSE
   return Scalar1f_One() / Vector4f_Length(vec);
+#else
+  // The scalar backend is the reference for the SSE one, so stop -ffast-math approximating it when not inlined
+  return Scalar1f_ReciprocalSqrt<Precision::Exact>(Vector4f_LengthSquared(vec));
+#endif
 }
 
 /// Copies vec and divides each component by the length of vec (returning the normalized or unit vector of vec).
@@ -380,6 +703,207 @@ inline Vector4f Vector4f_Normalized(const Vector4f& vec)
   return Vector4f_Scaled(vec, Vector4f_ReciprocalLength(vec));
 }
 
+/// Calculates the length of vec with the given precision. \see Precision
+template <Precision precision>
+inline Scalar1f Vector4f_Length(const Vector4f& vec)
+{
+  const Scalar1f lengthSquared = Vector4f_LengthSquared(vec);
+  if (precision == Precision::Exact || lengthSquared == Scalar1f_Zero())
+  {
+    return ::sqrt(lengthSquared);
+  }
+  return lengthSquared * Scalar1f_ReciprocalSqrt<precision>(lengthSquared);
+}
+
+/// Calculates 1/length of vec with the given precision. \see Precision
+template <Precision precision>
+inline Scalar1f Vector4f_ReciprocalLength(const Vector4f& vec)
+{
+  return Scalar1f_ReciprocalSqrt<precision>(Vector4f_LengthSquared(vec));
+}
+
+/// Copies vec and divides each component by the length of vec with the given precision. \see Precision
+template <Precision precision>
+inline Vector4f Vector4f_Normalized(const Vector4f& vec)
+{
+  return Vector4f_Scaled(vec, Vector4f_ReciprocalLength<precision>(vec));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// 3D Maths - Packed Vector
+
+/// \brief
+/// A packed three component vector for compactly storing positions or directions in memory.
+/// \note
+/// This is 12 bytes instead of 16 so is only intended for storage. Convert to a Vector4f to do maths with it.
+struct Vector3f
+{
+  union
+  {
+    Scalar1f v[3];            /// The 3 components accessible as an array.
+    struct
+    {
+      Scalar1f x, y, z;       /// The named components, x, y and z accessible by name.
+    };
+  };
+};
+
+// Check that Vector3f is packed so that arrays of it have a 12-byte stride
+static_assert(sizeof(Vector3f) == 3 * sizeof(Scalar1f), "Vector3f is not packed");
+
+
+/// Assigns x, y and z to the corresponding components of the packed vector.
+inline Vector3f Vector3f_Set(Scalar1f x, Scalar1f y, Scalar1f z)
+{
+  return Vector3f{ { { x, y, z } } };
+}
+
+/// Drops the w component of vec to make a packed vector.
+inline Vector3f Vector3f_FromVector4f(const Vector4f& vec)
+{
+  return Vector3f_Set(vec.x, vec.y, vec.z);
+}
+
+/// Expands the packed vector vec to a Vector4f with the given w component.
+inline Vector4f Vector4f_FromVector3f(const Vector3f& vec, Scalar1f w)
+{
+  return Vector4f_Set(vec.x, vec.y, vec.z, w);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// 3D Maths - Half Precision Vector
+
+/// Half1h is a 16-bit IEEE 754 half precision value, stored as its raw bits. It is only used for storage, convert
+/// to a Scalar1f to do any maths with it. It has about 3 significant decimal digits and a range of +/-65504.
+using Half1h = uint16_t;
+
+/// Converts a Scalar1f to the nearest half precision value, rounding ties to even. Values too large for half
+/// precision become infinity.
+Half1h Half1h_FromScalar1f(Scalar1f value);
+
+/// Converts a half precision value to a Scalar1f. This is exact.
+Scalar1f Scalar1f_FromHalf1h(Half1h value);
+
+/// \brief
+/// A four component half precision vector for storing large amounts of vertex data in half the space of a Vector4f.
+/// \note
+/// This is only intended for storage. Convert to a Vector4f to do maths with it.
+struct Vector4h
+{
+  union
+  {
+    Half1h v[4];              /// The 4 components accessible as an array.
+    struct
+    {
+      Half1h x, y, z, w;      /// The named components, x, y, z and w accessible by name.
+    };
+  };
+};
+
+// Check that Vector4h is packed so that arrays of it have an 8-byte stride
+static_assert(sizeof(Vector4h) == 4 * sizeof(Half1h), "Vector4h is not packed");
+
+
+/// Converts each component of vec to half precision.
+inline Vector4h Vector4h_FromVector4f(const Vector4f& vec)
+{
+  return Vector4h{ { { Half1h_FromScalar1f(vec.x), Half1h_FromScalar1f(vec.y),
+                       Half1h_FromScalar1f(vec.z), Half1h_FromScalar1f(vec.w) } } };
+}
+
+/// Converts each component of the half precision vector vec to a Scalar1f.
+inline Vector4f Vector4f_FromVector4h(const Vector4h& vec)
+{
+  return Vector4f_Set(Scalar1f_FromHalf1h(vec.x), Scalar1f_FromHalf1h(vec.y),
+                      Scalar1f_FromHalf1h(vec.z), Scalar1f_FromHalf1h(vec.w));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// 3D Maths - Quantized Vector
+
+/// \brief
+/// A four component vector of signed 16-bit integers for storing quantized positions.
+/// \note
+/// The integers are dequantized by multiplying by a scale and adding a bias. This is done as part of the
+/// Vector4s stream transforms in maths3d_ext.h.
+struct Vector4s
+{
+  union
+  {
+    int16_t v[4];             /// The 4 components accessible as an array.
+    struct
+    {
+      int16_t x, y, z, w;     /// The named components, x, y, z and w accessible by name.
+    };
+  };
+};
+
+/// \brief
+/// A four component vector of unsigned 16-bit integers for storing quantized positions.
+/// \see Vector4s
+struct Vector4us
+{
+  union
+  {
+    uint16_t v[4];            /// The 4 components accessible as an array.
+    struct
+    {
+      uint16_t x, y, z, w;    /// The named components, x, y, z and w accessible by name.
+    };
+  };
+};
+
+/// \brief
+/// A unit vector stored in 4 bytes using an octahedral encoding as two signed normalized 16-bit integers.
+/// \note
+/// The unit sphere is projected on to an octahedron which is then unfolded in to a square. This has a near uniform
+/// distribution of precision over the sphere, with an error of less than 0.0001 radians.
+struct Vector2s
+{
+  union
+  {
+    int16_t v[2];             /// The 2 components accessible as an array.
+    struct
+    {
+      int16_t x, y;           /// The named components, x and y accessible by name.
+    };
+  };
+};
+
+// Check that these are packed so that arrays of them have an 8 or 4 byte stride
+static_assert(sizeof(Vector4s) == 4 * sizeof(int16_t), "Vector4s is not packed");
+static_assert(sizeof(Vector4us) == 4 * sizeof(uint16_t), "Vector4us is not packed");
+static_assert(sizeof(Vector2s) == 2 * sizeof(int16_t), "Vector2s is not packed");
+
+
+/// Encodes the direction of normal as an octahedral unit vector. The w component of normal is ignored.
+Vector2s Vector2s_OctahedralEncode(const Vector4f& normal);
+
+/// Decodes the octahedral unit vector vec to a Vector4f with w set to 0 which is in the right direction but is not
+/// normalized. This can be used instead of Vector4f_OctahedralDecode when the result is normalized later anyway.
+inline Vector4f Vector4f_OctahedralUnfold(const Vector2s& vec)
+{
+  // The lower half is unfolded by moving x and y towards the axes by the amount z is below zero
+  Scalar1f x = Scalar1f(vec.x) * (1.0f / 32767.0f);
+  Scalar1f y = Scalar1f(vec.y) * (1.0f / 32767.0f);
+  x = (x < -1.0f) ? -1.0f : x;  // -32768 is the same as -32767
+  y = (y < -1.0f) ? -1.0f : y;
+  const Scalar1f z = Scalar1f_One() - ::fabs(x) - ::fabs(y);
+  const Scalar1f t = (z < Scalar1f_Zero()) ? -z : Scalar1f_Zero();
+  x += (x >= Scalar1f_Zero()) ? -t : t;
+  y += (y >= Scalar1f_Zero()) ? -t : t;
+  return Vector4f_Set(x, y, z, Scalar1f_Zero());
+}
+
+/// Decodes the octahedral unit vector vec to a normalized Vector4f with w set to 0.
+inline Vector4f Vector4f_OctahedralDecode(const Vector2s& vec)
+{
+  return Vector4f_Normalized(Vector4f_OctahedralUnfold(vec));
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////////
 // 3D Maths - Matrix
@@ -412,59 +936,96 @@ inline Matrix4x4f Matrix4x4f_Set(const Scalar1f v[16])
   return ret;
 }
 
+/// Initialize the matrix from its 4 rows.
+MATHS3D_CONSTEXPR Matrix4x4f Matrix4x4f_SetRows(const Vector4f& row0, const Vector4f& row1, const Vector4f& row2, const Vector4f& row3)
+{
+  return Matrix4x4f{ { { row0, row1, row2, row3 } } };
+}
+
 /// Initialize the matrix to zero.
-inline Matrix4x4f Matrix4x4f_Zero()
+MATHS3D_CONSTEXPR Matrix4x4f Matrix4x4f_Zero()
 {
-  Matrix4x4f ret;
-  for (int i = 0; i < 16; ++i)
-    ret.v[i] = Scalar1f_Zero();
-  return ret;
+  return Matrix4x4f_SetRows(Vector4f_Zero(), Vector4f_Zero(), Vector4f_Zero(), Vector4f_Zero());
+}
+
+/// Creates a matrix that when multiplied by it will be able to apply a 3D scaling
+/// transformation. This is a non-uniform scaling where the amount scaled in each
+/// dimension is determined by the scale vector parameter.
+MATHS3D_CONSTEXPR Matrix4x4f Matrix4x4f_ScaleXYZ(const Vector4f& scale)
+{
+  return Matrix4x4f_SetRows(Vector4f_Set(scale.x, Scalar1f_Zero(), Scalar1f_Zero(), Scalar1f_Zero()),
+                            Vector4f_Set(Scalar1f_Zero(), scale.y, Scalar1f_Zero(), Scalar1f_Zero()),
+                            Vector4f_Set(Scalar1f_Zero(), Scalar1f_Zero(), scale.z, Scalar1f_Zero()),
+                            Vector4f_Set(Scalar1f_Zero(), Scalar1f_Zero(), Scalar1f_Zero(), scale.w));
 }
 
 /// Creates a matrix that when multiplied by it will be able to apply a uniform 3D
 /// scaling transformation (uniform meaning that it is scaled by the same amount in
 /// the x, y and z dimensions).
-inline Matrix4x4f Matrix4x4f_Scale(Scalar1f scale)
+MATHS3D_CONSTEXPR Matrix4x4f Matrix4x4f_Scale(Scalar1f scale)
 {
-  Matrix4x4f ret = Matrix4x4f_Zero();
-  ret.m[0][0] = ret.m[1][1] = ret.m[2][2] = scale;
-  ret.m[3][3] = Scalar1f_One();
-  return ret;
+  return Matrix4x4f_ScaleXYZ(Vector4f_Set(scale, scale, scale, Scalar1f_One()));
 }
 
 /// Initialize the matrix to an identity matrix, a matrix that when multiplied with
 /// another matrix, returns an identical matrix back again.
-inline Matrix4x4f Matrix4x4f_Identity()
+MATHS3D_CONSTEXPR Matrix4x4f Matrix4x4f_Identity()
 {
   return Matrix4x4f_Scale(Scalar1f_One());
 }
 
 /// Creates a matrix that when multiplied by it, will flip the handedness
 /// (flips the sign of y).
-inline Matrix4x4f Matrix4x4f_YFlip()
+MATHS3D_CONSTEXPR Matrix4x4f Matrix4x4f_YFlip()
 {
-  Matrix4x4f ret = Matrix4x4f_Identity();
-  ret.m[1][1] = -Scalar1f_One();
-  return ret;
+  return Matrix4x4f_ScaleXYZ(Vector4f_Set(Scalar1f_One(), -Scalar1f_One(), Scalar1f_One(), Scalar1f_One()));
 }
 
 /// Creates a matrix that when multiplied by it, will swap the y and z values.
 /// This might be useful to be able to go from a right handed world coordinate
 /// system to a left handed view coordinate system.
-inline Matrix4x4f Matrix4x4f_YZSwap()
+MATHS3D_CONSTEXPR Matrix4x4f Matrix4x4f_YZSwap()
 {
-  Matrix4x4f ret = Matrix4x4f_Zero();
-  ret.m[0][0] = ret.m[2][1] = ret.m[1][2] = ret.m[3][3] = Scalar1f_One();
-  return ret;
+  const Matrix4x4f identity = Matrix4x4f_Identity();
+  return Matrix4x4f_SetRows(identity.row[0], identity.row[2], identity.row[1], identity.row[3]);
 }
 
 /// Creates a matrix that when multiplied by it, will be able to apply a 3D translation
 /// transformation.
-inline Matrix4x4f Matrix4x4f_TranslateXYZ(const Vector4f& vec)
+MATHS3D_CONSTEXPR Matrix4x4f Matrix4x4f_TranslateXYZ(const Vector4f& vec)
 {
-  Matrix4x4f ret = Matrix4x4f_Identity();
-  ret.row[3] = Vector4f_SetW(vec, Scalar1f_One());
-  return ret;
+  const Matrix4x4f identity = Matrix4x4f_Identity();
+  return Matrix4x4f_SetRows(identity.row[0], identity.row[1], identity.row[2], Vector4f_SetW(vec, Scalar1f_One()));
+}
+
+#if MATHS3D_SSE
+/// Internal SSE implementation of Matrix4x4f_Multiply.
+Matrix4x4f Matrixi4x4f_Multiply(const Matrix4x4f& m1, const Matrix4x4f& m2);
+
+/// Internal SSE implementation of Vector4f_Transform.
+Vector4f Vectori4f_Transform(const Matrix4x4f& m, const Vector4f& vec);
+#endif
+
+/// Applies the transformation of matrix m to vector vec, and returns the transformed
+/// vector.
+MATHS3D_CONSTEXPR Vector4f Vector4f_Transform(const Matrix4x4f& m, const Vector4f& vec)
+{
+#if MATHS3D_SSE
+  if (!MATHS3D_IS_CONSTANT_EVALUATED())
+    return Vectori4f_Transform(m, vec);
+#endif
+  // The rows are weighted by the components of vec
+  return Vector4f_Add(Vector4f_Add(Vector4f_Scaled(m.row[0], vec.x), Vector4f_Scaled(m.row[1], vec.y)),
+                      Vector4f_Add(Vector4f_Scaled(m.row[2], vec.z), Vector4f_Scaled(m.row[3], vec.w)));
+}
+
+/// Applies the transformation of matrix m to vector vec and then divides by w, which applies the perspective of a
+/// projection matrix. The reciprocal of w is calculated with the given precision. \see Precision
+template <Precision precision = Precision::Exact>
+inline Vector4f Vector4f_TransformCoord(const Matrix4x4f& m, const Vector4f& vec)
+{
+  const Vector4f ret = Vector4f_Transform(m, vec);
+  return Vector4f_Scaled(ret, Scalar1f_Reciprocal<precision>(ret.w));
 }
 
 /// Multiplies m1 with m2 and returns the resulting matrix that combines these.
@@ -472,23 +1033,51 @@ inline Matrix4x4f Matrix4x4f_TranslateXYZ(const Vector4f& vec)
 /// matters, as a translation followed by a rotation, for example, is not the same
 /// transformation as a rotation followed by a translation. The order used is
 /// pre-multiplication, transformation sequences going from right to left.
-Matrix4x4f Matrix4x4f_Multiply(const Matrix4x4f& m1, const Matrix4x4f& m2);
+MATHS3D_CONSTEXPR Matrix4x4f Matrix4x4f_Multiply(const Matrix4x4f& m1, const Matrix4x4f& m2)
+{
+#if MATHS3D_SSE
+  if (!MATHS3D_IS_CONSTANT_EVALUATED())
+    return Matrixi4x4f_Multiply(m1, m2);
+#endif
+  // Each row of the result is the row of m2 transformed by m1
+  return Matrix4x4f_SetRows(Vector4f_Transform(m1, m2.row[0]), Vector4f_Transform(m1, m2.row[1]),
+                            Vector4f_Transform(m1, m2.row[2]), Vector4f_Transform(m1, m2.row[3]));
+}
 
 /// Creates a matrix where the matrix a is mirrored through the diagonal of the matrix.
-Matrix4x4f Matrix4x4f_Transposed(const Matrix4x4f& a);
+MATHS3D_CONSTEXPR Matrix4x4f Matrix4x4f_Transposed(const Matrix4x4f& a)
+{
+  return Matrix4x4f_SetRows(Vector4f_Set(a.row[0].x, a.row[1].x, a.row[2].x, a.row[3].x),
+                            Vector4f_Set(a.row[0].y, a.row[1].y, a.row[2].y, a.row[3].y),
+                            Vector4f_Set(a.row[0].z, a.row[1].z, a.row[2].z, a.row[3].z),
+                            Vector4f_Set(a.row[0].w, a.row[1].w, a.row[2].w, a.row[3].w));
+}
 
 /// Multiplies each component of matrix m by scale and returns the resulting
 /// scaled matrix. For 3D scaling, \see Matrix4x4f_Scale or \see Matrix4x4f_ScaleXYZ.
-Matrix4x4f Matrix4x4f_Scaled(const Matrix4x4f& m, Scalar1f scale);
-
-/// Creates a matrix that when multiplied by it will be able to apply a 3D scaling
-/// transformation. This is a non-uniform scaling where the amount scaled in each
-/// dimension is determined by the scale vector parameter.
-Matrix4x4f Matrix4x4f_ScaleXYZ(const Vector4f& scale);
+MATHS3D_CONSTEXPR Matrix4x4f Matrix4x4f_Scaled(const Matrix4x4f& m, Scalar1f scale)
+{
+  return Matrix4x4f_SetRows(Vector4f_Scaled(m.row[0], scale), Vector4f_Scaled(m.row[1], scale),
+                            Vector4f_Scaled(m.row[2], scale), Vector4f_Scaled(m.row[3], scale));
+}
 
 /// Internal helper function for implementing the other matrix rotation functions.
 Matrix4x4f Matrix4x4f_RotateCommon(Radians angle, int axis);
 
+/// Creates a matrix which rotates about the given axis (0, 1 or 2 for x, y or z) from the sine and cosine of the
+/// angle. This is used by Matrix4x4f_RotateCommon and the batch rotation functions in maths3d_ext.h.
+inline Matrix4x4f Matrix4x4f_RotateSinCos(const SinCos1f& sinCos, int axis)
+{
+  Matrix4x4f ret = Matrix4x4f_Zero();
+  ret.m[0][2]    = ret.m[1][0]    = ret.m[2][1]    = sinCos.sin;
+  ret.m[0][1]    = ret.m[1][2]    = ret.m[2][0]    = -sinCos.sin;
+  ret.m[axis][0] = ret.m[axis][1] = ret.m[axis][2] = Scalar1f_Zero();
+  ret.m[0][axis] = ret.m[1][axis] = ret.m[2][axis] = Scalar1f_Zero();
+  ret.m[0][0]    = ret.m[1][1]    = ret.m[2][2]    = sinCos.cos;
+  ret.m[axis][axis] = ret.m[3][3] = Scalar1f_One();
+  return ret;
+}
+
 /// Creates a matrix that when multiplied by it will be able to apply a 3D rotation
 /// transformation about the x axis. The x parameter is in radians.
 inline Matrix4x4f Matrix4x4f_RotateX(Radians x)
@@ -510,13 +1099,48 @@ inline Matrix4x4f Matrix4x4f_RotateZ(Radians z)
   return Matrix4x4f_RotateCommon(z, 2);
 }
 
+/// Creates the same matrix as Matrix4x4f_RotateXYZ from the sines and cosines of the x, y and z rotations.
+/// This is the closed form of multiplying the x, y and z rotation matrices together, which only needs 12
+/// multiplies for the 9 non-trivial elements.
+inline Matrix4x4f Matrix4x4f_RotateSinCosXYZ(const SinCos1f& x, const SinCos1f& y, const SinCos1f& z)
+{
+  const Scalar1f sysx = y.sin * x.sin;
+  const Scalar1f sycx = y.sin * x.cos;
+  Matrix4x4f ret = Matrix4x4f_Identity();
+  ret.m[0][0] = z.cos * y.cos;
+  ret.m[0][1] = z.cos * sysx - z.sin * x.cos;
+  ret.m[0][2] = z.cos * sycx + z.sin * x.sin;
+  ret.m[1][0] = z.sin * y.cos;
+  ret.m[1][1] = z.sin * sysx + z.cos * x.cos;
+  ret.m[1][2] = z.sin * sycx - z.cos * x.sin;
+  ret.m[2][0] = -y.sin;
+  ret.m[2][1] = y.cos * x.sin;
+  ret.m[2][2] = y.cos * x.cos;
+  return ret;
+}
+
 /// Creates a matrix that when multiplied by it will be able to apply a 3D rotation
 /// transformation about the x, y and z axes.
 inline Matrix4x4f Matrix4x4f_RotateXYZ(const Rotation& rotation)
 {
-  const Matrix4x4f rotX = Matrix4x4f_RotateX(rotation.x);
-  const Matrix4x4f rotY = Matrix4x4f_RotateY(rotation.y);
-  return Matrix4x4f_Multiply(Matrix4x4f_Multiply(rotX, rotY), Matrix4x4f_RotateZ(rotation.z));
+  return Matrix4x4f_RotateSinCosXYZ(Radians_SinCos(rotation.x), Radians_SinCos(rotation.y), Radians_SinCos(rotation.z));
+}
+
+/// Creates the inverse of the matrix a, where a is only made up of rotations and a translation (the upper 3x3 part
+/// is orthonormal). The inverse of the rotation is then its transpose, and the translation is rotated by that and
+/// negated, which is much cheaper than Matrix4x4f_Inversed.
+inline Matrix4x4f Matrix4x4f_OrthonormalInversed(const Matrix4x4f& a)
+{
+  Matrix4x4f ret = Matrix4x4f_Identity();
+  for (int i = 0; i < 3; ++i)
+  {
+    for (int j = 0; j < 3; ++j)
+    {
+      ret.m[i][j] = a.m[j][i];
+    }
+    ret.m[3][i] = -(a.m[3][0] * a.m[i][0] + a.m[3][1] * a.m[i][1] + a.m[3][2] * a.m[i][2]);
+  }
+  return ret;
 }
 
 /// Creates a matrix that when multiplied by it will be able to apply a 3D perspective
@@ -550,18 +1174,765 @@ Matrix4x4f Matrix4x4f_Adjugate(const Matrix4x4f& a);
 
 /// Creates a matrix that is the inverse of matrix a. This resulting matrix when multiplied
 /// with the original matrix a will return an identity matrix (provided the matrix is invertible).
-/// \see Matrix4x4f_Adjugate, Matrix4x4f_Determinate
-inline Matrix4x4f Matrix4x4f_Inversed(const Matrix4x4f& a)
-{
-  const Scalar1f det = Matrix4x4f_Determinant(a);
-  if (det != Scalar1f_Zero())
-  {
-    return Matrix4x4f_Scaled(Matrix4x4f_Adjugate(a), Scalar1f_One() / det);
-  }
-  return Matrix4x4f_Zero();
-}
+/// The determinant and adjugate are calculated together from one shared set of 2x2 minors. If the
+/// matrix is not invertible a zero matrix is returned.
+/// \see Matrix4x4f_Adjugate, Matrix4x4f_Determinate, Matrix4x4f_AffineInversed, Matrix4x4f_OrthonormalInversed
+Matrix4x4f Matrix4x4f_Inversed(const Matrix4x4f& a);
 
-/// Applies the transformation of matrix m to vector vec, and returns the transformed
-/// vector.
-Vector4f Vector4f_Transform(const Matrix4x4f& m, const Vector4f& vec);
+/// Creates the inverse of the matrix a, where a is an affine transform, that is the last column is (0,0,0,1)
+/// as it is for any combination of scales, rotations, shears and translations. Only the upper 3x3 part needs
+/// a full inverse, which is much cheaper than Matrix4x4f_Inversed. If the matrix is not invertible a zero
+/// matrix is returned.
+Matrix4x4f Matrix4x4f_AffineInversed(const Matrix4x4f& a);
+
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// 3D Maths - Affine Matrix
+
+/// \brief
+/// A compact 3x4 matrix for affine transformations, which are all the transforms made up of translations,
+/// rotations, scales and shears. The last column of an affine Matrix4x4f is always (0,0,0,1), so it isn't stored.
+/// The rows of a Matrix3x4f are the first three columns of the equivalent Matrix4x4f, which keeps each row 16-byte
+/// aligned, with the translation for that component in the 4th element. It is 48 bytes instead of 64.
+/// \see Matrix3x4f_FromMatrix4x4f, Matrix4x4f_FromMatrix3x4f
+struct Matrix3x4f
+{
+  union
+  {
+    Vector4f row[3];              /// The 3 rows of the matrix accessible as an array of Vector4f.
+    Scalar1f m[3][4];             /// The 3x4 matrix values accessible as a 3x4 array of arrays.
+    Scalar1f v[12];               /// The 3x4 matrix values accessible as a single array of 12 values.
+  };
+};
+
+// Check that Matrix3x4f is a POD type and is 25% smaller than Matrix4x4f
+static_assert(std::is_pod<Matrix3x4f>(), "Matrix3x4f is non-POD type");
+static_assert(sizeof(Matrix3x4f) == 48, "Matrix3x4f is not 48 bytes");
+
+/// Initialize the matrix to the identity transform.
+inline Matrix3x4f Matrix3x4f_Identity()
+{
+  Matrix3x4f ret;
+  ret.row[0] = Vector4f_Set(1.0f, 0.0f, 0.0f, 0.0f);
+  ret.row[1] = Vector4f_Set(0.0f, 1.0f, 0.0f, 0.0f);
+  ret.row[2] = Vector4f_Set(0.0f, 0.0f, 1.0f, 0.0f);
+  return ret;
+}
+
+/// Converts the affine matrix a to a Matrix3x4f. The last column of a is assumed to be (0,0,0,1) and is ignored.
+inline Matrix3x4f Matrix3x4f_FromMatrix4x4f(const Matrix4x4f& a)
+{
+  Matrix3x4f ret;
+  for (int i = 0; i < 3; ++i)
+  {
+    ret.row[i] = Vector4f_Set(a.m[0][i], a.m[1][i], a.m[2][i], a.m[3][i]);
+  }
+  return ret;
+}
+
+/// Converts a to the equivalent Matrix4x4f, which has (0,0,0,1) as its last column.
+inline Matrix4x4f Matrix4x4f_FromMatrix3x4f(const Matrix3x4f& a)
+{
+  Matrix4x4f ret;
+  for (int i = 0; i < 4; ++i)
+  {
+    ret.row[i] = Vector4f_Set(a.m[0][i], a.m[1][i], a.m[2][i], (i == 3) ? Scalar1f_One() : Scalar1f_Zero());
+  }
+  return ret;
+}
+
+/// Multiplies m1 with m2, in the same order as Matrix4x4f_Multiply, so that the result applies m2 and then m1.
+/// As the last column isn't stored this needs 36 multiplies instead of 64.
+Matrix3x4f Matrix3x4f_Multiply(const Matrix3x4f& m1, const Matrix3x4f& m2);
+
+/// Creates the inverse of the affine transform a. If the matrix is not invertible a zero matrix is returned.
+/// \see Matrix4x4f_AffineInversed
+Matrix3x4f Matrix3x4f_Inversed(const Matrix3x4f& a);
+
+/// Applies the transformation of matrix m to vector vec, which is the same as Vector4f_Transform with the
+/// equivalent Matrix4x4f. The w component of vec is unchanged.
+Vector4f Vector4f_Transform(const Matrix3x4f& m, const Vector4f& vec);
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// 3D Maths - Prepared Transform
+
+/// \brief
+/// A transform matrix prepared for transforming many vectors by it, one at a time or in small batches. The matrix
+/// is held in the layout that the backend transforms vectors with: for SSE the rows, which are weighted by the
+/// broadcast components of the vector, and for the plain C++ backend the columns, which each give one component of
+/// the result as a dot-product with the vector. Unlike Vector4f_Transform, the transforms are inline, so a loop
+/// over them keeps the matrix in registers instead of reloading it for every vector.
+/// \see PreparedTransform4f_Prepare, and the stream versions in maths3d_ext.h
+struct PreparedTransform4f
+{
+  Matrix4x4f layout;              /// The rows (SSE) or columns (plain C++) of the transform.
+};
+
+/// Prepares the transform matrix for transforming vectors with the PreparedTransform4f functions.
+inline PreparedTransform4f PreparedTransform4f_Prepare(const Matrix4x4f& transform)
+{
+#if MATHS3D_SSE
+  return PreparedTransform4f{ transform };
+#else
+  return PreparedTransform4f{ Matrix4x4f_Transposed(transform) };
+#endif
+}
+
+/// Returns the transform matrix which was prepared.
+inline Matrix4x4f PreparedTransform4f_Matrix(const PreparedTransform4f& prepared)
+{
+#if MATHS3D_SSE
+  return prepared.layout;
+#else
+  return Matrix4x4f_Transposed(prepared.layout);
+#endif
+}
+
+/// Applies the prepared transform to vec, which gives the same result as Vector4f_Transform.
+inline Vector4f PreparedTransform4f_Transform(const PreparedTransform4f& prepared, const Vector4f& vec)
+{
+  const Matrix4x4f& m = prepared.layout;
+#if MATHS3D_SSE
+  Vector4f ret;
+  ret.m = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m.row[0].m, _mm_shuffle_ps(vec.m, vec.m, _MM_SHUFFLE(0,0,0,0))),
+                                _mm_mul_ps(m.row[1].m, _mm_shuffle_ps(vec.m, vec.m, _MM_SHUFFLE(1,1,1,1)))),
+                     _mm_add_ps(_mm_mul_ps(m.row[2].m, _mm_shuffle_ps(vec.m, vec.m, _MM_SHUFFLE(2,2,2,2))),
+                                _mm_mul_ps(m.row[3].m, _mm_shuffle_ps(vec.m, vec.m, _MM_SHUFFLE(3,3,3,3)))));
+  return ret;
+#else
+  return Vector4f_Set(Vector4f_DotProduct(m.row[0], vec), Vector4f_DotProduct(m.row[1], vec),
+                      Vector4f_DotProduct(m.row[2], vec), Vector4f_DotProduct(m.row[3], vec));
+#endif
+}
+
+/// Applies the prepared transform to the normal vector vec, so without the translation. The w component of the
+/// result is zero.
+inline Vector4f PreparedTransform4f_TransformNormal(const PreparedTransform4f& prepared, const Vector4f& vec)
+{
+  return PreparedTransform4f_Transform(prepared, Vector4f_SetW(vec, Scalar1f_Zero()));
+}
+
+/// Applies the prepared transform to each of the count vectors in inputStream and writes them to outputStream.
+/// This is intended for small batches, where the setup of the stream functions in maths3d_ext.h isn't worth it.
+inline void PreparedTransform4f_TransformBatch(const PreparedTransform4f& prepared, Vector4f* outputStream, const Vector4f* inputStream, unsigned count)
+{
+  for (unsigned i = 0; i < count; ++i)
+  {
+    outputStream[i] = PreparedTransform4f_Transform(prepared, inputStream[i]);
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// 3D Maths - Quaternion
+
+/// \brief
+/// A unit quaternion representing a 3D rotation. The x, y and z components are the axis of rotation scaled by the
+/// sine of half the angle and w is the cosine of half the angle. Quaternions can be composed and interpolated without
+/// any trigonometry, and converted to a matrix with only multiplies and adds.
+/// \note
+/// The rotations are in the same direction as the matrices, so Quaternion4f_FromAxisAngle about the x axis gives
+/// the same rotation as Matrix4x4f_RotateX.
+struct Quaternion4f
+{
+  union
+  {
+    Vector4f vec;                 /// The 4 components as a Vector4f.
+    struct
+    {
+      Scalar1f x, y, z, w;        /// The named components, x, y and z is the imaginary part and w is the real part.
+    };
+    Scalar1f v[4];                /// The 4 components accessible as an array.
+  };
+};
+
+// Check that Quaternion4f is a POD type and is the same as a Vector4f in memory
+static_assert(std::is_pod<Quaternion4f>(), "Quaternion4f is non-POD type");
+static_assert(sizeof(Quaternion4f) == sizeof(Vector4f), "Quaternion4f is not the size of a Vector4f");
 
+/// Assigns x, y, z and w to the corresponding components of the quaternion.
+inline Quaternion4f Quaternion4f_Set(Scalar1f x, Scalar1f y, Scalar1f z, Scalar1f w)
+{
+  return Quaternion4f{ Vector4f_Set(x, y, z, w) };
+}
+
+/// Initialize the quaternion to the identity, which is no rotation.
+inline Quaternion4f Quaternion4f_Identity()
+{
+  return Quaternion4f_Set(Scalar1f_Zero(), Scalar1f_Zero(), Scalar1f_Zero(), Scalar1f_One());
+}
+
+/// Creates a quaternion which rotates about the unit vector axis by angle. The w component of axis is ignored.
+inline Quaternion4f Quaternion4f_FromAxisAngle(const Vector4f& axis, Radians angle)
+{
+  // Negated so that the rotation is in the same direction as the matrices
+  const SinCos1f sinCos = Radians_SinCos(Radians{ angle.value * -0.5f });
+  return Quaternion4f{ Vector4f_SetW(Vector4f_Scaled(axis, sinCos.sin), sinCos.cos) };
+}
+
+/// Creates a quaternion which is the same rotation as Matrix4x4f_RotateXYZ.
+Quaternion4f Quaternion4f_FromRotation(const Rotation& rotation);
+
+/// Multiplies q1 with q2, in the same order as Matrix4x4f_Multiply, so that the result applies q2 and then q1.
+inline Quaternion4f Quaternion4f_Multiply(const Quaternion4f& q1, const Quaternion4f& q2)
+{
+  // The components of q1 weight q2 and the permutations of q2 with the signs for the imaginary products
+#if MATHS3D_SSE
+  const __m128 b = q2.vec.m;
+  __m128 r = _mm_mul_ps(_mm_shuffle_ps(q1.vec.m, q1.vec.m, _MM_SHUFFLE(3,3,3,3)), b);
+  r = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(_mm_shuffle_ps(q1.vec.m, q1.vec.m, _MM_SHUFFLE(0,0,0,0)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(0,1,2,3))),
+                               _mm_setr_ps(1.0f, -1.0f, 1.0f, -1.0f)));
+  r = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(_mm_shuffle_ps(q1.vec.m, q1.vec.m, _MM_SHUFFLE(1,1,1,1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1,0,3,2))),
+                               _mm_setr_ps(1.0f, 1.0f, -1.0f, -1.0f)));
+  r = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(_mm_shuffle_ps(q1.vec.m, q1.vec.m, _MM_SHUFFLE(2,2,2,2)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(2,3,0,1))),
+                               _mm_setr_ps(-1.0f, 1.0f, 1.0f, -1.0f)));
+  Quaternion4f ret;
+  ret.vec.m = r;
+  return ret;
+#else
+  return Quaternion4f_Set(q1.w * q2.x + q1.x * q2.w + q1.y * q2.z - q1.z * q2.y,
+                          q1.w * q2.y - q1.x * q2.z + q1.y * q2.w + q1.z * q2.x,
+                          q1.w * q2.z + q1.x * q2.y - q1.y * q2.x + q1.z * q2.w,
+                          q1.w * q2.w - q1.x * q2.x - q1.y * q2.y - q1.z * q2.z);
+#endif
+}
+
+/// Creates the conjugate of q, which for a unit quaternion is the inverse rotation.
+inline Quaternion4f Quaternion4f_Conjugate(const Quaternion4f& q)
+{
+  return Quaternion4f{ Vector4f_Multiply(q.vec, Vector4f_Set(-Scalar1f_One(), -Scalar1f_One(), -Scalar1f_One(), Scalar1f_One())) };
+}
+
+/// Calculates the dot-product of q1 and q2, which is the cosine of half the angle between the rotations.
+inline Scalar1f Quaternion4f_DotProduct(const Quaternion4f& q1, const Quaternion4f& q2)
+{
+  return Vector4f_DotProduct(q1.vec, q2.vec);
+}
+
+/// Copies q and scales it to be a unit quaternion.
+inline Quaternion4f Quaternion4f_Normalized(const Quaternion4f& q)
+{
+  return Quaternion4f{ Vector4f_Normalized(q.vec) };
+}
+
+/// Interpolates from q1 at t = 0 to q2 at t = 1 linearly and normalizes the result. This takes the shortest path
+/// between the rotations, but the speed of the rotation isn't constant. It is much cheaper than Quaternion4f_Slerp,
+/// and is close to it when the rotations are close, such as the keyframes of an animation.
+inline Quaternion4f Quaternion4f_Nlerp(const Quaternion4f& q1, const Quaternion4f& q2, Scalar1f t)
+{
+  // q2 and -q2 are the same rotation, the one closest to q1 is the shortest path
+  const Scalar1f t2 = (Quaternion4f_DotProduct(q1, q2) < Scalar1f_Zero()) ? -t : t;
+  return Quaternion4f_Normalized(Quaternion4f{ Vector4f_Add(Vector4f_Scaled(q1.vec, Scalar1f_One() - t), Vector4f_Scaled(q2.vec, t2)) });
+}
+
+/// Interpolates from q1 at t = 0 to q2 at t = 1 along the shortest path between the rotations at a constant speed.
+/// The angle is calculated with a polynomial approximation instead of libm, which is within 1e-6 of the exact
+/// interpolation. When the rotations are very close this is the same as Quaternion4f_Nlerp.
+Quaternion4f Quaternion4f_Slerp(const Quaternion4f& q1, const Quaternion4f& q2, Scalar1f t);
+
+/// Applies the rotation of q to vec, which is the same as Vector4f_Transform with Matrix4x4f_FromQuaternion4f.
+/// The w component of vec is unchanged.
+inline Vector4f Quaternion4f_Rotate(const Quaternion4f& q, const Vector4f& vec)
+{
+  // vec + 2w(u x vec) + 2u x (u x vec), where u is the imaginary part of q
+  const Vector4f t = Vector4f_Scaled(Vector4f_CrossProduct(q.vec, vec), Scalar1f_Two());
+  const Vector4f ret = Vector4f_Add(Vector4f_Add(vec, Vector4f_Scaled(t, q.w)), Vector4f_CrossProduct(q.vec, t));
+  return Vector4f_SetW(ret, vec.w);
+}
+
+/// Creates a matrix which when multiplied by it applies the scale, then the rotation and then the translation.
+/// This is the same as multiplying Matrix4x4f_TranslateXYZ, Matrix4x4f_FromQuaternion4f and Matrix4x4f_ScaleXYZ
+/// together, without the multiplies. The w components of translation and scale are ignored.
+inline Matrix4x4f Matrix4x4f_TranslateRotateScale(const Vector4f& translation, const Quaternion4f& rotation, const Vector4f& scale)
+{
+  const Scalar1f x = rotation.x, y = rotation.y, z = rotation.z, w = rotation.w;
+  const Scalar1f x2 = x + x, y2 = y + y, z2 = z + z;
+  const Scalar1f xx = x * x2, yy = y * y2, zz = z * z2;
+  const Scalar1f xy = x * y2, xz = x * z2, yz = y * z2;
+  const Scalar1f wx = w * x2, wy = w * y2, wz = w * z2;
+  return Matrix4x4f_SetRows(Vector4f_Scaled(Vector4f_Set(Scalar1f_One() - (yy + zz), xy + wz, xz - wy, Scalar1f_Zero()), scale.x),
+                            Vector4f_Scaled(Vector4f_Set(xy - wz, Scalar1f_One() - (xx + zz), yz + wx, Scalar1f_Zero()), scale.y),
+                            Vector4f_Scaled(Vector4f_Set(xz + wy, yz - wx, Scalar1f_One() - (xx + yy), Scalar1f_Zero()), scale.z),
+                            Vector4f_SetW(translation, Scalar1f_One()));
+}
+
+/// Creates the rotation matrix which is the same rotation as the quaternion q.
+inline Matrix4x4f Matrix4x4f_FromQuaternion4f(const Quaternion4f& q)
+{
+  return Matrix4x4f_TranslateRotateScale(Vector4f_Zero(), q, Vector4f_Replicate(Scalar1f_One()));
+}
+
+/// Creates the same transform as Matrix4x4f_TranslateRotateScale as a Matrix3x4f.
+inline Matrix3x4f Matrix3x4f_TranslateRotateScale(const Vector4f& translation, const Quaternion4f& rotation, const Vector4f& scale)
+{
+  return Matrix3x4f_FromMatrix4x4f(Matrix4x4f_TranslateRotateScale(translation, rotation, scale));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// 3D Maths - Dual Quaternion
+
+/// \brief
+/// A unit dual quaternion representing a rotation followed by a translation. Unlike matrices, dual quaternions can
+/// be blended without the shrinking and shearing that blending rotation matrices gives, which is why they are used
+/// for skinning. \see Vector4f_DualQuaternionSkinStream in maths3d_ext.h
+struct DualQuaternion4f
+{
+  Quaternion4f real;              /// The rotation.
+  Quaternion4f dual;              /// Half the translation as a pure quaternion multiplied by the rotation.
+};
+
+// Check that DualQuaternion4f is a POD type
+static_assert(std::is_pod<DualQuaternion4f>(), "DualQuaternion4f is non-POD type");
+
+/// Creates the dual quaternion which applies rotation and then translation. The w component of translation is ignored.
+inline DualQuaternion4f DualQuaternion4f_FromRotationTranslation(const Quaternion4f& rotation, const Vector4f& translation)
+{
+  const Quaternion4f halfTranslation = Quaternion4f{ Vector4f_SetW(Vector4f_Scaled(translation, 0.5f), Scalar1f_Zero()) };
+  return DualQuaternion4f{ rotation, Quaternion4f_Multiply(halfTranslation, rotation) };
+}
+
+/// Returns the translation of the unit dual quaternion dq. The w component is zero.
+inline Vector4f DualQuaternion4f_Translation(const DualQuaternion4f& dq)
+{
+  const Quaternion4f translation = Quaternion4f_Multiply(dq.dual, Quaternion4f_Conjugate(dq.real));
+  return Vector4f_SetW(Vector4f_Scaled(translation.vec, Scalar1f_Two()), Scalar1f_Zero());
+}
+
+/// Applies the rotation and then the translation of the unit dual quaternion dq to vec. As with Vector4f_Transform
+/// the translation is scaled by the w component of vec, so normals with a w of zero are only rotated.
+inline Vector4f DualQuaternion4f_Transform(const DualQuaternion4f& dq, const Vector4f& vec)
+{
+  return Vector4f_Add(Quaternion4f_Rotate(dq.real, vec), Vector4f_Scaled(DualQuaternion4f_Translation(dq), vec.w));
+}
+
+/// Creates the matrix which is the same transform as the unit dual quaternion dq.
+inline Matrix4x4f Matrix4x4f_FromDualQuaternion4f(const DualQuaternion4f& dq)
+{
+  return Matrix4x4f_TranslateRotateScale(DualQuaternion4f_Translation(dq), dq.real, Vector4f_Replicate(Scalar1f_One()));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// 3D Maths - Bounding volumes
+
+/// \brief
+/// An axis aligned bounding box, given by the corners with the smallest and largest components.
+/// \see Aabb4f_FromVector4fStream in maths3d_ext.h for the bounds of an array of points.
+struct Aabb4f
+{
+  Vector4f minimum;       /// The corner with the smallest components.
+  Vector4f maximum;       /// The corner with the largest components.
+};
+
+/// \brief
+/// A bounding sphere, given by its center and radius.
+struct BoundingSphere4f
+{
+  Vector4f center;        /// The center of the sphere. The w component is 1.
+  Scalar1f radius;        /// The radius of the sphere.
+};
+
+
+/// Creates the box with the corners minimum and maximum.
+inline Aabb4f Aabb4f_Set(const Vector4f& minimum, const Vector4f& maximum)
+{
+  return Aabb4f{ minimum, maximum };
+}
+
+/// Creates a box which contains nothing, so that merging it with any other box or point gives that box or point.
+inline Aabb4f Aabb4f_Empty()
+{
+  return Aabb4f{ Vector4f_Replicate(FLT_MAX), Vector4f_Replicate(-FLT_MAX) };
+}
+
+/// Returns the point in the center of the box.
+inline Vector4f Aabb4f_Center(const Aabb4f& box)
+{
+  return Vector4f_Scaled(Vector4f_Add(box.minimum, box.maximum), 0.5f);
+}
+
+/// Returns the half sizes of the box along each axis, which is the offset of the maximum corner from the center.
+inline Vector4f Aabb4f_Extent(const Aabb4f& box)
+{
+  return Vector4f_Scaled(Vector4f_Subtract(box.maximum, box.minimum), 0.5f);
+}
+
+/// Returns the smallest box which contains both box1 and box2.
+inline Aabb4f Aabb4f_Merge(const Aabb4f& box1, const Aabb4f& box2)
+{
+  return Aabb4f{ Vector4f_Minimum(box1.minimum, box2.minimum), Vector4f_Maximum(box1.maximum, box2.maximum) };
+}
+
+/// Returns the smallest box which contains both box and point.
+inline Aabb4f Aabb4f_AddPoint(const Aabb4f& box, const Vector4f& point)
+{
+  return Aabb4f{ Vector4f_Minimum(box.minimum, point), Vector4f_Maximum(box.maximum, point) };
+}
+
+/// Returns the axis aligned box which contains the box after it is transformed by the affine matrix m (Arvo).
+/// Rather than transforming the 8 corners, the center is transformed and the extent is transformed by the
+/// absolute values of the matrix, which gives the same box with much less work.
+inline Aabb4f Aabb4f_Transform(const Matrix4x4f& m, const Aabb4f& box)
+{
+  const Vector4f center = Vector4f_Transform(m, Vector4f_SetW(Aabb4f_Center(box), Scalar1f_One()));
+  const Vector4f extent = Aabb4f_Extent(box);
+  const Vector4f transformedExtent = Vector4f_Add(Vector4f_Add(Vector4f_Scaled(Vector4f_Absolute(m.row[0]), extent.x),
+                                                               Vector4f_Scaled(Vector4f_Absolute(m.row[1]), extent.y)),
+                                                  Vector4f_Scaled(Vector4f_Absolute(m.row[2]), extent.z));
+  return Aabb4f{ Vector4f_Subtract(center, transformedExtent), Vector4f_Add(center, transformedExtent) };
+}
+
+/// Creates the sphere with the given center and radius.
+inline BoundingSphere4f BoundingSphere4f_Set(const Vector4f& center, Scalar1f radius)
+{
+  return BoundingSphere4f{ Vector4f_SetW(center, Scalar1f_One()), radius };
+}
+
+/// Returns the sphere through the corners of the box, which is the smallest sphere which contains it.
+inline BoundingSphere4f BoundingSphere4f_FromAabb4f(const Aabb4f& box)
+{
+  return BoundingSphere4f_Set(Aabb4f_Center(box), Vector4f_Length(Vector4f_SetW(Aabb4f_Extent(box), Scalar1f_Zero())));
+}
+
+/// Returns the smallest sphere which contains both sphere1 and sphere2.
+inline BoundingSphere4f BoundingSphere4f_Merge(const BoundingSphere4f& sphere1, const BoundingSphere4f& sphere2)
+{
+  const Vector4f offset = Vector4f_SetW(Vector4f_Subtract(sphere2.center, sphere1.center), Scalar1f_Zero());
+  const Scalar1f distance = Vector4f_Length(offset);
+  if (distance + sphere2.radius <= sphere1.radius)
+  {
+    return sphere1;
+  }
+  if (distance + sphere1.radius <= sphere2.radius)
+  {
+    return sphere2;
+  }
+  // The new sphere spans from the far side of sphere1 to the far side of sphere2
+  const Scalar1f radius = (distance + sphere1.radius + sphere2.radius) * 0.5f;
+  return BoundingSphere4f_Set(Vector4f_Add(sphere1.center, Vector4f_Scaled(offset, (radius - sphere1.radius) / distance)), radius);
+}
+
+/// Returns a factor which is at least the largest that the affine matrix m scales lengths by, for scaling the
+/// radius of spheres. The largest scale is the square root of the largest eigenvalue of the matrix of dot products
+/// of the rows, which is bounded by its largest row sum of absolute values. This is exact when the rows are
+/// orthogonal, such as for rotations and uniform scales, and over estimates non-uniform scales applied after a
+/// rotation and shears by at most the fourth root of 3, but never under estimates it.
+inline Scalar1f BoundingSphere4f_MaximumScale(const Matrix4x4f& m)
+{
+  const Vector4f x = Vector4f_SetW(m.row[0], Scalar1f_Zero());
+  const Vector4f y = Vector4f_SetW(m.row[1], Scalar1f_Zero());
+  const Vector4f z = Vector4f_SetW(m.row[2], Scalar1f_Zero());
+  const Scalar1f xy = ::fabs(Vector4f_DotProduct(x, y));
+  const Scalar1f xz = ::fabs(Vector4f_DotProduct(x, z));
+  const Scalar1f yz = ::fabs(Vector4f_DotProduct(y, z));
+  const Scalar1f rowX = Vector4f_LengthSquared(x) + xy + xz;
+  const Scalar1f rowY = Vector4f_LengthSquared(y) + xy + yz;
+  const Scalar1f rowZ = Vector4f_LengthSquared(z) + xz + yz;
+  return ::sqrt(::fmax(::fmax(rowX, rowY), rowZ));
+}
+
+/// Returns the sphere which contains the sphere after it is transformed by the affine matrix m.
+inline BoundingSphere4f BoundingSphere4f_Transform(const Matrix4x4f& m, const BoundingSphere4f& sphere)
+{
+  return BoundingSphere4f{ Vector4f_Transform(m, Vector4f_SetW(sphere.center, Scalar1f_One())), sphere.radius * BoundingSphere4f_MaximumScale(m) };
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// 3D Maths - Frustum
+
+/// \brief
+/// The result of testing a bounding volume against a frustum.
+enum class Containment : uint8_t
+{
+  Outside,        /// Completely outside one of the planes, so it can't be seen.
+  Intersecting,   /// Crosses one or more of the planes, so it may be partly visible.
+  Inside,         /// Completely inside all of the planes.
+};
+
+/// \brief
+/// The six planes which bound a view frustum. Each plane is stored as (a, b, c, d) where a*x + b*y + c*z + d is the
+/// distance of the point (x, y, z) from the plane, which is positive on the inside of the frustum.
+/// \see Frustum4f_FromMatrix4x4f
+struct Frustum4f
+{
+  Vector4f planes[6];     /// The left, right, bottom, top, near and far planes.
+};
+
+/// Extracts the planes of the frustum of a projection matrix combined with the view matrix (Gribb and Hartmann).
+/// The planes are in the space that the matrix transforms from, so a view-projection gives world space planes and a
+/// model-view-projection gives model space planes. The clip space is -w <= x, y, z <= w, as Matrix4x4f_PerspectiveFrustum
+/// gives. The planes are normalized.
+Frustum4f Frustum4f_FromMatrix4x4f(const Matrix4x4f& viewProjection);
+
+/// Returns the signed distance of point from the plane, positive on the inside. The w component of point is ignored.
+inline Scalar1f Frustum4f_PlaneDistance(const Vector4f& plane, const Vector4f& point)
+{
+  return Vector4f_DotProduct(plane, Vector4f_SetW(point, Scalar1f_One()));
+}
+
+/// Tests if the sphere with the given center and radius is inside, outside or intersecting the frustum.
+inline Containment Frustum4f_ClassifySphere(const Frustum4f& frustum, const Vector4f& center, Scalar1f radius)
+{
+  Containment ret = Containment::Inside;
+  for (int i = 0; i < 6; ++i)
+  {
+    const Scalar1f distance = Frustum4f_PlaneDistance(frustum.planes[i], center);
+    if (distance < -radius)
+    {
+      return Containment::Outside;
+    }
+    if (distance < radius)
+    {
+      ret = Containment::Intersecting;
+    }
+  }
+  return ret;
+}
+
+/// Tests if the axis aligned box from minimum to maximum is inside, outside or intersecting the frustum.
+/// \note
+/// As the box is only tested against each plane and not the edges of the frustum, large boxes just outside the
+/// corners of the frustum may be reported as intersecting. This is conservative, visible boxes are never outside.
+inline Containment Frustum4f_ClassifyAabb(const Frustum4f& frustum, const Vector4f& minimum, const Vector4f& maximum)
+{
+  const Vector4f center = Vector4f_Scaled(Vector4f_Add(minimum, maximum), 0.5f);
+  const Vector4f extent = Vector4f_Scaled(Vector4f_Subtract(maximum, minimum), 0.5f);
+  Containment ret = Containment::Inside;
+  for (int i = 0; i < 6; ++i)
+  {
+    // The distance of the corner of the box furthest along the normal of the plane from the center
+    const Vector4f& plane = frustum.planes[i];
+    const Scalar1f radius = ::fabs(plane.x) * extent.x + ::fabs(plane.y) * extent.y + ::fabs(plane.z) * extent.z;
+    const Scalar1f distance = Frustum4f_PlaneDistance(plane, center);
+    if (distance < -radius)
+    {
+      return Containment::Outside;
+    }
+    if (distance < radius)
+    {
+      ret = Containment::Intersecting;
+    }
+  }
+  return ret;
+}
+
+/// Tests if the sphere is inside, outside or intersecting the frustum.
+inline Containment Frustum4f_ClassifySphere(const Frustum4f& frustum, const BoundingSphere4f& sphere)
+{
+  return Frustum4f_ClassifySphere(frustum, sphere.center, sphere.radius);
+}
+
+/// Tests if the box is inside, outside or intersecting the frustum. \see Frustum4f_ClassifyAabb
+inline Containment Frustum4f_ClassifyAabb(const Frustum4f& frustum, const Aabb4f& box)
+{
+  return Frustum4f_ClassifyAabb(frustum, box.minimum, box.maximum);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// 3D Maths - Rays
+
+/// \brief
+/// A ray from origin along direction. The direction doesn't need to be normalized, the distances along the ray
+/// are in units of its length.
+struct Ray4f
+{
+  Vector4f origin;        /// The start of the ray. The w component is ignored.
+  Vector4f direction;     /// The direction of the ray. The w component is ignored.
+};
+
+/// \brief
+/// The nearest intersection found so far along a ray. The intersection functions only replace it with hits which
+/// are nearer, so it is initialized with RayHit4f_None and then passed to each of the primitives in turn.
+struct RayHit4f
+{
+  Scalar1f t;             /// The distance along the ray of the hit, which is the point origin + t * direction.
+  uint32_t primitive;     /// The id of the primitive which was hit, or RayHit4f_NoPrimitive.
+  Scalar1f u;             /// The barycentric weight of the second vertex of a triangle, and 0 for other primitives.
+  Scalar1f v;             /// The barycentric weight of the third vertex of a triangle, and 0 for other primitives.
+};
+
+/// The primitive of a RayHit4f which hasn't hit anything.
+const uint32_t RayHit4f_NoPrimitive = 0xFFFFFFFFu;
+
+/// The smallest magnitude of the components of the direction used by the slab tests. \see Ray4f_InverseDirection
+const Scalar1f Ray4f_MinimumDirection = 1e-20f;
+
+
+/// Creates the ray from origin along direction.
+inline Ray4f Ray4f_Set(const Vector4f& origin, const Vector4f& direction)
+{
+  return Ray4f{ Vector4f_SetW(origin, Scalar1f_One()), Vector4f_SetW(direction, Scalar1f_Zero()) };
+}
+
+/// Returns the point at the distance t along the ray.
+inline Vector4f Ray4f_PointAt(const Ray4f& ray, Scalar1f t)
+{
+  return Vector4f_Add(ray.origin, Vector4f_Scaled(Vector4f_SetW(ray.direction, Scalar1f_Zero()), t));
+}
+
+/// Creates a hit which is further than anything, for starting the search for the nearest hit.
+inline RayHit4f RayHit4f_None()
+{
+  return RayHit4f{ FLT_MAX, RayHit4f_NoPrimitive, Scalar1f_Zero(), Scalar1f_Zero() };
+}
+
+/// Returns 1/x with x moved away from zero to at least Ray4f_MinimumDirection, keeping its sign.
+inline Scalar1f Ray4f_ClampedReciprocal(Scalar1f x)
+{
+  const Scalar1f magnitude = ::fmax(::fabs(x), Ray4f_MinimumDirection);
+  return Scalar1f_One() / ((x < Scalar1f_Zero()) ? -magnitude : magnitude);
+}
+
+/// Returns the reciprocal of each of the components of the direction of ray, for testing it against many boxes.
+/// Components too close to zero are clamped, so that the slab tests never multiply zero by infinity, which
+/// -ffast-math assumes can't happen.
+inline Vector4f Ray4f_InverseDirection(const Ray4f& ray)
+{
+  return Vector4f_Set(Ray4f_ClampedReciprocal(ray.direction.x), Ray4f_ClampedReciprocal(ray.direction.y),
+                      Ray4f_ClampedReciprocal(ray.direction.z), Scalar1f_Zero());
+}
+
+/// Intersects ray with sphere, and if it hits it nearer than hit, then hit is replaced with the hit of the sphere
+/// with the given primitive id. Rays which start inside the sphere hit it where they leave it. The rays which miss
+/// are rejected before the square root is needed.
+/// \return true if hit was replaced.
+inline bool Ray4f_IntersectSphere(const Ray4f& ray, const BoundingSphere4f& sphere, uint32_t primitive, RayHit4f& hit)
+{
+  const Vector4f offset = Vector4f_SetW(Vector4f_Subtract(ray.origin, sphere.center), Scalar1f_Zero());
+  const Vector4f direction = Vector4f_SetW(ray.direction, Scalar1f_Zero());
+  const Scalar1f a = Vector4f_DotProduct(direction, direction);
+  const Scalar1f b = Vector4f_DotProduct(offset, direction);
+  const Scalar1f c = Vector4f_DotProduct(offset, offset) - sphere.radius * sphere.radius;
+  const Scalar1f discriminant = b * b - a * c;
+  // Starting outside of the sphere and pointing away from it, or passing by it
+  if ((c > Scalar1f_Zero() && b > Scalar1f_Zero()) || discriminant < Scalar1f_Zero())
+  {
+    return false;
+  }
+  const Scalar1f root = ::sqrt(discriminant);
+  const Scalar1f nearest = (-b - root) / a;
+  const Scalar1f t = (nearest > Scalar1f_Zero()) ? nearest : (root - b) / a;
+  if (t <= Scalar1f_Zero() || t >= hit.t)
+  {
+    return false;
+  }
+  hit = RayHit4f{ t, primitive, Scalar1f_Zero(), Scalar1f_Zero() };
+  return true;
+}
+
+/// Intersects ray with the box using the slab test, and if it hits it nearer than hit, then hit is replaced with
+/// the hit of the box with the given primitive id. Rays which start inside the box hit it where they leave it.
+/// \param inverseDirection is the reciprocal of the direction of ray. \see Ray4f_InverseDirection
+/// \return true if hit was replaced.
+inline bool Ray4f_IntersectAabb(const Ray4f& ray, const Vector4f& inverseDirection, const Aabb4f& box, uint32_t primitive, RayHit4f& hit)
+{
+  const Vector4f t0 = Vector4f_Multiply(Vector4f_Subtract(box.minimum, ray.origin), inverseDirection);
+  const Vector4f t1 = Vector4f_Multiply(Vector4f_Subtract(box.maximum, ray.origin), inverseDirection);
+  const Vector4f tMin = Vector4f_Minimum(t0, t1);
+  const Vector4f tMax = Vector4f_Maximum(t0, t1);
+  const Scalar1f enter = ::fmax(::fmax(tMin.x, tMin.y), tMin.z);
+  const Scalar1f leave = ::fmin(::fmin(tMax.x, tMax.y), tMax.z);
+  const Scalar1f t = (enter > Scalar1f_Zero()) ? enter : leave;
+  if (enter > leave || t <= Scalar1f_Zero() || t >= hit.t)
+  {
+    return false;
+  }
+  hit = RayHit4f{ t, primitive, Scalar1f_Zero(), Scalar1f_Zero() };
+  return true;
+}
+
+/// Intersects ray with the box using the slab test. \see Ray4f_IntersectAabb
+inline bool Ray4f_IntersectAabb(const Ray4f& ray, const Aabb4f& box, uint32_t primitive, RayHit4f& hit)
+{
+  return Ray4f_IntersectAabb(ray, Ray4f_InverseDirection(ray), box, primitive, hit);
+}
+
+/// \brief
+/// A ray prepared for the watertight ray-triangle test (Woop, Benthin and Wald). The axes are permuted so that the
+/// ray goes mostly along z, and the shear makes it go exactly along z, so the test is 2D edge functions which are
+/// calculated the same way for both of the triangles which share an edge.
+struct RayShear4f
+{
+  Vector4f origin;        /// The start of the ray.
+  int kx, ky, kz;         /// The axes of the ray which become x, y and z, where kz is the largest of the direction.
+  Scalar1f sx, sy, sz;    /// The shear which makes the direction (0, 0, 1).
+};
+
+/// Prepares ray for intersecting it with triangles. \see RayShear4f
+inline RayShear4f Ray4f_Shear(const Ray4f& ray)
+{
+  const Vector4f magnitude = Vector4f_Absolute(ray.direction);
+  const int kz = (magnitude.x > magnitude.y) ? ((magnitude.x > magnitude.z) ? 0 : 2) : ((magnitude.y > magnitude.z) ? 1 : 2);
+  int kx = (kz + 1) % 3;
+  int ky = (kx + 1) % 3;
+  if (ray.direction.v[kz] < Scalar1f_Zero())
+  {
+    // Keep the winding of the triangles the same
+    const int swap = kx;
+    kx = ky;
+    ky = swap;
+  }
+  const Scalar1f sz = Scalar1f_One() / ray.direction.v[kz];
+  return RayShear4f{ ray.origin, kx, ky, kz, ray.direction.v[kx] * sz, ray.direction.v[ky] * sz, sz };
+}
+
+/// Returns x * y - z * w, with the products kept apart so that the result is exactly the negative of
+/// z * w - x * y even if the compiler would fuse one of the multiplies with the subtract.
+inline Scalar1f Ray4f_DifferenceOfProducts(Scalar1f x, Scalar1f y, Scalar1f z, Scalar1f w)
+{
+  Scalar1f xy = x * y;
+  Scalar1f zw = z * w;
+  MATHS3D_OPAQUE(xy);
+  MATHS3D_OPAQUE(zw);
+  return xy - zw;
+}
+
+/// Intersects the prepared ray with the triangle a, b, c from either side, and if it hits it nearer than hit,
+/// then hit is replaced with the hit of the triangle with the given primitive id. Rays through an edge or vertex
+/// shared by triangles hit at least one of them, so there are no cracks between them.
+/// \return true if hit was replaced.
+inline bool Ray4f_IntersectTriangle(const RayShear4f& ray, const Vector4f& a, const Vector4f& b, const Vector4f& c, uint32_t primitive, RayHit4f& hit)
+{
+  const Vector4f A = Vector4f_Subtract(a, ray.origin);
+  const Vector4f B = Vector4f_Subtract(b, ray.origin);
+  const Vector4f C = Vector4f_Subtract(c, ray.origin);
+  const Scalar1f ax = A.v[ray.kx] - ray.sx * A.v[ray.kz];
+  const Scalar1f ay = A.v[ray.ky] - ray.sy * A.v[ray.kz];
+  const Scalar1f bx = B.v[ray.kx] - ray.sx * B.v[ray.kz];
+  const Scalar1f by = B.v[ray.ky] - ray.sy * B.v[ray.kz];
+  const Scalar1f cx = C.v[ray.kx] - ray.sx * C.v[ray.kz];
+  const Scalar1f cy = C.v[ray.ky] - ray.sy * C.v[ray.kz];
+  // The edge functions, which are the barycentric coordinates scaled by the determinant
+  const Scalar1f U = Ray4f_DifferenceOfProducts(cx, by, cy, bx);
+  const Scalar1f V = Ray4f_DifferenceOfProducts(ax, cy, ay, cx);
+  const Scalar1f W = Ray4f_DifferenceOfProducts(bx, ay, by, ax);
+  if ((U < Scalar1f_Zero() || V < Scalar1f_Zero() || W < Scalar1f_Zero()) && (U > Scalar1f_Zero() || V > Scalar1f_Zero() || W > Scalar1f_Zero()))
+  {
+    return false;
+  }
+  const Scalar1f determinant = U + V + W;
+  if (determinant == Scalar1f_Zero())
+  {
+    return false;
+  }
+  const Scalar1f T = ray.sz * (U * A.v[ray.kz] + V * B.v[ray.kz] + W * C.v[ray.kz]);
+  const Scalar1f inverseDeterminant = Scalar1f_One() / determinant;
+  const Scalar1f t = T * inverseDeterminant;
+  if (t <= Scalar1f_Zero() || t >= hit.t)
+  {
+    return false;
+  }
+  hit = RayHit4f{ t, primitive, V * inverseDeterminant, W * inverseDeterminant };
+  return true;
+}
+
+/// Intersects ray with the triangle a, b, c. \see Ray4f_IntersectTriangle and Ray4f_Shear
+inline bool Ray4f_IntersectTriangle(const Ray4f& ray, const Vector4f& a, const Vector4f& b, const Vector4f& c, uint32_t primitive, RayHit4f& hit)
+{
+  return Ray4f_IntersectTriangle(Ray4f_Shear(ray), a, b, c, primitive, hit);
+}
@@ -54,21 +54,309 @@
 /// may be useful in a variety of situations. However this is platform specific code,
 /// so fallback code may be required.
 ///
-/// It should be a todo that based on a preprocessor define, this SSE optimized code
-/// is used or some fallback code is used instead which would need to be written.
+/// The SSE code is only compiled when targeting x86. Vector4f_TransformStreamGeneric
+/// is the plain C++ fallback which is used on other platforms.
+///
+/// There are also AVX2 (with FMA) and AVX-512 variants of the stream transform which
+/// transform 2 and 4 vectors per iteration respectively. These are compiled with
+/// per-function target attributes so that the rest of the code can still be built for
+/// the baseline instruction set, and so they must only be called when the CPU supports
+/// them.
+///
+/// So that a single binary can run well on both old and new CPUs, the instruction sets
+/// the CPU supports are detected once with cpuid, and each stream kernel is bound to a
+/// function pointer to the best implementation the first time it is used. Setting the
+/// MATHS3D_ISA environment variable to scalar, sse, avx2 or avx512 forces a lower tier,
+/// which is useful for A/B performance testing. \see InstructionSet_Active
+///
+/// Large streams can also be transformed using multiple threads from a pool which is
+/// created once and reused. \see Vector4f_ParallelTransformStreamGeneric
+///
+/// Vertex data which doesn't need full precision can be stored as half precision
+/// Vector4h to halve the memory bandwidth. The half precision stream transforms convert
+/// on load and store using F16C when the CPU has it. \see Vector4h_TransformStreamGeneric
+/// Compressed meshes with 16-bit quantized positions and octahedral normals can be
+/// decoded and transformed in a single pass. \see Vector4s_TransformStream
+///
+/// Arrays of matrices, such as skinning palettes and instance transforms, can be multiplied
+/// and inverted without a call per matrix. The inverses are done several at a time by
+/// transposing the matrices so that each SIMD lane holds one of them.
+/// \see Matrix4x4f_MultiplyStream, Matrix4x4f_InverseStream
 
 
 ///////////////////////////////////////////////////////////////////////////////////
 // Includes
 
 #include "maths3d.h"
-#include <xmmintrin.h>
-#include <emmintrin.h>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#  define MATHS3D_X86 1
+#  include <xmmintrin.h>
+#  include <emmintrin.h>
+#  include <immintrin.h>
+#  if defined(_MSC_VER)
+#    include <intrin.h>
+#  else
+#    include <cpuid.h>
+#  endif
+#else
+#  define MATHS3D_X86 0
+#endif
+
+
+// Allows a function to be compiled for a different instruction set to the rest of the file.
+#if defined(__GNUC__) || defined(__clang__)
+#  define MATHS3D_TARGET(isa)   __attribute__((target(isa)))
+#else
+#  define MATHS3D_TARGET(isa)
+#endif
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// Stream transforms
+
+/// Returns how many elements of a stream can be processed while prefetching distance floats ahead without
+/// the prefetch touching memory past the end of the stream.
+inline unsigned Stream_PrefetchEnd(unsigned count, unsigned step, unsigned distance)
+{
+  const unsigned ahead = (distance + step - 1) / step;
+  return (count > ahead) ? count - ahead : 0;
+}
+
+
+#if MATHS3D_X86
+
+/// Divides a by b with divps. -ffast-math would otherwise turn _mm_div_ps in to a reciprocal estimate and a
+/// Newton-Raphson step, which isn't accurate enough for Precision::Exact.
+inline __m128 Vector4f_SSEExactDivide(__m128 a, __m128 b)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  __asm__("divps %1, %0" : "+x"(a) : "x"(b));
+  return a;
+#else
+  return _mm_div_ps(a, b);
+#endif
+}
+
+/// Calculates 1/x of each component of x with the given precision. \see Precision
+template <Precision precision>
+inline __m128 Vector4f_SSEReciprocal(__m128 x)
+{
+  if (precision == Precision::Exact)
+  {
+    return Vector4f_SSEExactDivide(_mm_set1_ps(1.0f), x);
+  }
+  const __m128 estimate = _mm_rcp_ps(x);
+  if (precision == Precision::Fastest)
+  {
+    return estimate;
+  }
+  // One Newton-Raphson step, e' = e * (2 - x * e), roughly doubles the number of correct bits
+  return _mm_mul_ps(estimate, _mm_sub_ps(_mm_set1_ps(2.0f), _mm_mul_ps(x, estimate)));
+}
+
+/// Calculates 1/sqrt(x) of each component of x with the given precision. \see Precision
+template <Precision precision>
+inline __m128 Vector4f_SSEReciprocalSqrt(__m128 x)
+{
+  if (precision == Precision::Exact)
+  {
+    return Vector4f_SSEExactDivide(_mm_set1_ps(1.0f), _mm_sqrt_ps(x));
+  }
+  const __m128 estimate = _mm_rsqrt_ps(x);
+  if (precision == Precision::Fastest)
+  {
+    return estimate;
+  }
+  // One Newton-Raphson step, e' = e * (1.5 - 0.5 * x * e * e)
+  const __m128 halfX = _mm_mul_ps(x, _mm_set1_ps(0.5f));
+  return _mm_mul_ps(estimate, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(halfX, _mm_mul_ps(estimate, estimate))));
+}
+
+/// Divides each component of v by the w component with the given precision, applying the perspective.
+template <Precision precision>
+inline __m128 Vector4f_SSEDivideByW(__m128 v)
+{
+  const __m128 w = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3,3,3,3));
+  if (precision == Precision::Exact)
+  {
+    return Vector4f_SSEExactDivide(v, w);
+  }
+  return _mm_mul_ps(v, Vector4f_SSEReciprocal<precision>(w));
+}
+
+/// Divides a by b with vdivps, so that -ffast-math can't approximate it (AVX version of Vector4f_SSEExactDivide,
+/// which avoids mixing legacy SSE instructions with the AVX code).
+MATHS3D_TARGET("avx2,fma")
+inline __m128 Vector4f_AVX2ExactDivide(__m128 a, __m128 b)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  __asm__("vdivps %2, %1, %0" : "=x"(a) : "x"(a), "x"(b));
+  return a;
+#else
+  return _mm_div_ps(a, b);
+#endif
+}
+
+/// Divides a by b with vdivps, so that -ffast-math can't approximate it.
+MATHS3D_TARGET("avx2,fma")
+inline __m256 Vector4f_AVX2ExactDivide(__m256 a, __m256 b)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  __asm__("vdivps %2, %1, %0" : "=x"(a) : "x"(a), "x"(b));
+  return a;
+#else
+  return _mm256_div_ps(a, b);
+#endif
+}
+
+/// Calculates 1/x of each component of x with the given precision (AVX2 and FMA version). \see Precision
+template <Precision precision>
+MATHS3D_TARGET("avx2,fma")
+inline __m128 Vector4f_AVX2Reciprocal(__m128 x)
+{
+  if (precision == Precision::Exact)
+  {
+    return Vector4f_AVX2ExactDivide(_mm_set1_ps(1.0f), x);
+  }
+  const __m128 estimate = _mm_rcp_ps(x);
+  return (precision == Precision::Fastest) ? estimate : _mm_mul_ps(estimate, _mm_fnmadd_ps(x, estimate, _mm_set1_ps(2.0f)));
+}
+
+/// Calculates 1/x of each component of x with the given precision (AVX2 and FMA version). \see Precision
+template <Precision precision>
+MATHS3D_TARGET("avx2,fma")
+inline __m256 Vector4f_AVX2Reciprocal(__m256 x)
+{
+  if (precision == Precision::Exact)
+  {
+    return Vector4f_AVX2ExactDivide(_mm256_set1_ps(1.0f), x);
+  }
+  const __m256 estimate = _mm256_rcp_ps(x);
+  return (precision == Precision::Fastest) ? estimate : _mm256_mul_ps(estimate, _mm256_fnmadd_ps(x, estimate, _mm256_set1_ps(2.0f)));
+}
+
+/// Divides each component of v by the w component with the given precision (AVX2 and FMA version).
+template <Precision precision>
+MATHS3D_TARGET("avx2,fma")
+inline __m128 Vector4f_AVX2DivideByW(__m128 v)
+{
+  const __m128 w = _mm_permute_ps(v, _MM_SHUFFLE(3,3,3,3));
+  return (precision == Precision::Exact) ? Vector4f_AVX2ExactDivide(v, w) : _mm_mul_ps(v, Vector4f_AVX2Reciprocal<precision>(w));
+}
+
+/// Divides each component of the two vectors in v by their w components with the given precision.
+template <Precision precision>
+MATHS3D_TARGET("avx2,fma")
+inline __m256 Vector4f_AVX2DivideByW(__m256 v)
+{
+  const __m256 w = _mm256_permute_ps(v, _MM_SHUFFLE(3,3,3,3));
+  return (precision == Precision::Exact) ? Vector4f_AVX2ExactDivide(v, w) : _mm256_mul_ps(v, Vector4f_AVX2Reciprocal<precision>(w));
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+// Some versions of GCC give false uninitialized warnings from the AVX-512 intrinsics (GCC bug 105593)
+#  pragma GCC diagnostic push
+#  pragma GCC diagnostic ignored "-Wuninitialized"
+#  pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+/// Calculates 1/x of each component of x with the given precision (AVX-512 version). The estimate is accurate to
+/// 2^-14, so Precision::Fast is close to exact. \see Precision
+template <Precision precision>
+MATHS3D_TARGET("avx512f,avx2,fma")
+inline __m512 Vector4f_AVX512Reciprocal(__m512 x)
+{
+  if (precision == Precision::Exact)
+  {
+    __m512 one = _mm512_set1_ps(1.0f);
+#if defined(__GNUC__) || defined(__clang__)
+    __asm__("vdivps %2, %1, %0" : "=v"(one) : "v"(one), "v"(x));
+    return one;
+#else
+    return _mm512_div_ps(one, x);
+#endif
+  }
+  const __m512 estimate = _mm512_rcp14_ps(x);
+  return (precision == Precision::Fastest) ? estimate : _mm512_mul_ps(estimate, _mm512_fnmadd_ps(x, estimate, _mm512_set1_ps(2.0f)));
+}
+
+/// Divides each component of the four vectors in v by their w components with the given precision.
+template <Precision precision>
+MATHS3D_TARGET("avx512f,avx2,fma")
+inline __m512 Vector4f_AVX512DivideByW(__m512 v)
+{
+  const __m512 w = _mm512_permute_ps(v, _MM_SHUFFLE(3,3,3,3));
+  if (precision == Precision::Exact)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    __asm__("vdivps %2, %1, %0" : "=v"(v) : "v"(v), "v"(w));
+    return v;
+#else
+    return _mm512_div_ps(v, w);
+#endif
+  }
+  return _mm512_mul_ps(v, Vector4f_AVX512Reciprocal<precision>(w));
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#  pragma GCC diagnostic pop
+#endif
+
+/// Transforms a single vector, given as X, Y and Z registers with the x, y and z of the vector copied to all four
+/// lanes, by the rows of the transform matrix. This is the core of the SSE stream transforms.
+/// \see Vector4f_SSETransformStreamGeneric for a description of the template parameters.
+template <bool translate, bool divideByW, Precision precision = Precision::Exact>
+__m128 Vector4f_SSETransformSplatted(__m128 X, __m128 Y, __m128 Z, __m128 R0, __m128 R1, __m128 R2, __m128 R3)
+{
+  // We multiply Z with R2, so Z = z*R2[0], z*R2[1], z*R2[2], z*R2[3]
+  Z = _mm_mul_ps(Z,R2);
+  if (translate)
+  {
+    // We add R3, so Z = R3[0]+z*R2[0], R3[1]+z*R2[1], R3[2]+z*R2[2], R3[3]+z*R2[3]
+    Z = _mm_add_ps(Z,R3);
+  }
+  // We multiply Y with R1, so Y = y*R1[0], ...
+  Y = _mm_mul_ps(Y,R1);
+  // We add Y to Z, so Z = R3[0]+z*R2[0]+y*R1[0] ...
+  Z = _mm_add_ps(Z,Y);
+  // (See Vector4f_AVX2TransformStreamGeneric for the fused multiply+add version of this)
+  // We multiply X with R0, so X = x*R0[0], ...
+  X = _mm_mul_ps(X,R0);
+  // We add X to Z, so Z = R3[0] + z*R2[0] + y*R1[0] + x*R0[0], ...
+  Z = _mm_add_ps(Z,X);
+  // Z now contains our transformed point. For perspective transforms, we need to divide by W.
+  if (divideByW)
+  {
+    Z = Vector4f_SSEDivideByW<precision>(Z);
+  }
+  return Z;
+}
 
+/// Transforms a single vector by the rows of the transform matrix.
+/// \see Vector4f_SSETransformStreamGeneric for a description of the template parameters.
+template <bool translate, bool divideByW, Precision precision = Precision::Exact>
+__m128 Vector4f_SSETransformVector(__m128 vals, __m128 R0, __m128 R1, __m128 R2, __m128 R3)
+{
+  // vals contains the next x,y,z entry from the input stream
+  // We now make a 128-bit X with x copied as x,x,x,x, and same for Y and Z.
+  __m128 X = _mm_shuffle_ps(vals,vals,_MM_SHUFFLE(0,0,0,0));
+  __m128 Y = _mm_shuffle_ps(vals,vals,_MM_SHUFFLE(1,1,1,1));
+  __m128 Z = _mm_shuffle_ps(vals,vals,_MM_SHUFFLE(2,2,2,2));
+  return Vector4f_SSETransformSplatted<translate,divideByW,precision>(X, Y, Z, R0, R1, R2, R3);
+}
 
 /// Transforms arrays of vectors by the transform matrix. 
 /// \tparam translate is a bool to enable or disable applying the translation component of the transform.
 /// \tparam divideByW is a bool to enable or disable applying perspective by dividing by W.
+/// \tparam precision is the accuracy of the reciprocal of W when dividing by it, Exact by default. \see Precision
 /// \tparam alignedOutput is a bool to flag if outputStream is aligned to a 128-bit boundary or not.
 /// \tparam outputStep is the width in floats to the next vector element of the outputStream array.
 ///         This allows the outputStream array to be an array of structures of which the vector is a member.
@@ -83,7 +371,7 @@
 /// \param inputStream is the input array of vectors to apply the transform to.
 /// \param count is the number of vectors to transform.
 /// \param transform is the matrix to apply.
-template <bool translate, bool divideByW, bool alignedOutput, int outputStep, bool alignedInput, int inputStep>
+template <bool translate, bool divideByW, bool alignedOutput, int outputStep, bool alignedInput, int inputStep, Precision precision = Precision::Exact>
 void Vector4f_SSETransformStreamGeneric(float* outputStream, const float* inputStream, unsigned count, const Matrix4x4f& transform)
 {
   union
@@ -100,11 +388,16 @@ void Vector4f_SSETransformStreamGeneric(float* outputStream, const float* inputS
   __m128 R1 = xform.r[1];
   __m128 R2 = xform.r[2];
   __m128 R3 = xform.r[3];
+  const unsigned prefetchEnd = Stream_PrefetchEnd(count, inputStep, 256);
   for (unsigned i = 0; i < count; ++i)
   {
     // Hint to the CPU that we will access the memory ahead and it should warm the cache to avoid a cache miss
     // when we actually go to use it. A bit of tweaking was required to get the best value to look ahead by.
-    _mm_prefetch((const char*)&inputStream[256], _MM_HINT_T0);
+    // Near the end of the stream this is skipped so as not to touch memory past the end of the input.
+    if (i < prefetchEnd)
+    {
+      _mm_prefetch((const char*)&inputStream[256], _MM_HINT_T0);
+    }
     __m128 vals;
     if (alignedInput) // note these 'if's are only on template parameters so aren't in the generated code
     {
@@ -114,51 +407,218 @@ void Vector4f_SSETransformStreamGeneric(float* outputStream, const float* inputS
     {
       vals = _mm_loadu_ps(inputStream);
     }
-    // vals contains the next x,y,z entry from the input stream
-    // We now make a 128-bit X with x copied as x,x,x,x, and same for Y and Z.
-    __m128 X = _mm_shuffle_ps(vals,vals,_MM_SHUFFLE(0,0,0,0));
-    __m128 Y = _mm_shuffle_ps(vals,vals,_MM_SHUFFLE(1,1,1,1));
+    __m128 Z = Vector4f_SSETransformVector<translate,divideByW,precision>(vals, R0, R1, R2, R3);
+    if (alignedOutput)
+    {
+      _mm_stream_ps(outputStream,Z); // aligned and cache friendly
+    }
+    else
+    {
+      _mm_storeu_ps(outputStream,Z); // unaligned store
+    }
+    inputStream  += inputStep;
+    outputStream += outputStep;
+  }
+}
+
+/// Transforms arrays of vectors by the transform matrix (AVX2 and FMA implementation).
+/// Two vectors are transformed per iteration by broadcasting the rows of the transform matrix to both 128-bit
+/// lanes of the 256-bit registers, and the multiplies and adds are fused in to FMA instructions. An odd trailing
+/// vector is transformed using the 128-bit form of the same instructions.
+/// The template parameters and parameters are the same as for Vector4f_SSETransformStreamGeneric.
+/// \note must only be called if the CPU supports AVX2 and FMA. \see InstructionSet_IsSupported
+/// \see Vector4f_SSETransformStreamGeneric
+template <bool translate, bool divideByW, bool alignedOutput, int outputStep, bool alignedInput, int inputStep, Precision precision = Precision::Exact>
+MATHS3D_TARGET("avx2,fma")
+void Vector4f_AVX2TransformStreamGeneric(float* outputStream, const float* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  // The rows of the transform matrix duplicated in to both lanes. The broadcast does not require alignment.
+  const __m256 R0 = _mm256_broadcast_ps((const __m128*)transform.row[0].v);
+  const __m256 R1 = _mm256_broadcast_ps((const __m128*)transform.row[1].v);
+  const __m256 R2 = _mm256_broadcast_ps((const __m128*)transform.row[2].v);
+  const __m256 R3 = _mm256_broadcast_ps((const __m128*)transform.row[3].v);
+  const unsigned prefetchEnd = Stream_PrefetchEnd(count, inputStep, 256);
+  unsigned i = 0;
+  for (; i + 2 <= count; i += 2)
+  {
+    if (i < prefetchEnd)
+    {
+      _mm_prefetch((const char*)&inputStream[256], _MM_HINT_T0);
+    }
+    __m256 vals;
+    if (inputStep == 4)
+    {
+      // The input is only promised to be 128-bit aligned, so can't use the aligned 256-bit load here
+      vals = _mm256_loadu_ps(inputStream);
+    }
+    else
+    {
+      __m128 lo = alignedInput ? _mm_load_ps(inputStream) : _mm_loadu_ps(inputStream);
+      __m128 hi = alignedInput ? _mm_load_ps(inputStream + inputStep) : _mm_loadu_ps(inputStream + inputStep);
+      vals = _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+    }
+    // The permutes are within each 128-bit lane, so each lane gets the x,y,z of its own vector.
+    __m256 X = _mm256_permute_ps(vals, _MM_SHUFFLE(0,0,0,0));
+    __m256 Y = _mm256_permute_ps(vals, _MM_SHUFFLE(1,1,1,1));
+    __m256 Z = _mm256_permute_ps(vals, _MM_SHUFFLE(2,2,2,2));
+    Z = (translate) ? _mm256_fmadd_ps(Z,R2,R3) : _mm256_mul_ps(Z,R2);
+    Z = _mm256_fmadd_ps(Y,R1,Z);
+    Z = _mm256_fmadd_ps(X,R0,Z);
+    if (divideByW)
+    {
+      Z = Vector4f_AVX2DivideByW<precision>(Z);
+    }
+    if (alignedOutput)
+    {
+      // Only 128-bit alignment is promised, so stream out each half
+      _mm_stream_ps(outputStream, _mm256_castps256_ps128(Z));
+      _mm_stream_ps(outputStream + outputStep, _mm256_extractf128_ps(Z, 1));
+    }
+    else if (outputStep == 4)
+    {
+      _mm256_storeu_ps(outputStream, Z);
+    }
+    else
+    {
+      _mm_storeu_ps(outputStream, _mm256_castps256_ps128(Z));
+      _mm_storeu_ps(outputStream + outputStep, _mm256_extractf128_ps(Z, 1));
+    }
+    inputStream  += 2 * inputStep;
+    outputStream += 2 * outputStep;
+  }
+  if (i < count)
+  {
+    __m128 vals = alignedInput ? _mm_load_ps(inputStream) : _mm_loadu_ps(inputStream);
     __m128 Z = _mm_shuffle_ps(vals,vals,_MM_SHUFFLE(2,2,2,2));
-    // We multiply Z with R2, so Z = z*R2[0], z*R2[1], z*R2[2], z*R2[3]
-    Z = _mm_mul_ps(Z,R2);
-    if (translate)
+    Z = (translate) ? _mm_fmadd_ps(Z,_mm256_castps256_ps128(R2),_mm256_castps256_ps128(R3))
+                    : _mm_mul_ps(Z,_mm256_castps256_ps128(R2));
+    Z = _mm_fmadd_ps(_mm_shuffle_ps(vals,vals,_MM_SHUFFLE(1,1,1,1)),_mm256_castps256_ps128(R1),Z);
+    Z = _mm_fmadd_ps(_mm_shuffle_ps(vals,vals,_MM_SHUFFLE(0,0,0,0)),_mm256_castps256_ps128(R0),Z);
+    if (divideByW)
+    {
+      Z = Vector4f_AVX2DivideByW<precision>(Z);
+    }
+    if (alignedOutput)
+    {
+      _mm_stream_ps(outputStream,Z);
+    }
+    else
+    {
+      _mm_storeu_ps(outputStream,Z);
+    }
+  }
+}
+
+/// Transforms arrays of vectors by the transform matrix (AVX-512 implementation).
+/// Four vectors are transformed per iteration by broadcasting the rows of the transform matrix to all four
+/// 128-bit lanes of the 512-bit registers, using fused multiply+add. Up to three trailing vectors are transformed
+/// using the 128-bit form of the same instructions.
+/// The template parameters and parameters are the same as for Vector4f_SSETransformStreamGeneric.
+/// \note must only be called if the CPU supports AVX-512F. \see InstructionSet_IsSupported
+/// \see Vector4f_SSETransformStreamGeneric
+#if defined(__GNUC__) && !defined(__clang__)
+// Some versions of GCC give false uninitialized warnings from the AVX-512 intrinsics (GCC bug 105593)
+#  pragma GCC diagnostic push
+#  pragma GCC diagnostic ignored "-Wuninitialized"
+#  pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+template <bool translate, bool divideByW, bool alignedOutput, int outputStep, bool alignedInput, int inputStep, Precision precision = Precision::Exact>
+MATHS3D_TARGET("avx512f,avx2,fma")
+void Vector4f_AVX512TransformStreamGeneric(float* outputStream, const float* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  const __m128 r0 = _mm_loadu_ps(transform.row[0].v);
+  const __m128 r1 = _mm_loadu_ps(transform.row[1].v);
+  const __m128 r2 = _mm_loadu_ps(transform.row[2].v);
+  const __m128 r3 = _mm_loadu_ps(transform.row[3].v);
+  const __m512 R0 = _mm512_broadcast_f32x4(r0);
+  const __m512 R1 = _mm512_broadcast_f32x4(r1);
+  const __m512 R2 = _mm512_broadcast_f32x4(r2);
+  const __m512 R3 = _mm512_broadcast_f32x4(r3);
+  const unsigned prefetchEnd = Stream_PrefetchEnd(count, inputStep, 256);
+  unsigned i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    if (i < prefetchEnd)
+    {
+      _mm_prefetch((const char*)&inputStream[256], _MM_HINT_T0);
+    }
+    __m512 vals;
+    if (inputStep == 4)
     {
-      // We add R3, so Z = R3[0]+z*R2[0], R3[1]+z*R2[1], R3[2]+z*R2[2], R3[3]+z*R2[3]
-      Z = _mm_add_ps(Z,R3);
-    }
-    // We multiply Y with R1, so Y = y*R1[0], ...
-    Y = _mm_mul_ps(Y,R1);
-    // We add Y to Z, so Z = R3[0]+z*R2[0]+y*R1[0] ...
-    Z = _mm_add_ps(Z,Y);
-    
-    // TODO: add optional AVX2 optimizations
-    //_mm_fmadd_ps()   // fused multiply+add instruction if have AVX2
-
-    // We multiply X with R0, so X = x*R0[0], ...
-    X = _mm_mul_ps(X,R0);
-    // We add X to Z, so Z = R3[0] + z*R2[0] + y*R1[0] + x*R0[0], ...
-    Z = _mm_add_ps(Z,X);
-    // Z now contains our transformed point. For perspective transforms, we need to divide by W.
+      vals = _mm512_loadu_ps(inputStream);
+    }
+    else
+    {
+      vals = _mm512_castps128_ps512(alignedInput ? _mm_load_ps(inputStream) : _mm_loadu_ps(inputStream));
+      vals = _mm512_insertf32x4(vals, alignedInput ? _mm_load_ps(inputStream + 1*inputStep) : _mm_loadu_ps(inputStream + 1*inputStep), 1);
+      vals = _mm512_insertf32x4(vals, alignedInput ? _mm_load_ps(inputStream + 2*inputStep) : _mm_loadu_ps(inputStream + 2*inputStep), 2);
+      vals = _mm512_insertf32x4(vals, alignedInput ? _mm_load_ps(inputStream + 3*inputStep) : _mm_loadu_ps(inputStream + 3*inputStep), 3);
+    }
+    __m512 X = _mm512_permute_ps(vals, _MM_SHUFFLE(0,0,0,0));
+    __m512 Y = _mm512_permute_ps(vals, _MM_SHUFFLE(1,1,1,1));
+    __m512 Z = _mm512_permute_ps(vals, _MM_SHUFFLE(2,2,2,2));
+    Z = (translate) ? _mm512_fmadd_ps(Z,R2,R3) : _mm512_mul_ps(Z,R2);
+    Z = _mm512_fmadd_ps(Y,R1,Z);
+    Z = _mm512_fmadd_ps(X,R0,Z);
     if (divideByW)
     {
-      Z = _mm_div_ps(Z,_mm_shuffle_ps(Z,Z,_MM_SHUFFLE(3,3,3,3)));
+      Z = Vector4f_AVX512DivideByW<precision>(Z);
     }
     if (alignedOutput)
     {
-      _mm_stream_ps(outputStream,Z); // aligned and cache friendly
+      _mm_stream_ps(outputStream + 0*outputStep, _mm512_castps512_ps128(Z));
+      _mm_stream_ps(outputStream + 1*outputStep, _mm512_extractf32x4_ps(Z, 1));
+      _mm_stream_ps(outputStream + 2*outputStep, _mm512_extractf32x4_ps(Z, 2));
+      _mm_stream_ps(outputStream + 3*outputStep, _mm512_extractf32x4_ps(Z, 3));
+    }
+    else if (outputStep == 4)
+    {
+      _mm512_storeu_ps(outputStream, Z);
     }
     else
     {
-      _mm_storeu_ps(outputStream,Z); // unaligned store
+      _mm_storeu_ps(outputStream + 0*outputStep, _mm512_castps512_ps128(Z));
+      _mm_storeu_ps(outputStream + 1*outputStep, _mm512_extractf32x4_ps(Z, 1));
+      _mm_storeu_ps(outputStream + 2*outputStep, _mm512_extractf32x4_ps(Z, 2));
+      _mm_storeu_ps(outputStream + 3*outputStep, _mm512_extractf32x4_ps(Z, 3));
+    }
+    inputStream  += 4 * inputStep;
+    outputStream += 4 * outputStep;
+  }
+  for (; i < count; ++i)
+  {
+    __m128 vals = alignedInput ? _mm_load_ps(inputStream) : _mm_loadu_ps(inputStream);
+    __m128 Z = _mm_shuffle_ps(vals,vals,_MM_SHUFFLE(2,2,2,2));
+    Z = (translate) ? _mm_fmadd_ps(Z,r2,r3) : _mm_mul_ps(Z,r2);
+    Z = _mm_fmadd_ps(_mm_shuffle_ps(vals,vals,_MM_SHUFFLE(1,1,1,1)),r1,Z);
+    Z = _mm_fmadd_ps(_mm_shuffle_ps(vals,vals,_MM_SHUFFLE(0,0,0,0)),r0,Z);
+    if (divideByW)
+    {
+      Z = Vector4f_AVX2DivideByW<precision>(Z);
+    }
+    if (alignedOutput)
+    {
+      _mm_stream_ps(outputStream,Z);
+    }
+    else
+    {
+      _mm_storeu_ps(outputStream,Z);
     }
     inputStream  += inputStep;
     outputStream += outputStep;
   }
 }
 
-/// Transforms arrays of vectors by the transform matrix (non-SSE fallback implementation, untested). 
+#if defined(__GNUC__) && !defined(__clang__)
+#  pragma GCC diagnostic pop
+#endif
+
+#endif // MATHS3D_X86
+
+/// Transforms arrays of vectors by the transform matrix (non-SSE fallback implementation).
 /// \tparam translate is a bool to enable or disable applying the translation component of the transform.
 /// \tparam divideByW is a bool to enable or disable applying perspective by dividing by W.
+/// \tparam precision is the accuracy of the reciprocal of W when dividing by it, Exact by default. \see Precision
 /// \tparam alignedOutput is ignored
 /// \tparam outputStep is the width in floats to the next vector element of the outputStream array.
 ///         This allows the outputStream array to be an array of structures of which the vector is a member.
@@ -173,7 +633,7 @@ void Vector4f_SSETransformStreamGeneric(float* outputStream, const float* inputS
 /// \param inputStream is the input array of vectors to apply the transform to.
 /// \param count is the number of vectors to transform.
 /// \param transform is the matrix to apply.
-template <bool translate, bool divideByW, bool alignedOutput, int outputStep, bool alignedInput, int inputStep>
+template <bool translate, bool divideByW, bool alignedOutput, int outputStep, bool alignedInput, int inputStep, Precision precision = Precision::Exact>
 void Vector4f_TransformStreamGeneric(float* outputStream, const float* inputStream, unsigned count, const Matrix4x4f& transform)
 {
   for (unsigned i = 0; i < count; ++i)
@@ -192,14 +652,4981 @@ void Vector4f_TransformStreamGeneric(float* outputStream, const float* inputStre
     Z = Vector4f_Add(Z, Vector4f_Multiply(transform.row[0], Vector4f_Replicate(inputStream[0]))); // x
     if (divideByW)
     {
-      Z = Vector4f_Multiply(Z, Vector4f_Replicate(Scalar1f_One() / Z.w));
+      Z = Vector4f_Scaled(Z, Scalar1f_Reciprocal<precision>(Z.w));
+    }
+    // The output is only required to be 32-bit aligned, so this is copied a component at a time
+    for (int j = 0; j < 4; ++j)
+    {
+      outputStream[j] = Z.v[j];
     }
-    *(Vector4f*)outputStream = Z;
     inputStream  += inputStep;
     outputStream += outputStep;
   }
 }
 
+
+/// Transforms arrays of vectors by the transform matrix where the distance between the vectors is only known at runtime.
+/// \tparam translate is a bool to enable or disable applying the translation component of the transform.
+/// \tparam divideByW is a bool to enable or disable applying perspective by dividing by W.
+/// \tparam precision is the accuracy of the reciprocal of W when dividing by it, Exact by default. \see Precision
+/// \param outputStream is the output buffer to put the transformed vectors to.
+/// \param outputStride is the width in floats to the next vector element of the outputStream array.
+/// \param inputStream is the input array of vectors to apply the transform to.
+/// \param inputStride is the width in floats to the next vector element of the inputStream array.
+/// \param count is the number of vectors to transform.
+/// \param transform is the matrix to apply.
+template <bool translate, bool divideByW, Precision precision = Precision::Exact>
+void Vector4f_TransformStreamStrided(float* outputStream, unsigned outputStride, const float* inputStream, unsigned inputStride, unsigned count, const Matrix4x4f& transform)
+{
+#if MATHS3D_X86
+  const __m128 R0 = _mm_loadu_ps(transform.row[0].v);
+  const __m128 R1 = _mm_loadu_ps(transform.row[1].v);
+  const __m128 R2 = _mm_loadu_ps(transform.row[2].v);
+  const __m128 R3 = _mm_loadu_ps(transform.row[3].v);
+  const unsigned prefetchEnd = Stream_PrefetchEnd(count, inputStride, 256);
+  for (unsigned i = 0; i < count; ++i)
+  {
+    if (i < prefetchEnd)
+    {
+      _mm_prefetch((const char*)&inputStream[256], _MM_HINT_T0);
+    }
+    _mm_storeu_ps(outputStream, Vector4f_SSETransformVector<translate,divideByW,precision>(_mm_loadu_ps(inputStream), R0, R1, R2, R3));
+    inputStream  += inputStride;
+    outputStream += outputStride;
+  }
+#else
+  for (unsigned i = 0; i < count; ++i)
+  {
+    Vector4f_TransformStreamGeneric<translate,divideByW,false,4,false,4,precision>(outputStream, inputStream, 1, transform);
+    inputStream  += inputStride;
+    outputStream += outputStride;
+  }
+#endif
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// CPU feature detection and dispatch
+
+/// The tiers of instruction set that there are implementations of the stream kernels for.
+/// These are ordered so that each tier is a superset of the previous.
+enum class InstructionSet
+{
+  Scalar,     /// The plain C++ fallback implementations.
+  SSE,        /// The SSE and SSE2 implementations.
+  AVX2,       /// The AVX2 and FMA implementations.
+  AVX512,     /// The AVX-512F implementations.
+};
+
+/// The CPU features that are relevant to choosing which implementation of a kernel to use.
+/// The AVX features are only set if the OS also saves the wider registers on a context switch.
+struct CpuFeatures
+{
+  bool sse2;
+  bool sse41;
+  bool avx;
+  bool avx2;
+  bool fma;
+  bool f16c;
+  bool avx512f;
+};
+
+/// Queries the CPU with cpuid for the features it supports. Prefer CpuFeatures_Get which caches this.
+inline CpuFeatures CpuFeatures_Detect()
+{
+  CpuFeatures features = { false, false, false, false, false, false, false };
+#if MATHS3D_X86
+  unsigned regs1[4] = { 0, 0, 0, 0 }; // eax, ebx, ecx, edx
+  unsigned regs7[4] = { 0, 0, 0, 0 };
+  unsigned long long xcr0 = 0;
+#  if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  const int maxLeaf = info[0];
+  __cpuid(info, 1);
+  for (int i = 0; i < 4; ++i)
+    regs1[i] = info[i];
+  if (maxLeaf >= 7)
+  {
+    __cpuidex(info, 7, 0);
+    for (int i = 0; i < 4; ++i)
+      regs7[i] = info[i];
+  }
+  if (regs1[2] & (1u << 27))
+    xcr0 = _xgetbv(0);
+#  else
+  const unsigned maxLeaf = __get_cpuid_max(0, nullptr);
+  __get_cpuid(1, &regs1[0], &regs1[1], &regs1[2], &regs1[3]);
+  if (maxLeaf >= 7)
+    __cpuid_count(7, 0, regs7[0], regs7[1], regs7[2], regs7[3]);
+  if (regs1[2] & (1u << 27))
+  {
+    unsigned lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    xcr0 = ((unsigned long long)hi << 32) | lo;
+  }
+#  endif
+  const bool osAVX = (xcr0 & 0x06) == 0x06;          // XMM and YMM state
+  const bool osAVX512 = (xcr0 & 0xE6) == 0xE6;       // and also the opmask and ZMM state
+  features.sse2    = (regs1[3] & (1u << 26)) != 0;
+  features.sse41   = (regs1[2] & (1u << 19)) != 0;
+  features.avx     = (regs1[2] & (1u << 28)) != 0 && osAVX;
+  features.fma     = (regs1[2] & (1u << 12)) != 0 && osAVX;
+  features.f16c    = (regs1[2] & (1u << 29)) != 0 && osAVX;
+  features.avx2    = (regs7[1] & (1u << 5))  != 0 && osAVX;
+  features.avx512f = (regs7[1] & (1u << 16)) != 0 && osAVX512;
+#endif
+  return features;
+}
+
+/// Returns the features of the CPU. These are only detected the first time this is called.
+inline const CpuFeatures& CpuFeatures_Get()
+{
+  static const CpuFeatures features = CpuFeatures_Detect();
+  return features;
+}
+
+/// Returns true if there are implementations for the given instruction set and the CPU supports it.
+inline bool InstructionSet_IsSupported(InstructionSet isa)
+{
+  const CpuFeatures& features = CpuFeatures_Get();
+  switch (isa)
+  {
+    case InstructionSet::Scalar:  return true;
+    case InstructionSet::SSE:     return MATHS3D_X86 && features.sse2;
+    case InstructionSet::AVX2:    return MATHS3D_X86 && features.avx2 && features.fma;
+    case InstructionSet::AVX512:  return MATHS3D_X86 && features.avx512f && features.avx2 && features.fma;
+  }
+  return false;
+}
+
+/// Returns the name of the instruction set, which is the same as used by the MATHS3D_ISA environment variable.
+inline const char* InstructionSet_Name(InstructionSet isa)
+{
+  const char* names[] = { "scalar", "sse", "avx2", "avx512" };
+  return names[int(isa)];
+}
+
+/// Returns the best instruction set which the CPU supports, limited to the tier named by the MATHS3D_ISA
+/// environment variable if that is set. If the tier asked for is not supported, the next lower tier is used.
+inline InstructionSet InstructionSet_Detect()
+{
+  InstructionSet best = InstructionSet::AVX512;
+  const char* forced = ::getenv("MATHS3D_ISA");
+  if (forced)
+  {
+    for (int i = 0; i <= int(InstructionSet::AVX512); ++i)
+    {
+      if (::strcmp(forced, InstructionSet_Name(InstructionSet(i))) == 0)
+      {
+        best = InstructionSet(i);
+      }
+    }
+  }
+  while (!InstructionSet_IsSupported(best))
+  {
+    best = InstructionSet(int(best) - 1);
+  }
+  return best;
+}
+
+/// Returns the instruction set that the dispatched kernels use. This is decided only once, the first time
+/// this is called, so the MATHS3D_ISA environment variable needs to be set before the process starts.
+inline InstructionSet InstructionSet_Active()
+{
+  static const InstructionSet active = InstructionSet_Detect();
+  return active;
+}
+
+/// Function pointer type for the implementations of the stream transforms.
+using Vector4f_TransformStreamFunc = void (*)(float* outputStream, const float* inputStream, unsigned count, const Matrix4x4f& transform);
+
+/// Returns the implementation of the stream transform with the given template switches for the given instruction set.
+/// \see Vector4f_SSETransformStreamGeneric for a description of the template parameters.
+template <bool translate, bool divideByW, bool alignedOutput, int outputStep, bool alignedInput, int inputStep, Precision precision = Precision::Exact>
+Vector4f_TransformStreamFunc Vector4f_SelectTransformStream(InstructionSet isa)
+{
+  switch (isa)
+  {
+#if MATHS3D_X86
+    case InstructionSet::AVX512:
+      return &Vector4f_AVX512TransformStreamGeneric<translate,divideByW,alignedOutput,outputStep,alignedInput,inputStep,precision>;
+    case InstructionSet::AVX2:
+      return &Vector4f_AVX2TransformStreamGeneric<translate,divideByW,alignedOutput,outputStep,alignedInput,inputStep,precision>;
+    case InstructionSet::SSE:
+      return &Vector4f_SSETransformStreamGeneric<translate,divideByW,alignedOutput,outputStep,alignedInput,inputStep,precision>;
+#endif
+    default:
+      return &Vector4f_TransformStreamGeneric<translate,divideByW,alignedOutput,outputStep,alignedInput,inputStep,precision>;
+  }
+}
+
+/// Transforms arrays of vectors by the transform matrix using the best implementation for the CPU.
+/// The implementation is bound to a function pointer on the first call. \see InstructionSet_Active
+/// \see Vector4f_SSETransformStreamGeneric for a description of the template parameters and parameters.
+template <bool translate, bool divideByW, bool alignedOutput, int outputStep, bool alignedInput, int inputStep, Precision precision = Precision::Exact>
+void Vector4f_DispatchTransformStreamGeneric(float* outputStream, const float* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  static const Vector4f_TransformStreamFunc kernel =
+      Vector4f_SelectTransformStream<translate,divideByW,alignedOutput,outputStep,alignedInput,inputStep,precision>(InstructionSet_Active());
+  kernel(outputStream, inputStream, count, transform);
+}
+
+/// Specialization of Vector4f_DispatchTransformStreamGeneric for transforming an array of vectors without applying perspective.
+/// \see Vector4f_SSETransformStream
+template <size_t N>
+void Vector4f_TransformStream(Vector4f (&outputStream)[N], const Vector4f (&inputStream)[N], const Matrix4x4f& transform)
+{
+  Vector4f_DispatchTransformStreamGeneric<true,false,false,4,false,4>((float*)outputStream, (float*)inputStream, N, transform);
+}
+
+/// Specialization of Vector4f_DispatchTransformStreamGeneric for transforming an array of vectors with perspective.
+/// \see Vector4f_SSETransformCoordStream
+template <size_t N>
+void Vector4f_TransformCoordStream(Vector4f (&outputStream)[N], const Vector4f (&inputStream)[N], const Matrix4x4f& transform)
+{
+  Vector4f_DispatchTransformStreamGeneric<true,true,false,4,false,4>((float*)outputStream, (float*)inputStream, N, transform);
+}
+
+/// Specialization of Vector4f_DispatchTransformStreamGeneric for transforming an array of normal vectors.
+/// \see Vector4f_SSETransformNormalStream
+template <size_t N>
+void Vector4f_TransformNormalStream(Vector4f (&outputStream)[N], const Vector4f (&inputStream)[N], const Matrix4x4f& transform)
+{
+  Vector4f_DispatchTransformStreamGeneric<false,false,false,4,false,4>((float*)outputStream, (float*)inputStream, N, transform);
+}
+
+/// Specialization of Vector4f_DispatchTransformStreamGeneric for transforming an array of vectors without applying perspective
+/// where the arrays of vectors have been prepared to be aligned to a 128-bit boundary.
+/// \see Vector4f_SSETransformStreamAligned
+template <size_t N>
+void Vector4f_TransformStreamAligned(Vector4f (&outputStream)[N], const Vector4f (&inputStream)[N], const Matrix4x4f& transform)
+{
+  Vector4f_DispatchTransformStreamGeneric<true,false,true,4,true,4>((float*)outputStream, (float*)inputStream, N, transform);
+}
+
+/// Specialization of Vector4f_DispatchTransformStreamGeneric for transforming an array of vectors with perspective
+/// where the arrays of vectors have been prepared to be aligned to a 128-bit boundary.
+/// \see Vector4f_SSETransformCoordStreamAligned
+template <size_t N>
+void Vector4f_TransformCoordStreamAligned(Vector4f (&outputStream)[N], const Vector4f (&inputStream)[N], const Matrix4x4f& transform)
+{
+  Vector4f_DispatchTransformStreamGeneric<true,true,true,4,true,4>((float*)outputStream, (float*)inputStream, N, transform);
+}
+
+/// Specialization of Vector4f_DispatchTransformStreamGeneric for transforming an array of normal vectors
+/// where the arrays of vectors have been prepared to be aligned to a 128-bit boundary.
+/// \see Vector4f_SSETransformNormalStreamAligned
+template <size_t N>
+void Vector4f_TransformNormalStreamAligned(Vector4f (&outputStream)[N], const Vector4f (&inputStream)[N], const Matrix4x4f& transform)
+{
+  Vector4f_DispatchTransformStreamGeneric<false,false,true,4,true,4>((float*)outputStream, (float*)inputStream, N, transform);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// Runtime sized stream transforms
+
+/// Transforms count contiguous vectors, splitting the stream so that the bulk of it can use the aligned streaming
+/// stores. Streaming stores only pay off when whole cache lines are written, so the vectors before the first 64-byte
+/// boundary of the output and the partial cache line at the end are peeled off and transformed with regular stores.
+/// If the output isn't 128-bit aligned then no amount of peeling can align it, so regular stores are used throughout.
+/// \see Vector4f_TransformStreamStrided for a description of the parameters.
+template <bool translate, bool divideByW, Precision precision = Precision::Exact>
+void Vector4f_TransformStreamPeeled(float* outputStream, const float* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  const unsigned cacheLineVectors = 4;
+  const bool alignedInput = ((uintptr_t)inputStream & 15) == 0;
+  unsigned head = count;
+  unsigned tail = 0;
+  if (((uintptr_t)outputStream & 15) == 0)
+  {
+    head = unsigned((64 - ((uintptr_t)outputStream & 63)) & 63) / 16;
+    head = (head < count) ? head : count;
+    tail = (count - head) % cacheLineVectors;
+  }
+  const unsigned bulk = count - head - tail;
+  if (alignedInput)
+  {
+    Vector4f_DispatchTransformStreamGeneric<translate,divideByW,false,4,true,4,precision>(outputStream, inputStream, head, transform);
+    Vector4f_DispatchTransformStreamGeneric<translate,divideByW,true,4,true,4,precision>(outputStream + 4*head, inputStream + 4*head, bulk, transform);
+  }
+  else
+  {
+    Vector4f_DispatchTransformStreamGeneric<translate,divideByW,false,4,false,4,precision>(outputStream, inputStream, head, transform);
+    Vector4f_DispatchTransformStreamGeneric<translate,divideByW,true,4,false,4,precision>(outputStream + 4*head, inputStream + 4*head, bulk, transform);
+  }
+  Vector4f_DispatchTransformStreamGeneric<translate,divideByW,false,4,false,4,precision>(outputStream + 4*(head+bulk), inputStream + 4*(head+bulk), tail, transform);
+#if MATHS3D_X86
+  if (bulk)
+  {
+    // Streaming stores are weakly ordered, so make them visible before returning.
+    _mm_sfence();
+  }
+#endif
+}
+
+/// Transforms count vectors where the count and the distance between the vectors are only known at runtime.
+/// Contiguous streams of Vector4f are transformed with the dispatched kernels. \see Vector4f_TransformStreamPeeled
+/// \see Vector4f_TransformStreamStrided for a description of the template parameters and parameters.
+template <bool translate, bool divideByW, Precision precision = Precision::Exact>
+void Vector4f_TransformStreamRuntime(float* outputStream, unsigned outputStride, const float* inputStream, unsigned inputStride, unsigned count, const Matrix4x4f& transform)
+{
+  if (outputStride == 4 && inputStride == 4)
+  {
+    Vector4f_TransformStreamPeeled<translate,divideByW,precision>(outputStream, inputStream, count, transform);
+  }
+  else
+  {
+    Vector4f_TransformStreamStrided<translate,divideByW,precision>(outputStream, outputStride, inputStream, inputStride, count, transform);
+  }
+}
+
+/// Transforms an array of count vectors without applying perspective. \see Vector4f_TransformStream
+inline void Vector4f_TransformStream(Vector4f* outputStream, const Vector4f* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  Vector4f_TransformStreamRuntime<true,false>(outputStream->v, 4, inputStream->v, 4, count, transform);
+}
+
+/// Transforms an array of count vectors with perspective, dividing by w with the given precision.
+/// \see Vector4f_TransformCoordStream
+template <Precision precision = Precision::Exact>
+void Vector4f_TransformCoordStream(Vector4f* outputStream, const Vector4f* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  Vector4f_TransformStreamRuntime<true,true,precision>(outputStream->v, 4, inputStream->v, 4, count, transform);
+}
+
+/// Transforms an array of count normal vectors. \see Vector4f_TransformNormalStream
+inline void Vector4f_TransformNormalStream(Vector4f* outputStream, const Vector4f* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  Vector4f_TransformStreamRuntime<false,false>(outputStream->v, 4, inputStream->v, 4, count, transform);
+}
+
+/// Transforms count vectors without applying perspective, where the vectors are members of structures
+/// which are outputStride and inputStride floats apart. \see Vector4f_TransformStreamRuntime
+inline void Vector4f_TransformStream(float* outputStream, unsigned outputStride, const float* inputStream, unsigned inputStride, unsigned count, const Matrix4x4f& transform)
+{
+  Vector4f_TransformStreamRuntime<true,false>(outputStream, outputStride, inputStream, inputStride, count, transform);
+}
+
+/// Transforms count vectors with perspective, dividing by w with the given precision, where the vectors are members
+/// of structures which are outputStride and inputStride floats apart. \see Vector4f_TransformStreamRuntime
+template <Precision precision = Precision::Exact>
+void Vector4f_TransformCoordStream(float* outputStream, unsigned outputStride, const float* inputStream, unsigned inputStride, unsigned count, const Matrix4x4f& transform)
+{
+  Vector4f_TransformStreamRuntime<true,true,precision>(outputStream, outputStride, inputStream, inputStride, count, transform);
+}
+
+/// Transforms count normal vectors, where the vectors are members of structures
+/// which are outputStride and inputStride floats apart. \see Vector4f_TransformStreamRuntime
+inline void Vector4f_TransformNormalStream(float* outputStream, unsigned outputStride, const float* inputStream, unsigned inputStride, unsigned count, const Matrix4x4f& transform)
+{
+  Vector4f_TransformStreamRuntime<false,false>(outputStream, outputStride, inputStream, inputStride, count, transform);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// Parallel stream transforms
+
+/// A job which is split in to chunks which are processed by the calling thread and the workers of a WorkerPool.
+struct ParallelJob
+{
+  void (*func)(void* context, unsigned chunk);  /// Processes one chunk of the job.
+  void* context;                                /// Passed to func.
+  unsigned chunkCount;                          /// The number of chunks in the job.
+  unsigned maxWorkers;                          /// The most workers (not counting the calling thread) to use.
+  std::atomic<unsigned> nextChunk;              /// The next chunk to be claimed.
+};
+
+/// A pool of worker threads which are created once and then reused for each parallel job, so that threads are not
+/// spawned for each call. Only one job runs at a time, jobs submitted from other threads wait their turn.
+struct WorkerPool
+{
+  std::vector<std::thread> threads;
+  std::mutex               mutex;             /// Protects job, generation, busy and quit.
+  std::mutex               submitMutex;       /// Serializes submitting jobs.
+  std::condition_variable  wake;              /// Signalled when there is a new job or to quit.
+  std::condition_variable  done;              /// Signalled when the last busy worker finishes.
+  ParallelJob*             job;
+  unsigned                 generation;
+  unsigned                 busy;
+  bool                     quit;
+
+  ~WorkerPool();
+};
+
+/// Returns true if the current thread is one of the WorkerPool threads.
+inline bool& WorkerPool_IsWorkerThread()
+{
+  static thread_local bool isWorker = false;
+  return isWorker;
+}
+
+/// Claims and processes chunks of the job until there are none left.
+inline void ParallelJob_Work(ParallelJob& job)
+{
+  for (unsigned chunk = job.nextChunk++; chunk < job.chunkCount; chunk = job.nextChunk++)
+  {
+    job.func(job.context, chunk);
+  }
+}
+
+/// The function each of the worker threads runs, waiting for and then helping with each job.
+inline void WorkerPool_WorkerMain(WorkerPool& pool)
+{
+  WorkerPool_IsWorkerThread() = true;
+  unsigned seen = 0;
+  for (;;)
+  {
+    ParallelJob* job;
+    {
+      std::unique_lock<std::mutex> lock(pool.mutex);
+      pool.wake.wait(lock, [&]{ return pool.quit || pool.generation != seen; });
+      if (pool.quit)
+      {
+        return;
+      }
+      seen = pool.generation;
+      job = pool.job;
+      if (!job || pool.busy >= job->maxWorkers)
+      {
+        continue;
+      }
+      ++pool.busy;
+    }
+    ParallelJob_Work(*job);
+    {
+      std::unique_lock<std::mutex> lock(pool.mutex);
+      if (--pool.busy == 0)
+      {
+        pool.done.notify_all();
+      }
+    }
+  }
+}
+
+inline WorkerPool::~WorkerPool()
+{
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    quit = true;
+  }
+  wake.notify_all();
+  for (std::thread& thread : threads)
+  {
+    thread.join();
+  }
+}
+
+/// Returns the shared worker pool. It is created on first use with one less worker than the number of hardware
+/// threads, as the thread submitting a job also works on it.
+inline WorkerPool& WorkerPool_Get()
+{
+  static WorkerPool pool;
+  static std::once_flag started;
+  std::call_once(started, []
+  {
+    pool.job = nullptr;
+    pool.generation = 0;
+    pool.busy = 0;
+    pool.quit = false;
+    const unsigned hardwareThreads = std::thread::hardware_concurrency();
+    for (unsigned i = 1; i < hardwareThreads; ++i)
+    {
+      pool.threads.push_back(std::thread(WorkerPool_WorkerMain, std::ref(pool)));
+    }
+  });
+  return pool;
+}
+
+/// Calls func(context, chunk) for each chunk from 0 to chunkCount-1, using the calling thread and up to
+/// maxThreads-1 of the worker threads. If called from within a job, the chunks are processed serially.
+inline void WorkerPool_ParallelFor(unsigned chunkCount, unsigned maxThreads, void (*func)(void* context, unsigned chunk), void* context)
+{
+  ParallelJob job;
+  job.func = func;
+  job.context = context;
+  job.chunkCount = chunkCount;
+  job.maxWorkers = (maxThreads > 0) ? maxThreads - 1 : 0;
+  job.nextChunk = 0;
+  if (WorkerPool_IsWorkerThread() || job.maxWorkers == 0 || chunkCount < 2)
+  {
+    ParallelJob_Work(job);
+    return;
+  }
+  WorkerPool& pool = WorkerPool_Get();
+  std::unique_lock<std::mutex> submitLock(pool.submitMutex);
+  {
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    pool.job = &job;
+    ++pool.generation;
+  }
+  pool.wake.notify_all();
+  ParallelJob_Work(job);
+  // All the chunks have been claimed, so wait for the workers still processing theirs, and then make sure
+  // no late waking worker can pick up the job after it goes out of scope.
+  std::unique_lock<std::mutex> lock(pool.mutex);
+  pool.done.wait(lock, [&]{ return pool.busy == 0; });
+  pool.job = nullptr;
+}
+
+/// Settings which control how Vector4f_ParallelTransformStreamGeneric splits up the work.
+struct ParallelConfig
+{
+  unsigned serialThreshold;   /// Streams with fewer vectors than this are transformed on the calling thread.
+  unsigned chunkBytes;        /// The approximate size of the input of each chunk, chosen to fit in the L1 cache.
+  unsigned maxThreads;        /// The most threads to use including the calling thread. 0 means all of them.
+};
+
+/// Returns the default settings for the parallel stream transforms. A job has an overhead of a few microseconds
+/// to wake the workers, so the threshold is set so each stream is at least a few times larger than that.
+inline ParallelConfig ParallelConfig_Default()
+{
+  return ParallelConfig{ 32768, 16384, 0 };
+}
+
+/// Returns the number of elements of elementBytes each in a chunk with the settings in config. Chunks are a multiple
+/// of 16 elements, so that each chunk starts on a cache line if the array does, and are at least 16 elements even
+/// when config.chunkBytes is smaller than one element.
+inline unsigned ParallelConfig_ChunkSize(const ParallelConfig& config, size_t elementBytes)
+{
+  const unsigned chunkSize = (unsigned(config.chunkBytes / elementBytes) + 15) & ~15u;
+  return (chunkSize) ? chunkSize : 16;
+}
+
+/// The context passed to each of the chunks of Vector4f_ParallelTransformStreamGeneric.
+struct ParallelTransformContext
+{
+  float*            outputStream;
+  const float*      inputStream;
+  unsigned          count;
+  unsigned          chunkSize;
+  const Matrix4x4f* transform;
+};
+
+/// Transforms one chunk of the stream for Vector4f_ParallelTransformStreamGeneric.
+template <bool translate, bool divideByW, bool alignedOutput, int outputStep, bool alignedInput, int inputStep, Precision precision = Precision::Exact>
+void Vector4f_ParallelTransformChunk(void* context, unsigned chunk)
+{
+  const ParallelTransformContext& ctx = *(const ParallelTransformContext*)context;
+  const unsigned start = chunk * ctx.chunkSize;
+  const unsigned count = (ctx.count - start < ctx.chunkSize) ? ctx.count - start : ctx.chunkSize;
+  Vector4f_DispatchTransformStreamGeneric<translate,divideByW,alignedOutput,outputStep,alignedInput,inputStep,precision>(
+      ctx.outputStream + size_t(start) * outputStep, ctx.inputStream + size_t(start) * inputStep, count, *ctx.transform);
+#if MATHS3D_X86
+  if (alignedOutput)
+  {
+    // Make the streaming stores visible before the chunk is reported as done.
+    _mm_sfence();
+  }
+#endif
+}
+
+/// Transforms arrays of vectors by the transform matrix, split in to cache sized chunks which are shared out to
+/// the threads of the WorkerPool. Each chunk is transformed with the dispatched kernel for the CPU.
+/// Streams smaller than config.serialThreshold are transformed on the calling thread.
+/// \see Vector4f_SSETransformStreamGeneric for a description of the template parameters and parameters.
+/// \param config controls the splitting of the work. \see ParallelConfig_Default
+template <bool translate, bool divideByW, bool alignedOutput, int outputStep, bool alignedInput, int inputStep, Precision precision = Precision::Exact>
+void Vector4f_ParallelTransformStreamGeneric(float* outputStream, const float* inputStream, unsigned count, const Matrix4x4f& transform,
+                                             const ParallelConfig& config = ParallelConfig_Default())
+{
+  const unsigned maxThreads = (config.maxThreads) ? config.maxThreads : unsigned(WorkerPool_Get().threads.size() + 1);
+  if (count < config.serialThreshold || maxThreads < 2)
+  {
+    Vector4f_DispatchTransformStreamGeneric<translate,divideByW,alignedOutput,outputStep,alignedInput,inputStep,precision>(outputStream, inputStream, count, transform);
+    return;
+  }
+  const unsigned chunkSize = ParallelConfig_ChunkSize(config, inputStep * sizeof(float));
+  ParallelTransformContext context = { outputStream, inputStream, count, chunkSize, &transform };
+  WorkerPool_ParallelFor((count + chunkSize - 1) / chunkSize, maxThreads,
+                         Vector4f_ParallelTransformChunk<translate,divideByW,alignedOutput,outputStep,alignedInput,inputStep,precision>, &context);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// Structure of arrays stream transforms
+
+/// Transforms vectors stored as a structure of arrays (SoA), where the x, y and z components are in separate arrays
+/// (non-SIMD fallback implementation). Compared to the array of structures (AoS) Vector4f stream transforms, this
+/// layout needs no shuffles to splat the components and has no wasted w lane, so each SIMD register holds the same
+/// component of several vectors. \see Vector4f_AoSToSoA and Vector4f_SoAToAoS to convert between the layouts.
+/// \tparam translate is a bool to enable or disable applying the translation component of the transform.
+///         The input w components are treated as 1 if set, otherwise as 0.
+/// \tparam divideByW is a bool to enable or disable applying perspective by dividing by W.
+/// \tparam precision is the accuracy of the reciprocal of W when dividing by it, Exact by default. \see Precision
+/// \param outX, outY, outZ, outW are the arrays to put the components of the transformed vectors to.
+///         outW may be null if the w components are not needed.
+/// \param inX, inY, inZ are the arrays of the components of the vectors to apply the transform to.
+///         These may be the same as the output arrays to transform in place.
+/// \param count is the number of vectors to transform.
+/// \param transform is the matrix to apply.
+template <bool translate, bool divideByW, Precision precision = Precision::Exact>
+void Vector4f_TransformStreamSoA(float* outX, float* outY, float* outZ, float* outW,
+                                 const float* inX, const float* inY, const float* inZ, unsigned count, const Matrix4x4f& transform)
+{
+  const Matrix4x4f& m = transform;
+  for (unsigned i = 0; i < count; ++i)
+  {
+    const Scalar1f x = inX[i], y = inY[i], z = inZ[i];
+    Scalar1f X = x * m.m[0][0] + y * m.m[1][0] + z * m.m[2][0] + ((translate) ? m.m[3][0] : Scalar1f_Zero());
+    Scalar1f Y = x * m.m[0][1] + y * m.m[1][1] + z * m.m[2][1] + ((translate) ? m.m[3][1] : Scalar1f_Zero());
+    Scalar1f Z = x * m.m[0][2] + y * m.m[1][2] + z * m.m[2][2] + ((translate) ? m.m[3][2] : Scalar1f_Zero());
+    Scalar1f W = x * m.m[0][3] + y * m.m[1][3] + z * m.m[2][3] + ((translate) ? m.m[3][3] : Scalar1f_Zero());
+    if (divideByW)
+    {
+      const Scalar1f invW = Scalar1f_Reciprocal<precision>(W);
+      X *= invW;
+      Y *= invW;
+      Z *= invW;
+      W = Scalar1f_One();
+    }
+    outX[i] = X;
+    outY[i] = Y;
+    outZ[i] = Z;
+    if (outW)
+    {
+      outW[i] = W;
+    }
+  }
+}
+
+#if MATHS3D_X86
+
+/// Transforms vectors stored as a structure of arrays, 4 vectors per iteration (SSE implementation).
+/// \see Vector4f_TransformStreamSoA for a description of the template parameters and parameters.
+template <bool translate, bool divideByW, Precision precision = Precision::Exact>
+void Vector4f_SSETransformStreamSoA(float* outX, float* outY, float* outZ, float* outW,
+                                    const float* inX, const float* inY, const float* inZ, unsigned count, const Matrix4x4f& transform)
+{
+  // Each element of the matrix is splatted once, so that the loop only does multiplies and adds.
+  __m128 M[4][4];
+  for (int i = 0; i < 4; ++i)
+    for (int j = 0; j < 4; ++j)
+      M[i][j] = _mm_set1_ps(transform.m[i][j]);
+  unsigned i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    const __m128 x = _mm_loadu_ps(inX + i);
+    const __m128 y = _mm_loadu_ps(inY + i);
+    const __m128 z = _mm_loadu_ps(inZ + i);
+    __m128 out[4];
+    for (int j = 0; j < 4; ++j)
+    {
+      out[j] = _mm_mul_ps(z, M[2][j]);
+      if (translate)
+      {
+        out[j] = _mm_add_ps(out[j], M[3][j]);
+      }
+      out[j] = _mm_add_ps(out[j], _mm_mul_ps(y, M[1][j]));
+      out[j] = _mm_add_ps(out[j], _mm_mul_ps(x, M[0][j]));
+    }
+    if (divideByW)
+    {
+      const __m128 invW = Vector4f_SSEReciprocal<precision>(out[3]);
+      out[0] = _mm_mul_ps(out[0], invW);
+      out[1] = _mm_mul_ps(out[1], invW);
+      out[2] = _mm_mul_ps(out[2], invW);
+      out[3] = _mm_set1_ps(1.0f);
+    }
+    _mm_storeu_ps(outX + i, out[0]);
+    _mm_storeu_ps(outY + i, out[1]);
+    _mm_storeu_ps(outZ + i, out[2]);
+    if (outW)
+    {
+      _mm_storeu_ps(outW + i, out[3]);
+    }
+  }
+  Vector4f_TransformStreamSoA<translate,divideByW,precision>(outX + i, outY + i, outZ + i, outW ? outW + i : nullptr,
+                                                   inX + i, inY + i, inZ + i, count - i, transform);
+}
+
+/// Transforms vectors stored as a structure of arrays, 8 vectors per iteration (AVX2 and FMA implementation).
+/// \note must only be called if the CPU supports AVX2 and FMA. \see InstructionSet_IsSupported
+/// \see Vector4f_TransformStreamSoA for a description of the template parameters and parameters.
+template <bool translate, bool divideByW, Precision precision = Precision::Exact>
+MATHS3D_TARGET("avx2,fma")
+void Vector4f_AVX2TransformStreamSoA(float* outX, float* outY, float* outZ, float* outW,
+                                     const float* inX, const float* inY, const float* inZ, unsigned count, const Matrix4x4f& transform)
+{
+  __m256 M[4][4];
+  for (int i = 0; i < 4; ++i)
+    for (int j = 0; j < 4; ++j)
+      M[i][j] = _mm256_set1_ps(transform.m[i][j]);
+  unsigned i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    const __m256 x = _mm256_loadu_ps(inX + i);
+    const __m256 y = _mm256_loadu_ps(inY + i);
+    const __m256 z = _mm256_loadu_ps(inZ + i);
+    __m256 out[4];
+    for (int j = 0; j < 4; ++j)
+    {
+      out[j] = (translate) ? _mm256_fmadd_ps(z, M[2][j], M[3][j]) : _mm256_mul_ps(z, M[2][j]);
+      out[j] = _mm256_fmadd_ps(y, M[1][j], out[j]);
+      out[j] = _mm256_fmadd_ps(x, M[0][j], out[j]);
+    }
+    if (divideByW)
+    {
+      const __m256 invW = Vector4f_AVX2Reciprocal<precision>(out[3]);
+      out[0] = _mm256_mul_ps(out[0], invW);
+      out[1] = _mm256_mul_ps(out[1], invW);
+      out[2] = _mm256_mul_ps(out[2], invW);
+      out[3] = _mm256_set1_ps(1.0f);
+    }
+    _mm256_storeu_ps(outX + i, out[0]);
+    _mm256_storeu_ps(outY + i, out[1]);
+    _mm256_storeu_ps(outZ + i, out[2]);
+    if (outW)
+    {
+      _mm256_storeu_ps(outW + i, out[3]);
+    }
+  }
+  Vector4f_TransformStreamSoA<translate,divideByW,precision>(outX + i, outY + i, outZ + i, outW ? outW + i : nullptr,
+                                                   inX + i, inY + i, inZ + i, count - i, transform);
+}
+
+/// Transforms vectors stored as a structure of arrays, 16 vectors per iteration (AVX-512 implementation).
+/// \note must only be called if the CPU supports AVX-512F. \see InstructionSet_IsSupported
+/// \see Vector4f_TransformStreamSoA for a description of the template parameters and parameters.
+template <bool translate, bool divideByW, Precision precision = Precision::Exact>
+MATHS3D_TARGET("avx512f,avx2,fma")
+void Vector4f_AVX512TransformStreamSoA(float* outX, float* outY, float* outZ, float* outW,
+                                       const float* inX, const float* inY, const float* inZ, unsigned count, const Matrix4x4f& transform)
+{
+  __m512 M[4][4];
+  for (int i = 0; i < 4; ++i)
+    for (int j = 0; j < 4; ++j)
+      M[i][j] = _mm512_set1_ps(transform.m[i][j]);
+  unsigned i = 0;
+  for (; i + 16 <= count; i += 16)
+  {
+    const __m512 x = _mm512_loadu_ps(inX + i);
+    const __m512 y = _mm512_loadu_ps(inY + i);
+    const __m512 z = _mm512_loadu_ps(inZ + i);
+    __m512 out[4];
+    for (int j = 0; j < 4; ++j)
+    {
+      out[j] = (translate) ? _mm512_fmadd_ps(z, M[2][j], M[3][j]) : _mm512_mul_ps(z, M[2][j]);
+      out[j] = _mm512_fmadd_ps(y, M[1][j], out[j]);
+      out[j] = _mm512_fmadd_ps(x, M[0][j], out[j]);
+    }
+    if (divideByW)
+    {
+      const __m512 invW = Vector4f_AVX512Reciprocal<precision>(out[3]);
+      out[0] = _mm512_mul_ps(out[0], invW);
+      out[1] = _mm512_mul_ps(out[1], invW);
+      out[2] = _mm512_mul_ps(out[2], invW);
+      out[3] = _mm512_set1_ps(1.0f);
+    }
+    _mm512_storeu_ps(outX + i, out[0]);
+    _mm512_storeu_ps(outY + i, out[1]);
+    _mm512_storeu_ps(outZ + i, out[2]);
+    if (outW)
+    {
+      _mm512_storeu_ps(outW + i, out[3]);
+    }
+  }
+  Vector4f_TransformStreamSoA<translate,divideByW,precision>(outX + i, outY + i, outZ + i, outW ? outW + i : nullptr,
+                                                   inX + i, inY + i, inZ + i, count - i, transform);
+}
+
+#endif // MATHS3D_X86
+
+/// Function pointer type for the implementations of the structure of arrays stream transforms.
+using Vector4f_TransformStreamSoAFunc = void (*)(float* outX, float* outY, float* outZ, float* outW,
+                                                 const float* inX, const float* inY, const float* inZ, unsigned count, const Matrix4x4f& transform);
+
+/// Returns the implementation of the structure of arrays stream transform for the given instruction set.
+template <bool translate, bool divideByW, Precision precision = Precision::Exact>
+Vector4f_TransformStreamSoAFunc Vector4f_SelectTransformStreamSoA(InstructionSet isa)
+{
+  switch (isa)
+  {
+#if MATHS3D_X86
+    case InstructionSet::AVX512:
+      return &Vector4f_AVX512TransformStreamSoA<translate,divideByW,precision>;
+    case InstructionSet::AVX2:
+      return &Vector4f_AVX2TransformStreamSoA<translate,divideByW,precision>;
+    case InstructionSet::SSE:
+      return &Vector4f_SSETransformStreamSoA<translate,divideByW,precision>;
+#endif
+    default:
+      return &Vector4f_TransformStreamSoA<translate,divideByW,precision>;
+  }
+}
+
+/// Transforms vectors stored as a structure of arrays using the best implementation for the CPU.
+/// \see Vector4f_TransformStreamSoA for a description of the template parameters and parameters.
+template <bool translate, bool divideByW, Precision precision = Precision::Exact>
+void Vector4f_DispatchTransformStreamSoA(float* outX, float* outY, float* outZ, float* outW,
+                                         const float* inX, const float* inY, const float* inZ, unsigned count, const Matrix4x4f& transform)
+{
+  static const Vector4f_TransformStreamSoAFunc kernel = Vector4f_SelectTransformStreamSoA<translate,divideByW,precision>(InstructionSet_Active());
+  kernel(outX, outY, outZ, outW, inX, inY, inZ, count, transform);
+}
+
+/// Converts count vectors from an array of structures (AoS) to a structure of arrays (SoA).
+/// \param x, y, z, w are the arrays to put the components to. w may be null if it is not needed.
+/// \param inputStream is the array of vectors to convert.
+/// \param count is the number of vectors to convert.
+inline void Vector4f_AoSToSoA(float* x, float* y, float* z, float* w, const Vector4f* inputStream, unsigned count)
+{
+  unsigned i = 0;
+#if MATHS3D_X86
+  // Four vectors at a time are loaded as the rows of a 4x4 matrix and then transposed so each row is one component.
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128 r0 = _mm_loadu_ps(inputStream[i+0].v);
+    __m128 r1 = _mm_loadu_ps(inputStream[i+1].v);
+    __m128 r2 = _mm_loadu_ps(inputStream[i+2].v);
+    __m128 r3 = _mm_loadu_ps(inputStream[i+3].v);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    _mm_storeu_ps(x + i, r0);
+    _mm_storeu_ps(y + i, r1);
+    _mm_storeu_ps(z + i, r2);
+    if (w)
+    {
+      _mm_storeu_ps(w + i, r3);
+    }
+  }
+#endif
+  for (; i < count; ++i)
+  {
+    x[i] = inputStream[i].x;
+    y[i] = inputStream[i].y;
+    z[i] = inputStream[i].z;
+    if (w)
+    {
+      w[i] = inputStream[i].w;
+    }
+  }
+}
+
+/// Converts count vectors from a structure of arrays (SoA) to an array of structures (AoS).
+/// \param outputStream is the array to put the vectors to.
+/// \param x, y, z, w are the arrays of the components to convert. If w is null, the w components are set to 1.
+/// \param count is the number of vectors to convert.
+inline void Vector4f_SoAToAoS(Vector4f* outputStream, const float* x, const float* y, const float* z, const float* w, unsigned count)
+{
+  unsigned i = 0;
+#if MATHS3D_X86
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128 r0 = _mm_loadu_ps(x + i);
+    __m128 r1 = _mm_loadu_ps(y + i);
+    __m128 r2 = _mm_loadu_ps(z + i);
+    __m128 r3 = (w) ? _mm_loadu_ps(w + i) : _mm_set1_ps(1.0f);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    _mm_storeu_ps(outputStream[i+0].v, r0);
+    _mm_storeu_ps(outputStream[i+1].v, r1);
+    _mm_storeu_ps(outputStream[i+2].v, r2);
+    _mm_storeu_ps(outputStream[i+3].v, r3);
+  }
+#endif
+  for (; i < count; ++i)
+  {
+    outputStream[i] = Vector4f_Set(x[i], y[i], z[i], (w) ? w[i] : Scalar1f_One());
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// Packed Vector3f stream transforms
+
+/// Transforms arrays of packed Vector3f by the transform matrix (non-SSE fallback implementation).
+/// \tparam translate is a bool to enable or disable applying the translation component of the transform.
+/// \tparam divideByW is a bool to enable or disable applying perspective by dividing by W.
+/// \tparam outputStep is 3 to output packed Vector3f, or 4 to output Vector4f.
+/// \tparam precision is the accuracy of the reciprocal of W when dividing by it, Exact by default. \see Precision
+/// \param outputStream is the output buffer to put the transformed vectors to.
+/// \param inputStream is the input array of packed Vector3f to apply the transform to. This is allowed to be the
+///        same as outputStream if outputStep is 3.
+/// \param count is the number of vectors to transform.
+/// \param transform is the matrix to apply.
+template <bool translate, bool divideByW, int outputStep, Precision precision = Precision::Exact>
+void Vector3f_TransformStreamGeneric(float* outputStream, const float* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  static_assert(outputStep == 3 || outputStep == 4, "outputStep must be 3 or 4");
+  for (unsigned i = 0; i < count; ++i)
+  {
+    Vector4f Z = Vector4f_Multiply(transform.row[2], Vector4f_Replicate(inputStream[2])); // z
+    if (translate)
+    {
+      Z = Vector4f_Add(transform.row[3], Z);
+    }
+    Z = Vector4f_Add(Z, Vector4f_Multiply(transform.row[1], Vector4f_Replicate(inputStream[1]))); // y
+    Z = Vector4f_Add(Z, Vector4f_Multiply(transform.row[0], Vector4f_Replicate(inputStream[0]))); // x
+    if (divideByW)
+    {
+      Z = Vector4f_Scaled(Z, Scalar1f_Reciprocal<precision>(Z.w));
+    }
+    for (int j = 0; j < outputStep; ++j)
+    {
+      outputStream[j] = Z.v[j];
+    }
+    inputStream  += 3;
+    outputStream += outputStep;
+  }
+}
+
+#if MATHS3D_X86
+
+/// Splits 4 packed Vector3f loaded as 3 registers (x0 y0 z0 x1, y1 z1 x2 y2, z2 x3 y3 z3) in to 4 vectors
+/// with w set from the w register.
+inline void Vector3f_SSEUnpack4(__m128 a, __m128 b, __m128 c, __m128 w, __m128 (&out)[4])
+{
+  const __m128 a2w = _mm_shuffle_ps(a, w, _MM_SHUFFLE(0,0,2,2));   // z0 z0 w w
+  const __m128 a3b0 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0,0,3,3));  // x1 x1 y1 y1
+  const __m128 b1w = _mm_shuffle_ps(b, w, _MM_SHUFFLE(0,0,1,1));   // z1 z1 w w
+  const __m128 c0w = _mm_shuffle_ps(c, w, _MM_SHUFFLE(0,0,0,0));   // z2 z2 w w
+  const __m128 c3w = _mm_shuffle_ps(c, w, _MM_SHUFFLE(0,0,3,3));   // z3 z3 w w
+  out[0] = _mm_shuffle_ps(a, a2w, _MM_SHUFFLE(2,0,1,0));
+  out[1] = _mm_shuffle_ps(a3b0, b1w, _MM_SHUFFLE(2,0,2,0));
+  out[2] = _mm_shuffle_ps(b, c0w, _MM_SHUFFLE(2,0,3,2));
+  out[3] = _mm_shuffle_ps(c, c3w, _MM_SHUFFLE(2,0,2,1));
+}
+
+/// Packs the x, y and z of 4 vectors in to 3 registers (x0 y0 z0 x1, y1 z1 x2 y2, z2 x3 y3 z3) which can be
+/// stored as 4 packed Vector3f.
+inline void Vector3f_SSEPack4(const __m128 (&in)[4], __m128& a, __m128& b, __m128& c)
+{
+  const __m128 z0x1 = _mm_shuffle_ps(in[0], in[1], _MM_SHUFFLE(0,0,2,2));  // z0 z0 x1 x1
+  const __m128 z2x3 = _mm_shuffle_ps(in[2], in[3], _MM_SHUFFLE(0,0,2,2));  // z2 z2 x3 x3
+  a = _mm_shuffle_ps(in[0], z0x1, _MM_SHUFFLE(2,0,1,0));
+  b = _mm_shuffle_ps(in[1], in[2], _MM_SHUFFLE(1,0,2,1));
+  c = _mm_shuffle_ps(z2x3, in[3], _MM_SHUFFLE(2,1,2,0));
+}
+
+/// Transforms arrays of packed Vector3f by the transform matrix (SSE implementation).
+/// Four vectors (48 bytes) are read per iteration with three 128-bit loads, so unlike the Vector4f kernels there is
+/// no 16-byte load of a 12-byte element which would read past the end of the last one. The remaining vectors are
+/// loaded one component at a time, and packed outputs are stored as 8 and 4 byte parts so nothing past the end of
+/// the output is written to either.
+/// \see Vector3f_TransformStreamGeneric for a description of the template parameters and parameters.
+template <bool translate, bool divideByW, int outputStep, Precision precision = Precision::Exact>
+void Vector3f_SSETransformStreamGeneric(float* outputStream, const float* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  static_assert(outputStep == 3 || outputStep == 4, "outputStep must be 3 or 4");
+  const __m128 R0 = _mm_loadu_ps(transform.row[0].v);
+  const __m128 R1 = _mm_loadu_ps(transform.row[1].v);
+  const __m128 R2 = _mm_loadu_ps(transform.row[2].v);
+  const __m128 R3 = _mm_loadu_ps(transform.row[3].v);
+  const unsigned prefetchEnd = Stream_PrefetchEnd(count, 3, 256);
+  unsigned i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    if (i < prefetchEnd)
+    {
+      _mm_prefetch((const char*)&inputStream[256], _MM_HINT_T0);
+    }
+    const __m128 a = _mm_loadu_ps(inputStream + 0);
+    const __m128 b = _mm_loadu_ps(inputStream + 4);
+    const __m128 c = _mm_loadu_ps(inputStream + 8);
+    // The x, y and z of each vector are splatted straight from the loaded registers without unpacking them
+    // first, so this takes no more shuffles than the Vector4f stream transform.
+    __m128 out[4];
+    out[0] = Vector4f_SSETransformSplatted<translate,divideByW,precision>(_mm_shuffle_ps(a,a,_MM_SHUFFLE(0,0,0,0)),
+        _mm_shuffle_ps(a,a,_MM_SHUFFLE(1,1,1,1)), _mm_shuffle_ps(a,a,_MM_SHUFFLE(2,2,2,2)), R0, R1, R2, R3);
+    out[1] = Vector4f_SSETransformSplatted<translate,divideByW,precision>(_mm_shuffle_ps(a,a,_MM_SHUFFLE(3,3,3,3)),
+        _mm_shuffle_ps(b,b,_MM_SHUFFLE(0,0,0,0)), _mm_shuffle_ps(b,b,_MM_SHUFFLE(1,1,1,1)), R0, R1, R2, R3);
+    out[2] = Vector4f_SSETransformSplatted<translate,divideByW,precision>(_mm_shuffle_ps(b,b,_MM_SHUFFLE(2,2,2,2)),
+        _mm_shuffle_ps(b,b,_MM_SHUFFLE(3,3,3,3)), _mm_shuffle_ps(c,c,_MM_SHUFFLE(0,0,0,0)), R0, R1, R2, R3);
+    out[3] = Vector4f_SSETransformSplatted<translate,divideByW,precision>(_mm_shuffle_ps(c,c,_MM_SHUFFLE(1,1,1,1)),
+        _mm_shuffle_ps(c,c,_MM_SHUFFLE(2,2,2,2)), _mm_shuffle_ps(c,c,_MM_SHUFFLE(3,3,3,3)), R0, R1, R2, R3);
+    if (outputStep == 4)
+    {
+      _mm_storeu_ps(outputStream + 0, out[0]);
+      _mm_storeu_ps(outputStream + 4, out[1]);
+      _mm_storeu_ps(outputStream + 8, out[2]);
+      _mm_storeu_ps(outputStream + 12, out[3]);
+    }
+    else
+    {
+      __m128 oa, ob, oc;
+      Vector3f_SSEPack4(out, oa, ob, oc);
+      _mm_storeu_ps(outputStream + 0, oa);
+      _mm_storeu_ps(outputStream + 4, ob);
+      _mm_storeu_ps(outputStream + 8, oc);
+    }
+    inputStream  += 3 * 4;
+    outputStream += outputStep * 4;
+  }
+  for (; i < count; ++i)
+  {
+    const __m128 Z = Vector4f_SSETransformSplatted<translate,divideByW,precision>(_mm_load1_ps(inputStream + 0),
+        _mm_load1_ps(inputStream + 1), _mm_load1_ps(inputStream + 2), R0, R1, R2, R3);
+    if (outputStep == 4)
+    {
+      _mm_storeu_ps(outputStream, Z);
+    }
+    else
+    {
+      _mm_storel_pi((__m64*)outputStream, Z);
+      _mm_store_ss(outputStream + 2, _mm_movehl_ps(Z, Z));
+    }
+    inputStream  += 3;
+    outputStream += outputStep;
+  }
+}
+
+#endif // MATHS3D_X86
+
+/// Function pointer type for the implementations of the packed Vector3f stream transforms.
+using Vector3f_TransformStreamFunc = void (*)(float* outputStream, const float* inputStream, unsigned count, const Matrix4x4f& transform);
+
+/// Returns the implementation of the packed Vector3f stream transform for the given instruction set.
+/// The SSE implementation is used for the AVX tiers.
+template <bool translate, bool divideByW, int outputStep, Precision precision = Precision::Exact>
+Vector3f_TransformStreamFunc Vector3f_SelectTransformStream(InstructionSet isa)
+{
+#if MATHS3D_X86
+  if (isa != InstructionSet::Scalar)
+  {
+    return &Vector3f_SSETransformStreamGeneric<translate,divideByW,outputStep,precision>;
+  }
+#endif
+  return &Vector3f_TransformStreamGeneric<translate,divideByW,outputStep,precision>;
+}
+
+/// Transforms arrays of packed Vector3f using the best implementation for the CPU.
+/// \see Vector3f_TransformStreamGeneric for a description of the template parameters and parameters.
+template <bool translate, bool divideByW, int outputStep, Precision precision = Precision::Exact>
+void Vector3f_DispatchTransformStreamGeneric(float* outputStream, const float* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  static const Vector3f_TransformStreamFunc kernel = Vector3f_SelectTransformStream<translate,divideByW,outputStep,precision>(InstructionSet_Active());
+  kernel(outputStream, inputStream, count, transform);
+}
+
+/// Transforms an array of count packed vectors without applying perspective. The w components are treated as 1.
+inline void Vector3f_TransformStream(Vector3f* outputStream, const Vector3f* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  Vector3f_DispatchTransformStreamGeneric<true,false,3>(outputStream->v, inputStream->v, count, transform);
+}
+
+/// Transforms an array of count packed vectors in to an array of Vector4f without applying perspective.
+inline void Vector3f_TransformStream(Vector4f* outputStream, const Vector3f* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  Vector3f_DispatchTransformStreamGeneric<true,false,4>(outputStream->v, inputStream->v, count, transform);
+}
+
+/// Transforms an array of count packed vectors with perspective, dividing by w with the given precision.
+template <Precision precision = Precision::Exact>
+void Vector3f_TransformCoordStream(Vector3f* outputStream, const Vector3f* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  Vector3f_DispatchTransformStreamGeneric<true,true,3,precision>(outputStream->v, inputStream->v, count, transform);
+}
+
+/// Transforms an array of count packed vectors in to an array of Vector4f with perspective, dividing by w with the given precision.
+template <Precision precision = Precision::Exact>
+void Vector3f_TransformCoordStream(Vector4f* outputStream, const Vector3f* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  Vector3f_DispatchTransformStreamGeneric<true,true,4,precision>(outputStream->v, inputStream->v, count, transform);
+}
+
+/// Transforms an array of count packed normal vectors. The w components are treated as 0.
+inline void Vector3f_TransformNormalStream(Vector3f* outputStream, const Vector3f* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  Vector3f_DispatchTransformStreamGeneric<false,false,3>(outputStream->v, inputStream->v, count, transform);
+}
+
+/// Transforms an array of count packed normal vectors in to an array of Vector4f.
+inline void Vector3f_TransformNormalStream(Vector4f* outputStream, const Vector3f* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  Vector3f_DispatchTransformStreamGeneric<false,false,4>(outputStream->v, inputStream->v, count, transform);
+}
+
+/// Converts an array of count Vector4f to packed Vector3f, dropping the w components.
+inline void Vector4f_PackStream(Vector3f* outputStream, const Vector4f* inputStream, unsigned count)
+{
+  unsigned i = 0;
+#if MATHS3D_X86
+  for (; i + 4 <= count; i += 4)
+  {
+    const __m128 in[4] = { _mm_loadu_ps(inputStream[i+0].v), _mm_loadu_ps(inputStream[i+1].v),
+                           _mm_loadu_ps(inputStream[i+2].v), _mm_loadu_ps(inputStream[i+3].v) };
+    __m128 a, b, c;
+    Vector3f_SSEPack4(in, a, b, c);
+    _mm_storeu_ps(outputStream[i].v + 0, a);
+    _mm_storeu_ps(outputStream[i].v + 4, b);
+    _mm_storeu_ps(outputStream[i].v + 8, c);
+  }
+#endif
+  for (; i < count; ++i)
+  {
+    outputStream[i] = Vector3f_FromVector4f(inputStream[i]);
+  }
+}
+
+/// Converts an array of count packed Vector3f to Vector4f, setting the w components to w.
+inline void Vector3f_UnpackStream(Vector4f* outputStream, const Vector3f* inputStream, unsigned count, Scalar1f w)
+{
+  unsigned i = 0;
+#if MATHS3D_X86
+  const __m128 W = _mm_set1_ps(w);
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128 out[4];
+    Vector3f_SSEUnpack4(_mm_loadu_ps(inputStream[i].v + 0), _mm_loadu_ps(inputStream[i].v + 4), _mm_loadu_ps(inputStream[i].v + 8), W, out);
+    _mm_storeu_ps(outputStream[i+0].v, out[0]);
+    _mm_storeu_ps(outputStream[i+1].v, out[1]);
+    _mm_storeu_ps(outputStream[i+2].v, out[2]);
+    _mm_storeu_ps(outputStream[i+3].v, out[3]);
+  }
+#endif
+  for (; i < count; ++i)
+  {
+    outputStream[i] = Vector4f_FromVector3f(inputStream[i], w);
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// Half precision stream transforms
+
+/// Transforms arrays of half or single precision vectors by the transform matrix (non-F16C fallback implementation).
+/// The halves are converted in software with Half1h_FromScalar1f and Scalar1f_FromHalf1h.
+/// \tparam translate is a bool to enable or disable applying the translation component of the transform.
+/// \tparam divideByW is a bool to enable or disable applying perspective by dividing by W.
+/// \tparam halfOutput is true if outputStream is an array of Vector4h, or false if it is an array of Vector4f.
+/// \tparam halfInput is true if inputStream is an array of Vector4h, or false if it is an array of Vector4f.
+/// \tparam precision is the accuracy of the reciprocal of W when dividing by it, Exact by default. \see Precision
+/// \param outputStream is the output buffer to put the transformed vectors to.
+/// \param inputStream is the input array of vectors to apply the transform to. This is allowed to be the same as
+///        outputStream if halfOutput and halfInput are the same.
+/// \param count is the number of vectors to transform.
+/// \param transform is the matrix to apply.
+template <bool translate, bool divideByW, bool halfOutput, bool halfInput, Precision precision = Precision::Exact>
+void Vector4h_TransformStreamGeneric(void* outputStream, const void* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  for (unsigned i = 0; i < count; ++i)
+  {
+    const Vector4f in = (halfInput) ? Vector4f_FromVector4h(((const Vector4h*)inputStream)[i]) : ((const Vector4f*)inputStream)[i];
+    Vector4f Z = Vector4f_Multiply(transform.row[2], Vector4f_Replicate(in.z)); // z
+    if (translate)
+    {
+      Z = Vector4f_Add(transform.row[3], Z);
+    }
+    Z = Vector4f_Add(Z, Vector4f_Multiply(transform.row[1], Vector4f_Replicate(in.y))); // y
+    Z = Vector4f_Add(Z, Vector4f_Multiply(transform.row[0], Vector4f_Replicate(in.x))); // x
+    if (divideByW)
+    {
+      Z = Vector4f_Scaled(Z, Scalar1f_Reciprocal<precision>(Z.w));
+    }
+    if (halfOutput)
+    {
+      ((Vector4h*)outputStream)[i] = Vector4h_FromVector4f(Z);
+    }
+    else
+    {
+      ((Vector4f*)outputStream)[i] = Z;
+    }
+  }
+}
+
+#if MATHS3D_X86
+
+/// Transforms arrays of half or single precision vectors by the transform matrix (F16C implementation).
+/// Two vectors are processed per iteration, so a pair of Vector4h is read or written with a single 128-bit load or
+/// store and converted with _mm_cvtph_ps and _mm_cvtps_ph. The conversions round to nearest even, so the results
+/// are identical to those of the software conversion used by Vector4h_TransformStreamGeneric.
+/// \see Vector4h_TransformStreamGeneric for a description of the template parameters and parameters.
+template <bool translate, bool divideByW, bool halfOutput, bool halfInput, Precision precision = Precision::Exact>
+MATHS3D_TARGET("f16c")
+void Vector4h_F16CTransformStreamGeneric(void* outputStream, const void* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  const __m128 R0 = _mm_loadu_ps(transform.row[0].v);
+  const __m128 R1 = _mm_loadu_ps(transform.row[1].v);
+  const __m128 R2 = _mm_loadu_ps(transform.row[2].v);
+  const __m128 R3 = _mm_loadu_ps(transform.row[3].v);
+  const unsigned inputSize = (halfInput) ? sizeof(Vector4h) : sizeof(Vector4f);
+  const unsigned outputSize = (halfOutput) ? sizeof(Vector4h) : sizeof(Vector4f);
+  const char* in = (const char*)inputStream;
+  char* out = (char*)outputStream;
+  const unsigned prefetchEnd = Stream_PrefetchEnd(count, inputSize, 256);
+  unsigned i = 0;
+  for (; i + 2 <= count; i += 2)
+  {
+    if (i < prefetchEnd)
+    {
+      _mm_prefetch(in + 256, _MM_HINT_T0);
+    }
+    __m128 vals0, vals1;
+    if (halfInput)
+    {
+      const __m128i halves = _mm_loadu_si128((const __m128i*)in);
+      vals0 = _mm_cvtph_ps(halves);
+      vals1 = _mm_cvtph_ps(_mm_unpackhi_epi64(halves, halves));
+    }
+    else
+    {
+      vals0 = _mm_loadu_ps((const float*)in);
+      vals1 = _mm_loadu_ps((const float*)in + 4);
+    }
+    const __m128 Z0 = Vector4f_SSETransformVector<translate,divideByW,precision>(vals0, R0, R1, R2, R3);
+    const __m128 Z1 = Vector4f_SSETransformVector<translate,divideByW,precision>(vals1, R0, R1, R2, R3);
+    if (halfOutput)
+    {
+      _mm_storeu_si128((__m128i*)out, _mm_unpacklo_epi64(_mm_cvtps_ph(Z0, _MM_FROUND_TO_NEAREST_INT),
+                                                         _mm_cvtps_ph(Z1, _MM_FROUND_TO_NEAREST_INT)));
+    }
+    else
+    {
+      _mm_storeu_ps((float*)out, Z0);
+      _mm_storeu_ps((float*)out + 4, Z1);
+    }
+    in  += 2 * inputSize;
+    out += 2 * outputSize;
+  }
+  if (i < count)
+  {
+    // The last odd vector, which is only 64-bits if it is half precision
+    const __m128 vals = (halfInput) ? _mm_cvtph_ps(_mm_loadl_epi64((const __m128i*)in)) : _mm_loadu_ps((const float*)in);
+    const __m128 Z = Vector4f_SSETransformVector<translate,divideByW,precision>(vals, R0, R1, R2, R3);
+    if (halfOutput)
+    {
+      _mm_storel_epi64((__m128i*)out, _mm_cvtps_ph(Z, _MM_FROUND_TO_NEAREST_INT));
+    }
+    else
+    {
+      _mm_storeu_ps((float*)out, Z);
+    }
+  }
+}
+
+/// Converts an array of count Vector4f to half precision (F16C implementation).
+MATHS3D_TARGET("f16c")
+inline void Vector4f_F16CPackHalfStream(Vector4h* outputStream, const Vector4f* inputStream, unsigned count)
+{
+  unsigned i = 0;
+  for (; i + 2 <= count; i += 2)
+  {
+    _mm_storeu_si128((__m128i*)&outputStream[i], _mm_unpacklo_epi64(_mm_cvtps_ph(_mm_loadu_ps(inputStream[i+0].v), _MM_FROUND_TO_NEAREST_INT),
+                                                                    _mm_cvtps_ph(_mm_loadu_ps(inputStream[i+1].v), _MM_FROUND_TO_NEAREST_INT)));
+  }
+  if (i < count)
+  {
+    _mm_storel_epi64((__m128i*)&outputStream[i], _mm_cvtps_ph(_mm_loadu_ps(inputStream[i].v), _MM_FROUND_TO_NEAREST_INT));
+  }
+}
+
+/// Converts an array of count Vector4h to single precision (F16C implementation).
+MATHS3D_TARGET("f16c")
+inline void Vector4h_F16CUnpackStream(Vector4f* outputStream, const Vector4h* inputStream, unsigned count)
+{
+  unsigned i = 0;
+  for (; i + 2 <= count; i += 2)
+  {
+    const __m128i halves = _mm_loadu_si128((const __m128i*)&inputStream[i]);
+    _mm_storeu_ps(outputStream[i+0].v, _mm_cvtph_ps(halves));
+    _mm_storeu_ps(outputStream[i+1].v, _mm_cvtph_ps(_mm_unpackhi_epi64(halves, halves)));
+  }
+  if (i < count)
+  {
+    _mm_storeu_ps(outputStream[i].v, _mm_cvtph_ps(_mm_loadl_epi64((const __m128i*)&inputStream[i])));
+  }
+}
+
+#endif // MATHS3D_X86
+
+/// Returns if the F16C conversions can be used with the given instruction set. F16C was introduced alongside AVX, so
+/// it is only used for the AVX tiers, which means forcing MATHS3D_ISA to sse also tests the software conversions.
+inline bool Vector4h_UseF16C(InstructionSet isa)
+{
+  return (isa == InstructionSet::AVX2 || isa == InstructionSet::AVX512) && CpuFeatures_Get().f16c;
+}
+
+/// Function pointer type for the implementations of the half precision stream transforms.
+using Vector4h_TransformStreamFunc = void (*)(void* outputStream, const void* inputStream, unsigned count, const Matrix4x4f& transform);
+
+/// Returns the implementation of the half precision stream transform for the given instruction set.
+template <bool translate, bool divideByW, bool halfOutput, bool halfInput, Precision precision = Precision::Exact>
+Vector4h_TransformStreamFunc Vector4h_SelectTransformStream(InstructionSet isa)
+{
+#if MATHS3D_X86
+  if (Vector4h_UseF16C(isa))
+  {
+    return &Vector4h_F16CTransformStreamGeneric<translate,divideByW,halfOutput,halfInput,precision>;
+  }
+#endif
+  return &Vector4h_TransformStreamGeneric<translate,divideByW,halfOutput,halfInput,precision>;
+}
+
+/// Transforms arrays of half or single precision vectors using the best implementation for the CPU.
+/// \see Vector4h_TransformStreamGeneric for a description of the template parameters and parameters.
+template <bool translate, bool divideByW, bool halfOutput, bool halfInput, Precision precision = Precision::Exact>
+void Vector4h_DispatchTransformStreamGeneric(void* outputStream, const void* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  static const Vector4h_TransformStreamFunc kernel = Vector4h_SelectTransformStream<translate,divideByW,halfOutput,halfInput,precision>(InstructionSet_Active());
+  kernel(outputStream, inputStream, count, transform);
+}
+
+/// Transforms an array of count half precision vectors without applying perspective. The w components are treated as 1.
+inline void Vector4h_TransformStream(Vector4h* outputStream, const Vector4h* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  Vector4h_DispatchTransformStreamGeneric<true,false,true,true>(outputStream, inputStream, count, transform);
+}
+
+/// Transforms an array of count half precision vectors in to an array of Vector4f without applying perspective.
+inline void Vector4h_TransformStream(Vector4f* outputStream, const Vector4h* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  Vector4h_DispatchTransformStreamGeneric<true,false,false,true>(outputStream, inputStream, count, transform);
+}
+
+/// Transforms an array of count vectors in to an array of Vector4h without applying perspective.
+inline void Vector4f_TransformStream(Vector4h* outputStream, const Vector4f* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  Vector4h_DispatchTransformStreamGeneric<true,false,true,false>(outputStream, inputStream, count, transform);
+}
+
+/// Transforms an array of count half precision vectors with perspective, dividing by w with the given precision.
+template <Precision precision = Precision::Exact>
+void Vector4h_TransformCoordStream(Vector4h* outputStream, const Vector4h* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  Vector4h_DispatchTransformStreamGeneric<true,true,true,true,precision>(outputStream, inputStream, count, transform);
+}
+
+/// Transforms an array of count half precision vectors in to an array of Vector4f with perspective, dividing by w with the given precision.
+template <Precision precision = Precision::Exact>
+void Vector4h_TransformCoordStream(Vector4f* outputStream, const Vector4h* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  Vector4h_DispatchTransformStreamGeneric<true,true,false,true,precision>(outputStream, inputStream, count, transform);
+}
+
+/// Transforms an array of count vectors in to an array of Vector4h with perspective, dividing by w with the given precision.
+template <Precision precision = Precision::Exact>
+void Vector4f_TransformCoordStream(Vector4h* outputStream, const Vector4f* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  Vector4h_DispatchTransformStreamGeneric<true,true,true,false,precision>(outputStream, inputStream, count, transform);
+}
+
+/// Transforms an array of count half precision normal vectors. The w components are treated as 0.
+inline void Vector4h_TransformNormalStream(Vector4h* outputStream, const Vector4h* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  Vector4h_DispatchTransformStreamGeneric<false,false,true,true>(outputStream, inputStream, count, transform);
+}
+
+/// Transforms an array of count half precision normal vectors in to an array of Vector4f.
+inline void Vector4h_TransformNormalStream(Vector4f* outputStream, const Vector4h* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  Vector4h_DispatchTransformStreamGeneric<false,false,false,true>(outputStream, inputStream, count, transform);
+}
+
+/// Transforms an array of count normal vectors in to an array of Vector4h.
+inline void Vector4f_TransformNormalStream(Vector4h* outputStream, const Vector4f* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  Vector4h_DispatchTransformStreamGeneric<false,false,true,false>(outputStream, inputStream, count, transform);
+}
+
+/// Converts an array of count Vector4f to half precision, rounding to nearest even.
+inline void Vector4f_PackHalfStream(Vector4h* outputStream, const Vector4f* inputStream, unsigned count)
+{
+#if MATHS3D_X86
+  if (Vector4h_UseF16C(InstructionSet_Active()))
+  {
+    Vector4f_F16CPackHalfStream(outputStream, inputStream, count);
+    return;
+  }
+#endif
+  for (unsigned i = 0; i < count; ++i)
+  {
+    outputStream[i] = Vector4h_FromVector4f(inputStream[i]);
+  }
+}
+
+/// Converts an array of count Vector4h to single precision.
+inline void Vector4h_UnpackStream(Vector4f* outputStream, const Vector4h* inputStream, unsigned count)
+{
+#if MATHS3D_X86
+  if (Vector4h_UseF16C(InstructionSet_Active()))
+  {
+    Vector4h_F16CUnpackStream(outputStream, inputStream, count);
+    return;
+  }
+#endif
+  for (unsigned i = 0; i < count; ++i)
+  {
+    outputStream[i] = Vector4f_FromVector4h(inputStream[i]);
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// Quantized stream transforms
+
+/// Returns transform with the dequantization of positions folded in to it, so that transforming a quantized position
+/// q by the result is the same as transforming q * scale + bias by transform. Only the x, y and z of scale and bias
+/// are used.
+inline Matrix4x4f Matrix4x4f_Dequantized(const Matrix4x4f& transform, const Vector4f& scale, const Vector4f& bias)
+{
+  Matrix4x4f ret;
+  ret.row[0] = Vector4f_Scaled(transform.row[0], scale.x);
+  ret.row[1] = Vector4f_Scaled(transform.row[1], scale.y);
+  ret.row[2] = Vector4f_Scaled(transform.row[2], scale.z);
+  ret.row[3] = Vector4f_Add(transform.row[3], Vector4f_Add(Vector4f_Add(Vector4f_Scaled(transform.row[0], bias.x),
+                                                                        Vector4f_Scaled(transform.row[1], bias.y)),
+                                                           Vector4f_Scaled(transform.row[2], bias.z)));
+  return ret;
+}
+
+/// Transforms arrays of quantized positions by the transform matrix (non-SSE fallback implementation).
+/// \tparam translate is a bool to enable or disable applying the translation component of the transform.
+/// \tparam divideByW is a bool to enable or disable applying perspective by dividing by W.
+/// \tparam QuantizedVector is either Vector4s or Vector4us.
+/// \tparam precision is the accuracy of the reciprocal of W when dividing by it, Exact by default. \see Precision
+/// \param outputStream is the output array of Vector4f to put the transformed vectors to.
+/// \param inputStream is the input array of quantized positions to apply the transform to. The w components are
+///        ignored and treated as 1.
+/// \param count is the number of vectors to transform.
+/// \param transform is the matrix to apply, which should have the dequantization folded in to it with
+///        Matrix4x4f_Dequantized.
+template <bool translate, bool divideByW, typename QuantizedVector, Precision precision = Precision::Exact>
+void Vector4s_TransformStreamGeneric(float* outputStream, const QuantizedVector* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  for (unsigned i = 0; i < count; ++i)
+  {
+    Vector4f Z = Vector4f_Multiply(transform.row[2], Vector4f_Replicate(Scalar1f(inputStream[i].z))); // z
+    if (translate)
+    {
+      Z = Vector4f_Add(transform.row[3], Z);
+    }
+    Z = Vector4f_Add(Z, Vector4f_Multiply(transform.row[1], Vector4f_Replicate(Scalar1f(inputStream[i].y)))); // y
+    Z = Vector4f_Add(Z, Vector4f_Multiply(transform.row[0], Vector4f_Replicate(Scalar1f(inputStream[i].x)))); // x
+    if (divideByW)
+    {
+      Z = Vector4f_Scaled(Z, Scalar1f_Reciprocal<precision>(Z.w));
+    }
+    *(Vector4f*)outputStream = Z;
+    outputStream += 4;
+  }
+}
+
+/// Transforms arrays of octahedral encoded normals by the transform matrix and renormalizes them (non-SSE fallback
+/// implementation).
+/// \param outputStream is the output array of Vector4f to put the transformed normals to. The w components are set to 0.
+/// \param inputStream is the input array of octahedral encoded normals to apply the transform to.
+/// \param count is the number of normals to transform.
+/// \param transform is the matrix to apply. Only the upper 3x3 part is used, so for transforms with a non-uniform
+///        scale this should be the inverse transpose of the matrix the positions are transformed by.
+inline void Vector2s_TransformNormalStreamGeneric(float* outputStream, const Vector2s* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  for (unsigned i = 0; i < count; ++i)
+  {
+    // The decoded normal doesn't need normalizing first as it is normalized after it is transformed
+    const Vector4f N = Vector4f_OctahedralUnfold(inputStream[i]);
+    Vector4f Z = Vector4f_Multiply(transform.row[2], Vector4f_Replicate(N.z));
+    Z = Vector4f_Add(Z, Vector4f_Multiply(transform.row[1], Vector4f_Replicate(N.y)));
+    Z = Vector4f_Add(Z, Vector4f_Multiply(transform.row[0], Vector4f_Replicate(N.x)));
+    *(Vector4f*)outputStream = Vector4f_Normalized(Vector4f_SetW(Z, Scalar1f_Zero()));
+    outputStream += 4;
+  }
+}
+
+#if MATHS3D_X86
+
+/// Converts the first 4 signed 16-bit integers in v to floats.
+inline __m128 Vector4s_SSEConvert(__m128i v, const Vector4s*)
+{
+  return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+}
+
+/// Converts the first 4 unsigned 16-bit integers in v to floats.
+inline __m128 Vector4s_SSEConvert(__m128i v, const Vector4us*)
+{
+  return _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, _mm_setzero_si128()));
+}
+
+/// Transforms arrays of quantized positions by the transform matrix (SSE implementation).
+/// Two positions are read with a single 128-bit load and converted to floats in registers, so no intermediate
+/// array of Vector4f is needed.
+/// \see Vector4s_TransformStreamGeneric for a description of the template parameters and parameters.
+template <bool translate, bool divideByW, typename QuantizedVector, Precision precision = Precision::Exact>
+void Vector4s_SSETransformStreamGeneric(float* outputStream, const QuantizedVector* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  const __m128 R0 = _mm_loadu_ps(transform.row[0].v);
+  const __m128 R1 = _mm_loadu_ps(transform.row[1].v);
+  const __m128 R2 = _mm_loadu_ps(transform.row[2].v);
+  const __m128 R3 = _mm_loadu_ps(transform.row[3].v);
+  const unsigned prefetchEnd = Stream_PrefetchEnd(count, sizeof(QuantizedVector), 256);
+  unsigned i = 0;
+  for (; i + 2 <= count; i += 2)
+  {
+    if (i < prefetchEnd)
+    {
+      _mm_prefetch((const char*)&inputStream[i] + 256, _MM_HINT_T0);
+    }
+    const __m128i quantized = _mm_loadu_si128((const __m128i*)&inputStream[i]);
+    const __m128 vals0 = Vector4s_SSEConvert(quantized, inputStream);
+    const __m128 vals1 = Vector4s_SSEConvert(_mm_unpackhi_epi64(quantized, quantized), inputStream);
+    _mm_storeu_ps(outputStream + 0, Vector4f_SSETransformVector<translate,divideByW,precision>(vals0, R0, R1, R2, R3));
+    _mm_storeu_ps(outputStream + 4, Vector4f_SSETransformVector<translate,divideByW,precision>(vals1, R0, R1, R2, R3));
+    outputStream += 8;
+  }
+  if (i < count)
+  {
+    const __m128 vals = Vector4s_SSEConvert(_mm_loadl_epi64((const __m128i*)&inputStream[i]), inputStream);
+    _mm_storeu_ps(outputStream, Vector4f_SSETransformVector<translate,divideByW,precision>(vals, R0, R1, R2, R3));
+  }
+}
+
+/// Transforms arrays of octahedral encoded normals by the transform matrix and renormalizes them (SSE implementation).
+/// Four normals are decoded, transformed and normalized per iteration as a structure of arrays, and then transposed
+/// to store them. The normalization uses the reciprocal square root estimate refined with a Newton-Raphson step.
+/// \see Vector2s_TransformNormalStreamGeneric for a description of the parameters.
+inline void Vector2s_SSETransformNormalStream(float* outputStream, const Vector2s* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  const __m128 M00 = _mm_set1_ps(transform.row[0].x), M01 = _mm_set1_ps(transform.row[0].y), M02 = _mm_set1_ps(transform.row[0].z);
+  const __m128 M10 = _mm_set1_ps(transform.row[1].x), M11 = _mm_set1_ps(transform.row[1].y), M12 = _mm_set1_ps(transform.row[1].z);
+  const __m128 M20 = _mm_set1_ps(transform.row[2].x), M21 = _mm_set1_ps(transform.row[2].y), M22 = _mm_set1_ps(transform.row[2].z);
+  const __m128 signMask = _mm_set1_ps(-0.0f);
+  const __m128 minusOne = _mm_set1_ps(-1.0f);
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 half = _mm_set1_ps(0.5f);
+  const __m128 threeHalves = _mm_set1_ps(1.5f);
+  const __m128 dequantize = _mm_set1_ps(1.0f / 32767.0f);
+  const unsigned prefetchEnd = Stream_PrefetchEnd(count, sizeof(Vector2s), 256);
+  unsigned i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    if (i < prefetchEnd)
+    {
+      _mm_prefetch((const char*)&inputStream[i] + 256, _MM_HINT_T0);
+    }
+    // Each 32-bit lane holds the x and y of a normal, so shifting sign extends them
+    const __m128i xy = _mm_loadu_si128((const __m128i*)&inputStream[i]);
+    __m128 X = _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(xy, 16), 16)), dequantize), minusOne);
+    __m128 Y = _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(xy, 16)), dequantize), minusOne);
+    // Unfold the octahedron. \see Vector4f_OctahedralUnfold
+    const __m128 Z = _mm_sub_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, X)), _mm_andnot_ps(signMask, Y));
+    const __m128 T = _mm_max_ps(_mm_sub_ps(_mm_setzero_ps(), Z), _mm_setzero_ps());
+    X = _mm_sub_ps(X, _mm_or_ps(T, _mm_and_ps(X, signMask)));
+    Y = _mm_sub_ps(Y, _mm_or_ps(T, _mm_and_ps(Y, signMask)));
+    // Transform
+    __m128 OX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(X, M00), _mm_mul_ps(Y, M10)), _mm_mul_ps(Z, M20));
+    __m128 OY = _mm_add_ps(_mm_add_ps(_mm_mul_ps(X, M01), _mm_mul_ps(Y, M11)), _mm_mul_ps(Z, M21));
+    __m128 OZ = _mm_add_ps(_mm_add_ps(_mm_mul_ps(X, M02), _mm_mul_ps(Y, M12)), _mm_mul_ps(Z, M22));
+    // Normalize
+    const __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(OX, OX), _mm_mul_ps(OY, OY)), _mm_mul_ps(OZ, OZ));
+    __m128 R = _mm_rsqrt_ps(lengthSquared);
+    R = _mm_mul_ps(R, _mm_sub_ps(threeHalves, _mm_mul_ps(_mm_mul_ps(half, lengthSquared), _mm_mul_ps(R, R))));
+    OX = _mm_mul_ps(OX, R);
+    OY = _mm_mul_ps(OY, R);
+    OZ = _mm_mul_ps(OZ, R);
+    __m128 OW = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(OX, OY, OZ, OW);
+    _mm_storeu_ps(outputStream + 0, OX);
+    _mm_storeu_ps(outputStream + 4, OY);
+    _mm_storeu_ps(outputStream + 8, OZ);
+    _mm_storeu_ps(outputStream + 12, OW);
+    outputStream += 16;
+  }
+  Vector2s_TransformNormalStreamGeneric(outputStream, inputStream + i, count - i, transform);
+}
+
+#endif // MATHS3D_X86
+
+/// Function pointer type for the implementations of the quantized position stream transforms.
+template <typename QuantizedVector>
+using Vector4s_TransformStreamFunc = void (*)(float* outputStream, const QuantizedVector* inputStream, unsigned count, const Matrix4x4f& transform);
+
+/// Returns the implementation of the quantized position stream transform for the given instruction set.
+/// The SSE implementation is used for the AVX tiers.
+template <bool translate, bool divideByW, typename QuantizedVector, Precision precision = Precision::Exact>
+Vector4s_TransformStreamFunc<QuantizedVector> Vector4s_SelectTransformStream(InstructionSet isa)
+{
+#if MATHS3D_X86
+  if (isa != InstructionSet::Scalar)
+  {
+    return &Vector4s_SSETransformStreamGeneric<translate,divideByW,QuantizedVector,precision>;
+  }
+#endif
+  return &Vector4s_TransformStreamGeneric<translate,divideByW,QuantizedVector,precision>;
+}
+
+/// Transforms arrays of quantized positions using the best implementation for the CPU.
+/// \see Vector4s_TransformStreamGeneric for a description of the template parameters and parameters.
+template <bool translate, bool divideByW, typename QuantizedVector, Precision precision = Precision::Exact>
+void Vector4s_DispatchTransformStreamGeneric(float* outputStream, const QuantizedVector* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  static const Vector4s_TransformStreamFunc<QuantizedVector> kernel = Vector4s_SelectTransformStream<translate,divideByW,QuantizedVector,precision>(InstructionSet_Active());
+  kernel(outputStream, inputStream, count, transform);
+}
+
+/// Function pointer type for the implementations of the octahedral normal stream transforms.
+using Vector2s_TransformNormalStreamFunc = void (*)(float* outputStream, const Vector2s* inputStream, unsigned count, const Matrix4x4f& transform);
+
+/// Returns the implementation of the octahedral normal stream transform for the given instruction set.
+/// The SSE implementation is used for the AVX tiers.
+inline Vector2s_TransformNormalStreamFunc Vector2s_SelectTransformNormalStream(InstructionSet isa)
+{
+#if MATHS3D_X86
+  if (isa != InstructionSet::Scalar)
+  {
+    return &Vector2s_SSETransformNormalStream;
+  }
+#endif
+  return &Vector2s_TransformNormalStreamGeneric;
+}
+
+/// Dequantizes an array of count positions as inputStream[i] * scale + bias and transforms them without applying
+/// perspective, in a single pass.
+inline void Vector4s_TransformStream(Vector4f* outputStream, const Vector4s* inputStream, unsigned count, const Vector4f& scale, const Vector4f& bias, const Matrix4x4f& transform)
+{
+  Vector4s_DispatchTransformStreamGeneric<true,false>(outputStream->v, inputStream, count, Matrix4x4f_Dequantized(transform, scale, bias));
+}
+
+/// Dequantizes an array of count positions as inputStream[i] * scale + bias and transforms them with perspective,
+/// dividing by w with the given precision, in a single pass.
+template <Precision precision = Precision::Exact>
+void Vector4s_TransformCoordStream(Vector4f* outputStream, const Vector4s* inputStream, unsigned count, const Vector4f& scale, const Vector4f& bias, const Matrix4x4f& transform)
+{
+  Vector4s_DispatchTransformStreamGeneric<true,true,Vector4s,precision>(outputStream->v, inputStream, count, Matrix4x4f_Dequantized(transform, scale, bias));
+}
+
+/// Dequantizes an array of count unsigned positions as inputStream[i] * scale + bias and transforms them without
+/// applying perspective, in a single pass.
+inline void Vector4us_TransformStream(Vector4f* outputStream, const Vector4us* inputStream, unsigned count, const Vector4f& scale, const Vector4f& bias, const Matrix4x4f& transform)
+{
+  Vector4s_DispatchTransformStreamGeneric<true,false>(outputStream->v, inputStream, count, Matrix4x4f_Dequantized(transform, scale, bias));
+}
+
+/// Dequantizes an array of count unsigned positions as inputStream[i] * scale + bias and transforms them with
+/// perspective, dividing by w with the given precision, in a single pass.
+template <Precision precision = Precision::Exact>
+void Vector4us_TransformCoordStream(Vector4f* outputStream, const Vector4us* inputStream, unsigned count, const Vector4f& scale, const Vector4f& bias, const Matrix4x4f& transform)
+{
+  Vector4s_DispatchTransformStreamGeneric<true,true,Vector4us,precision>(outputStream->v, inputStream, count, Matrix4x4f_Dequantized(transform, scale, bias));
+}
+
+/// Decodes an array of count octahedral encoded normals, transforms them and renormalizes them in a single pass.
+/// \see Vector2s_TransformNormalStreamGeneric
+inline void Vector2s_TransformNormalStream(Vector4f* outputStream, const Vector2s* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  static const Vector2s_TransformNormalStreamFunc kernel = Vector2s_SelectTransformNormalStream(InstructionSet_Active());
+  kernel(outputStream->v, inputStream, count, transform);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// Batch trigonometry
+
+/// \brief
+/// The sines and cosines of four angles.
+struct SinCos4f
+{
+  Vector4f sin;
+  Vector4f cos;
+};
+
+#if MATHS3D_X86
+
+/// Calculates the sines and cosines of four angles in radians with the given precision (SSE2 implementation).
+/// These are the same polynomial approximations as Radians_SinCos<precision>, so have the same accuracy, which is
+/// within 2 ULP for angles between -8192 and 8192 when exact.
+template <Precision precision = Precision::Exact>
+inline void Vector4f_SSESinCos(__m128 angles, __m128& sines, __m128& cosines)
+{
+  const __m128 signMask = _mm_set1_ps(-0.0f);
+  const __m128 x = _mm_andnot_ps(signMask, angles);
+  // x * 4/pi rounded up to even gives the octant
+  __m128i octant = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.27323954473516f)));
+  octant = _mm_and_si128(_mm_add_epi32(octant, _mm_set1_epi32(1)), _mm_set1_epi32(~1));
+  // Subtract octant * pi/4 in double precision, as Radians_SinCos does. The usual float version with pi/4 split in to
+  // 3 parts isn't exact for octants above about 4096, as the product with the second part needs more than 24 bits.
+  const __m128d quarterPi = _mm_set1_pd(0.78539816339744830962);
+  const __m128d rLow = _mm_sub_pd(_mm_cvtps_pd(x), _mm_mul_pd(_mm_cvtepi32_pd(octant), quarterPi));
+  const __m128d rHigh = _mm_sub_pd(_mm_cvtps_pd(_mm_movehl_ps(x, x)), _mm_mul_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(octant, octant)), quarterPi));
+  const __m128 r = _mm_movelh_ps(_mm_cvtpd_ps(rLow), _mm_cvtpd_ps(rHigh));
+  const __m128 z = _mm_mul_ps(r, r);
+  __m128 s, c;
+  if (precision == Precision::Fastest)
+  {
+    s = _mm_mul_ps(_mm_set1_ps(-1.6226767e-1f), z);
+    c = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(4.0491350e-2f), z), _mm_set1_ps(-4.9977723e-1f)), z), _mm_set1_ps(1.0f));
+  }
+  else
+  {
+    if (precision == Precision::Exact)
+    {
+      s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-1.9515295891e-4f), z), _mm_set1_ps(8.3321608736e-3f));
+      s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(-1.6666654611e-1f));
+      c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(2.443315711809948e-5f), z), _mm_set1_ps(-1.388731625493765e-3f));
+      c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(4.166664568298827e-2f));
+    }
+    else
+    {
+      s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(8.1533752e-3f), z), _mm_set1_ps(-1.6662850e-1f));
+      c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-1.3652966e-3f), z), _mm_set1_ps(4.1661302e-2f));
+    }
+    s = _mm_mul_ps(s, z);
+    c = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(_mm_mul_ps(c, z), z), _mm_mul_ps(_mm_set1_ps(0.5f), z)), _mm_set1_ps(1.0f));
+  }
+  s = _mm_add_ps(_mm_mul_ps(s, r), r);
+  // Swap and negate the polynomials based on the octant. \see Radians_SinCos
+  const __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(octant, _mm_set1_epi32(2)), _mm_set1_epi32(2)));
+  const __m128 sinSign = _mm_xor_ps(_mm_and_ps(angles, signMask), _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(octant, _mm_set1_epi32(4)), 29)));
+  const __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_andnot_si128(_mm_sub_epi32(octant, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29));
+  sines = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s)), sinSign);
+  cosines = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c)), cosSign);
+}
+
+#endif // MATHS3D_X86
+
+/// Calculates the sines and cosines of the four angles in radians in angles with the given precision.
+/// \see Radians_SinCos<Precision> for the accuracy.
+template <Precision precision = Precision::Exact>
+inline SinCos4f Vector4f_SinCos(const Vector4f& angles)
+{
+  SinCos4f ret;
+#if MATHS3D_X86
+  __m128 sines, cosines;
+  Vector4f_SSESinCos<precision>(_mm_loadu_ps(angles.v), sines, cosines);
+  _mm_storeu_ps(ret.sin.v, sines);
+  _mm_storeu_ps(ret.cos.v, cosines);
+#else
+  for (int i = 0; i < 4; ++i)
+  {
+    const SinCos1f sinCos = Radians_SinCos<precision>(Radians{ angles.v[i] });
+    ret.sin.v[i] = sinCos.sin;
+    ret.cos.v[i] = sinCos.cos;
+  }
+#endif
+  return ret;
+}
+
+/// Calculates the sines of the four angles in radians in angles with the given precision.
+template <Precision precision = Precision::Exact>
+inline Vector4f Vector4f_Sin(const Vector4f& angles)
+{
+  return Vector4f_SinCos<precision>(angles).sin;
+}
+
+/// Calculates the cosines of the four angles in radians in angles with the given precision.
+template <Precision precision = Precision::Exact>
+inline Vector4f Vector4f_Cos(const Vector4f& angles)
+{
+  return Vector4f_SinCos<precision>(angles).cos;
+}
+
+/// Calculates the tangents of the four angles in radians in angles with the given precision.
+/// \see Radians_Tan<Precision> for the accuracy.
+template <Precision precision = Precision::Exact>
+inline Vector4f Vector4f_Tan(const Vector4f& angles)
+{
+  Vector4f ret;
+#if MATHS3D_X86
+  __m128 sines, cosines;
+  Vector4f_SSESinCos<precision>(_mm_loadu_ps(angles.v), sines, cosines);
+  // Exact uses a divide -ffast-math can't replace with the reciprocal estimate, which costs about 1 ULP more
+  const __m128 tangents = (precision == Precision::Exact) ? Vector4f_SSEExactDivide(sines, cosines) :
+                                                            _mm_mul_ps(sines, Vector4f_SSEReciprocal<precision>(cosines));
+  _mm_storeu_ps(ret.v, tangents);
+#else
+  for (int i = 0; i < 4; ++i)
+  {
+    ret.v[i] = Radians_Tan<precision>(Radians{ angles.v[i] });
+  }
+#endif
+  return ret;
+}
+
+/// Calculates the sines and cosines of an array of count angles, four at a time.
+/// \param sines is the output array for the sines of the angles. This may be null if they aren't needed.
+/// \param cosines is the output array for the cosines of the angles. This may be null if they aren't needed.
+/// \param angles is the input array of angles.
+/// \param count is the number of angles.
+inline void Radians_SinCosStream(Scalar1f* sines, Scalar1f* cosines, const Radians* angles, unsigned count)
+{
+  static_assert(sizeof(Radians) == sizeof(Scalar1f), "Radians needs to be the same as a Scalar1f");
+  unsigned i = 0;
+#if MATHS3D_X86
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128 s, c;
+    Vector4f_SSESinCos(_mm_loadu_ps(&angles[i].value), s, c);
+    if (sines)
+    {
+      _mm_storeu_ps(sines + i, s);
+    }
+    if (cosines)
+    {
+      _mm_storeu_ps(cosines + i, c);
+    }
+  }
+#endif
+  for (; i < count; ++i)
+  {
+    const SinCos1f sinCos = Radians_SinCos(angles[i]);
+    if (sines)
+    {
+      sines[i] = sinCos.sin;
+    }
+    if (cosines)
+    {
+      cosines[i] = sinCos.cos;
+    }
+  }
+}
+
+/// Creates an array of count rotation matrices about the given axis (0, 1 or 2 for x, y or z) from an array of
+/// count angles. The sines and cosines are calculated four at a time.
+/// \see Matrix4x4f_RotateCommon
+inline void Matrix4x4f_RotateStream(Matrix4x4f* outputStream, const Radians* angles, unsigned count, int axis)
+{
+  unsigned i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    const SinCos4f sinCos = Vector4f_SinCos(Vector4f_Set(angles[i+0].value, angles[i+1].value, angles[i+2].value, angles[i+3].value));
+    for (int j = 0; j < 4; ++j)
+    {
+      outputStream[i+j] = Matrix4x4f_RotateSinCos(SinCos1f{ sinCos.sin.v[j], sinCos.cos.v[j] }, axis);
+    }
+  }
+  for (; i < count; ++i)
+  {
+    outputStream[i] = Matrix4x4f_RotateSinCos(Radians_SinCos(angles[i]), axis);
+  }
+}
+
+/// Creates an array of count matrices which rotate about the x axis by the angles in the angles array.
+inline void Matrix4x4f_RotateXStream(Matrix4x4f* outputStream, const Radians* angles, unsigned count)
+{
+  Matrix4x4f_RotateStream(outputStream, angles, count, 0);
+}
+
+/// Creates an array of count matrices which rotate about the y axis by the angles in the angles array.
+inline void Matrix4x4f_RotateYStream(Matrix4x4f* outputStream, const Radians* angles, unsigned count)
+{
+  Matrix4x4f_RotateStream(outputStream, angles, count, 1);
+}
+
+/// Creates an array of count matrices which rotate about the z axis by the angles in the angles array.
+inline void Matrix4x4f_RotateZStream(Matrix4x4f* outputStream, const Radians* angles, unsigned count)
+{
+  Matrix4x4f_RotateStream(outputStream, angles, count, 2);
+}
+
+/// Creates an array of count matrices which rotate about the x, y and z axes by the rotations in the rotations
+/// array. The sines and cosines are calculated for four rotations at a time.
+/// \see Matrix4x4f_RotateXYZ
+inline void Matrix4x4f_RotateXYZStream(Matrix4x4f* outputStream, const Rotation* rotations, unsigned count)
+{
+  unsigned i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    SinCos4f sinCos[3];
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      const Degrees Rotation::* member = (axis == 0) ? &Rotation::x : (axis == 1) ? &Rotation::y : &Rotation::z;
+      sinCos[axis] = Vector4f_SinCos(Vector4f_Set(Radians(rotations[i+0].*member).value, Radians(rotations[i+1].*member).value,
+                                                  Radians(rotations[i+2].*member).value, Radians(rotations[i+3].*member).value));
+    }
+    for (int j = 0; j < 4; ++j)
+    {
+      outputStream[i+j] = Matrix4x4f_RotateSinCosXYZ(SinCos1f{ sinCos[0].sin.v[j], sinCos[0].cos.v[j] },
+                                                     SinCos1f{ sinCos[1].sin.v[j], sinCos[1].cos.v[j] },
+                                                     SinCos1f{ sinCos[2].sin.v[j], sinCos[2].cos.v[j] });
+    }
+  }
+  for (; i < count; ++i)
+  {
+    outputStream[i] = Matrix4x4f_RotateXYZ(rotations[i]);
+  }
+}
+
+/// Creates an array of count perspective projection matrices, one for each of the fields of view in the
+/// fieldsOfView array, with the tangents calculated four at a time.
+/// \see Matrix4x4f_PerspectiveFrustum
+inline void Matrix4x4f_PerspectiveFrustumStream(Matrix4x4f* outputStream, const Radians* fieldsOfView, unsigned count, Scalar1f aspectRatio, Scalar1f near, Scalar1f far)
+{
+  // All but the scaling of x and y are the same for each matrix
+  const Matrix4x4f common = Matrix4x4f_PerspectiveFrustum(Radians{ 1.0f }, aspectRatio, near, far);
+  unsigned i = 0;
+  for (; i < count; i += 4)
+  {
+    Vector4f halfAngles = Vector4f_Replicate(1.0f);
+    for (unsigned j = 0; j < 4 && i + j < count; ++j)
+    {
+      halfAngles.v[j] = fieldsOfView[i+j].value * 0.5f;
+    }
+    const SinCos4f sinCos = Vector4f_SinCos(halfAngles);
+    for (unsigned j = 0; j < 4 && i + j < count; ++j)
+    {
+      const Scalar1f invTan = sinCos.cos.v[j] / sinCos.sin.v[j];
+      outputStream[i+j] = common;
+      outputStream[i+j].m[0][0] = invTan / aspectRatio;
+      outputStream[i+j].m[1][1] = invTan;
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// Batch matrix multiplies and inverses
+
+/// Multiplies count pairs of matrices, where the matrices are members of structures which are outputStride,
+/// inputStride1 and inputStride2 floats apart (non-SIMD fallback implementation). Each output is
+/// Matrix4x4f_Multiply of the matrices at the same index in the two input streams.
+/// \param outputStream is where to put the resulting matrices. This may be the same as one of the input streams
+///        if the stride is the same as it.
+/// \param inputStream1, inputStream2 are the first and second matrix of each multiply. A stride of 0 uses the
+///        same matrix for every multiply, for example to concatenate a palette of matrices with a view matrix.
+/// \param count is the number of multiplies to do.
+inline void Matrix4x4f_MultiplyStreamGeneric(float* outputStream, unsigned outputStride, const float* inputStream1, unsigned inputStride1,
+                                             const float* inputStream2, unsigned inputStride2, unsigned count)
+{
+  for (unsigned i = 0; i < count; ++i)
+  {
+    const Matrix4x4f result = Matrix4x4f_Multiply(Matrix4x4f_Set(inputStream1 + i * inputStride1), Matrix4x4f_Set(inputStream2 + i * inputStride2));
+    for (int j = 0; j < 16; ++j)
+    {
+      outputStream[i * outputStride + j] = result.v[j];
+    }
+  }
+}
+
+/// Inverts count matrices, where the matrices are members of structures which are outputStride and inputStride
+/// floats apart (non-SIMD fallback implementation). Matrices which are not invertible give a zero matrix.
+/// \see Matrix4x4f_Inversed
+/// \param outputStream is where to put the inverted matrices. This may be the same as inputStream if the
+///        strides are the same.
+/// \param inputStream is the matrices to invert.
+/// \param count is the number of matrices to invert.
+inline void Matrix4x4f_InverseStreamGeneric(float* outputStream, unsigned outputStride, const float* inputStream, unsigned inputStride, unsigned count)
+{
+  for (unsigned i = 0; i < count; ++i)
+  {
+    const Matrix4x4f result = Matrix4x4f_Inversed(Matrix4x4f_Set(inputStream + i * inputStride));
+    for (int j = 0; j < 16; ++j)
+    {
+      outputStream[i * outputStride + j] = result.v[j];
+    }
+  }
+}
+
+#if MATHS3D_X86
+
+/// Loads 4 matrices which are stride floats apart and transposes them so that m[4*row+column] holds that element
+/// of each of the matrices, one matrix per lane. All 4 matrices can then be worked on with the scalar formulas.
+inline void Matrix4x4f_SSELoadSoA(__m128 (&m)[16], const float* inputStream, unsigned stride)
+{
+  for (int r = 0; r < 4; ++r)
+  {
+    __m128 c0 = _mm_loadu_ps(inputStream + 0 * stride + 4 * r);
+    __m128 c1 = _mm_loadu_ps(inputStream + 1 * stride + 4 * r);
+    __m128 c2 = _mm_loadu_ps(inputStream + 2 * stride + 4 * r);
+    __m128 c3 = _mm_loadu_ps(inputStream + 3 * stride + 4 * r);
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    m[4*r+0] = c0;
+    m[4*r+1] = c1;
+    m[4*r+2] = c2;
+    m[4*r+3] = c3;
+  }
+}
+
+/// Transposes 4 matrices back from the layout of Matrix4x4f_SSELoadSoA and stores them stride floats apart.
+inline void Matrix4x4f_SSEStoreSoA(float* outputStream, unsigned stride, const __m128 (&m)[16])
+{
+  for (int r = 0; r < 4; ++r)
+  {
+    __m128 c0 = m[4*r+0], c1 = m[4*r+1], c2 = m[4*r+2], c3 = m[4*r+3];
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    _mm_storeu_ps(outputStream + 0 * stride + 4 * r, c0);
+    _mm_storeu_ps(outputStream + 1 * stride + 4 * r, c1);
+    _mm_storeu_ps(outputStream + 2 * stride + 4 * r, c2);
+    _mm_storeu_ps(outputStream + 3 * stride + 4 * r, c3);
+  }
+}
+
+/// Calculates a*x - b*y + c*z, the form of each cofactor when expanded with the 2x2 minors.
+inline __m128 Matrix4x4f_SSECofactor(__m128 a, __m128 x, __m128 b, __m128 y, __m128 c, __m128 z)
+{
+  return _mm_add_ps(_mm_sub_ps(_mm_mul_ps(a, x), _mm_mul_ps(b, y)), _mm_mul_ps(c, z));
+}
+
+/// Multiplies pairs of matrices (SSE implementation). Unlike the inverse, the multiply stays in the layout of
+/// Matrix4x4f_Multiply, with each row of the result being the rows of the first matrix weighted by the splatted
+/// elements of the second, as that needs no transposes and only 4 registers for the rows. Being inline, the
+/// rows of the first matrix are loaded straight from the stream and there is no call per matrix.
+/// \see Matrix4x4f_MultiplyStreamGeneric for a description of the parameters.
+inline void Matrix4x4f_SSEMultiplyStream(float* outputStream, unsigned outputStride, const float* inputStream1, unsigned inputStride1,
+                                         const float* inputStream2, unsigned inputStride2, unsigned count)
+{
+  for (unsigned i = 0; i < count; ++i)
+  {
+    const float* a = inputStream1 + i * inputStride1;
+    const float* b = inputStream2 + i * inputStride2;
+    const __m128 a0 = _mm_loadu_ps(a + 0), a1 = _mm_loadu_ps(a + 4), a2 = _mm_loadu_ps(a + 8), a3 = _mm_loadu_ps(a + 12);
+    // The first matrix is already loaded and each row of the result only needs the same row of the second, so the
+    // rows are stored straight away and the output can still be the same as either input
+    for (int r = 0; r < 4; ++r)
+    {
+      const __m128 row = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0, _mm_set1_ps(b[4*r+0])), _mm_mul_ps(a1, _mm_set1_ps(b[4*r+1]))),
+                                    _mm_add_ps(_mm_mul_ps(a2, _mm_set1_ps(b[4*r+2])), _mm_mul_ps(a3, _mm_set1_ps(b[4*r+3]))));
+      _mm_storeu_ps(outputStream + i * outputStride + 4 * r, row);
+    }
+  }
+}
+
+/// Inverts matrices, 4 per iteration (SSE implementation). The 12 shared 2x2 minors, 16 cofactors and the
+/// determinant are each calculated for 4 matrices at once, with no shuffles between the transposes.
+/// \see Matrix4x4f_InverseStreamGeneric for a description of the parameters.
+inline void Matrix4x4f_SSEInverseStream(float* outputStream, unsigned outputStride, const float* inputStream, unsigned inputStride, unsigned count)
+{
+  unsigned i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128 m[16], out[16];
+    Matrix4x4f_SSELoadSoA(m, inputStream + i * inputStride, inputStride);
+    // 2x2 minors of the top two rows (s) and the bottom two rows (c), named by the pair of columns they use
+    const __m128 s01 = _mm_sub_ps(_mm_mul_ps(m[0], m[5]), _mm_mul_ps(m[4], m[1]));
+    const __m128 s02 = _mm_sub_ps(_mm_mul_ps(m[0], m[6]), _mm_mul_ps(m[4], m[2]));
+    const __m128 s03 = _mm_sub_ps(_mm_mul_ps(m[0], m[7]), _mm_mul_ps(m[4], m[3]));
+    const __m128 s12 = _mm_sub_ps(_mm_mul_ps(m[1], m[6]), _mm_mul_ps(m[5], m[2]));
+    const __m128 s13 = _mm_sub_ps(_mm_mul_ps(m[1], m[7]), _mm_mul_ps(m[5], m[3]));
+    const __m128 s23 = _mm_sub_ps(_mm_mul_ps(m[2], m[7]), _mm_mul_ps(m[6], m[3]));
+    const __m128 c01 = _mm_sub_ps(_mm_mul_ps(m[8], m[13]), _mm_mul_ps(m[12], m[9]));
+    const __m128 c02 = _mm_sub_ps(_mm_mul_ps(m[8], m[14]), _mm_mul_ps(m[12], m[10]));
+    const __m128 c03 = _mm_sub_ps(_mm_mul_ps(m[8], m[15]), _mm_mul_ps(m[12], m[11]));
+    const __m128 c12 = _mm_sub_ps(_mm_mul_ps(m[9], m[14]), _mm_mul_ps(m[13], m[10]));
+    const __m128 c13 = _mm_sub_ps(_mm_mul_ps(m[9], m[15]), _mm_mul_ps(m[13], m[11]));
+    const __m128 c23 = _mm_sub_ps(_mm_mul_ps(m[10], m[15]), _mm_mul_ps(m[14], m[11]));
+    // The cofactors without their checkerboard signs, which are applied with the scale by the determinant
+    out[0]  = Matrix4x4f_SSECofactor(m[5], c23, m[6], c13, m[7], c12);
+    out[1]  = Matrix4x4f_SSECofactor(m[1], c23, m[2], c13, m[3], c12);
+    out[2]  = Matrix4x4f_SSECofactor(m[13], s23, m[14], s13, m[15], s12);
+    out[3]  = Matrix4x4f_SSECofactor(m[9], s23, m[10], s13, m[11], s12);
+    out[4]  = Matrix4x4f_SSECofactor(m[4], c23, m[6], c03, m[7], c02);
+    out[5]  = Matrix4x4f_SSECofactor(m[0], c23, m[2], c03, m[3], c02);
+    out[6]  = Matrix4x4f_SSECofactor(m[12], s23, m[14], s03, m[15], s02);
+    out[7]  = Matrix4x4f_SSECofactor(m[8], s23, m[10], s03, m[11], s02);
+    out[8]  = Matrix4x4f_SSECofactor(m[4], c13, m[5], c03, m[7], c01);
+    out[9]  = Matrix4x4f_SSECofactor(m[0], c13, m[1], c03, m[3], c01);
+    out[10] = Matrix4x4f_SSECofactor(m[12], s13, m[13], s03, m[15], s01);
+    out[11] = Matrix4x4f_SSECofactor(m[8], s13, m[9], s03, m[11], s01);
+    out[12] = Matrix4x4f_SSECofactor(m[4], c12, m[5], c02, m[6], c01);
+    out[13] = Matrix4x4f_SSECofactor(m[0], c12, m[1], c02, m[2], c01);
+    out[14] = Matrix4x4f_SSECofactor(m[12], s12, m[13], s02, m[14], s01);
+    out[15] = Matrix4x4f_SSECofactor(m[8], s12, m[9], s02, m[10], s01);
+    // Expanding along the first column gives the determinant. Singular matrices get a scale of 0, so give zero.
+    const __m128 det = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(m[0], out[0]), _mm_mul_ps(m[4], out[1])),
+                                  _mm_sub_ps(_mm_mul_ps(m[8], out[2]), _mm_mul_ps(m[12], out[3])));
+    const __m128 invDet = _mm_andnot_ps(_mm_cmpeq_ps(det, _mm_setzero_ps()), _mm_div_ps(_mm_set1_ps(1.0f), det));
+    const __m128 negInvDet = _mm_sub_ps(_mm_setzero_ps(), invDet);
+    for (int j = 0; j < 16; ++j)
+    {
+      out[j] = _mm_mul_ps(out[j], (((j >> 2) ^ j) & 1) ? negInvDet : invDet);
+    }
+    Matrix4x4f_SSEStoreSoA(outputStream + i * outputStride, outputStride, out);
+  }
+  Matrix4x4f_InverseStreamGeneric(outputStream + i * outputStride, outputStride, inputStream + i * inputStride, inputStride, count - i);
+}
+
+/// Loads 8 matrices which are stride floats apart in to the layout of Matrix4x4f_SSELoadSoA, with matrices 0 to 3
+/// in the low 128-bit lanes and 4 to 7 in the high lanes. The 4x4 transpose works within each lane.
+MATHS3D_TARGET("avx2,fma")
+inline void Matrix4x4f_AVX2LoadSoA(__m256 (&m)[16], const float* inputStream, unsigned stride)
+{
+  for (int r = 0; r < 4; ++r)
+  {
+    __m256 c[4];
+    for (int j = 0; j < 4; ++j)
+    {
+      c[j] = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(inputStream + j * stride + 4 * r)),
+                                  _mm_loadu_ps(inputStream + (j + 4) * stride + 4 * r), 1);
+    }
+    const __m256 t0 = _mm256_unpacklo_ps(c[0], c[1]);
+    const __m256 t1 = _mm256_unpacklo_ps(c[2], c[3]);
+    const __m256 t2 = _mm256_unpackhi_ps(c[0], c[1]);
+    const __m256 t3 = _mm256_unpackhi_ps(c[2], c[3]);
+    m[4*r+0] = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1,0,1,0));
+    m[4*r+1] = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3,2,3,2));
+    m[4*r+2] = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1,0,1,0));
+    m[4*r+3] = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3,2,3,2));
+  }
+}
+
+/// Transposes 8 matrices back from the layout of Matrix4x4f_AVX2LoadSoA and stores them stride floats apart.
+MATHS3D_TARGET("avx2,fma")
+inline void Matrix4x4f_AVX2StoreSoA(float* outputStream, unsigned stride, const __m256 (&m)[16])
+{
+  for (int r = 0; r < 4; ++r)
+  {
+    const __m256 t0 = _mm256_unpacklo_ps(m[4*r+0], m[4*r+1]);
+    const __m256 t1 = _mm256_unpacklo_ps(m[4*r+2], m[4*r+3]);
+    const __m256 t2 = _mm256_unpackhi_ps(m[4*r+0], m[4*r+1]);
+    const __m256 t3 = _mm256_unpackhi_ps(m[4*r+2], m[4*r+3]);
+    const __m256 c[4] = { _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1,0,1,0)), _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3,2,3,2)),
+                          _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1,0,1,0)), _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3,2,3,2)) };
+    for (int j = 0; j < 4; ++j)
+    {
+      _mm_storeu_ps(outputStream + j * stride + 4 * r, _mm256_castps256_ps128(c[j]));
+      _mm_storeu_ps(outputStream + (j + 4) * stride + 4 * r, _mm256_extractf128_ps(c[j], 1));
+    }
+  }
+}
+
+/// Calculates a*x - b*y + c*z with fused multiply-adds. \see Matrix4x4f_SSECofactor
+MATHS3D_TARGET("avx2,fma")
+inline __m256 Matrix4x4f_AVX2Cofactor(__m256 a, __m256 x, __m256 b, __m256 y, __m256 c, __m256 z)
+{
+  return _mm256_fmadd_ps(c, z, _mm256_fnmadd_ps(b, y, _mm256_mul_ps(a, x)));
+}
+
+/// Calculates the 2x2 minor a*b - c*d with a fused multiply-subtract.
+MATHS3D_TARGET("avx2,fma")
+inline __m256 Matrix4x4f_AVX2Minor(__m256 a, __m256 b, __m256 c, __m256 d)
+{
+  return _mm256_fmsub_ps(a, b, _mm256_mul_ps(c, d));
+}
+
+/// Multiplies pairs of matrices (AVX2 and FMA implementation). \see Matrix4x4f_SSEMultiplyStream
+/// \note must only be called if the CPU supports AVX2 and FMA. \see InstructionSet_IsSupported
+/// \see Matrix4x4f_MultiplyStreamGeneric for a description of the parameters.
+MATHS3D_TARGET("avx2,fma")
+inline void Matrix4x4f_AVX2MultiplyStream(float* outputStream, unsigned outputStride, const float* inputStream1, unsigned inputStride1,
+                                          const float* inputStream2, unsigned inputStride2, unsigned count)
+{
+  for (unsigned i = 0; i < count; ++i)
+  {
+    const float* a = inputStream1 + i * inputStride1;
+    const float* b = inputStream2 + i * inputStride2;
+    const __m128 a0 = _mm_loadu_ps(a + 0), a1 = _mm_loadu_ps(a + 4), a2 = _mm_loadu_ps(a + 8), a3 = _mm_loadu_ps(a + 12);
+    for (int r = 0; r < 4; ++r)
+    {
+      // The splats are broadcasts from memory, so each row is 4 loads, a multiply and 3 fused multiply-adds
+      __m128 row = _mm_mul_ps(a0, _mm_broadcast_ss(b + 4*r+0));
+      row = _mm_fmadd_ps(a1, _mm_broadcast_ss(b + 4*r+1), row);
+      row = _mm_fmadd_ps(a2, _mm_broadcast_ss(b + 4*r+2), row);
+      row = _mm_fmadd_ps(a3, _mm_broadcast_ss(b + 4*r+3), row);
+      _mm_storeu_ps(outputStream + i * outputStride + 4 * r, row);
+    }
+  }
+}
+
+/// Inverts matrices, 8 per iteration (AVX2 and FMA implementation).
+/// \note must only be called if the CPU supports AVX2 and FMA. \see InstructionSet_IsSupported
+/// \see Matrix4x4f_SSEInverseStream for how the inverse is calculated.
+MATHS3D_TARGET("avx2,fma")
+inline void Matrix4x4f_AVX2InverseStream(float* outputStream, unsigned outputStride, const float* inputStream, unsigned inputStride, unsigned count)
+{
+  unsigned i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256 m[16], out[16];
+    Matrix4x4f_AVX2LoadSoA(m, inputStream + i * inputStride, inputStride);
+    const __m256 s01 = Matrix4x4f_AVX2Minor(m[0], m[5], m[4], m[1]);
+    const __m256 s02 = Matrix4x4f_AVX2Minor(m[0], m[6], m[4], m[2]);
+    const __m256 s03 = Matrix4x4f_AVX2Minor(m[0], m[7], m[4], m[3]);
+    const __m256 s12 = Matrix4x4f_AVX2Minor(m[1], m[6], m[5], m[2]);
+    const __m256 s13 = Matrix4x4f_AVX2Minor(m[1], m[7], m[5], m[3]);
+    const __m256 s23 = Matrix4x4f_AVX2Minor(m[2], m[7], m[6], m[3]);
+    const __m256 c01 = Matrix4x4f_AVX2Minor(m[8], m[13], m[12], m[9]);
+    const __m256 c02 = Matrix4x4f_AVX2Minor(m[8], m[14], m[12], m[10]);
+    const __m256 c03 = Matrix4x4f_AVX2Minor(m[8], m[15], m[12], m[11]);
+    const __m256 c12 = Matrix4x4f_AVX2Minor(m[9], m[14], m[13], m[10]);
+    const __m256 c13 = Matrix4x4f_AVX2Minor(m[9], m[15], m[13], m[11]);
+    const __m256 c23 = Matrix4x4f_AVX2Minor(m[10], m[15], m[14], m[11]);
+    out[0]  = Matrix4x4f_AVX2Cofactor(m[5], c23, m[6], c13, m[7], c12);
+    out[1]  = Matrix4x4f_AVX2Cofactor(m[1], c23, m[2], c13, m[3], c12);
+    out[2]  = Matrix4x4f_AVX2Cofactor(m[13], s23, m[14], s13, m[15], s12);
+    out[3]  = Matrix4x4f_AVX2Cofactor(m[9], s23, m[10], s13, m[11], s12);
+    out[4]  = Matrix4x4f_AVX2Cofactor(m[4], c23, m[6], c03, m[7], c02);
+    out[5]  = Matrix4x4f_AVX2Cofactor(m[0], c23, m[2], c03, m[3], c02);
+    out[6]  = Matrix4x4f_AVX2Cofactor(m[12], s23, m[14], s03, m[15], s02);
+    out[7]  = Matrix4x4f_AVX2Cofactor(m[8], s23, m[10], s03, m[11], s02);
+    out[8]  = Matrix4x4f_AVX2Cofactor(m[4], c13, m[5], c03, m[7], c01);
+    out[9]  = Matrix4x4f_AVX2Cofactor(m[0], c13, m[1], c03, m[3], c01);
+    out[10] = Matrix4x4f_AVX2Cofactor(m[12], s13, m[13], s03, m[15], s01);
+    out[11] = Matrix4x4f_AVX2Cofactor(m[8], s13, m[9], s03, m[11], s01);
+    out[12] = Matrix4x4f_AVX2Cofactor(m[4], c12, m[5], c02, m[6], c01);
+    out[13] = Matrix4x4f_AVX2Cofactor(m[0], c12, m[1], c02, m[2], c01);
+    out[14] = Matrix4x4f_AVX2Cofactor(m[12], s12, m[13], s02, m[14], s01);
+    out[15] = Matrix4x4f_AVX2Cofactor(m[8], s12, m[9], s02, m[10], s01);
+    const __m256 det = _mm256_fmadd_ps(m[0], out[0], _mm256_fnmadd_ps(m[4], out[1], _mm256_fmsub_ps(m[8], out[2], _mm256_mul_ps(m[12], out[3]))));
+    const __m256 invDet = _mm256_andnot_ps(_mm256_cmp_ps(det, _mm256_setzero_ps(), _CMP_EQ_OQ), _mm256_div_ps(_mm256_set1_ps(1.0f), det));
+    const __m256 negInvDet = _mm256_sub_ps(_mm256_setzero_ps(), invDet);
+    for (int j = 0; j < 16; ++j)
+    {
+      out[j] = _mm256_mul_ps(out[j], (((j >> 2) ^ j) & 1) ? negInvDet : invDet);
+    }
+    Matrix4x4f_AVX2StoreSoA(outputStream + i * outputStride, outputStride, out);
+  }
+  Matrix4x4f_SSEInverseStream(outputStream + i * outputStride, outputStride, inputStream + i * inputStride, inputStride, count - i);
+}
+
+#endif // MATHS3D_X86
+
+/// Function pointer type for the implementations of the batch matrix multiplies.
+using Matrix4x4f_MultiplyStreamFunc = void (*)(float* outputStream, unsigned outputStride, const float* inputStream1, unsigned inputStride1,
+                                               const float* inputStream2, unsigned inputStride2, unsigned count);
+
+/// Function pointer type for the implementations of the batch matrix inverses.
+using Matrix4x4f_InverseStreamFunc = void (*)(float* outputStream, unsigned outputStride, const float* inputStream, unsigned inputStride, unsigned count);
+
+/// Returns the implementation of the batch matrix multiply for the given instruction set.
+/// The AVX-512 tier uses the AVX2 implementation.
+inline Matrix4x4f_MultiplyStreamFunc Matrix4x4f_SelectMultiplyStream(InstructionSet isa)
+{
+  switch (isa)
+  {
+#if MATHS3D_X86
+    case InstructionSet::AVX512:
+    case InstructionSet::AVX2:
+      return &Matrix4x4f_AVX2MultiplyStream;
+    case InstructionSet::SSE:
+      return &Matrix4x4f_SSEMultiplyStream;
+#endif
+    default:
+      return &Matrix4x4f_MultiplyStreamGeneric;
+  }
+}
+
+/// Returns the implementation of the batch matrix inverse for the given instruction set.
+/// \see Matrix4x4f_SelectMultiplyStream
+inline Matrix4x4f_InverseStreamFunc Matrix4x4f_SelectInverseStream(InstructionSet isa)
+{
+  switch (isa)
+  {
+#if MATHS3D_X86
+    case InstructionSet::AVX512:
+    case InstructionSet::AVX2:
+      return &Matrix4x4f_AVX2InverseStream;
+    case InstructionSet::SSE:
+      return &Matrix4x4f_SSEInverseStream;
+#endif
+    default:
+      return &Matrix4x4f_InverseStreamGeneric;
+  }
+}
+
+/// Multiplies count pairs of matrices which are members of structures, using the best implementation for the CPU.
+/// \see Matrix4x4f_MultiplyStreamGeneric for a description of the parameters.
+inline void Matrix4x4f_MultiplyStream(float* outputStream, unsigned outputStride, const float* inputStream1, unsigned inputStride1,
+                                      const float* inputStream2, unsigned inputStride2, unsigned count)
+{
+  static const Matrix4x4f_MultiplyStreamFunc kernel = Matrix4x4f_SelectMultiplyStream(InstructionSet_Active());
+  kernel(outputStream, outputStride, inputStream1, inputStride1, inputStream2, inputStride2, count);
+}
+
+/// Multiplies each matrix in inputStream1 with the matrix at the same index in inputStream2.
+/// \see Matrix4x4f_Multiply
+inline void Matrix4x4f_MultiplyStream(Matrix4x4f* outputStream, const Matrix4x4f* inputStream1, const Matrix4x4f* inputStream2, unsigned count)
+{
+  Matrix4x4f_MultiplyStream(outputStream->v, 16, inputStream1->v, 16, inputStream2->v, 16, count);
+}
+
+/// Inverts count matrices which are members of structures, using the best implementation for the CPU.
+/// \see Matrix4x4f_InverseStreamGeneric for a description of the parameters.
+inline void Matrix4x4f_InverseStream(float* outputStream, unsigned outputStride, const float* inputStream, unsigned inputStride, unsigned count)
+{
+  static const Matrix4x4f_InverseStreamFunc kernel = Matrix4x4f_SelectInverseStream(InstructionSet_Active());
+  kernel(outputStream, outputStride, inputStream, inputStride, count);
+}
+
+/// Inverts an array of count matrices. \see Matrix4x4f_Inversed
+inline void Matrix4x4f_InverseStream(Matrix4x4f* outputStream, const Matrix4x4f* inputStream, unsigned count)
+{
+  Matrix4x4f_InverseStream(outputStream->v, 16, inputStream->v, 16, count);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// Affine matrix streams
+
+/// Multiplies count pairs of affine matrices, where the matrices are members of structures which are outputStride,
+/// inputStride1 and inputStride2 floats apart (non-SIMD fallback implementation). Each output is
+/// Matrix3x4f_Multiply of the matrices at the same index in the two input streams.
+/// \see Matrix4x4f_MultiplyStreamGeneric for a description of the parameters.
+inline void Matrix3x4f_MultiplyStreamGeneric(float* outputStream, unsigned outputStride, const float* inputStream1, unsigned inputStride1,
+                                             const float* inputStream2, unsigned inputStride2, unsigned count)
+{
+  for (unsigned i = 0; i < count; ++i)
+  {
+    const float* a = inputStream1 + i * inputStride1;
+    const float* b = inputStream2 + i * inputStride2;
+    float out[12];
+    for (int r = 0; r < 3; ++r)
+    {
+      for (int c = 0; c < 4; ++c)
+      {
+        out[4*r+c] = a[4*r+0] * b[c] + a[4*r+1] * b[4+c] + a[4*r+2] * b[8+c];
+      }
+      out[4*r+3] += a[4*r+3];
+    }
+    for (int j = 0; j < 12; ++j)
+    {
+      outputStream[i * outputStride + j] = out[j];
+    }
+  }
+}
+
+#if MATHS3D_X86
+
+/// Multiplies pairs of affine matrices (SSE implementation). \see Matrix4x4f_SSEMultiplyStream
+/// \see Matrix4x4f_MultiplyStreamGeneric for a description of the parameters.
+inline void Matrix3x4f_SSEMultiplyStream(float* outputStream, unsigned outputStride, const float* inputStream1, unsigned inputStride1,
+                                         const float* inputStream2, unsigned inputStride2, unsigned count)
+{
+  for (unsigned i = 0; i < count; ++i)
+  {
+    const float* a = inputStream1 + i * inputStride1;
+    const float* b = inputStream2 + i * inputStride2;
+    const __m128 b0 = _mm_loadu_ps(b + 0), b1 = _mm_loadu_ps(b + 4), b2 = _mm_loadu_ps(b + 8);
+    // Each row of the result only needs the same row of the first matrix, which has already been read when it is
+    // stored, so the rows are stored straight away and the output can be the same as either input
+    for (int r = 0; r < 3; ++r)
+    {
+      const __m128 row = _mm_add_ps(_mm_add_ps(_mm_mul_ps(b0, _mm_set1_ps(a[4*r+0])), _mm_mul_ps(b1, _mm_set1_ps(a[4*r+1]))),
+                                    _mm_add_ps(_mm_mul_ps(b2, _mm_set1_ps(a[4*r+2])), _mm_setr_ps(0.0f, 0.0f, 0.0f, a[4*r+3])));
+      _mm_storeu_ps(outputStream + i * outputStride + 4 * r, row);
+    }
+  }
+}
+
+/// Multiplies pairs of affine matrices (AVX2 and FMA implementation). \see Matrix4x4f_AVX2MultiplyStream
+/// \note must only be called if the CPU supports AVX2 and FMA. \see InstructionSet_IsSupported
+/// \see Matrix4x4f_MultiplyStreamGeneric for a description of the parameters.
+MATHS3D_TARGET("avx2,fma")
+inline void Matrix3x4f_AVX2MultiplyStream(float* outputStream, unsigned outputStride, const float* inputStream1, unsigned inputStride1,
+                                          const float* inputStream2, unsigned inputStride2, unsigned count)
+{
+  const __m128 translationMask = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+  for (unsigned i = 0; i < count; ++i)
+  {
+    const float* a = inputStream1 + i * inputStride1;
+    const float* b = inputStream2 + i * inputStride2;
+    const __m128 b0 = _mm_loadu_ps(b + 0), b1 = _mm_loadu_ps(b + 4), b2 = _mm_loadu_ps(b + 8);
+    // Each row of the result only needs the same row of the first matrix, which has already been read when it is
+    // stored, so the rows are stored straight away and the output can be the same as either input
+    for (int r = 0; r < 3; ++r)
+    {
+      __m128 row = _mm_and_ps(_mm_loadu_ps(a + 4*r), translationMask);
+      row = _mm_fmadd_ps(b0, _mm_broadcast_ss(a + 4*r+0), row);
+      row = _mm_fmadd_ps(b1, _mm_broadcast_ss(a + 4*r+1), row);
+      row = _mm_fmadd_ps(b2, _mm_broadcast_ss(a + 4*r+2), row);
+      _mm_storeu_ps(outputStream + i * outputStride + 4 * r, row);
+    }
+  }
+}
+
+#endif // MATHS3D_X86
+
+/// Returns the implementation of the batch affine matrix multiply for the given instruction set.
+/// The AVX-512 tier uses the AVX2 implementation.
+inline Matrix4x4f_MultiplyStreamFunc Matrix3x4f_SelectMultiplyStream(InstructionSet isa)
+{
+  switch (isa)
+  {
+#if MATHS3D_X86
+    case InstructionSet::AVX512:
+    case InstructionSet::AVX2:
+      return &Matrix3x4f_AVX2MultiplyStream;
+    case InstructionSet::SSE:
+      return &Matrix3x4f_SSEMultiplyStream;
+#endif
+    default:
+      return &Matrix3x4f_MultiplyStreamGeneric;
+  }
+}
+
+/// Multiplies count pairs of affine matrices which are members of structures, using the best implementation for
+/// the CPU. \see Matrix4x4f_MultiplyStreamGeneric for a description of the parameters.
+inline void Matrix3x4f_MultiplyStream(float* outputStream, unsigned outputStride, const float* inputStream1, unsigned inputStride1,
+                                      const float* inputStream2, unsigned inputStride2, unsigned count)
+{
+  static const Matrix4x4f_MultiplyStreamFunc kernel = Matrix3x4f_SelectMultiplyStream(InstructionSet_Active());
+  kernel(outputStream, outputStride, inputStream1, inputStride1, inputStream2, inputStride2, count);
+}
+
+/// Multiplies each affine matrix in inputStream1 with the matrix at the same index in inputStream2.
+/// \see Matrix3x4f_Multiply
+inline void Matrix3x4f_MultiplyStream(Matrix3x4f* outputStream, const Matrix3x4f* inputStream1, const Matrix3x4f* inputStream2, unsigned count)
+{
+  Matrix3x4f_MultiplyStream(outputStream->v, 12, inputStream1->v, 12, inputStream2->v, 12, count);
+}
+
+/// Transforms an array of count vectors by an affine matrix. An affine transform has no perspective, so the
+/// equivalent Matrix4x4f is used with the dispatched kernels. \see Vector4f_TransformStream
+inline void Vector4f_TransformStream(Vector4f* outputStream, const Vector4f* inputStream, unsigned count, const Matrix3x4f& transform)
+{
+  Vector4f_TransformStream(outputStream, inputStream, count, Matrix4x4f_FromMatrix3x4f(transform));
+}
+
+/// Transforms an array of count normal vectors by an affine matrix. \see Vector4f_TransformNormalStream
+inline void Vector4f_TransformNormalStream(Vector4f* outputStream, const Vector4f* inputStream, unsigned count, const Matrix3x4f& transform)
+{
+  Vector4f_TransformNormalStream(outputStream, inputStream, count, Matrix4x4f_FromMatrix3x4f(transform));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// Prepared transform streams
+
+/// Transforms an array of count vectors by the prepared transform without applying perspective.
+/// \see Vector4f_TransformStream, PreparedTransform4f_TransformBatch for small batches
+inline void PreparedTransform4f_TransformStream(const PreparedTransform4f& prepared, Vector4f* outputStream, const Vector4f* inputStream, unsigned count)
+{
+  Vector4f_TransformStream(outputStream, inputStream, count, PreparedTransform4f_Matrix(prepared));
+}
+
+/// Transforms an array of count vectors by the prepared transform with perspective. \see Vector4f_TransformCoordStream
+inline void PreparedTransform4f_TransformCoordStream(const PreparedTransform4f& prepared, Vector4f* outputStream, const Vector4f* inputStream, unsigned count)
+{
+  Vector4f_TransformCoordStream(outputStream, inputStream, count, PreparedTransform4f_Matrix(prepared));
+}
+
+/// Transforms an array of count normal vectors by the prepared transform. \see Vector4f_TransformNormalStream
+inline void PreparedTransform4f_TransformNormalStream(const PreparedTransform4f& prepared, Vector4f* outputStream, const Vector4f* inputStream, unsigned count)
+{
+  Vector4f_TransformNormalStream(outputStream, inputStream, count, PreparedTransform4f_Matrix(prepared));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// Batch quaternions
+
+#if MATHS3D_X86
+
+/// Loads four Vector4f (or Quaternion4f) from the array at stream and transposes them so that each register holds the
+/// same component of the four.
+inline void Vector4f_SSELoadSoA(__m128& x, __m128& y, __m128& z, __m128& w, const float* stream)
+{
+  x = _mm_loadu_ps(stream + 0);
+  y = _mm_loadu_ps(stream + 4);
+  z = _mm_loadu_ps(stream + 8);
+  w = _mm_loadu_ps(stream + 12);
+  _MM_TRANSPOSE4_PS(x, y, z, w);
+}
+
+/// Calculates the upper 3x3 part of Matrix4x4f_TranslateRotateScale for four quaternions and scales at a time.
+/// Each of the 9 elements m[row][column] is returned in a register with the element for the four transforms.
+inline void Matrix4x4f_SSERotateScale(__m128 (&m)[3][3], const Quaternion4f* rotations, const Vector4f* scales)
+{
+  __m128 x, y, z, w, sx, sy, sz, sw;
+  Vector4f_SSELoadSoA(x, y, z, w, rotations->v);
+  Vector4f_SSELoadSoA(sx, sy, sz, sw, scales->v);
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 x2 = _mm_add_ps(x, x), y2 = _mm_add_ps(y, y), z2 = _mm_add_ps(z, z);
+  const __m128 xx = _mm_mul_ps(x, x2), yy = _mm_mul_ps(y, y2), zz = _mm_mul_ps(z, z2);
+  const __m128 xy = _mm_mul_ps(x, y2), xz = _mm_mul_ps(x, z2), yz = _mm_mul_ps(y, z2);
+  const __m128 wx = _mm_mul_ps(w, x2), wy = _mm_mul_ps(w, y2), wz = _mm_mul_ps(w, z2);
+  m[0][0] = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), sx);
+  m[0][1] = _mm_mul_ps(_mm_add_ps(xy, wz), sx);
+  m[0][2] = _mm_mul_ps(_mm_sub_ps(xz, wy), sx);
+  m[1][0] = _mm_mul_ps(_mm_sub_ps(xy, wz), sy);
+  m[1][1] = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), sy);
+  m[1][2] = _mm_mul_ps(_mm_add_ps(yz, wx), sy);
+  m[2][0] = _mm_mul_ps(_mm_add_ps(xz, wy), sz);
+  m[2][1] = _mm_mul_ps(_mm_sub_ps(yz, wx), sz);
+  m[2][2] = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), sz);
+}
+
+#endif // MATHS3D_X86
+
+/// Creates an array of count matrices from arrays of count translations, rotations and scales, which is the same as
+/// Matrix4x4f_TranslateRotateScale for each of them. The rotations are converted four at a time with SSE.
+inline void Matrix4x4f_TranslateRotateScaleStream(Matrix4x4f* outputStream, const Vector4f* translations, const Quaternion4f* rotations,
+                                                  const Vector4f* scales, unsigned count)
+{
+  unsigned i = 0;
+#if MATHS3D_X86
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128 m[3][3];
+    Matrix4x4f_SSERotateScale(m, rotations + i, scales + i);
+    for (int row = 0; row < 3; ++row)
+    {
+      // Transposing the elements of a row gives the row for each of the four matrices
+      __m128 r0 = m[row][0], r1 = m[row][1], r2 = m[row][2], r3 = zero;
+      _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+      _mm_storeu_ps(outputStream[i+0].m[row], r0);
+      _mm_storeu_ps(outputStream[i+1].m[row], r1);
+      _mm_storeu_ps(outputStream[i+2].m[row], r2);
+      _mm_storeu_ps(outputStream[i+3].m[row], r3);
+    }
+    for (int j = 0; j < 4; ++j)
+    {
+      // Replace w with one
+      const __m128 t = _mm_loadu_ps(translations[i+j].v);
+      _mm_storeu_ps(outputStream[i+j].m[3], _mm_shuffle_ps(t, _mm_unpackhi_ps(t, one), _MM_SHUFFLE(1,0,1,0)));
+    }
+  }
+#endif
+  for (; i < count; ++i)
+  {
+    outputStream[i] = Matrix4x4f_TranslateRotateScale(translations[i], rotations[i], scales[i]);
+  }
+}
+
+/// Creates an array of count affine matrices from arrays of count translations, rotations and scales, which is the
+/// same as Matrix3x4f_TranslateRotateScale for each of them. The rotations are converted four at a time with SSE.
+inline void Matrix3x4f_TranslateRotateScaleStream(Matrix3x4f* outputStream, const Vector4f* translations, const Quaternion4f* rotations,
+                                                  const Vector4f* scales, unsigned count)
+{
+  unsigned i = 0;
+#if MATHS3D_X86
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128 m[3][3], tx, ty, tz, tw;
+    Matrix4x4f_SSERotateScale(m, rotations + i, scales + i);
+    Vector4f_SSELoadSoA(tx, ty, tz, tw, translations[i].v);
+    const __m128 t[3] = { tx, ty, tz };
+    for (int column = 0; column < 3; ++column)
+    {
+      // The rows of a Matrix3x4f are the columns of the Matrix4x4f with the translation in the last element
+      __m128 r0 = m[0][column], r1 = m[1][column], r2 = m[2][column], r3 = t[column];
+      _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+      _mm_storeu_ps(outputStream[i+0].m[column], r0);
+      _mm_storeu_ps(outputStream[i+1].m[column], r1);
+      _mm_storeu_ps(outputStream[i+2].m[column], r2);
+      _mm_storeu_ps(outputStream[i+3].m[column], r3);
+    }
+  }
+#endif
+  for (; i < count; ++i)
+  {
+    outputStream[i] = Matrix3x4f_TranslateRotateScale(translations[i], rotations[i], scales[i]);
+  }
+}
+
+/// Interpolates count pairs of rotations from the arrays q1 and q2 by the matching factors in t with
+/// Quaternion4f_Nlerp (reference implementation), for example to blend between the keyframes of many animated instances.
+/// \param outputStream is the output array for the interpolated rotations. This may be the same as q1 or q2.
+/// \param q1 is the array of rotations at t = 0.
+/// \param q2 is the array of rotations at t = 1.
+/// \param t is the array of interpolation factors.
+/// \param count is the number of rotations.
+inline void Quaternion4f_NlerpStreamGeneric(Quaternion4f* outputStream, const Quaternion4f* q1, const Quaternion4f* q2, const Scalar1f* t, unsigned count)
+{
+  for (unsigned i = 0; i < count; ++i)
+  {
+    outputStream[i] = Quaternion4f_Nlerp(q1[i], q2[i], t[i]);
+  }
+}
+
+#if MATHS3D_X86
+
+/// Interpolates count pairs of rotations four at a time (SSE implementation). Each register holds one component of
+/// the four rotations, so the dot products and lengths need no horizontal adds.
+/// \see Quaternion4f_NlerpStreamGeneric for a description of the parameters.
+inline void Quaternion4f_SSENlerpStream(Quaternion4f* outputStream, const Quaternion4f* q1, const Quaternion4f* q2, const Scalar1f* t, unsigned count)
+{
+  const __m128 signMask = _mm_set1_ps(-0.0f);
+  const __m128 one = _mm_set1_ps(1.0f);
+  unsigned i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128 x1, y1, z1, w1, x2, y2, z2, w2;
+    Vector4f_SSELoadSoA(x1, y1, z1, w1, q1[i].v);
+    Vector4f_SSELoadSoA(x2, y2, z2, w2, q2[i].v);
+    const __m128 t1 = _mm_loadu_ps(t + i);
+    const __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x1, x2), _mm_mul_ps(y1, y2)), _mm_add_ps(_mm_mul_ps(z1, z2), _mm_mul_ps(w1, w2)));
+    // Negate t for the rotations where -q2 is closer to q1, as Quaternion4f_Nlerp does
+    const __m128 t2 = _mm_xor_ps(t1, _mm_and_ps(_mm_cmplt_ps(dot, _mm_setzero_ps()), signMask));
+    const __m128 s = _mm_sub_ps(one, t1);
+    __m128 x = _mm_add_ps(_mm_mul_ps(x1, s), _mm_mul_ps(x2, t2));
+    __m128 y = _mm_add_ps(_mm_mul_ps(y1, s), _mm_mul_ps(y2, t2));
+    __m128 z = _mm_add_ps(_mm_mul_ps(z1, s), _mm_mul_ps(z2, t2));
+    __m128 w = _mm_add_ps(_mm_mul_ps(w1, s), _mm_mul_ps(w2, t2));
+    const __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w)));
+    const __m128 scale = Vector4f_SSEReciprocalSqrt<Precision::Exact>(lengthSquared);
+    x = _mm_mul_ps(x, scale);
+    y = _mm_mul_ps(y, scale);
+    z = _mm_mul_ps(z, scale);
+    w = _mm_mul_ps(w, scale);
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+    _mm_storeu_ps(outputStream[i+0].v, x);
+    _mm_storeu_ps(outputStream[i+1].v, y);
+    _mm_storeu_ps(outputStream[i+2].v, z);
+    _mm_storeu_ps(outputStream[i+3].v, w);
+  }
+  Quaternion4f_NlerpStreamGeneric(outputStream + i, q1 + i, q2 + i, t + i, count - i);
+}
+
+/// Loads eight Vector4f (or Quaternion4f) from the array at stream and transposes them as Vector4f_SSELoadSoA does,
+/// with the first four in the low 128-bit lanes and the last four in the high lanes.
+MATHS3D_TARGET("avx2,fma")
+inline void Vector4f_AVX2LoadSoA(__m256& x, __m256& y, __m256& z, __m256& w, const float* stream)
+{
+  __m256 c[4];
+  for (int j = 0; j < 4; ++j)
+  {
+    c[j] = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(stream + 4 * j)), _mm_loadu_ps(stream + 4 * (j + 4)), 1);
+  }
+  const __m256 t0 = _mm256_unpacklo_ps(c[0], c[1]);
+  const __m256 t1 = _mm256_unpacklo_ps(c[2], c[3]);
+  const __m256 t2 = _mm256_unpackhi_ps(c[0], c[1]);
+  const __m256 t3 = _mm256_unpackhi_ps(c[2], c[3]);
+  x = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1,0,1,0));
+  y = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3,2,3,2));
+  z = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1,0,1,0));
+  w = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3,2,3,2));
+}
+
+/// Transposes eight vectors back from the layout of Vector4f_AVX2LoadSoA and stores them to the array at stream.
+MATHS3D_TARGET("avx2,fma")
+inline void Vector4f_AVX2StoreSoA(float* stream, __m256 x, __m256 y, __m256 z, __m256 w)
+{
+  const __m256 t0 = _mm256_unpacklo_ps(x, y);
+  const __m256 t1 = _mm256_unpacklo_ps(z, w);
+  const __m256 t2 = _mm256_unpackhi_ps(x, y);
+  const __m256 t3 = _mm256_unpackhi_ps(z, w);
+  const __m256 c[4] = { _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1,0,1,0)), _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3,2,3,2)),
+                        _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1,0,1,0)), _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3,2,3,2)) };
+  for (int j = 0; j < 4; ++j)
+  {
+    _mm_storeu_ps(stream + 4 * j, _mm256_castps256_ps128(c[j]));
+    _mm_storeu_ps(stream + 4 * (j + 4), _mm256_extractf128_ps(c[j], 1));
+  }
+}
+
+/// Interpolates count pairs of rotations eight at a time with fused multiply-adds (AVX2 implementation).
+/// \note must only be called if the CPU supports AVX2 and FMA. \see InstructionSet_IsSupported
+/// \see Quaternion4f_NlerpStreamGeneric for a description of the parameters.
+MATHS3D_TARGET("avx2,fma")
+inline void Quaternion4f_AVX2NlerpStream(Quaternion4f* outputStream, const Quaternion4f* q1, const Quaternion4f* q2, const Scalar1f* t, unsigned count)
+{
+  const __m256 signMask = _mm256_set1_ps(-0.0f);
+  const __m256 one = _mm256_set1_ps(1.0f);
+  unsigned i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256 x1, y1, z1, w1, x2, y2, z2, w2;
+    Vector4f_AVX2LoadSoA(x1, y1, z1, w1, q1[i].v);
+    Vector4f_AVX2LoadSoA(x2, y2, z2, w2, q2[i].v);
+    const __m256 t1 = _mm256_loadu_ps(t + i);
+    const __m256 dot = _mm256_fmadd_ps(w1, w2, _mm256_fmadd_ps(z1, z2, _mm256_fmadd_ps(y1, y2, _mm256_mul_ps(x1, x2))));
+    // Negate t for the rotations where -q2 is closer to q1, as Quaternion4f_Nlerp does
+    const __m256 t2 = _mm256_xor_ps(t1, _mm256_and_ps(_mm256_cmp_ps(dot, _mm256_setzero_ps(), _CMP_LT_OQ), signMask));
+    const __m256 s = _mm256_sub_ps(one, t1);
+    __m256 x = _mm256_fmadd_ps(x2, t2, _mm256_mul_ps(x1, s));
+    __m256 y = _mm256_fmadd_ps(y2, t2, _mm256_mul_ps(y1, s));
+    __m256 z = _mm256_fmadd_ps(z2, t2, _mm256_mul_ps(z1, s));
+    __m256 w = _mm256_fmadd_ps(w2, t2, _mm256_mul_ps(w1, s));
+    const __m256 lengthSquared = _mm256_fmadd_ps(w, w, _mm256_fmadd_ps(z, z, _mm256_fmadd_ps(y, y, _mm256_mul_ps(x, x))));
+    const __m256 scale = Vector4f_AVX2ExactDivide(one, _mm256_sqrt_ps(lengthSquared));
+    Vector4f_AVX2StoreSoA(outputStream[i].v, _mm256_mul_ps(x, scale), _mm256_mul_ps(y, scale), _mm256_mul_ps(z, scale), _mm256_mul_ps(w, scale));
+  }
+  Quaternion4f_SSENlerpStream(outputStream + i, q1 + i, q2 + i, t + i, count - i);
+}
+
+#endif // MATHS3D_X86
+
+/// Function pointer type for the implementations of the batch quaternion interpolation.
+using Quaternion4f_NlerpStreamFunc = void (*)(Quaternion4f* outputStream, const Quaternion4f* q1, const Quaternion4f* q2, const Scalar1f* t, unsigned count);
+
+/// Returns the implementation of the batch quaternion interpolation for the given instruction set.
+/// The AVX-512 tier uses the AVX2 implementation.
+inline Quaternion4f_NlerpStreamFunc Quaternion4f_SelectNlerpStream(InstructionSet isa)
+{
+  switch (isa)
+  {
+#if MATHS3D_X86
+    case InstructionSet::AVX512:
+    case InstructionSet::AVX2:
+      return &Quaternion4f_AVX2NlerpStream;
+    case InstructionSet::SSE:
+      return &Quaternion4f_SSENlerpStream;
+#endif
+    default:
+      return &Quaternion4f_NlerpStreamGeneric;
+  }
+}
+
+/// Interpolates count pairs of rotations with Quaternion4f_Nlerp, using the best implementation for the CPU.
+/// \see Quaternion4f_NlerpStreamGeneric for a description of the parameters.
+inline void Quaternion4f_NlerpStream(Quaternion4f* outputStream, const Quaternion4f* q1, const Quaternion4f* q2, const Scalar1f* t, unsigned count)
+{
+  static const Quaternion4f_NlerpStreamFunc kernel = Quaternion4f_SelectNlerpStream(InstructionSet_Active());
+  kernel(outputStream, q1, q2, t, count);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// Skinning
+
+/// The palette matrices of the vertex this many vertices ahead are prefetched by the skinning kernels, as the bone
+/// indices make the palette reads random so the hardware prefetcher can't predict them.
+const unsigned Skinning_PrefetchVertices = 8;
+
+/// Skins an array of count vertices by linear blending of the bone matrices in the palette (reference implementation).
+/// Each vertex is transformed by the sum of the matrices of its 4 bones weighted by the bone weights.
+/// \param outputPositions is the output array for the skinned positions.
+/// \param outputNormals is the output array for the skinned normals. This may be null if they aren't needed.
+/// \param positions is the input array of positions. The translations are scaled by the w, which is usually 1.
+/// \param normals is the input array of normals. The w components are ignored. This may be null if outputNormals is.
+/// \param boneIndices is the index in the palette of the 4 bones of each vertex. Unused bones have a weight of 0.
+/// \param boneWeights is the weights of the 4 bones of each vertex, which should add up to 1.
+/// \param count is the number of vertices.
+/// \param palette is the array of bone matrices, each the transform from the bind pose to the posed bone.
+inline void Vector4f_SkinStreamGeneric(Vector4f* outputPositions, Vector4f* outputNormals, const Vector4f* positions, const Vector4f* normals,
+                                       const Vector4us* boneIndices, const Vector4f* boneWeights, unsigned count, const Matrix4x4f* palette)
+{
+  for (unsigned i = 0; i < count; ++i)
+  {
+    Matrix4x4f blend = Matrix4x4f_Zero();
+    for (int k = 0; k < 4; ++k)
+    {
+      const Matrix4x4f& bone = palette[boneIndices[i].v[k]];
+      for (int r = 0; r < 4; ++r)
+      {
+        blend.row[r] = Vector4f_Add(blend.row[r], Vector4f_Scaled(bone.row[r], boneWeights[i].v[k]));
+      }
+    }
+    outputPositions[i] = Vector4f_Transform(blend, positions[i]);
+    if (outputNormals)
+    {
+      outputNormals[i] = Vector4f_Transform(blend, Vector4f_SetW(normals[i], Scalar1f_Zero()));
+    }
+  }
+}
+
+#if MATHS3D_X86
+
+/// Prefetches the palette matrices of the bones of a vertex.
+inline void Skinning_PrefetchBones(const float* palette, unsigned stride, const Vector4us& bones)
+{
+  for (int k = 0; k < 4; ++k)
+  {
+    // The matrix may straddle two cache lines
+    _mm_prefetch((const char*)(palette + bones.v[k] * stride), _MM_HINT_T0);
+    _mm_prefetch((const char*)(palette + bones.v[k] * stride + stride - 1), _MM_HINT_T0);
+  }
+}
+
+/// Blends the rows of the palette matrices of the 4 bones of a vertex by the bone weights (SSE implementation).
+inline void Vector4f_SSESkinBlend(__m128 (&rows)[4], const Matrix4x4f* palette, const Vector4us& bones, const Vector4f& weights)
+{
+  const __m128 w = _mm_loadu_ps(weights.v);
+  const __m128 w0 = _mm_shuffle_ps(w, w, _MM_SHUFFLE(0,0,0,0));
+  const __m128 w1 = _mm_shuffle_ps(w, w, _MM_SHUFFLE(1,1,1,1));
+  const __m128 w2 = _mm_shuffle_ps(w, w, _MM_SHUFFLE(2,2,2,2));
+  const __m128 w3 = _mm_shuffle_ps(w, w, _MM_SHUFFLE(3,3,3,3));
+  const float* b0 = palette[bones.x].v;
+  const float* b1 = palette[bones.y].v;
+  const float* b2 = palette[bones.z].v;
+  const float* b3 = palette[bones.w].v;
+  for (int r = 0; r < 4; ++r)
+  {
+    rows[r] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(b0 + 4*r), w0), _mm_mul_ps(_mm_loadu_ps(b1 + 4*r), w1)),
+                         _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(b2 + 4*r), w2), _mm_mul_ps(_mm_loadu_ps(b3 + 4*r), w3)));
+  }
+}
+
+/// Transforms the vector in v by the rows, which are weighted by the components of v.
+template <bool translate>
+inline __m128 Vector4f_SSETransformRows(const __m128 (&rows)[4], __m128 v)
+{
+  __m128 ret = _mm_add_ps(_mm_mul_ps(rows[0], _mm_shuffle_ps(v, v, _MM_SHUFFLE(0,0,0,0))),
+                          _mm_mul_ps(rows[1], _mm_shuffle_ps(v, v, _MM_SHUFFLE(1,1,1,1))));
+  ret = _mm_add_ps(ret, _mm_mul_ps(rows[2], _mm_shuffle_ps(v, v, _MM_SHUFFLE(2,2,2,2))));
+  if (translate)
+  {
+    ret = _mm_add_ps(ret, _mm_mul_ps(rows[3], _mm_shuffle_ps(v, v, _MM_SHUFFLE(3,3,3,3))));
+  }
+  return ret;
+}
+
+/// Skins an array of vertices by linear blending of the bone matrices in the palette (SSE implementation).
+/// \see Vector4f_SkinStreamGeneric for a description of the parameters.
+inline void Vector4f_SSESkinStream(Vector4f* outputPositions, Vector4f* outputNormals, const Vector4f* positions, const Vector4f* normals,
+                                   const Vector4us* boneIndices, const Vector4f* boneWeights, unsigned count, const Matrix4x4f* palette)
+{
+  for (unsigned i = 0; i < count; ++i)
+  {
+    if (i + Skinning_PrefetchVertices < count)
+    {
+      Skinning_PrefetchBones(palette->v, 16, boneIndices[i + Skinning_PrefetchVertices]);
+    }
+    __m128 rows[4];
+    Vector4f_SSESkinBlend(rows, palette, boneIndices[i], boneWeights[i]);
+    _mm_storeu_ps(outputPositions[i].v, Vector4f_SSETransformRows<true>(rows, _mm_loadu_ps(positions[i].v)));
+    if (outputNormals)
+    {
+      _mm_storeu_ps(outputNormals[i].v, Vector4f_SSETransformRows<false>(rows, _mm_loadu_ps(normals[i].v)));
+    }
+  }
+}
+
+/// Skins an array of vertices by linear blending of the bone matrices in the palette (AVX2 and FMA implementation).
+/// Two rows of the matrices are blended at a time, so the blend is 8 fused multiply-adds instead of 16 multiplies
+/// and 12 adds, and the transform does two rows at a time too.
+/// \note must only be called if the CPU supports AVX2 and FMA. \see InstructionSet_IsSupported
+/// \see Vector4f_SkinStreamGeneric for a description of the parameters.
+MATHS3D_TARGET("avx2,fma")
+inline void Vector4f_AVX2SkinStream(Vector4f* outputPositions, Vector4f* outputNormals, const Vector4f* positions, const Vector4f* normals,
+                                    const Vector4us* boneIndices, const Vector4f* boneWeights, unsigned count, const Matrix4x4f* palette)
+{
+  const __m256i xy = _mm256_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1);
+  const __m256i zw = _mm256_setr_epi32(2, 2, 2, 2, 3, 3, 3, 3);
+  for (unsigned i = 0; i < count; ++i)
+  {
+    if (i + Skinning_PrefetchVertices < count)
+    {
+      Skinning_PrefetchBones(palette->v, 16, boneIndices[i + Skinning_PrefetchVertices]);
+    }
+    __m256 rows01 = _mm256_setzero_ps();
+    __m256 rows23 = _mm256_setzero_ps();
+    for (int k = 0; k < 4; ++k)
+    {
+      const float* bone = palette[boneIndices[i].v[k]].v;
+      const __m256 weight = _mm256_broadcast_ss(&boneWeights[i].v[k]);
+      rows01 = _mm256_fmadd_ps(_mm256_loadu_ps(bone + 0), weight, rows01);
+      rows23 = _mm256_fmadd_ps(_mm256_loadu_ps(bone + 8), weight, rows23);
+    }
+    // The lower half is row 0 and 2 weighted by x and z and the upper half is row 1 and 3 weighted by y and w
+    const __m256 position = _mm256_broadcast_ps((const __m128*)positions[i].v);
+    const __m256 p = _mm256_fmadd_ps(rows01, _mm256_permutevar_ps(position, xy), _mm256_mul_ps(rows23, _mm256_permutevar_ps(position, zw)));
+    _mm_storeu_ps(outputPositions[i].v, _mm_add_ps(_mm256_castps256_ps128(p), _mm256_extractf128_ps(p, 1)));
+    if (outputNormals)
+    {
+      // Row 3 is the translation, so the w of the normal is replaced with zero
+      const __m256 normal = _mm256_broadcast_ps((const __m128*)normals[i].v);
+      const __m256 z0 = _mm256_blend_ps(_mm256_permutevar_ps(normal, zw), _mm256_setzero_ps(), 0xF0);
+      const __m256 n = _mm256_fmadd_ps(rows01, _mm256_permutevar_ps(normal, xy), _mm256_mul_ps(rows23, z0));
+      _mm_storeu_ps(outputNormals[i].v, _mm_add_ps(_mm256_castps256_ps128(n), _mm256_extractf128_ps(n, 1)));
+    }
+  }
+}
+
+#endif // MATHS3D_X86
+
+/// Function pointer type for the implementations of the skinning stream.
+using Vector4f_SkinStreamFunc = void (*)(Vector4f* outputPositions, Vector4f* outputNormals, const Vector4f* positions, const Vector4f* normals,
+                                         const Vector4us* boneIndices, const Vector4f* boneWeights, unsigned count, const Matrix4x4f* palette);
+
+/// Returns the implementation of the skinning stream for the given instruction set. AVX-512 uses the AVX2 version,
+/// as each vertex only needs 256-bit registers.
+inline Vector4f_SkinStreamFunc Vector4f_SelectSkinStream(InstructionSet isa)
+{
+  switch (isa)
+  {
+#if MATHS3D_X86
+    case InstructionSet::AVX512:
+    case InstructionSet::AVX2:
+      return &Vector4f_AVX2SkinStream;
+    case InstructionSet::SSE:
+      return &Vector4f_SSESkinStream;
+#endif
+    default:
+      return &Vector4f_SkinStreamGeneric;
+  }
+}
+
+/// Skins an array of count vertices by linear blending of the bone matrices in the palette, using the best
+/// implementation for the CPU. \see Vector4f_SkinStreamGeneric for a description of the parameters.
+inline void Vector4f_SkinStream(Vector4f* outputPositions, Vector4f* outputNormals, const Vector4f* positions, const Vector4f* normals,
+                                const Vector4us* boneIndices, const Vector4f* boneWeights, unsigned count, const Matrix4x4f* palette)
+{
+  static const Vector4f_SkinStreamFunc kernel = Vector4f_SelectSkinStream(InstructionSet_Active());
+  kernel(outputPositions, outputNormals, positions, normals, boneIndices, boneWeights, count, palette);
+}
+
+/// Skins an array of count vertices by blending the unit dual quaternions in the palette. This keeps the volume of
+/// joints which twist or bend a lot, which linear blending of matrices loses, but the bones can't be scaled. The
+/// blending uses the Vector4f functions, so it is SSE when that is the backend.
+/// \see Vector4f_SkinStreamGeneric for a description of the parameters.
+inline void Vector4f_DualQuaternionSkinStream(Vector4f* outputPositions, Vector4f* outputNormals, const Vector4f* positions, const Vector4f* normals,
+                                              const Vector4us* boneIndices, const Vector4f* boneWeights, unsigned count, const DualQuaternion4f* palette)
+{
+  for (unsigned i = 0; i < count; ++i)
+  {
+#if MATHS3D_X86
+    if (i + Skinning_PrefetchVertices < count)
+    {
+      Skinning_PrefetchBones(palette->real.v, 8, boneIndices[i + Skinning_PrefetchVertices]);
+    }
+#endif
+    const DualQuaternion4f& first = palette[boneIndices[i].x];
+    Vector4f real = Vector4f_Scaled(first.real.vec, boneWeights[i].x);
+    Vector4f dual = Vector4f_Scaled(first.dual.vec, boneWeights[i].x);
+    for (int k = 1; k < 4; ++k)
+    {
+      // q and -q are the same rotation, so the bones are blended in the same hemisphere as the first one
+      const DualQuaternion4f& bone = palette[boneIndices[i].v[k]];
+      const Scalar1f weight = (Quaternion4f_DotProduct(first.real, bone.real) < Scalar1f_Zero()) ? -boneWeights[i].v[k] : boneWeights[i].v[k];
+      real = Vector4f_Add(real, Vector4f_Scaled(bone.real.vec, weight));
+      dual = Vector4f_Add(dual, Vector4f_Scaled(bone.dual.vec, weight));
+    }
+    const Scalar1f invLength = Vector4f_ReciprocalLength(real);
+    const DualQuaternion4f blend = { { Vector4f_Scaled(real, invLength) }, { Vector4f_Scaled(dual, invLength) } };
+    outputPositions[i] = DualQuaternion4f_Transform(blend, positions[i]);
+    if (outputNormals)
+    {
+      outputNormals[i] = Quaternion4f_Rotate(blend.real, Vector4f_SetW(normals[i], Scalar1f_Zero()));
+    }
+  }
+}
+
+/// Skins an array of count positions or normals in structure of arrays layout by linear blending of the bone
+/// matrices in the palette. The w components are taken to be 1 for positions and 0 for normals.
+/// \tparam translate is true for positions and false for normals.
+/// \see Vector4f_SkinStreamGeneric for a description of the other parameters.
+template <bool translate>
+void Vector4f_SkinStreamSoA(float* outX, float* outY, float* outZ, const float* x, const float* y, const float* z,
+                            const Vector4us* boneIndices, const Vector4f* boneWeights, unsigned count, const Matrix4x4f* palette)
+{
+  unsigned i = 0;
+#if MATHS3D_X86
+  // Four vertices are skinned at a time and transposed back in to the separate arrays
+  for (; i + 4 <= count; i += 4)
+  {
+    if (i + 4 + Skinning_PrefetchVertices <= count)
+    {
+      for (unsigned j = 0; j < 4; ++j)
+      {
+        Skinning_PrefetchBones(palette->v, 16, boneIndices[i + j + Skinning_PrefetchVertices]);
+      }
+    }
+    __m128 out[4];
+    for (unsigned j = 0; j < 4; ++j)
+    {
+      __m128 rows[4];
+      Vector4f_SSESkinBlend(rows, palette, boneIndices[i+j], boneWeights[i+j]);
+      out[j] = Vector4f_SSETransformRows<translate>(rows, _mm_setr_ps(x[i+j], y[i+j], z[i+j], 1.0f));
+    }
+    _MM_TRANSPOSE4_PS(out[0], out[1], out[2], out[3]);
+    _mm_storeu_ps(outX + i, out[0]);
+    _mm_storeu_ps(outY + i, out[1]);
+    _mm_storeu_ps(outZ + i, out[2]);
+  }
+#endif
+  for (; i < count; ++i)
+  {
+    Vector4f position = Vector4f_Set(x[i], y[i], z[i], translate ? Scalar1f_One() : Scalar1f_Zero());
+    Vector4f skinned;
+    Vector4f_SkinStreamGeneric(&skinned, nullptr, &position, nullptr, boneIndices + i, boneWeights + i, 1, palette);
+    outX[i] = skinned.x;
+    outY[i] = skinned.y;
+    outZ[i] = skinned.z;
+  }
+}
+
+/// The context passed to each of the chunks of Vector4f_ParallelSkinStream.
+struct ParallelSkinContext
+{
+  Vector4f*               outputPositions;
+  Vector4f*               outputNormals;
+  const Vector4f*         positions;
+  const Vector4f*         normals;
+  const Vector4us*        boneIndices;
+  const Vector4f*         boneWeights;
+  unsigned                count;
+  unsigned                chunkSize;
+  const Matrix4x4f*       palette;          /// The palette for linear blend skinning, or null.
+  const DualQuaternion4f* dualPalette;      /// The palette for dual quaternion skinning, or null.
+};
+
+/// Skins one chunk of the vertices for Vector4f_ParallelSkinStream.
+inline void Vector4f_ParallelSkinChunk(void* context, unsigned chunk)
+{
+  const ParallelSkinContext& ctx = *(const ParallelSkinContext*)context;
+  const unsigned start = chunk * ctx.chunkSize;
+  const unsigned count = (ctx.count - start < ctx.chunkSize) ? ctx.count - start : ctx.chunkSize;
+  Vector4f* outputNormals = (ctx.outputNormals) ? ctx.outputNormals + start : nullptr;
+  const Vector4f* normals = (ctx.normals) ? ctx.normals + start : nullptr;
+  if (ctx.palette)
+  {
+    Vector4f_SkinStream(ctx.outputPositions + start, outputNormals, ctx.positions + start, normals,
+                        ctx.boneIndices + start, ctx.boneWeights + start, count, ctx.palette);
+  }
+  else
+  {
+    Vector4f_DualQuaternionSkinStream(ctx.outputPositions + start, outputNormals, ctx.positions + start, normals,
+                                      ctx.boneIndices + start, ctx.boneWeights + start, count, ctx.dualPalette);
+  }
+}
+
+/// Splits the skinning in the context in to cache sized chunks which are shared out to the threads of the WorkerPool.
+/// Meshes with fewer vertices than config.serialThreshold are skinned on the calling thread.
+inline void Vector4f_ParallelSkin(ParallelSkinContext& context, const ParallelConfig& config)
+{
+  const unsigned maxThreads = (config.maxThreads) ? config.maxThreads : unsigned(WorkerPool_Get().threads.size() + 1);
+  // Each vertex reads a position, a normal, the weights and the indices
+  context.chunkSize = ParallelConfig_ChunkSize(config, 3 * sizeof(Vector4f) + sizeof(Vector4us));
+  if (context.count < config.serialThreshold || maxThreads < 2)
+  {
+    context.chunkSize = context.count;
+    Vector4f_ParallelSkinChunk(&context, 0);
+    return;
+  }
+  WorkerPool_ParallelFor((context.count + context.chunkSize - 1) / context.chunkSize, maxThreads, Vector4f_ParallelSkinChunk, &context);
+}
+
+/// Skins a large mesh by linear blending of the bone matrices, split over the threads of the WorkerPool.
+/// \see Vector4f_SkinStreamGeneric for a description of the parameters.
+/// \param config controls the splitting of the work. \see ParallelConfig_Default
+inline void Vector4f_ParallelSkinStream(Vector4f* outputPositions, Vector4f* outputNormals, const Vector4f* positions, const Vector4f* normals,
+                                        const Vector4us* boneIndices, const Vector4f* boneWeights, unsigned count, const Matrix4x4f* palette,
+                                        const ParallelConfig& config = ParallelConfig_Default())
+{
+  ParallelSkinContext context = { outputPositions, outputNormals, positions, normals, boneIndices, boneWeights, count, 0, palette, nullptr };
+  Vector4f_ParallelSkin(context, config);
+}
+
+/// Skins a large mesh by blending the dual quaternions, split over the threads of the WorkerPool.
+/// \see Vector4f_DualQuaternionSkinStream
+/// \param config controls the splitting of the work. \see ParallelConfig_Default
+inline void Vector4f_ParallelDualQuaternionSkinStream(Vector4f* outputPositions, Vector4f* outputNormals, const Vector4f* positions, const Vector4f* normals,
+                                                      const Vector4us* boneIndices, const Vector4f* boneWeights, unsigned count,
+                                                      const DualQuaternion4f* palette, const ParallelConfig& config = ParallelConfig_Default())
+{
+  ParallelSkinContext context = { outputPositions, outputNormals, positions, normals, boneIndices, boneWeights, count, 0, nullptr, palette };
+  Vector4f_ParallelSkin(context, config);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// Batch normalize and length
+
+#if MATHS3D_X86
+
+/// Calculates sqrt(x) of each component of x with the given precision. The approximations calculate it as
+/// x * 1/sqrt(x), with zero masked so that it doesn't give NaN.
+template <Precision precision>
+inline __m128 Vector4f_SSESqrt(__m128 x)
+{
+  if (precision == Precision::Exact)
+  {
+    return _mm_sqrt_ps(x);
+  }
+  return _mm_and_ps(_mm_cmpneq_ps(x, _mm_setzero_ps()), _mm_mul_ps(x, Vector4f_SSEReciprocalSqrt<precision>(x)));
+}
+
+/// Calculates the lengths squared of the four vectors v0 to v3 in to one register.
+inline __m128 Vector4f_SSELengthSquared4(__m128 v0, __m128 v1, __m128 v2, __m128 v3)
+{
+  _MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+  return _mm_add_ps(_mm_add_ps(_mm_mul_ps(v0, v0), _mm_mul_ps(v1, v1)), _mm_add_ps(_mm_mul_ps(v2, v2), _mm_mul_ps(v3, v3)));
+}
+
+/// Calculates 1/length of the four vectors in input with the given precision.
+template <Precision precision>
+inline void Vector4f_SSEReciprocalLength4(Scalar1f* output, const Vector4f* input)
+{
+  const __m128 lengthSquared = Vector4f_SSELengthSquared4(_mm_loadu_ps(input[0].v), _mm_loadu_ps(input[1].v), _mm_loadu_ps(input[2].v), _mm_loadu_ps(input[3].v));
+  _mm_storeu_ps(output, Vector4f_SSEReciprocalSqrt<precision>(lengthSquared));
+}
+
+/// Calculates the lengths of the four vectors in input with the given precision.
+template <Precision precision>
+inline void Vector4f_SSELength4(Scalar1f* output, const Vector4f* input)
+{
+  const __m128 lengthSquared = Vector4f_SSELengthSquared4(_mm_loadu_ps(input[0].v), _mm_loadu_ps(input[1].v), _mm_loadu_ps(input[2].v), _mm_loadu_ps(input[3].v));
+  _mm_storeu_ps(output, Vector4f_SSESqrt<precision>(lengthSquared));
+}
+
+/// Normalizes the four vectors in input with the given precision.
+template <Precision precision>
+inline void Vector4f_SSENormalize4(Vector4f* output, const Vector4f* input)
+{
+  const __m128 v0 = _mm_loadu_ps(input[0].v), v1 = _mm_loadu_ps(input[1].v), v2 = _mm_loadu_ps(input[2].v), v3 = _mm_loadu_ps(input[3].v);
+  const __m128 scale = Vector4f_SSEReciprocalSqrt<precision>(Vector4f_SSELengthSquared4(v0, v1, v2, v3));
+  _mm_storeu_ps(output[0].v, _mm_mul_ps(v0, _mm_shuffle_ps(scale, scale, _MM_SHUFFLE(0,0,0,0))));
+  _mm_storeu_ps(output[1].v, _mm_mul_ps(v1, _mm_shuffle_ps(scale, scale, _MM_SHUFFLE(1,1,1,1))));
+  _mm_storeu_ps(output[2].v, _mm_mul_ps(v2, _mm_shuffle_ps(scale, scale, _MM_SHUFFLE(2,2,2,2))));
+  _mm_storeu_ps(output[3].v, _mm_mul_ps(v3, _mm_shuffle_ps(scale, scale, _MM_SHUFFLE(3,3,3,3))));
+}
+
+/// Applies the kernel to count vectors, four at a time. The last 1 to 3 vectors are copied to a padded block of four,
+/// so they get the same results as they would in a full block.
+/// \tparam Output is the type of the output for each vector, either Scalar1f or Vector4f.
+/// \tparam kernel processes four vectors, such as Vector4f_SSENormalize4.
+template <typename Output, void (*kernel)(Output* output, const Vector4f* input)>
+inline void Vector4f_SSEStreamBlocks(Output* outputStream, const Vector4f* inputStream, unsigned count)
+{
+  unsigned i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    kernel(outputStream + i, inputStream + i);
+  }
+  if (i < count)
+  {
+    Vector4f input[4] = { Vector4f_Replicate(Scalar1f_One()), Vector4f_Replicate(Scalar1f_One()),
+                          Vector4f_Replicate(Scalar1f_One()), Vector4f_Replicate(Scalar1f_One()) };
+    Output output[4];
+    memcpy(input, inputStream + i, (count - i) * sizeof(Vector4f));
+    kernel(output, input);
+    memcpy(outputStream + i, output, (count - i) * sizeof(Output));
+  }
+}
+
+#endif // MATHS3D_X86
+
+/// Calculates 1/length of count vectors (all four components) with the given precision.
+/// \param outputStream is the output array for the reciprocal lengths.
+/// \param inputStream is the input array of vectors. Zero length vectors give infinity, or NaN when approximated.
+/// \param count is the number of vectors.
+template <Precision precision>
+void Vector4f_ReciprocalLengthStream(Scalar1f* outputStream, const Vector4f* inputStream, unsigned count)
+{
+#if MATHS3D_X86
+  Vector4f_SSEStreamBlocks<Scalar1f, Vector4f_SSEReciprocalLength4<precision>>(outputStream, inputStream, count);
+#else
+  // Without a reciprocal square root estimate instruction, the full calculation is used for all the precisions
+  for (unsigned i = 0; i < count; ++i)
+  {
+    outputStream[i] = Vector4f_ReciprocalLength(inputStream[i]);
+  }
+#endif
+}
+
+/// Calculates the length of count vectors (all four components) with the given precision.
+/// \param outputStream is the output array for the lengths.
+/// \param inputStream is the input array of vectors.
+/// \param count is the number of vectors.
+template <Precision precision>
+void Vector4f_LengthStream(Scalar1f* outputStream, const Vector4f* inputStream, unsigned count)
+{
+#if MATHS3D_X86
+  Vector4f_SSEStreamBlocks<Scalar1f, Vector4f_SSELength4<precision>>(outputStream, inputStream, count);
+#else
+  for (unsigned i = 0; i < count; ++i)
+  {
+    outputStream[i] = Vector4f_Length(inputStream[i]);
+  }
+#endif
+}
+
+/// Normalizes count vectors (all four components) with the given precision, so that normals can be renormalized
+/// in bulk. The output may be the same as the input to normalize in place.
+/// \param outputStream is the output array for the unit vectors.
+/// \param inputStream is the input array of vectors. Zero length vectors give NaN, as with Vector4f_Normalized.
+/// \param count is the number of vectors.
+template <Precision precision>
+void Vector4f_NormalizeStream(Vector4f* outputStream, const Vector4f* inputStream, unsigned count)
+{
+#if MATHS3D_X86
+  Vector4f_SSEStreamBlocks<Vector4f, Vector4f_SSENormalize4<precision>>(outputStream, inputStream, count);
+#else
+  for (unsigned i = 0; i < count; ++i)
+  {
+    outputStream[i] = Vector4f_Normalized(inputStream[i]);
+  }
+#endif
+}
+
+/// Normalizes count 3D vectors stored as a structure of arrays with the given precision. This needs no transposes,
+/// so is the fastest way to renormalize large numbers of normals or directions. \see Vector4f_AoSToSoA
+/// \param outX, outY, outZ are the arrays to put the components of the unit vectors to. These may be the same as
+///        the input arrays to normalize in place.
+/// \param inX, inY, inZ are the arrays of the components of the vectors to normalize.
+/// \param count is the number of vectors.
+template <Precision precision>
+void Vector4f_NormalizeStreamSoA(float* outX, float* outY, float* outZ, const float* inX, const float* inY, const float* inZ, unsigned count)
+{
+  unsigned i = 0;
+#if MATHS3D_X86
+  for (; i + 4 <= count; i += 4)
+  {
+    const __m128 x = _mm_loadu_ps(inX + i), y = _mm_loadu_ps(inY + i), z = _mm_loadu_ps(inZ + i);
+    const __m128 scale = Vector4f_SSEReciprocalSqrt<precision>(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+    _mm_storeu_ps(outX + i, _mm_mul_ps(x, scale));
+    _mm_storeu_ps(outY + i, _mm_mul_ps(y, scale));
+    _mm_storeu_ps(outZ + i, _mm_mul_ps(z, scale));
+  }
+#endif
+  for (; i < count; ++i)
+  {
+    const Vector4f unit = Vector4f_Normalized(Vector4f_Set(inX[i], inY[i], inZ[i], Scalar1f_Zero()));
+    outX[i] = unit.x;
+    outY[i] = unit.y;
+    outZ[i] = unit.z;
+  }
+}
+
+/// Calculates the dot-products of the pairs of vectors in inputStream1 and inputStream2.
+/// \param outputStream is the output array for the dot-products.
+/// \param inputStream1, inputStream2 are the input arrays of vectors.
+/// \param count is the number of pairs of vectors.
+inline void Vector4f_DotProductStream(Scalar1f* outputStream, const Vector4f* inputStream1, const Vector4f* inputStream2, unsigned count)
+{
+  unsigned i = 0;
+#if MATHS3D_X86
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128 a0 = _mm_loadu_ps(inputStream1[i+0].v), a1 = _mm_loadu_ps(inputStream1[i+1].v);
+    __m128 a2 = _mm_loadu_ps(inputStream1[i+2].v), a3 = _mm_loadu_ps(inputStream1[i+3].v);
+    __m128 b0 = _mm_loadu_ps(inputStream2[i+0].v), b1 = _mm_loadu_ps(inputStream2[i+1].v);
+    __m128 b2 = _mm_loadu_ps(inputStream2[i+2].v), b3 = _mm_loadu_ps(inputStream2[i+3].v);
+    _MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+    _MM_TRANSPOSE4_PS(b0, b1, b2, b3);
+    _mm_storeu_ps(outputStream + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0, b0), _mm_mul_ps(a1, b1)), _mm_add_ps(_mm_mul_ps(a2, b2), _mm_mul_ps(a3, b3))));
+  }
+#endif
+  for (; i < count; ++i)
+  {
+    outputStream[i] = Vector4f_DotProduct(inputStream1[i], inputStream2[i]);
+  }
+}
+
+/// Calculates the cross-products of the pairs of vectors in inputStream1 and inputStream2. As with
+/// Vector4f_CrossProduct, the w components of the results are 1.
+/// \param outputStream is the output array for the cross-products.
+/// \param inputStream1, inputStream2 are the input arrays of vectors.
+/// \param count is the number of pairs of vectors.
+inline void Vector4f_CrossProductStream(Vector4f* outputStream, const Vector4f* inputStream1, const Vector4f* inputStream2, unsigned count)
+{
+  unsigned i = 0;
+#if MATHS3D_X86
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128 a0 = _mm_loadu_ps(inputStream1[i+0].v), a1 = _mm_loadu_ps(inputStream1[i+1].v);
+    __m128 a2 = _mm_loadu_ps(inputStream1[i+2].v), a3 = _mm_loadu_ps(inputStream1[i+3].v);
+    __m128 b0 = _mm_loadu_ps(inputStream2[i+0].v), b1 = _mm_loadu_ps(inputStream2[i+1].v);
+    __m128 b2 = _mm_loadu_ps(inputStream2[i+2].v), b3 = _mm_loadu_ps(inputStream2[i+3].v);
+    _MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+    _MM_TRANSPOSE4_PS(b0, b1, b2, b3);
+    __m128 x = _mm_sub_ps(_mm_mul_ps(a1, b2), _mm_mul_ps(a2, b1));
+    __m128 y = _mm_sub_ps(_mm_mul_ps(a2, b0), _mm_mul_ps(a0, b2));
+    __m128 z = _mm_sub_ps(_mm_mul_ps(a0, b1), _mm_mul_ps(a1, b0));
+    __m128 w = _mm_set1_ps(1.0f);
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+    _mm_storeu_ps(outputStream[i+0].v, x);
+    _mm_storeu_ps(outputStream[i+1].v, y);
+    _mm_storeu_ps(outputStream[i+2].v, z);
+    _mm_storeu_ps(outputStream[i+3].v, w);
+  }
+#endif
+  for (; i < count; ++i)
+  {
+    outputStream[i] = Vector4f_CrossProduct(inputStream1[i], inputStream2[i]);
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// Frustum culling
+
+/// Appends the indices of the volumes first to first + lanes - 1 which aren't outside to visibleIndices, and sets
+/// their containments if requested. Each index is written and only kept by incrementing the count, so there are no
+/// unpredictable branches. \return the new number of visible indices.
+inline unsigned Frustum4f_CompactVisible(unsigned* visibleIndices, Containment* containments, unsigned visibleCount,
+                                         unsigned first, unsigned lanes, unsigned outsideMask, unsigned intersectingMask)
+{
+  for (unsigned k = 0; k < lanes; ++k)
+  {
+    visibleIndices[visibleCount] = first + k;
+    visibleCount += ((outsideMask >> k) & 1) ^ 1;
+  }
+  if (containments)
+  {
+    for (unsigned k = 0; k < lanes; ++k)
+    {
+      containments[first + k] = ((outsideMask >> k) & 1) ? Containment::Outside
+                              : ((intersectingMask >> k) & 1) ? Containment::Intersecting : Containment::Inside;
+    }
+  }
+  return visibleCount;
+}
+
+/// Tests count bounding spheres stored as a structure of arrays against the frustum, and writes the indices of the
+/// ones which aren't outside it to visibleIndices (reference implementation). The visible list can then be used to
+/// only transform what can be seen. \see Vector4f_TransformStreamIndexed
+/// \param visibleIndices is the output array for the indices of the visible spheres, in increasing order. This must
+///        have space for count indices, as up to count are written to it.
+/// \param containments is the output array for the containment of all of the spheres, or null if not needed.
+/// \param frustum is the frustum to test against. \see Frustum4f_FromMatrix4x4f
+/// \param centerX, centerY, centerZ are the arrays of the components of the centers of the spheres.
+/// \param radius is the array of the radii of the spheres.
+/// \param count is the number of spheres.
+/// \return the number of visible spheres written to visibleIndices.
+inline unsigned Frustum4f_CullSpheresStreamGeneric(unsigned* visibleIndices, Containment* containments, const Frustum4f& frustum,
+                                                   const float* centerX, const float* centerY, const float* centerZ, const float* radius, unsigned count)
+{
+  unsigned visibleCount = 0;
+  for (unsigned i = 0; i < count; ++i)
+  {
+    const Containment containment = Frustum4f_ClassifySphere(frustum, Vector4f_Set(centerX[i], centerY[i], centerZ[i], Scalar1f_One()), radius[i]);
+    visibleCount = Frustum4f_CompactVisible(visibleIndices, containments, visibleCount, i, 1,
+                                            containment == Containment::Outside, containment == Containment::Intersecting);
+  }
+  return visibleCount;
+}
+
+/// Tests count axis aligned boxes stored as a structure of arrays against the frustum, and writes the indices of the
+/// ones which aren't outside it to visibleIndices (reference implementation). \see Frustum4f_ClassifyAabb
+/// \param minX, minY, minZ, maxX, maxY, maxZ are the arrays of the components of the corners of the boxes.
+/// \see Frustum4f_CullSpheresStreamGeneric for a description of the other parameters and the return value.
+inline unsigned Frustum4f_CullAabbsStreamGeneric(unsigned* visibleIndices, Containment* containments, const Frustum4f& frustum,
+                                                 const float* minX, const float* minY, const float* minZ,
+                                                 const float* maxX, const float* maxY, const float* maxZ, unsigned count)
+{
+  unsigned visibleCount = 0;
+  for (unsigned i = 0; i < count; ++i)
+  {
+    const Containment containment = Frustum4f_ClassifyAabb(frustum, Vector4f_Set(minX[i], minY[i], minZ[i], Scalar1f_One()),
+                                                           Vector4f_Set(maxX[i], maxY[i], maxZ[i], Scalar1f_One()));
+    visibleCount = Frustum4f_CompactVisible(visibleIndices, containments, visibleCount, i, 1,
+                                            containment == Containment::Outside, containment == Containment::Intersecting);
+  }
+  return visibleCount;
+}
+
+#if MATHS3D_X86
+
+/// Tests bounding spheres against the frustum four at a time (SSE implementation).
+/// \see Frustum4f_CullSpheresStreamGeneric for a description of the parameters and the return value.
+inline unsigned Frustum4f_SSECullSpheresStream(unsigned* visibleIndices, Containment* containments, const Frustum4f& frustum,
+                                               const float* centerX, const float* centerY, const float* centerZ, const float* radius, unsigned count)
+{
+  __m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+  for (int p = 0; p < 6; ++p)
+  {
+    planeX[p] = _mm_set1_ps(frustum.planes[p].x);
+    planeY[p] = _mm_set1_ps(frustum.planes[p].y);
+    planeZ[p] = _mm_set1_ps(frustum.planes[p].z);
+    planeW[p] = _mm_set1_ps(frustum.planes[p].w);
+  }
+  unsigned visibleCount = 0;
+  unsigned i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    const __m128 x = _mm_loadu_ps(centerX + i), y = _mm_loadu_ps(centerY + i), z = _mm_loadu_ps(centerZ + i);
+    const __m128 r = _mm_loadu_ps(radius + i);
+    const __m128 negativeR = _mm_sub_ps(_mm_setzero_ps(), r);
+    __m128 outside = _mm_setzero_ps();
+    __m128 intersecting = _mm_setzero_ps();
+    for (int p = 0; p < 6; ++p)
+    {
+      const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], x), _mm_mul_ps(planeY[p], y)),
+                                         _mm_add_ps(_mm_mul_ps(planeZ[p], z), planeW[p]));
+      outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negativeR));
+      intersecting = _mm_or_ps(intersecting, _mm_cmplt_ps(distance, r));
+    }
+    visibleCount = Frustum4f_CompactVisible(visibleIndices, containments, visibleCount, i, 4, _mm_movemask_ps(outside), _mm_movemask_ps(intersecting));
+  }
+  if (i < count)
+  {
+    // The generic version numbers the remaining volumes from zero, so offset the indices it appends
+    const unsigned tailCount = Frustum4f_CullSpheresStreamGeneric(visibleIndices + visibleCount, containments ? containments + i : nullptr, frustum,
+                                                       centerX + i, centerY + i, centerZ + i, radius + i, count - i);
+    for (unsigned j = 0; j < tailCount; ++j)
+    {
+      visibleIndices[visibleCount++] += i;
+    }
+  }
+  return visibleCount;
+}
+
+/// Tests axis aligned boxes against the frustum four at a time (SSE implementation).
+/// \see Frustum4f_CullAabbsStreamGeneric for a description of the parameters and the return value.
+inline unsigned Frustum4f_SSECullAabbsStream(unsigned* visibleIndices, Containment* containments, const Frustum4f& frustum,
+                                             const float* minX, const float* minY, const float* minZ,
+                                             const float* maxX, const float* maxY, const float* maxZ, unsigned count)
+{
+  const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+  __m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+  for (int p = 0; p < 6; ++p)
+  {
+    planeX[p] = _mm_set1_ps(frustum.planes[p].x);
+    planeY[p] = _mm_set1_ps(frustum.planes[p].y);
+    planeZ[p] = _mm_set1_ps(frustum.planes[p].z);
+    planeW[p] = _mm_set1_ps(frustum.planes[p].w);
+  }
+  const __m128 half = _mm_set1_ps(0.5f);
+  unsigned visibleCount = 0;
+  unsigned i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    const __m128 x0 = _mm_loadu_ps(minX + i), y0 = _mm_loadu_ps(minY + i), z0 = _mm_loadu_ps(minZ + i);
+    const __m128 x1 = _mm_loadu_ps(maxX + i), y1 = _mm_loadu_ps(maxY + i), z1 = _mm_loadu_ps(maxZ + i);
+    const __m128 x = _mm_mul_ps(_mm_add_ps(x0, x1), half), y = _mm_mul_ps(_mm_add_ps(y0, y1), half), z = _mm_mul_ps(_mm_add_ps(z0, z1), half);
+    const __m128 ex = _mm_mul_ps(_mm_sub_ps(x1, x0), half), ey = _mm_mul_ps(_mm_sub_ps(y1, y0), half), ez = _mm_mul_ps(_mm_sub_ps(z1, z0), half);
+    __m128 outside = _mm_setzero_ps();
+    __m128 intersecting = _mm_setzero_ps();
+    for (int p = 0; p < 6; ++p)
+    {
+      // The distance of the corner furthest along the normal of the plane from the center of each box
+      const __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_and_ps(planeX[p], absMask), ex), _mm_mul_ps(_mm_and_ps(planeY[p], absMask), ey)),
+                                  _mm_mul_ps(_mm_and_ps(planeZ[p], absMask), ez));
+      const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], x), _mm_mul_ps(planeY[p], y)),
+                                         _mm_add_ps(_mm_mul_ps(planeZ[p], z), planeW[p]));
+      outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_sub_ps(_mm_setzero_ps(), r)));
+      intersecting = _mm_or_ps(intersecting, _mm_cmplt_ps(distance, r));
+    }
+    visibleCount = Frustum4f_CompactVisible(visibleIndices, containments, visibleCount, i, 4, _mm_movemask_ps(outside), _mm_movemask_ps(intersecting));
+  }
+  if (i < count)
+  {
+    // The generic version numbers the remaining volumes from zero, so offset the indices it appends
+    const unsigned tailCount = Frustum4f_CullAabbsStreamGeneric(visibleIndices + visibleCount, containments ? containments + i : nullptr, frustum,
+                                                     minX + i, minY + i, minZ + i, maxX + i, maxY + i, maxZ + i, count - i);
+    for (unsigned j = 0; j < tailCount; ++j)
+    {
+      visibleIndices[visibleCount++] += i;
+    }
+  }
+  return visibleCount;
+}
+
+/// Tests bounding spheres against the frustum eight at a time (AVX2 and FMA implementation).
+/// \note must only be called if the CPU supports AVX2 and FMA. \see InstructionSet_IsSupported
+/// \see Frustum4f_CullSpheresStreamGeneric for a description of the parameters and the return value.
+MATHS3D_TARGET("avx2,fma")
+inline unsigned Frustum4f_AVX2CullSpheresStream(unsigned* visibleIndices, Containment* containments, const Frustum4f& frustum,
+                                                const float* centerX, const float* centerY, const float* centerZ, const float* radius, unsigned count)
+{
+  __m256 planeX[6], planeY[6], planeZ[6], planeW[6];
+  for (int p = 0; p < 6; ++p)
+  {
+    planeX[p] = _mm256_set1_ps(frustum.planes[p].x);
+    planeY[p] = _mm256_set1_ps(frustum.planes[p].y);
+    planeZ[p] = _mm256_set1_ps(frustum.planes[p].z);
+    planeW[p] = _mm256_set1_ps(frustum.planes[p].w);
+  }
+  unsigned visibleCount = 0;
+  unsigned i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    const __m256 x = _mm256_loadu_ps(centerX + i), y = _mm256_loadu_ps(centerY + i), z = _mm256_loadu_ps(centerZ + i);
+    const __m256 r = _mm256_loadu_ps(radius + i);
+    const __m256 negativeR = _mm256_sub_ps(_mm256_setzero_ps(), r);
+    __m256 outside = _mm256_setzero_ps();
+    __m256 intersecting = _mm256_setzero_ps();
+    for (int p = 0; p < 6; ++p)
+    {
+      const __m256 distance = _mm256_fmadd_ps(planeX[p], x, _mm256_fmadd_ps(planeY[p], y, _mm256_fmadd_ps(planeZ[p], z, planeW[p])));
+      outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, negativeR, _CMP_LT_OQ));
+      intersecting = _mm256_or_ps(intersecting, _mm256_cmp_ps(distance, r, _CMP_LT_OQ));
+    }
+    visibleCount = Frustum4f_CompactVisible(visibleIndices, containments, visibleCount, i, 8, _mm256_movemask_ps(outside), _mm256_movemask_ps(intersecting));
+  }
+  if (i < count)
+  {
+    // The generic version numbers the remaining volumes from zero, so offset the indices it appends
+    const unsigned tailCount = Frustum4f_CullSpheresStreamGeneric(visibleIndices + visibleCount, containments ? containments + i : nullptr, frustum,
+                                                       centerX + i, centerY + i, centerZ + i, radius + i, count - i);
+    for (unsigned j = 0; j < tailCount; ++j)
+    {
+      visibleIndices[visibleCount++] += i;
+    }
+  }
+  return visibleCount;
+}
+
+/// Tests axis aligned boxes against the frustum eight at a time (AVX2 and FMA implementation).
+/// \note must only be called if the CPU supports AVX2 and FMA. \see InstructionSet_IsSupported
+/// \see Frustum4f_CullAabbsStreamGeneric for a description of the parameters and the return value.
+MATHS3D_TARGET("avx2,fma")
+inline unsigned Frustum4f_AVX2CullAabbsStream(unsigned* visibleIndices, Containment* containments, const Frustum4f& frustum,
+                                              const float* minX, const float* minY, const float* minZ,
+                                              const float* maxX, const float* maxY, const float* maxZ, unsigned count)
+{
+  __m256 planeX[6], planeY[6], planeZ[6], planeW[6], absX[6], absY[6], absZ[6];
+  for (int p = 0; p < 6; ++p)
+  {
+    planeX[p] = _mm256_set1_ps(frustum.planes[p].x);
+    planeY[p] = _mm256_set1_ps(frustum.planes[p].y);
+    planeZ[p] = _mm256_set1_ps(frustum.planes[p].z);
+    planeW[p] = _mm256_set1_ps(frustum.planes[p].w);
+    absX[p] = _mm256_set1_ps(::fabsf(frustum.planes[p].x));
+    absY[p] = _mm256_set1_ps(::fabsf(frustum.planes[p].y));
+    absZ[p] = _mm256_set1_ps(::fabsf(frustum.planes[p].z));
+  }
+  const __m256 half = _mm256_set1_ps(0.5f);
+  unsigned visibleCount = 0;
+  unsigned i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    const __m256 x0 = _mm256_loadu_ps(minX + i), y0 = _mm256_loadu_ps(minY + i), z0 = _mm256_loadu_ps(minZ + i);
+    const __m256 x1 = _mm256_loadu_ps(maxX + i), y1 = _mm256_loadu_ps(maxY + i), z1 = _mm256_loadu_ps(maxZ + i);
+    const __m256 x = _mm256_mul_ps(_mm256_add_ps(x0, x1), half), y = _mm256_mul_ps(_mm256_add_ps(y0, y1), half), z = _mm256_mul_ps(_mm256_add_ps(z0, z1), half);
+    const __m256 ex = _mm256_mul_ps(_mm256_sub_ps(x1, x0), half), ey = _mm256_mul_ps(_mm256_sub_ps(y1, y0), half), ez = _mm256_mul_ps(_mm256_sub_ps(z1, z0), half);
+    __m256 outside = _mm256_setzero_ps();
+    __m256 intersecting = _mm256_setzero_ps();
+    for (int p = 0; p < 6; ++p)
+    {
+      const __m256 r = _mm256_fmadd_ps(absX[p], ex, _mm256_fmadd_ps(absY[p], ey, _mm256_mul_ps(absZ[p], ez)));
+      const __m256 distance = _mm256_fmadd_ps(planeX[p], x, _mm256_fmadd_ps(planeY[p], y, _mm256_fmadd_ps(planeZ[p], z, planeW[p])));
+      outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, _mm256_sub_ps(_mm256_setzero_ps(), r), _CMP_LT_OQ));
+      intersecting = _mm256_or_ps(intersecting, _mm256_cmp_ps(distance, r, _CMP_LT_OQ));
+    }
+    visibleCount = Frustum4f_CompactVisible(visibleIndices, containments, visibleCount, i, 8, _mm256_movemask_ps(outside), _mm256_movemask_ps(intersecting));
+  }
+  if (i < count)
+  {
+    // The generic version numbers the remaining volumes from zero, so offset the indices it appends
+    const unsigned tailCount = Frustum4f_CullAabbsStreamGeneric(visibleIndices + visibleCount, containments ? containments + i : nullptr, frustum,
+                                                     minX + i, minY + i, minZ + i, maxX + i, maxY + i, maxZ + i, count - i);
+    for (unsigned j = 0; j < tailCount; ++j)
+    {
+      visibleIndices[visibleCount++] += i;
+    }
+  }
+  return visibleCount;
+}
+
+#endif // MATHS3D_X86
+
+/// Function pointer type for the implementations of the sphere culling stream.
+using Frustum4f_CullSpheresStreamFunc = unsigned (*)(unsigned* visibleIndices, Containment* containments, const Frustum4f& frustum,
+                                                     const float* centerX, const float* centerY, const float* centerZ, const float* radius, unsigned count);
+
+/// Function pointer type for the implementations of the box culling stream.
+using Frustum4f_CullAabbsStreamFunc = unsigned (*)(unsigned* visibleIndices, Containment* containments, const Frustum4f& frustum,
+                                                   const float* minX, const float* minY, const float* minZ,
+                                                   const float* maxX, const float* maxY, const float* maxZ, unsigned count);
+
+/// Returns the implementation of the sphere culling stream for the given instruction set. AVX-512 uses the AVX2 version.
+inline Frustum4f_CullSpheresStreamFunc Frustum4f_SelectCullSpheresStream(InstructionSet isa)
+{
+  switch (isa)
+  {
+#if MATHS3D_X86
+    case InstructionSet::AVX512:
+    case InstructionSet::AVX2:
+      return &Frustum4f_AVX2CullSpheresStream;
+    case InstructionSet::SSE:
+      return &Frustum4f_SSECullSpheresStream;
+#endif
+    default:
+      return &Frustum4f_CullSpheresStreamGeneric;
+  }
+}
+
+/// Returns the implementation of the box culling stream for the given instruction set. AVX-512 uses the AVX2 version.
+inline Frustum4f_CullAabbsStreamFunc Frustum4f_SelectCullAabbsStream(InstructionSet isa)
+{
+  switch (isa)
+  {
+#if MATHS3D_X86
+    case InstructionSet::AVX512:
+    case InstructionSet::AVX2:
+      return &Frustum4f_AVX2CullAabbsStream;
+    case InstructionSet::SSE:
+      return &Frustum4f_SSECullAabbsStream;
+#endif
+    default:
+      return &Frustum4f_CullAabbsStreamGeneric;
+  }
+}
+
+/// Tests count bounding spheres against the frustum and writes the indices of the visible ones to visibleIndices,
+/// using the best implementation for the CPU. \see Frustum4f_CullSpheresStreamGeneric for a description of the
+/// parameters and the return value.
+inline unsigned Frustum4f_CullSpheresStream(unsigned* visibleIndices, Containment* containments, const Frustum4f& frustum,
+                                            const float* centerX, const float* centerY, const float* centerZ, const float* radius, unsigned count)
+{
+  static const Frustum4f_CullSpheresStreamFunc kernel = Frustum4f_SelectCullSpheresStream(InstructionSet_Active());
+  return kernel(visibleIndices, containments, frustum, centerX, centerY, centerZ, radius, count);
+}
+
+/// Tests count axis aligned boxes against the frustum and writes the indices of the visible ones to visibleIndices,
+/// using the best implementation for the CPU. \see Frustum4f_CullAabbsStreamGeneric for a description of the
+/// parameters and the return value.
+inline unsigned Frustum4f_CullAabbsStream(unsigned* visibleIndices, Containment* containments, const Frustum4f& frustum,
+                                          const float* minX, const float* minY, const float* minZ,
+                                          const float* maxX, const float* maxY, const float* maxZ, unsigned count)
+{
+  static const Frustum4f_CullAabbsStreamFunc kernel = Frustum4f_SelectCullAabbsStream(InstructionSet_Active());
+  return kernel(visibleIndices, containments, frustum, minX, minY, minZ, maxX, maxY, maxZ, count);
+}
+
+/// Transforms the vectors of inputStream picked by indices in to consecutive elements of outputStream, such as the
+/// positions of the visible objects from Frustum4f_CullSpheresStream. The vectors are prefetched ahead, as the
+/// hardware prefetcher can't predict the gaps between them.
+/// \see Vector4f_SSETransformStreamGeneric for a description of the template parameters.
+/// \param outputStream is the output array for the count transformed vectors.
+/// \param inputStream is the array of vectors to pick from.
+/// \param indices is the array of the count indices in inputStream of the vectors to transform.
+/// \param count is the number of vectors to transform.
+/// \param transform is the matrix to apply.
+template <bool translate, bool divideByW, Precision precision = Precision::Exact>
+void Vector4f_TransformStreamIndexed(Vector4f* outputStream, const Vector4f* inputStream, const unsigned* indices, unsigned count, const Matrix4x4f& transform)
+{
+#if MATHS3D_X86
+  const __m128 R0 = _mm_loadu_ps(transform.row[0].v);
+  const __m128 R1 = _mm_loadu_ps(transform.row[1].v);
+  const __m128 R2 = _mm_loadu_ps(transform.row[2].v);
+  const __m128 R3 = _mm_loadu_ps(transform.row[3].v);
+  const unsigned prefetchDistance = 8;
+  for (unsigned i = 0; i < count; ++i)
+  {
+    if (i + prefetchDistance < count)
+    {
+      _mm_prefetch((const char*)inputStream[indices[i + prefetchDistance]].v, _MM_HINT_T0);
+    }
+    _mm_storeu_ps(outputStream[i].v, Vector4f_SSETransformVector<translate,divideByW,precision>(_mm_loadu_ps(inputStream[indices[i]].v), R0, R1, R2, R3));
+  }
+#else
+  for (unsigned i = 0; i < count; ++i)
+  {
+    Vector4f_TransformStreamGeneric<translate,divideByW,false,4,false,4,precision>(outputStream[i].v, inputStream[indices[i]].v, 1, transform);
+  }
+#endif
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// Bounding volumes
+
+/// Transforms an array of boxes by the affine transform matrix (reference implementation). \see Aabb4f_Transform
+/// \param outputStream is the output array for the count transformed boxes. It may be the same as inputStream.
+/// \param inputStream is the array of boxes to transform.
+/// \param count is the number of boxes.
+/// \param transform is the matrix to apply.
+inline void Aabb4f_TransformStreamGeneric(Aabb4f* outputStream, const Aabb4f* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  for (unsigned i = 0; i < count; ++i)
+  {
+    outputStream[i] = Aabb4f_Transform(transform, inputStream[i]);
+  }
+}
+
+/// Transforms an array of spheres by the affine transform matrix (reference implementation).
+/// \see BoundingSphere4f_Transform and Aabb4f_TransformStreamGeneric for a description of the parameters.
+inline void BoundingSphere4f_TransformStreamGeneric(BoundingSphere4f* outputStream, const BoundingSphere4f* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  for (unsigned i = 0; i < count; ++i)
+  {
+    outputStream[i] = BoundingSphere4f_Transform(transform, inputStream[i]);
+  }
+}
+
+/// Returns the bounds of an array of vectors (reference implementation). The w components are bounded too, which
+/// are 1 for points. An empty array gives Aabb4f_Empty.
+/// \param inputStream is the array of points.
+/// \param count is the number of points.
+inline Aabb4f Aabb4f_FromVector4fStreamGeneric(const Vector4f* inputStream, unsigned count)
+{
+  Aabb4f ret = Aabb4f_Empty();
+  for (unsigned i = 0; i < count; ++i)
+  {
+    ret = Aabb4f_AddPoint(ret, inputStream[i]);
+  }
+  return ret;
+}
+
+#if MATHS3D_X86
+
+/// Transforms an array of boxes by the affine transform matrix (SSE implementation). The absolute values of the
+/// rows are found once, so each box is the same work as transforming two vectors.
+/// \see Aabb4f_TransformStreamGeneric for a description of the parameters.
+inline void Aabb4f_SSETransformStream(Aabb4f* outputStream, const Aabb4f* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  const __m128 signMask = _mm_set1_ps(-0.0f);
+  const __m128 half = _mm_set1_ps(0.5f);
+  const __m128 R0 = _mm_loadu_ps(transform.row[0].v);
+  const __m128 R1 = _mm_loadu_ps(transform.row[1].v);
+  const __m128 R2 = _mm_loadu_ps(transform.row[2].v);
+  const __m128 R3 = _mm_loadu_ps(transform.row[3].v);
+  const __m128 A0 = _mm_andnot_ps(signMask, R0);
+  const __m128 A1 = _mm_andnot_ps(signMask, R1);
+  const __m128 A2 = _mm_andnot_ps(signMask, R2);
+  for (unsigned i = 0; i < count; ++i)
+  {
+    const __m128 minimum = _mm_loadu_ps(inputStream[i].minimum.v);
+    const __m128 maximum = _mm_loadu_ps(inputStream[i].maximum.v);
+    const __m128 center = Vector4f_SSETransformVector<true,false>(_mm_mul_ps(_mm_add_ps(minimum, maximum), half), R0, R1, R2, R3);
+    const __m128 extent = Vector4f_SSETransformVector<false,false>(_mm_mul_ps(_mm_sub_ps(maximum, minimum), half), A0, A1, A2, R3);
+    _mm_storeu_ps(outputStream[i].minimum.v, _mm_sub_ps(center, extent));
+    _mm_storeu_ps(outputStream[i].maximum.v, _mm_add_ps(center, extent));
+  }
+}
+
+/// Transforms an array of spheres by the affine transform matrix (SSE implementation). The scale of the radius
+/// is found once for the whole array.
+/// \see Aabb4f_TransformStreamGeneric for a description of the parameters.
+inline void BoundingSphere4f_SSETransformStream(BoundingSphere4f* outputStream, const BoundingSphere4f* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+  const Scalar1f scale = BoundingSphere4f_MaximumScale(transform);
+  const __m128 R0 = _mm_loadu_ps(transform.row[0].v);
+  const __m128 R1 = _mm_loadu_ps(transform.row[1].v);
+  const __m128 R2 = _mm_loadu_ps(transform.row[2].v);
+  const __m128 R3 = _mm_loadu_ps(transform.row[3].v);
+  for (unsigned i = 0; i < count; ++i)
+  {
+    const Scalar1f radius = inputStream[i].radius * scale;
+    _mm_storeu_ps(outputStream[i].center.v, Vector4f_SSETransformVector<true,false>(_mm_loadu_ps(inputStream[i].center.v), R0, R1, R2, R3));
+    outputStream[i].radius = radius;
+  }
+}
+
+/// Returns the bounds of an array of vectors (SSE implementation). Two pairs of running minimums and maximums are
+/// kept, so that each min and max doesn't wait for the result of the one before.
+/// \see Aabb4f_FromVector4fStreamGeneric for a description of the parameters.
+inline Aabb4f Aabb4f_SSEFromVector4fStream(const Vector4f* inputStream, unsigned count)
+{
+  __m128 minimum0 = _mm_set1_ps(FLT_MAX), minimum1 = minimum0;
+  __m128 maximum0 = _mm_set1_ps(-FLT_MAX), maximum1 = maximum0;
+  unsigned i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    const __m128 v0 = _mm_loadu_ps(inputStream[i + 0].v);
+    const __m128 v1 = _mm_loadu_ps(inputStream[i + 1].v);
+    const __m128 v2 = _mm_loadu_ps(inputStream[i + 2].v);
+    const __m128 v3 = _mm_loadu_ps(inputStream[i + 3].v);
+    minimum0 = _mm_min_ps(minimum0, _mm_min_ps(v0, v2));
+    minimum1 = _mm_min_ps(minimum1, _mm_min_ps(v1, v3));
+    maximum0 = _mm_max_ps(maximum0, _mm_max_ps(v0, v2));
+    maximum1 = _mm_max_ps(maximum1, _mm_max_ps(v1, v3));
+  }
+  for (; i < count; ++i)
+  {
+    const __m128 v = _mm_loadu_ps(inputStream[i].v);
+    minimum0 = _mm_min_ps(minimum0, v);
+    maximum0 = _mm_max_ps(maximum0, v);
+  }
+  Aabb4f ret;
+  _mm_storeu_ps(ret.minimum.v, _mm_min_ps(minimum0, minimum1));
+  _mm_storeu_ps(ret.maximum.v, _mm_max_ps(maximum0, maximum1));
+  return ret;
+}
+
+/// Returns the bounds of an array of vectors, loading two at a time (AVX2 implementation).
+/// \note must only be called if the CPU supports AVX2 and FMA. \see InstructionSet_IsSupported
+/// \see Aabb4f_FromVector4fStreamGeneric for a description of the parameters.
+MATHS3D_TARGET("avx2,fma")
+inline Aabb4f Aabb4f_AVX2FromVector4fStream(const Vector4f* inputStream, unsigned count)
+{
+  __m256 minimum0 = _mm256_set1_ps(FLT_MAX), minimum1 = minimum0;
+  __m256 maximum0 = _mm256_set1_ps(-FLT_MAX), maximum1 = maximum0;
+  unsigned i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    const __m256 v0 = _mm256_loadu_ps(inputStream[i + 0].v);
+    const __m256 v1 = _mm256_loadu_ps(inputStream[i + 2].v);
+    const __m256 v2 = _mm256_loadu_ps(inputStream[i + 4].v);
+    const __m256 v3 = _mm256_loadu_ps(inputStream[i + 6].v);
+    minimum0 = _mm256_min_ps(minimum0, _mm256_min_ps(v0, v2));
+    minimum1 = _mm256_min_ps(minimum1, _mm256_min_ps(v1, v3));
+    maximum0 = _mm256_max_ps(maximum0, _mm256_max_ps(v0, v2));
+    maximum1 = _mm256_max_ps(maximum1, _mm256_max_ps(v1, v3));
+  }
+  // Fold the two vectors in each register together, then bound the remaining few
+  const __m256 minimum = _mm256_min_ps(minimum0, minimum1);
+  const __m256 maximum = _mm256_max_ps(maximum0, maximum1);
+  __m128 minimum4 = _mm_min_ps(_mm256_castps256_ps128(minimum), _mm256_extractf128_ps(minimum, 1));
+  __m128 maximum4 = _mm_max_ps(_mm256_castps256_ps128(maximum), _mm256_extractf128_ps(maximum, 1));
+  for (; i < count; ++i)
+  {
+    const __m128 v = _mm_loadu_ps(inputStream[i].v);
+    minimum4 = _mm_min_ps(minimum4, v);
+    maximum4 = _mm_max_ps(maximum4, v);
+  }
+  Aabb4f ret;
+  _mm_storeu_ps(ret.minimum.v, minimum4);
+  _mm_storeu_ps(ret.maximum.v, maximum4);
+  return ret;
+}
+
+#endif // MATHS3D_X86
+
+/// Transforms an array of boxes by the affine transform matrix, with SSE where available.
+/// \see Aabb4f_TransformStreamGeneric for a description of the parameters.
+inline void Aabb4f_TransformStream(Aabb4f* outputStream, const Aabb4f* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+#if MATHS3D_X86
+  Aabb4f_SSETransformStream(outputStream, inputStream, count, transform);
+#else
+  Aabb4f_TransformStreamGeneric(outputStream, inputStream, count, transform);
+#endif
+}
+
+/// Transforms an array of spheres by the affine transform matrix, with SSE where available.
+/// \see Aabb4f_TransformStreamGeneric for a description of the parameters.
+inline void BoundingSphere4f_TransformStream(BoundingSphere4f* outputStream, const BoundingSphere4f* inputStream, unsigned count, const Matrix4x4f& transform)
+{
+#if MATHS3D_X86
+  BoundingSphere4f_SSETransformStream(outputStream, inputStream, count, transform);
+#else
+  BoundingSphere4f_TransformStreamGeneric(outputStream, inputStream, count, transform);
+#endif
+}
+
+/// Function pointer type for the implementations of the bounds of an array of vectors.
+using Aabb4f_FromVector4fStreamFunc = Aabb4f (*)(const Vector4f* inputStream, unsigned count);
+
+/// Returns the implementation of the bounds of an array of vectors for the given instruction set. AVX-512 uses the
+/// AVX2 version, as this is limited by loading the vectors.
+inline Aabb4f_FromVector4fStreamFunc Aabb4f_SelectFromVector4fStream(InstructionSet isa)
+{
+  switch (isa)
+  {
+#if MATHS3D_X86
+    case InstructionSet::AVX512:
+    case InstructionSet::AVX2:
+      return &Aabb4f_AVX2FromVector4fStream;
+    case InstructionSet::SSE:
+      return &Aabb4f_SSEFromVector4fStream;
+#endif
+    default:
+      return &Aabb4f_FromVector4fStreamGeneric;
+  }
+}
+
+/// Returns the bounds of an array of vectors, using the best implementation for the CPU.
+/// \see Aabb4f_FromVector4fStreamGeneric for a description of the parameters.
+inline Aabb4f Aabb4f_FromVector4fStream(const Vector4f* inputStream, unsigned count)
+{
+  static const Aabb4f_FromVector4fStreamFunc kernel = Aabb4f_SelectFromVector4fStream(InstructionSet_Active());
+  return kernel(inputStream, count);
+}
+
+/// Returns a sphere which contains all of an array of points. The center is the center of their bounds, and the
+/// radius is the distance to the furthest point from it, which is close to the smallest sphere for most meshes.
+/// The w components of the points are ignored.
+/// \see Aabb4f_FromVector4fStreamGeneric for a description of the parameters.
+inline BoundingSphere4f BoundingSphere4f_FromVector4fStream(const Vector4f* inputStream, unsigned count)
+{
+  const Vector4f center = Vector4f_SetW(Aabb4f_Center(Aabb4f_FromVector4fStream(inputStream, count)), Scalar1f_Zero());
+#if MATHS3D_X86
+  const __m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), cz = _mm_set1_ps(center.z);
+  __m128 furthest = _mm_setzero_ps();
+  unsigned i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    // Transpose four points so that each lane holds the squared distance of one of them
+    __m128 x = _mm_loadu_ps(inputStream[i + 0].v);
+    __m128 y = _mm_loadu_ps(inputStream[i + 1].v);
+    __m128 z = _mm_loadu_ps(inputStream[i + 2].v);
+    __m128 w = _mm_loadu_ps(inputStream[i + 3].v);
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+    x = _mm_sub_ps(x, cx);
+    y = _mm_sub_ps(y, cy);
+    z = _mm_sub_ps(z, cz);
+    furthest = _mm_max_ps(furthest, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+  }
+  furthest = _mm_max_ps(furthest, _mm_shuffle_ps(furthest, furthest, _MM_SHUFFLE(1,0,3,2)));
+  furthest = _mm_max_ps(furthest, _mm_shuffle_ps(furthest, furthest, _MM_SHUFFLE(2,3,0,1)));
+  Scalar1f distanceSquared = _mm_cvtss_f32(furthest);
+  for (; i < count; ++i)
+  {
+    distanceSquared = ::fmax(distanceSquared, Vector4f_LengthSquared(Vector4f_SetW(Vector4f_Subtract(inputStream[i], center), Scalar1f_Zero())));
+  }
+#else
+  Scalar1f distanceSquared = 0.0f;
+  for (unsigned i = 0; i < count; ++i)
+  {
+    distanceSquared = ::fmax(distanceSquared, Vector4f_LengthSquared(Vector4f_SetW(Vector4f_Subtract(inputStream[i], center), Scalar1f_Zero())));
+  }
+#endif
+  return BoundingSphere4f_Set(center, ::sqrt(distanceSquared));
+}
+
+/// The context passed to each of the chunks of Aabb4f_ParallelFromVector4fStream.
+struct ParallelBoundsContext
+{
+  const Vector4f* inputStream;
+  unsigned        count;
+  unsigned        chunkSize;
+  Aabb4f*         chunkBounds;
+};
+
+/// Bounds one chunk of the array for Aabb4f_ParallelFromVector4fStream.
+inline void Aabb4f_ParallelBoundsChunk(void* context, unsigned chunk)
+{
+  const ParallelBoundsContext& ctx = *(const ParallelBoundsContext*)context;
+  const unsigned start = chunk * ctx.chunkSize;
+  const unsigned count = (ctx.count - start < ctx.chunkSize) ? ctx.count - start : ctx.chunkSize;
+  ctx.chunkBounds[chunk] = Aabb4f_FromVector4fStream(ctx.inputStream + start, count);
+}
+
+/// Returns the bounds of an array of vectors, for very large point clouds. The array is split in to cache sized
+/// chunks which are bounded by the threads of the WorkerPool, and the bounds of the chunks are merged on the
+/// calling thread. Arrays smaller than config.serialThreshold are bounded on the calling thread.
+/// \see Aabb4f_FromVector4fStreamGeneric for a description of the parameters.
+/// \param config controls the splitting of the work. \see ParallelConfig_Default
+inline Aabb4f Aabb4f_ParallelFromVector4fStream(const Vector4f* inputStream, unsigned count, const ParallelConfig& config = ParallelConfig_Default())
+{
+  const unsigned maxThreads = (config.maxThreads) ? config.maxThreads : unsigned(WorkerPool_Get().threads.size() + 1);
+  if (count < config.serialThreshold || maxThreads < 2)
+  {
+    return Aabb4f_FromVector4fStream(inputStream, count);
+  }
+  const unsigned chunkSize = ParallelConfig_ChunkSize(config, sizeof(Vector4f));
+  const unsigned chunkCount = (count + chunkSize - 1) / chunkSize;
+  std::vector<Aabb4f> chunkBounds(chunkCount);
+  ParallelBoundsContext context = { inputStream, count, chunkSize, chunkBounds.data() };
+  WorkerPool_ParallelFor(chunkCount, maxThreads, Aabb4f_ParallelBoundsChunk, &context);
+  Aabb4f ret = Aabb4f_Empty();
+  for (unsigned i = 0; i < chunkCount; ++i)
+  {
+    ret = Aabb4f_Merge(ret, chunkBounds[i]);
+  }
+  return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// Ray intersection
+
+/// \brief
+/// Rays stored as a structure of arrays, so that 4 or 8 of them can be intersected with a primitive at once.
+struct RayPacketSoA
+{
+  const float* originX;       /// The x components of the origins of the rays.
+  const float* originY;       /// The y components of the origins of the rays.
+  const float* originZ;       /// The z components of the origins of the rays.
+  const float* directionX;    /// The x components of the directions of the rays.
+  const float* directionY;    /// The y components of the directions of the rays.
+  const float* directionZ;    /// The z components of the directions of the rays.
+};
+
+/// \brief
+/// The nearest hits of each ray of a RayPacketSoA, stored as a structure of arrays. \see RayHit4f
+struct RayHitsSoA
+{
+  float*    t;                /// The distances of the hits along the rays.
+  uint32_t* primitive;        /// The ids of the primitives which were hit.
+  float*    u;                /// The barycentric weights of the second vertex of the triangles hit.
+  float*    v;                /// The barycentric weights of the third vertex of the triangles hit.
+};
+
+/// \brief
+/// Triangles stored as a structure of arrays of the components of their three vertices a, b and c.
+struct TrianglesSoA
+{
+  const float* ax;
+  const float* ay;
+  const float* az;
+  const float* bx;
+  const float* by;
+  const float* bz;
+  const float* cx;
+  const float* cy;
+  const float* cz;
+};
+
+/// Returns the ray at index of the packet.
+inline Ray4f RayPacketSoA_Ray(const RayPacketSoA& rays, unsigned index)
+{
+  return Ray4f_Set(Vector4f_Set(rays.originX[index], rays.originY[index], rays.originZ[index], Scalar1f_One()),
+                   Vector4f_Set(rays.directionX[index], rays.directionY[index], rays.directionZ[index], Scalar1f_Zero()));
+}
+
+/// Returns the hit at index of the hits.
+inline RayHit4f RayHitsSoA_Hit(const RayHitsSoA& hits, unsigned index)
+{
+  return RayHit4f{ hits.t[index], hits.primitive[index], hits.u[index], hits.v[index] };
+}
+
+/// Stores hit at index of the hits.
+inline void RayHitsSoA_SetHit(const RayHitsSoA& hits, unsigned index, const RayHit4f& hit)
+{
+  hits.t[index] = hit.t;
+  hits.primitive[index] = hit.primitive;
+  hits.u[index] = hit.u;
+  hits.v[index] = hit.v;
+}
+
+/// Sets count of the hits to RayHit4f_None, ready to search for the nearest hits of a packet of rays.
+inline void RayHitsSoA_Clear(const RayHitsSoA& hits, unsigned count)
+{
+  for (unsigned i = 0; i < count; ++i)
+  {
+    RayHitsSoA_SetHit(hits, i, RayHit4f_None());
+  }
+}
+
+/// Returns the vertex a of the triangle at index.
+inline Vector4f TrianglesSoA_A(const TrianglesSoA& triangles, unsigned index)
+{
+  return Vector4f_Set(triangles.ax[index], triangles.ay[index], triangles.az[index], Scalar1f_One());
+}
+
+/// Returns the vertex b of the triangle at index.
+inline Vector4f TrianglesSoA_B(const TrianglesSoA& triangles, unsigned index)
+{
+  return Vector4f_Set(triangles.bx[index], triangles.by[index], triangles.bz[index], Scalar1f_One());
+}
+
+/// Returns the vertex c of the triangle at index.
+inline Vector4f TrianglesSoA_C(const TrianglesSoA& triangles, unsigned index)
+{
+  return Vector4f_Set(triangles.cx[index], triangles.cy[index], triangles.cz[index], Scalar1f_One());
+}
+
+/// Replaces hit with the nearest of the per lane hits of a search along one ray, if it is nearer. Of equally near
+/// lanes, the one with the lowest primitive id is used, which is the one the reference implementations find.
+/// \return true if hit was replaced.
+inline bool RayHit4f_NearestLane(RayHit4f& hit, const float* t, const uint32_t* primitive, const float* u, const float* v, unsigned lanes)
+{
+  const uint32_t original = hit.primitive;
+  const Scalar1f originalT = hit.t;
+  for (unsigned k = 0; k < lanes; ++k)
+  {
+    if (t[k] < hit.t || (t[k] == hit.t && t[k] < originalT && primitive[k] < hit.primitive))
+    {
+      hit = RayHit4f{ t[k], primitive[k], u[k], v[k] };
+    }
+  }
+  return hit.primitive != original || hit.t != originalT;
+}
+
+/// Intersects ray with count spheres stored as a structure of arrays, keeping the nearest hit (reference
+/// implementation). The primitive ids of the hits are the indices of the spheres.
+/// \param ray is the ray to intersect.
+/// \param centerX, centerY, centerZ are the arrays of the components of the centers of the spheres.
+/// \param radius is the array of the radii of the spheres.
+/// \param count is the number of spheres.
+/// \param hit is the nearest hit so far, which is replaced by any nearer hit. \see RayHit4f_None
+/// \return true if hit was replaced.
+inline bool Ray4f_IntersectSpheresStreamGeneric(const Ray4f& ray, const float* centerX, const float* centerY, const float* centerZ,
+                                                const float* radius, unsigned count, RayHit4f& hit)
+{
+  bool replaced = false;
+  for (unsigned i = 0; i < count; ++i)
+  {
+    const BoundingSphere4f sphere = BoundingSphere4f_Set(Vector4f_Set(centerX[i], centerY[i], centerZ[i], Scalar1f_One()), radius[i]);
+    replaced |= Ray4f_IntersectSphere(ray, sphere, i, hit);
+  }
+  return replaced;
+}
+
+/// Intersects ray with count axis aligned boxes stored as a structure of arrays, keeping the nearest hit
+/// (reference implementation). The primitive ids of the hits are the indices of the boxes.
+/// \param minX, minY, minZ, maxX, maxY, maxZ are the arrays of the components of the corners of the boxes.
+/// \see Ray4f_IntersectSpheresStreamGeneric for a description of the other parameters and the return value.
+inline bool Ray4f_IntersectAabbsStreamGeneric(const Ray4f& ray, const float* minX, const float* minY, const float* minZ,
+                                              const float* maxX, const float* maxY, const float* maxZ, unsigned count, RayHit4f& hit)
+{
+  const Vector4f inverseDirection = Ray4f_InverseDirection(ray);
+  bool replaced = false;
+  for (unsigned i = 0; i < count; ++i)
+  {
+    const Aabb4f box = Aabb4f_Set(Vector4f_Set(minX[i], minY[i], minZ[i], Scalar1f_One()), Vector4f_Set(maxX[i], maxY[i], maxZ[i], Scalar1f_One()));
+    replaced |= Ray4f_IntersectAabb(ray, inverseDirection, box, i, hit);
+  }
+  return replaced;
+}
+
+/// Intersects ray with count triangles stored as a structure of arrays, keeping the nearest hit (reference
+/// implementation). The primitive ids of the hits are the indices of the triangles. \see Ray4f_IntersectTriangle
+/// \param triangles are the arrays of the components of the vertices of the triangles.
+/// \see Ray4f_IntersectSpheresStreamGeneric for a description of the other parameters and the return value.
+inline bool Ray4f_IntersectTrianglesStreamGeneric(const Ray4f& ray, const TrianglesSoA& triangles, unsigned count, RayHit4f& hit)
+{
+  const RayShear4f shear = Ray4f_Shear(ray);
+  bool replaced = false;
+  for (unsigned i = 0; i < count; ++i)
+  {
+    replaced |= Ray4f_IntersectTriangle(shear, TrianglesSoA_A(triangles, i), TrianglesSoA_B(triangles, i), TrianglesSoA_C(triangles, i), i, hit);
+  }
+  return replaced;
+}
+
+/// Intersects count rays stored as a structure of arrays with the sphere, keeping the nearest hit of each ray
+/// (reference implementation).
+/// \param rays are the arrays of the components of the rays.
+/// \param count is the number of rays.
+/// \param sphere is the sphere to intersect.
+/// \param primitive is the id of the sphere for the hits.
+/// \param hits are the nearest hits so far of each ray, which are replaced by any nearer hits. \see RayHitsSoA_Clear
+inline void RayPacketSoA_IntersectSphereGeneric(const RayPacketSoA& rays, unsigned count, const BoundingSphere4f& sphere, uint32_t primitive, const RayHitsSoA& hits)
+{
+  for (unsigned i = 0; i < count; ++i)
+  {
+    RayHit4f hit = RayHitsSoA_Hit(hits, i);
+    if (Ray4f_IntersectSphere(RayPacketSoA_Ray(rays, i), sphere, primitive, hit))
+    {
+      RayHitsSoA_SetHit(hits, i, hit);
+    }
+  }
+}
+
+/// Intersects count rays stored as a structure of arrays with the box, keeping the nearest hit of each ray
+/// (reference implementation). \see RayPacketSoA_IntersectSphereGeneric for a description of the parameters.
+inline void RayPacketSoA_IntersectAabbGeneric(const RayPacketSoA& rays, unsigned count, const Aabb4f& box, uint32_t primitive, const RayHitsSoA& hits)
+{
+  for (unsigned i = 0; i < count; ++i)
+  {
+    RayHit4f hit = RayHitsSoA_Hit(hits, i);
+    if (Ray4f_IntersectAabb(RayPacketSoA_Ray(rays, i), box, primitive, hit))
+    {
+      RayHitsSoA_SetHit(hits, i, hit);
+    }
+  }
+}
+
+/// Intersects count rays stored as a structure of arrays with the triangle a, b, c, keeping the nearest hit of
+/// each ray (reference implementation). \see RayPacketSoA_IntersectSphereGeneric for a description of the parameters.
+inline void RayPacketSoA_IntersectTriangleGeneric(const RayPacketSoA& rays, unsigned count, const Vector4f& a, const Vector4f& b, const Vector4f& c,
+                                                  uint32_t primitive, const RayHitsSoA& hits)
+{
+  for (unsigned i = 0; i < count; ++i)
+  {
+    RayHit4f hit = RayHitsSoA_Hit(hits, i);
+    if (Ray4f_IntersectTriangle(RayPacketSoA_Ray(rays, i), a, b, c, primitive, hit))
+    {
+      RayHitsSoA_SetHit(hits, i, hit);
+    }
+  }
+}
+
+#if MATHS3D_X86
+
+/// Returns the components of a where mask is set and of b elsewhere.
+inline __m128 Vector4f_SSESelect(__m128 mask, __m128 a, __m128 b)
+{
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+/// Intersects the ray and sphere in each of the four lanes (SSE implementation). Whole sets of lanes which miss
+/// are rejected before the square roots. \see Ray4f_IntersectSphere
+/// \return the mask of the lanes which hit nearer than nearestT, with the distances of their hits in t.
+inline __m128 Ray4f_SSEIntersectSphereLanes(__m128 ox, __m128 oy, __m128 oz, __m128 dx, __m128 dy, __m128 dz,
+                                            __m128 cx, __m128 cy, __m128 cz, __m128 r, __m128 nearestT, __m128& t)
+{
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 offsetX = _mm_sub_ps(ox, cx), offsetY = _mm_sub_ps(oy, cy), offsetZ = _mm_sub_ps(oz, cz);
+  const __m128 a = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+  const __m128 b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(offsetX, dx), _mm_mul_ps(offsetY, dy)), _mm_mul_ps(offsetZ, dz));
+  const __m128 c = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(offsetX, offsetX), _mm_mul_ps(offsetY, offsetY)), _mm_mul_ps(offsetZ, offsetZ)), _mm_mul_ps(r, r));
+  const __m128 discriminant = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(a, c));
+  const __m128 candidate = _mm_andnot_ps(_mm_and_ps(_mm_cmpgt_ps(c, zero), _mm_cmpgt_ps(b, zero)), _mm_cmpge_ps(discriminant, zero));
+  t = zero;
+  if (!_mm_movemask_ps(candidate))
+  {
+    return zero;
+  }
+  const __m128 root = _mm_sqrt_ps(_mm_max_ps(discriminant, zero));
+  const __m128 nearest = Vector4f_SSEExactDivide(_mm_sub_ps(_mm_sub_ps(zero, b), root), a);
+  t = Vector4f_SSESelect(_mm_cmpgt_ps(nearest, zero), nearest, Vector4f_SSEExactDivide(_mm_sub_ps(root, b), a));
+  return _mm_and_ps(candidate, _mm_and_ps(_mm_cmpgt_ps(t, zero), _mm_cmplt_ps(t, nearestT)));
+}
+
+/// Intersects the ray and box in each of the four lanes with the slab test (SSE implementation).
+/// \see Ray4f_IntersectAabb and Ray4f_SSEIntersectSphereLanes
+inline __m128 Ray4f_SSEIntersectAabbLanes(__m128 ox, __m128 oy, __m128 oz, __m128 ix, __m128 iy, __m128 iz,
+                                          __m128 minX, __m128 minY, __m128 minZ, __m128 maxX, __m128 maxY, __m128 maxZ,
+                                          __m128 nearestT, __m128& t)
+{
+  const __m128 t0x = _mm_mul_ps(_mm_sub_ps(minX, ox), ix), t1x = _mm_mul_ps(_mm_sub_ps(maxX, ox), ix);
+  const __m128 t0y = _mm_mul_ps(_mm_sub_ps(minY, oy), iy), t1y = _mm_mul_ps(_mm_sub_ps(maxY, oy), iy);
+  const __m128 t0z = _mm_mul_ps(_mm_sub_ps(minZ, oz), iz), t1z = _mm_mul_ps(_mm_sub_ps(maxZ, oz), iz);
+  const __m128 enter = _mm_max_ps(_mm_max_ps(_mm_min_ps(t0x, t1x), _mm_min_ps(t0y, t1y)), _mm_min_ps(t0z, t1z));
+  const __m128 leave = _mm_min_ps(_mm_min_ps(_mm_max_ps(t0x, t1x), _mm_max_ps(t0y, t1y)), _mm_max_ps(t0z, t1z));
+  const __m128 zero = _mm_setzero_ps();
+  t = Vector4f_SSESelect(_mm_cmpgt_ps(enter, zero), enter, leave);
+  return _mm_and_ps(_mm_cmple_ps(enter, leave), _mm_and_ps(_mm_cmpgt_ps(t, zero), _mm_cmplt_ps(t, nearestT)));
+}
+
+/// Returns x * y - z * w for each lane, with the products kept apart. \see Ray4f_DifferenceOfProducts
+inline __m128 Ray4f_SSEDifferenceOfProducts(__m128 x, __m128 y, __m128 z, __m128 w)
+{
+  __m128 xy = _mm_mul_ps(x, y);
+  __m128 zw = _mm_mul_ps(z, w);
+  MATHS3D_OPAQUE(xy);
+  MATHS3D_OPAQUE(zw);
+  return _mm_sub_ps(xy, zw);
+}
+
+/// Intersects the sheared ray and triangle in each of the four lanes with the watertight test (SSE implementation).
+/// The vertices are relative to the origins of the rays and permuted to the axes kx, ky and kz of the rays.
+/// \see Ray4f_IntersectTriangle and Ray4f_SSEIntersectSphereLanes
+inline __m128 Ray4f_SSEIntersectTriangleLanes(__m128 sx, __m128 sy, __m128 sz,
+                                              __m128 akx, __m128 aky, __m128 akz, __m128 bkx, __m128 bky, __m128 bkz,
+                                              __m128 ckx, __m128 cky, __m128 ckz, __m128 nearestT, __m128& t, __m128& u, __m128& v)
+{
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 ax = _mm_sub_ps(akx, _mm_mul_ps(sx, akz)), ay = _mm_sub_ps(aky, _mm_mul_ps(sy, akz));
+  const __m128 bx = _mm_sub_ps(bkx, _mm_mul_ps(sx, bkz)), by = _mm_sub_ps(bky, _mm_mul_ps(sy, bkz));
+  const __m128 cx = _mm_sub_ps(ckx, _mm_mul_ps(sx, ckz)), cy = _mm_sub_ps(cky, _mm_mul_ps(sy, ckz));
+  const __m128 U = Ray4f_SSEDifferenceOfProducts(cx, by, cy, bx);
+  const __m128 V = Ray4f_SSEDifferenceOfProducts(ax, cy, ay, cx);
+  const __m128 W = Ray4f_SSEDifferenceOfProducts(bx, ay, by, ax);
+  const __m128 negative = _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(U, zero), _mm_cmplt_ps(V, zero)), _mm_cmplt_ps(W, zero));
+  const __m128 positive = _mm_or_ps(_mm_or_ps(_mm_cmpgt_ps(U, zero), _mm_cmpgt_ps(V, zero)), _mm_cmpgt_ps(W, zero));
+  const __m128 determinant = _mm_add_ps(_mm_add_ps(U, V), W);
+  const __m128 valid = _mm_andnot_ps(_mm_and_ps(negative, positive), _mm_cmpneq_ps(determinant, zero));
+  t = u = v = zero;
+  if (!_mm_movemask_ps(valid))
+  {
+    return zero;
+  }
+  // The lanes which missed divide by one instead of zero
+  const __m128 inverseDeterminant = Vector4f_SSEExactDivide(_mm_set1_ps(1.0f), Vector4f_SSESelect(valid, determinant, _mm_set1_ps(1.0f)));
+  const __m128 T = _mm_mul_ps(sz, _mm_add_ps(_mm_add_ps(_mm_mul_ps(U, akz), _mm_mul_ps(V, bkz)), _mm_mul_ps(W, ckz)));
+  t = _mm_mul_ps(T, inverseDeterminant);
+  u = _mm_mul_ps(V, inverseDeterminant);
+  v = _mm_mul_ps(W, inverseDeterminant);
+  return _mm_and_ps(valid, _mm_and_ps(_mm_cmpgt_ps(t, zero), _mm_cmplt_ps(t, nearestT)));
+}
+
+/// Permutes the x, y and z components in each lane to the axes kx, ky and kz of the ray in that lane, where zIsX
+/// and zIsY select kz, and swap reverses kx and ky. \see Ray4f_Shear
+inline void Ray4f_SSEPermute(__m128 zIsX, __m128 zIsY, __m128 swap, __m128 x, __m128 y, __m128 z, __m128& px, __m128& py, __m128& pz)
+{
+  const __m128 next = Vector4f_SSESelect(zIsX, y, Vector4f_SSESelect(zIsY, z, x));
+  const __m128 after = Vector4f_SSESelect(zIsX, z, Vector4f_SSESelect(zIsY, x, y));
+  pz = Vector4f_SSESelect(zIsX, x, Vector4f_SSESelect(zIsY, y, z));
+  px = Vector4f_SSESelect(swap, after, next);
+  py = Vector4f_SSESelect(swap, next, after);
+}
+
+/// Returns 1/x of each lane with x moved away from zero to at least Ray4f_MinimumDirection, keeping its sign.
+/// \see Ray4f_ClampedReciprocal
+inline __m128 Ray4f_SSEClampedReciprocal(__m128 x)
+{
+  const __m128 signMask = _mm_set1_ps(-0.0f);
+  const __m128 magnitude = _mm_max_ps(_mm_andnot_ps(signMask, x), _mm_set1_ps(Ray4f_MinimumDirection));
+  return Vector4f_SSEExactDivide(_mm_set1_ps(1.0f), _mm_or_ps(_mm_and_ps(signMask, x), magnitude));
+}
+
+/// Replaces the hits of the lanes in mask of the four rays from index with t, primitive, u and v.
+inline void RayHitsSoA_SSEUpdate(const RayHitsSoA& hits, unsigned index, __m128 mask, __m128 t, __m128 primitive, __m128 u, __m128 v)
+{
+  if (!_mm_movemask_ps(mask))
+  {
+    return;
+  }
+  _mm_storeu_ps(hits.t + index, Vector4f_SSESelect(mask, t, _mm_loadu_ps(hits.t + index)));
+  const __m128 primitives = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(hits.primitive + index)));
+  _mm_storeu_si128((__m128i*)(hits.primitive + index), _mm_castps_si128(Vector4f_SSESelect(mask, primitive, primitives)));
+  _mm_storeu_ps(hits.u + index, Vector4f_SSESelect(mask, u, _mm_loadu_ps(hits.u + index)));
+  _mm_storeu_ps(hits.v + index, Vector4f_SSESelect(mask, v, _mm_loadu_ps(hits.v + index)));
+}
+
+/// Intersects ray with spheres four at a time (SSE implementation).
+/// \see Ray4f_IntersectSpheresStreamGeneric for a description of the parameters and the return value.
+inline bool Ray4f_SSEIntersectSpheresStream(const Ray4f& ray, const float* centerX, const float* centerY, const float* centerZ,
+                                            const float* radius, unsigned count, RayHit4f& hit)
+{
+  const __m128 ox = _mm_set1_ps(ray.origin.x), oy = _mm_set1_ps(ray.origin.y), oz = _mm_set1_ps(ray.origin.z);
+  const __m128 dx = _mm_set1_ps(ray.direction.x), dy = _mm_set1_ps(ray.direction.y), dz = _mm_set1_ps(ray.direction.z);
+  __m128 nearestT = _mm_set1_ps(hit.t);
+  __m128 nearestPrimitive = _mm_castsi128_ps(_mm_set1_epi32(int(hit.primitive)));
+  __m128i index = _mm_setr_epi32(0, 1, 2, 3);
+  unsigned i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128 t;
+    const __m128 mask = Ray4f_SSEIntersectSphereLanes(ox, oy, oz, dx, dy, dz, _mm_loadu_ps(centerX + i), _mm_loadu_ps(centerY + i),
+                                                      _mm_loadu_ps(centerZ + i), _mm_loadu_ps(radius + i), nearestT, t);
+    nearestT = Vector4f_SSESelect(mask, t, nearestT);
+    nearestPrimitive = Vector4f_SSESelect(mask, _mm_castsi128_ps(index), nearestPrimitive);
+    index = _mm_add_epi32(index, _mm_set1_epi32(4));
+  }
+  float t[4], u[4] = {}, v[4] = {};
+  uint32_t primitive[4];
+  _mm_storeu_ps(t, nearestT);
+  _mm_storeu_si128((__m128i*)primitive, _mm_castps_si128(nearestPrimitive));
+  bool replaced = RayHit4f_NearestLane(hit, t, primitive, u, v, 4);
+  for (; i < count; ++i)
+  {
+    replaced |= Ray4f_IntersectSphere(ray, BoundingSphere4f_Set(Vector4f_Set(centerX[i], centerY[i], centerZ[i], 1.0f), radius[i]), i, hit);
+  }
+  return replaced;
+}
+
+/// Intersects ray with boxes four at a time (SSE implementation).
+/// \see Ray4f_IntersectAabbsStreamGeneric for a description of the parameters and the return value.
+inline bool Ray4f_SSEIntersectAabbsStream(const Ray4f& ray, const float* minX, const float* minY, const float* minZ,
+                                          const float* maxX, const float* maxY, const float* maxZ, unsigned count, RayHit4f& hit)
+{
+  const Vector4f inverseDirection = Ray4f_InverseDirection(ray);
+  const __m128 ox = _mm_set1_ps(ray.origin.x), oy = _mm_set1_ps(ray.origin.y), oz = _mm_set1_ps(ray.origin.z);
+  const __m128 ix = _mm_set1_ps(inverseDirection.x), iy = _mm_set1_ps(inverseDirection.y), iz = _mm_set1_ps(inverseDirection.z);
+  __m128 nearestT = _mm_set1_ps(hit.t);
+  __m128 nearestPrimitive = _mm_castsi128_ps(_mm_set1_epi32(int(hit.primitive)));
+  __m128i index = _mm_setr_epi32(0, 1, 2, 3);
+  unsigned i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128 t;
+    const __m128 mask = Ray4f_SSEIntersectAabbLanes(ox, oy, oz, ix, iy, iz, _mm_loadu_ps(minX + i), _mm_loadu_ps(minY + i), _mm_loadu_ps(minZ + i),
+                                                    _mm_loadu_ps(maxX + i), _mm_loadu_ps(maxY + i), _mm_loadu_ps(maxZ + i), nearestT, t);
+    nearestT = Vector4f_SSESelect(mask, t, nearestT);
+    nearestPrimitive = Vector4f_SSESelect(mask, _mm_castsi128_ps(index), nearestPrimitive);
+    index = _mm_add_epi32(index, _mm_set1_epi32(4));
+  }
+  float t[4], u[4] = {}, v[4] = {};
+  uint32_t primitive[4];
+  _mm_storeu_ps(t, nearestT);
+  _mm_storeu_si128((__m128i*)primitive, _mm_castps_si128(nearestPrimitive));
+  bool replaced = RayHit4f_NearestLane(hit, t, primitive, u, v, 4);
+  for (; i < count; ++i)
+  {
+    const Aabb4f box = Aabb4f_Set(Vector4f_Set(minX[i], minY[i], minZ[i], 1.0f), Vector4f_Set(maxX[i], maxY[i], maxZ[i], 1.0f));
+    replaced |= Ray4f_IntersectAabb(ray, inverseDirection, box, i, hit);
+  }
+  return replaced;
+}
+
+/// Intersects ray with triangles four at a time (SSE implementation). The permutation of the axes is the same for
+/// all of the triangles, so it is done by picking which arrays to load.
+/// \see Ray4f_IntersectTrianglesStreamGeneric for a description of the parameters and the return value.
+inline bool Ray4f_SSEIntersectTrianglesStream(const Ray4f& ray, const TrianglesSoA& triangles, unsigned count, RayHit4f& hit)
+{
+  const RayShear4f shear = Ray4f_Shear(ray);
+  const float* const a[3] = { triangles.ax, triangles.ay, triangles.az };
+  const float* const b[3] = { triangles.bx, triangles.by, triangles.bz };
+  const float* const c[3] = { triangles.cx, triangles.cy, triangles.cz };
+  const __m128 okx = _mm_set1_ps(shear.origin.v[shear.kx]), oky = _mm_set1_ps(shear.origin.v[shear.ky]), okz = _mm_set1_ps(shear.origin.v[shear.kz]);
+  const __m128 sx = _mm_set1_ps(shear.sx), sy = _mm_set1_ps(shear.sy), sz = _mm_set1_ps(shear.sz);
+  __m128 nearestT = _mm_set1_ps(hit.t);
+  __m128 nearestPrimitive = _mm_castsi128_ps(_mm_set1_epi32(int(hit.primitive)));
+  __m128 nearestU = _mm_set1_ps(hit.u), nearestV = _mm_set1_ps(hit.v);
+  __m128i index = _mm_setr_epi32(0, 1, 2, 3);
+  unsigned i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128 t, u, v;
+    const __m128 mask = Ray4f_SSEIntersectTriangleLanes(sx, sy, sz,
+        _mm_sub_ps(_mm_loadu_ps(a[shear.kx] + i), okx), _mm_sub_ps(_mm_loadu_ps(a[shear.ky] + i), oky), _mm_sub_ps(_mm_loadu_ps(a[shear.kz] + i), okz),
+        _mm_sub_ps(_mm_loadu_ps(b[shear.kx] + i), okx), _mm_sub_ps(_mm_loadu_ps(b[shear.ky] + i), oky), _mm_sub_ps(_mm_loadu_ps(b[shear.kz] + i), okz),
+        _mm_sub_ps(_mm_loadu_ps(c[shear.kx] + i), okx), _mm_sub_ps(_mm_loadu_ps(c[shear.ky] + i), oky), _mm_sub_ps(_mm_loadu_ps(c[shear.kz] + i), okz),
+        nearestT, t, u, v);
+    nearestT = Vector4f_SSESelect(mask, t, nearestT);
+    nearestPrimitive = Vector4f_SSESelect(mask, _mm_castsi128_ps(index), nearestPrimitive);
+    nearestU = Vector4f_SSESelect(mask, u, nearestU);
+    nearestV = Vector4f_SSESelect(mask, v, nearestV);
+    index = _mm_add_epi32(index, _mm_set1_epi32(4));
+  }
+  float t[4], u[4], v[4];
+  uint32_t primitive[4];
+  _mm_storeu_ps(t, nearestT);
+  _mm_storeu_si128((__m128i*)primitive, _mm_castps_si128(nearestPrimitive));
+  _mm_storeu_ps(u, nearestU);
+  _mm_storeu_ps(v, nearestV);
+  bool replaced = RayHit4f_NearestLane(hit, t, primitive, u, v, 4);
+  for (; i < count; ++i)
+  {
+    replaced |= Ray4f_IntersectTriangle(shear, TrianglesSoA_A(triangles, i), TrianglesSoA_B(triangles, i), TrianglesSoA_C(triangles, i), i, hit);
+  }
+  return replaced;
+}
+
+/// Intersects rays with the sphere four at a time (SSE implementation).
+/// \see RayPacketSoA_IntersectSphereGeneric for a description of the parameters.
+inline void RayPacketSoA_SSEIntersectSphere(const RayPacketSoA& rays, unsigned count, const BoundingSphere4f& sphere, uint32_t primitive, const RayHitsSoA& hits)
+{
+  const __m128 cx = _mm_set1_ps(sphere.center.x), cy = _mm_set1_ps(sphere.center.y), cz = _mm_set1_ps(sphere.center.z);
+  const __m128 r = _mm_set1_ps(sphere.radius);
+  const __m128 primitives = _mm_castsi128_ps(_mm_set1_epi32(int(primitive)));
+  unsigned i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128 t;
+    const __m128 mask = Ray4f_SSEIntersectSphereLanes(_mm_loadu_ps(rays.originX + i), _mm_loadu_ps(rays.originY + i), _mm_loadu_ps(rays.originZ + i),
+                                                      _mm_loadu_ps(rays.directionX + i), _mm_loadu_ps(rays.directionY + i), _mm_loadu_ps(rays.directionZ + i),
+                                                      cx, cy, cz, r, _mm_loadu_ps(hits.t + i), t);
+    RayHitsSoA_SSEUpdate(hits, i, mask, t, primitives, _mm_setzero_ps(), _mm_setzero_ps());
+  }
+  for (; i < count; ++i)
+  {
+    RayHit4f hit = RayHitsSoA_Hit(hits, i);
+    if (Ray4f_IntersectSphere(RayPacketSoA_Ray(rays, i), sphere, primitive, hit))
+    {
+      RayHitsSoA_SetHit(hits, i, hit);
+    }
+  }
+}
+
+/// Intersects rays with the box four at a time (SSE implementation).
+/// \see RayPacketSoA_IntersectSphereGeneric for a description of the parameters.
+inline void RayPacketSoA_SSEIntersectAabb(const RayPacketSoA& rays, unsigned count, const Aabb4f& box, uint32_t primitive, const RayHitsSoA& hits)
+{
+  const __m128 minX = _mm_set1_ps(box.minimum.x), minY = _mm_set1_ps(box.minimum.y), minZ = _mm_set1_ps(box.minimum.z);
+  const __m128 maxX = _mm_set1_ps(box.maximum.x), maxY = _mm_set1_ps(box.maximum.y), maxZ = _mm_set1_ps(box.maximum.z);
+  const __m128 primitives = _mm_castsi128_ps(_mm_set1_epi32(int(primitive)));
+  unsigned i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128 t;
+    const __m128 mask = Ray4f_SSEIntersectAabbLanes(_mm_loadu_ps(rays.originX + i), _mm_loadu_ps(rays.originY + i), _mm_loadu_ps(rays.originZ + i),
+                                                    Ray4f_SSEClampedReciprocal(_mm_loadu_ps(rays.directionX + i)),
+                                                    Ray4f_SSEClampedReciprocal(_mm_loadu_ps(rays.directionY + i)),
+                                                    Ray4f_SSEClampedReciprocal(_mm_loadu_ps(rays.directionZ + i)),
+                                                    minX, minY, minZ, maxX, maxY, maxZ, _mm_loadu_ps(hits.t + i), t);
+    RayHitsSoA_SSEUpdate(hits, i, mask, t, primitives, _mm_setzero_ps(), _mm_setzero_ps());
+  }
+  for (; i < count; ++i)
+  {
+    RayHit4f hit = RayHitsSoA_Hit(hits, i);
+    if (Ray4f_IntersectAabb(RayPacketSoA_Ray(rays, i), box, primitive, hit))
+    {
+      RayHitsSoA_SetHit(hits, i, hit);
+    }
+  }
+}
+
+/// Intersects rays with the triangle a, b, c four at a time (SSE implementation). Each ray can have a different
+/// permutation of the axes, so the components are selected in each lane.
+/// \see RayPacketSoA_IntersectSphereGeneric for a description of the parameters.
+inline void RayPacketSoA_SSEIntersectTriangle(const RayPacketSoA& rays, unsigned count, const Vector4f& a, const Vector4f& b, const Vector4f& c,
+                                              uint32_t primitive, const RayHitsSoA& hits)
+{
+  const __m128 signMask = _mm_set1_ps(-0.0f);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 primitives = _mm_castsi128_ps(_mm_set1_epi32(int(primitive)));
+  unsigned i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    const __m128 ox = _mm_loadu_ps(rays.originX + i), oy = _mm_loadu_ps(rays.originY + i), oz = _mm_loadu_ps(rays.originZ + i);
+    const __m128 dx = _mm_loadu_ps(rays.directionX + i), dy = _mm_loadu_ps(rays.directionY + i), dz = _mm_loadu_ps(rays.directionZ + i);
+    // Choose kz as the largest component of each direction, as Ray4f_Shear does
+    const __m128 mx = _mm_andnot_ps(signMask, dx), my = _mm_andnot_ps(signMask, dy), mz = _mm_andnot_ps(signMask, dz);
+    const __m128 xOverY = _mm_cmpgt_ps(mx, my);
+    const __m128 zIsX = _mm_and_ps(xOverY, _mm_cmpgt_ps(mx, mz));
+    const __m128 zIsY = _mm_andnot_ps(xOverY, _mm_cmpgt_ps(my, mz));
+    __m128 dkx, dky, dkz;
+    Ray4f_SSEPermute(zIsX, zIsY, zero, dx, dy, dz, dkx, dky, dkz);
+    const __m128 swap = _mm_cmplt_ps(dkz, zero);
+    Ray4f_SSEPermute(zIsX, zIsY, swap, dx, dy, dz, dkx, dky, dkz);
+    const __m128 sz = Vector4f_SSEExactDivide(_mm_set1_ps(1.0f), dkz);
+    const __m128 sx = _mm_mul_ps(dkx, sz), sy = _mm_mul_ps(dky, sz);
+    __m128 akx, aky, akz, bkx, bky, bkz, ckx, cky, ckz;
+    Ray4f_SSEPermute(zIsX, zIsY, swap, _mm_sub_ps(_mm_set1_ps(a.x), ox), _mm_sub_ps(_mm_set1_ps(a.y), oy), _mm_sub_ps(_mm_set1_ps(a.z), oz), akx, aky, akz);
+    Ray4f_SSEPermute(zIsX, zIsY, swap, _mm_sub_ps(_mm_set1_ps(b.x), ox), _mm_sub_ps(_mm_set1_ps(b.y), oy), _mm_sub_ps(_mm_set1_ps(b.z), oz), bkx, bky, bkz);
+    Ray4f_SSEPermute(zIsX, zIsY, swap, _mm_sub_ps(_mm_set1_ps(c.x), ox), _mm_sub_ps(_mm_set1_ps(c.y), oy), _mm_sub_ps(_mm_set1_ps(c.z), oz), ckx, cky, ckz);
+    __m128 t, u, v;
+    const __m128 mask = Ray4f_SSEIntersectTriangleLanes(sx, sy, sz, akx, aky, akz, bkx, bky, bkz, ckx, cky, ckz, _mm_loadu_ps(hits.t + i), t, u, v);
+    RayHitsSoA_SSEUpdate(hits, i, mask, t, primitives, u, v);
+  }
+  for (; i < count; ++i)
+  {
+    RayHit4f hit = RayHitsSoA_Hit(hits, i);
+    if (Ray4f_IntersectTriangle(RayPacketSoA_Ray(rays, i), a, b, c, primitive, hit))
+    {
+      RayHitsSoA_SetHit(hits, i, hit);
+    }
+  }
+}
+
+/// Returns the components of a where mask is set and of b elsewhere.
+MATHS3D_TARGET("avx2,fma")
+inline __m256 Vector4f_AVX2Select(__m256 mask, __m256 a, __m256 b)
+{
+  return _mm256_blendv_ps(b, a, mask);
+}
+
+/// Intersects the ray and sphere in each of the eight lanes (AVX2 and FMA implementation).
+/// \see Ray4f_SSEIntersectSphereLanes
+MATHS3D_TARGET("avx2,fma")
+inline __m256 Ray4f_AVX2IntersectSphereLanes(__m256 ox, __m256 oy, __m256 oz, __m256 dx, __m256 dy, __m256 dz,
+                                             __m256 cx, __m256 cy, __m256 cz, __m256 r, __m256 nearestT, __m256& t)
+{
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 offsetX = _mm256_sub_ps(ox, cx), offsetY = _mm256_sub_ps(oy, cy), offsetZ = _mm256_sub_ps(oz, cz);
+  const __m256 a = _mm256_fmadd_ps(dx, dx, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dz, dz)));
+  const __m256 b = _mm256_fmadd_ps(offsetX, dx, _mm256_fmadd_ps(offsetY, dy, _mm256_mul_ps(offsetZ, dz)));
+  const __m256 c = _mm256_fmadd_ps(offsetX, offsetX, _mm256_fmadd_ps(offsetY, offsetY, _mm256_fmsub_ps(offsetZ, offsetZ, _mm256_mul_ps(r, r))));
+  const __m256 discriminant = _mm256_fmsub_ps(b, b, _mm256_mul_ps(a, c));
+  const __m256 candidate = _mm256_andnot_ps(_mm256_and_ps(_mm256_cmp_ps(c, zero, _CMP_GT_OQ), _mm256_cmp_ps(b, zero, _CMP_GT_OQ)),
+                                            _mm256_cmp_ps(discriminant, zero, _CMP_GE_OQ));
+  t = zero;
+  if (!_mm256_movemask_ps(candidate))
+  {
+    return zero;
+  }
+  const __m256 root = _mm256_sqrt_ps(_mm256_max_ps(discriminant, zero));
+  const __m256 nearest = Vector4f_AVX2ExactDivide(_mm256_sub_ps(_mm256_sub_ps(zero, b), root), a);
+  t = Vector4f_AVX2Select(_mm256_cmp_ps(nearest, zero, _CMP_GT_OQ), nearest, Vector4f_AVX2ExactDivide(_mm256_sub_ps(root, b), a));
+  return _mm256_and_ps(candidate, _mm256_and_ps(_mm256_cmp_ps(t, zero, _CMP_GT_OQ), _mm256_cmp_ps(t, nearestT, _CMP_LT_OQ)));
+}
+
+/// Intersects the ray and box in each of the eight lanes with the slab test (AVX2 and FMA implementation).
+/// \see Ray4f_SSEIntersectAabbLanes
+MATHS3D_TARGET("avx2,fma")
+inline __m256 Ray4f_AVX2IntersectAabbLanes(__m256 ox, __m256 oy, __m256 oz, __m256 ix, __m256 iy, __m256 iz,
+                                           __m256 minX, __m256 minY, __m256 minZ, __m256 maxX, __m256 maxY, __m256 maxZ,
+                                           __m256 nearestT, __m256& t)
+{
+  const __m256 t0x = _mm256_mul_ps(_mm256_sub_ps(minX, ox), ix), t1x = _mm256_mul_ps(_mm256_sub_ps(maxX, ox), ix);
+  const __m256 t0y = _mm256_mul_ps(_mm256_sub_ps(minY, oy), iy), t1y = _mm256_mul_ps(_mm256_sub_ps(maxY, oy), iy);
+  const __m256 t0z = _mm256_mul_ps(_mm256_sub_ps(minZ, oz), iz), t1z = _mm256_mul_ps(_mm256_sub_ps(maxZ, oz), iz);
+  const __m256 enter = _mm256_max_ps(_mm256_max_ps(_mm256_min_ps(t0x, t1x), _mm256_min_ps(t0y, t1y)), _mm256_min_ps(t0z, t1z));
+  const __m256 leave = _mm256_min_ps(_mm256_min_ps(_mm256_max_ps(t0x, t1x), _mm256_max_ps(t0y, t1y)), _mm256_max_ps(t0z, t1z));
+  const __m256 zero = _mm256_setzero_ps();
+  t = Vector4f_AVX2Select(_mm256_cmp_ps(enter, zero, _CMP_GT_OQ), enter, leave);
+  return _mm256_and_ps(_mm256_cmp_ps(enter, leave, _CMP_LE_OQ),
+                       _mm256_and_ps(_mm256_cmp_ps(t, zero, _CMP_GT_OQ), _mm256_cmp_ps(t, nearestT, _CMP_LT_OQ)));
+}
+
+/// Returns x * y - z * w for each lane, with the products kept apart so they can't be fused.
+/// \see Ray4f_DifferenceOfProducts
+MATHS3D_TARGET("avx2,fma")
+inline __m256 Ray4f_AVX2DifferenceOfProducts(__m256 x, __m256 y, __m256 z, __m256 w)
+{
+  __m256 xy = _mm256_mul_ps(x, y);
+  __m256 zw = _mm256_mul_ps(z, w);
+  MATHS3D_OPAQUE(xy);
+  MATHS3D_OPAQUE(zw);
+  return _mm256_sub_ps(xy, zw);
+}
+
+/// Intersects the sheared ray and triangle in each of the eight lanes with the watertight test (AVX2 and FMA
+/// implementation). \see Ray4f_SSEIntersectTriangleLanes
+MATHS3D_TARGET("avx2,fma")
+inline __m256 Ray4f_AVX2IntersectTriangleLanes(__m256 sx, __m256 sy, __m256 sz,
+                                               __m256 akx, __m256 aky, __m256 akz, __m256 bkx, __m256 bky, __m256 bkz,
+                                               __m256 ckx, __m256 cky, __m256 ckz, __m256 nearestT, __m256& t, __m256& u, __m256& v)
+{
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 ax = _mm256_fnmadd_ps(sx, akz, akx), ay = _mm256_fnmadd_ps(sy, akz, aky);
+  const __m256 bx = _mm256_fnmadd_ps(sx, bkz, bkx), by = _mm256_fnmadd_ps(sy, bkz, bky);
+  const __m256 cx = _mm256_fnmadd_ps(sx, ckz, ckx), cy = _mm256_fnmadd_ps(sy, ckz, cky);
+  const __m256 U = Ray4f_AVX2DifferenceOfProducts(cx, by, cy, bx);
+  const __m256 V = Ray4f_AVX2DifferenceOfProducts(ax, cy, ay, cx);
+  const __m256 W = Ray4f_AVX2DifferenceOfProducts(bx, ay, by, ax);
+  const __m256 negative = _mm256_or_ps(_mm256_or_ps(_mm256_cmp_ps(U, zero, _CMP_LT_OQ), _mm256_cmp_ps(V, zero, _CMP_LT_OQ)),
+                                       _mm256_cmp_ps(W, zero, _CMP_LT_OQ));
+  const __m256 positive = _mm256_or_ps(_mm256_or_ps(_mm256_cmp_ps(U, zero, _CMP_GT_OQ), _mm256_cmp_ps(V, zero, _CMP_GT_OQ)),
+                                       _mm256_cmp_ps(W, zero, _CMP_GT_OQ));
+  const __m256 determinant = _mm256_add_ps(_mm256_add_ps(U, V), W);
+  const __m256 valid = _mm256_andnot_ps(_mm256_and_ps(negative, positive), _mm256_cmp_ps(determinant, zero, _CMP_NEQ_OQ));
+  t = u = v = zero;
+  if (!_mm256_movemask_ps(valid))
+  {
+    return zero;
+  }
+  // The lanes which missed divide by one instead of zero
+  const __m256 inverseDeterminant = Vector4f_AVX2ExactDivide(one, Vector4f_AVX2Select(valid, determinant, one));
+  const __m256 T = _mm256_mul_ps(sz, _mm256_fmadd_ps(U, akz, _mm256_fmadd_ps(V, bkz, _mm256_mul_ps(W, ckz))));
+  t = _mm256_mul_ps(T, inverseDeterminant);
+  u = _mm256_mul_ps(V, inverseDeterminant);
+  v = _mm256_mul_ps(W, inverseDeterminant);
+  return _mm256_and_ps(valid, _mm256_and_ps(_mm256_cmp_ps(t, zero, _CMP_GT_OQ), _mm256_cmp_ps(t, nearestT, _CMP_LT_OQ)));
+}
+
+/// Permutes the x, y and z components in each lane to the axes kx, ky and kz of the ray in that lane (AVX2 and
+/// FMA implementation). \see Ray4f_SSEPermute
+MATHS3D_TARGET("avx2,fma")
+inline void Ray4f_AVX2Permute(__m256 zIsX, __m256 zIsY, __m256 swap, __m256 x, __m256 y, __m256 z, __m256& px, __m256& py, __m256& pz)
+{
+  const __m256 next = Vector4f_AVX2Select(zIsX, y, Vector4f_AVX2Select(zIsY, z, x));
+  const __m256 after = Vector4f_AVX2Select(zIsX, z, Vector4f_AVX2Select(zIsY, x, y));
+  pz = Vector4f_AVX2Select(zIsX, x, Vector4f_AVX2Select(zIsY, y, z));
+  px = Vector4f_AVX2Select(swap, after, next);
+  py = Vector4f_AVX2Select(swap, next, after);
+}
+
+/// Returns 1/x of each lane with x moved away from zero to at least Ray4f_MinimumDirection, keeping its sign.
+/// \see Ray4f_ClampedReciprocal
+MATHS3D_TARGET("avx2,fma")
+inline __m256 Ray4f_AVX2ClampedReciprocal(__m256 x)
+{
+  const __m256 signMask = _mm256_set1_ps(-0.0f);
+  const __m256 magnitude = _mm256_max_ps(_mm256_andnot_ps(signMask, x), _mm256_set1_ps(Ray4f_MinimumDirection));
+  return Vector4f_AVX2ExactDivide(_mm256_set1_ps(1.0f), _mm256_or_ps(_mm256_and_ps(signMask, x), magnitude));
+}
+
+/// Replaces the hits of the lanes in mask of the eight rays from index with t, primitive, u and v.
+MATHS3D_TARGET("avx2,fma")
+inline void RayHitsSoA_AVX2Update(const RayHitsSoA& hits, unsigned index, __m256 mask, __m256 t, __m256 primitive, __m256 u, __m256 v)
+{
+  if (!_mm256_movemask_ps(mask))
+  {
+    return;
+  }
+  _mm256_storeu_ps(hits.t + index, Vector4f_AVX2Select(mask, t, _mm256_loadu_ps(hits.t + index)));
+  const __m256 primitives = _mm256_castsi256_ps(_mm256_loadu_si256((const __m256i*)(hits.primitive + index)));
+  _mm256_storeu_si256((__m256i*)(hits.primitive + index), _mm256_castps_si256(Vector4f_AVX2Select(mask, primitive, primitives)));
+  _mm256_storeu_ps(hits.u + index, Vector4f_AVX2Select(mask, u, _mm256_loadu_ps(hits.u + index)));
+  _mm256_storeu_ps(hits.v + index, Vector4f_AVX2Select(mask, v, _mm256_loadu_ps(hits.v + index)));
+}
+
+/// Intersects ray with spheres eight at a time (AVX2 and FMA implementation).
+/// \note must only be called if the CPU supports AVX2 and FMA. \see InstructionSet_IsSupported
+/// \see Ray4f_IntersectSpheresStreamGeneric for a description of the parameters and the return value.
+MATHS3D_TARGET("avx2,fma")
+inline bool Ray4f_AVX2IntersectSpheresStream(const Ray4f& ray, const float* centerX, const float* centerY, const float* centerZ,
+                                             const float* radius, unsigned count, RayHit4f& hit)
+{
+  const __m256 ox = _mm256_set1_ps(ray.origin.x), oy = _mm256_set1_ps(ray.origin.y), oz = _mm256_set1_ps(ray.origin.z);
+  const __m256 dx = _mm256_set1_ps(ray.direction.x), dy = _mm256_set1_ps(ray.direction.y), dz = _mm256_set1_ps(ray.direction.z);
+  __m256 nearestT = _mm256_set1_ps(hit.t);
+  __m256 nearestPrimitive = _mm256_castsi256_ps(_mm256_set1_epi32(int(hit.primitive)));
+  __m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  unsigned i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256 t;
+    const __m256 mask = Ray4f_AVX2IntersectSphereLanes(ox, oy, oz, dx, dy, dz, _mm256_loadu_ps(centerX + i), _mm256_loadu_ps(centerY + i),
+                                                       _mm256_loadu_ps(centerZ + i), _mm256_loadu_ps(radius + i), nearestT, t);
+    nearestT = Vector4f_AVX2Select(mask, t, nearestT);
+    nearestPrimitive = Vector4f_AVX2Select(mask, _mm256_castsi256_ps(index), nearestPrimitive);
+    index = _mm256_add_epi32(index, _mm256_set1_epi32(8));
+  }
+  float t[8], u[8] = {}, v[8] = {};
+  uint32_t primitive[8];
+  _mm256_storeu_ps(t, nearestT);
+  _mm256_storeu_si256((__m256i*)primitive, _mm256_castps_si256(nearestPrimitive));
+  bool replaced = RayHit4f_NearestLane(hit, t, primitive, u, v, 8);
+  for (; i < count; ++i)
+  {
+    replaced |= Ray4f_IntersectSphere(ray, BoundingSphere4f_Set(Vector4f_Set(centerX[i], centerY[i], centerZ[i], 1.0f), radius[i]), i, hit);
+  }
+  return replaced;
+}
+
+/// Intersects ray with boxes eight at a time (AVX2 and FMA implementation).
+/// \note must only be called if the CPU supports AVX2 and FMA. \see InstructionSet_IsSupported
+/// \see Ray4f_IntersectAabbsStreamGeneric for a description of the parameters and the return value.
+MATHS3D_TARGET("avx2,fma")
+inline bool Ray4f_AVX2IntersectAabbsStream(const Ray4f& ray, const float* minX, const float* minY, const float* minZ,
+                                           const float* maxX, const float* maxY, const float* maxZ, unsigned count, RayHit4f& hit)
+{
+  const Vector4f inverseDirection = Ray4f_InverseDirection(ray);
+  const __m256 ox = _mm256_set1_ps(ray.origin.x), oy = _mm256_set1_ps(ray.origin.y), oz = _mm256_set1_ps(ray.origin.z);
+  const __m256 ix = _mm256_set1_ps(inverseDirection.x), iy = _mm256_set1_ps(inverseDirection.y), iz = _mm256_set1_ps(inverseDirection.z);
+  __m256 nearestT = _mm256_set1_ps(hit.t);
+  __m256 nearestPrimitive = _mm256_castsi256_ps(_mm256_set1_epi32(int(hit.primitive)));
+  __m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  unsigned i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256 t;
+    const __m256 mask = Ray4f_AVX2IntersectAabbLanes(ox, oy, oz, ix, iy, iz,
+                                                     _mm256_loadu_ps(minX + i), _mm256_loadu_ps(minY + i), _mm256_loadu_ps(minZ + i),
+                                                     _mm256_loadu_ps(maxX + i), _mm256_loadu_ps(maxY + i), _mm256_loadu_ps(maxZ + i), nearestT, t);
+    nearestT = Vector4f_AVX2Select(mask, t, nearestT);
+    nearestPrimitive = Vector4f_AVX2Select(mask, _mm256_castsi256_ps(index), nearestPrimitive);
+    index = _mm256_add_epi32(index, _mm256_set1_epi32(8));
+  }
+  float t[8], u[8] = {}, v[8] = {};
+  uint32_t primitive[8];
+  _mm256_storeu_ps(t, nearestT);
+  _mm256_storeu_si256((__m256i*)primitive, _mm256_castps_si256(nearestPrimitive));
+  bool replaced = RayHit4f_NearestLane(hit, t, primitive, u, v, 8);
+  for (; i < count; ++i)
+  {
+    const Aabb4f box = Aabb4f_Set(Vector4f_Set(minX[i], minY[i], minZ[i], 1.0f), Vector4f_Set(maxX[i], maxY[i], maxZ[i], 1.0f));
+    replaced |= Ray4f_IntersectAabb(ray, inverseDirection, box, i, hit);
+  }
+  return replaced;
+}
+
+/// Intersects ray with triangles eight at a time (AVX2 and FMA implementation).
+/// \note must only be called if the CPU supports AVX2 and FMA. \see InstructionSet_IsSupported
+/// \see Ray4f_SSEIntersectTrianglesStream and Ray4f_IntersectTrianglesStreamGeneric for a description of the
+/// parameters and the return value.
+MATHS3D_TARGET("avx2,fma")
+inline bool Ray4f_AVX2IntersectTrianglesStream(const Ray4f& ray, const TrianglesSoA& triangles, unsigned count, RayHit4f& hit)
+{
+  const RayShear4f shear = Ray4f_Shear(ray);
+  const float* const a[3] = { triangles.ax, triangles.ay, triangles.az };
+  const float* const b[3] = { triangles.bx, triangles.by, triangles.bz };
+  const float* const c[3] = { triangles.cx, triangles.cy, triangles.cz };
+  const __m256 okx = _mm256_set1_ps(shear.origin.v[shear.kx]), oky = _mm256_set1_ps(shear.origin.v[shear.ky]), okz = _mm256_set1_ps(shear.origin.v[shear.kz]);
+  const __m256 sx = _mm256_set1_ps(shear.sx), sy = _mm256_set1_ps(shear.sy), sz = _mm256_set1_ps(shear.sz);
+  __m256 nearestT = _mm256_set1_ps(hit.t);
+  __m256 nearestPrimitive = _mm256_castsi256_ps(_mm256_set1_epi32(int(hit.primitive)));
+  __m256 nearestU = _mm256_set1_ps(hit.u), nearestV = _mm256_set1_ps(hit.v);
+  __m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  unsigned i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256 t, u, v;
+    const __m256 mask = Ray4f_AVX2IntersectTriangleLanes(sx, sy, sz,
+        _mm256_sub_ps(_mm256_loadu_ps(a[shear.kx] + i), okx), _mm256_sub_ps(_mm256_loadu_ps(a[shear.ky] + i), oky), _mm256_sub_ps(_mm256_loadu_ps(a[shear.kz] + i), okz),
+        _mm256_sub_ps(_mm256_loadu_ps(b[shear.kx] + i), okx), _mm256_sub_ps(_mm256_loadu_ps(b[shear.ky] + i), oky), _mm256_sub_ps(_mm256_loadu_ps(b[shear.kz] + i), okz),
+        _mm256_sub_ps(_mm256_loadu_ps(c[shear.kx] + i), okx), _mm256_sub_ps(_mm256_loadu_ps(c[shear.ky] + i), oky), _mm256_sub_ps(_mm256_loadu_ps(c[shear.kz] + i), okz),
+        nearestT, t, u, v);
+    nearestT = Vector4f_AVX2Select(mask, t, nearestT);
+    nearestPrimitive = Vector4f_AVX2Select(mask, _mm256_castsi256_ps(index), nearestPrimitive);
+    nearestU = Vector4f_AVX2Select(mask, u, nearestU);
+    nearestV = Vector4f_AVX2Select(mask, v, nearestV);
+    index = _mm256_add_epi32(index, _mm256_set1_epi32(8));
+  }
+  float t[8], u[8], v[8];
+  uint32_t primitive[8];
+  _mm256_storeu_ps(t, nearestT);
+  _mm256_storeu_si256((__m256i*)primitive, _mm256_castps_si256(nearestPrimitive));
+  _mm256_storeu_ps(u, nearestU);
+  _mm256_storeu_ps(v, nearestV);
+  bool replaced = RayHit4f_NearestLane(hit, t, primitive, u, v, 8);
+  for (; i < count; ++i)
+  {
+    replaced |= Ray4f_IntersectTriangle(shear, TrianglesSoA_A(triangles, i), TrianglesSoA_B(triangles, i), TrianglesSoA_C(triangles, i), i, hit);
+  }
+  return replaced;
+}
+
+/// Intersects rays with the sphere eight at a time (AVX2 and FMA implementation).
+/// \note must only be called if the CPU supports AVX2 and FMA. \see InstructionSet_IsSupported
+/// \see RayPacketSoA_IntersectSphereGeneric for a description of the parameters.
+MATHS3D_TARGET("avx2,fma")
+inline void RayPacketSoA_AVX2IntersectSphere(const RayPacketSoA& rays, unsigned count, const BoundingSphere4f& sphere, uint32_t primitive, const RayHitsSoA& hits)
+{
+  const __m256 cx = _mm256_set1_ps(sphere.center.x), cy = _mm256_set1_ps(sphere.center.y), cz = _mm256_set1_ps(sphere.center.z);
+  const __m256 r = _mm256_set1_ps(sphere.radius);
+  const __m256 primitives = _mm256_castsi256_ps(_mm256_set1_epi32(int(primitive)));
+  unsigned i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256 t;
+    const __m256 mask = Ray4f_AVX2IntersectSphereLanes(_mm256_loadu_ps(rays.originX + i), _mm256_loadu_ps(rays.originY + i), _mm256_loadu_ps(rays.originZ + i),
+                                                       _mm256_loadu_ps(rays.directionX + i), _mm256_loadu_ps(rays.directionY + i),
+                                                       _mm256_loadu_ps(rays.directionZ + i), cx, cy, cz, r, _mm256_loadu_ps(hits.t + i), t);
+    RayHitsSoA_AVX2Update(hits, i, mask, t, primitives, _mm256_setzero_ps(), _mm256_setzero_ps());
+  }
+  for (; i < count; ++i)
+  {
+    RayHit4f hit = RayHitsSoA_Hit(hits, i);
+    if (Ray4f_IntersectSphere(RayPacketSoA_Ray(rays, i), sphere, primitive, hit))
+    {
+      RayHitsSoA_SetHit(hits, i, hit);
+    }
+  }
+}
+
+/// Intersects rays with the box eight at a time (AVX2 and FMA implementation).
+/// \note must only be called if the CPU supports AVX2 and FMA. \see InstructionSet_IsSupported
+/// \see RayPacketSoA_IntersectSphereGeneric for a description of the parameters.
+MATHS3D_TARGET("avx2,fma")
+inline void RayPacketSoA_AVX2IntersectAabb(const RayPacketSoA& rays, unsigned count, const Aabb4f& box, uint32_t primitive, const RayHitsSoA& hits)
+{
+  const __m256 minX = _mm256_set1_ps(box.minimum.x), minY = _mm256_set1_ps(box.minimum.y), minZ = _mm256_set1_ps(box.minimum.z);
+  const __m256 maxX = _mm256_set1_ps(box.maximum.x), maxY = _mm256_set1_ps(box.maximum.y), maxZ = _mm256_set1_ps(box.maximum.z);
+  const __m256 primitives = _mm256_castsi256_ps(_mm256_set1_epi32(int(primitive)));
+  unsigned i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256 t;
+    const __m256 mask = Ray4f_AVX2IntersectAabbLanes(_mm256_loadu_ps(rays.originX + i), _mm256_loadu_ps(rays.originY + i), _mm256_loadu_ps(rays.originZ + i),
+                                                     Ray4f_AVX2ClampedReciprocal(_mm256_loadu_ps(rays.directionX + i)),
+                                                     Ray4f_AVX2ClampedReciprocal(_mm256_loadu_ps(rays.directionY + i)),
+                                                     Ray4f_AVX2ClampedReciprocal(_mm256_loadu_ps(rays.directionZ + i)),
+                                                     minX, minY, minZ, maxX, maxY, maxZ, _mm256_loadu_ps(hits.t + i), t);
+    RayHitsSoA_AVX2Update(hits, i, mask, t, primitives, _mm256_setzero_ps(), _mm256_setzero_ps());
+  }
+  for (; i < count; ++i)
+  {
+    RayHit4f hit = RayHitsSoA_Hit(hits, i);
+    if (Ray4f_IntersectAabb(RayPacketSoA_Ray(rays, i), box, primitive, hit))
+    {
+      RayHitsSoA_SetHit(hits, i, hit);
+    }
+  }
+}
+
+/// Intersects rays with the triangle a, b, c eight at a time (AVX2 and FMA implementation).
+/// \note must only be called if the CPU supports AVX2 and FMA. \see InstructionSet_IsSupported
+/// \see RayPacketSoA_SSEIntersectTriangle and RayPacketSoA_IntersectSphereGeneric for a description of the parameters.
+MATHS3D_TARGET("avx2,fma")
+inline void RayPacketSoA_AVX2IntersectTriangle(const RayPacketSoA& rays, unsigned count, const Vector4f& a, const Vector4f& b, const Vector4f& c,
+                                               uint32_t primitive, const RayHitsSoA& hits)
+{
+  const __m256 signMask = _mm256_set1_ps(-0.0f);
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 primitives = _mm256_castsi256_ps(_mm256_set1_epi32(int(primitive)));
+  unsigned i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    const __m256 ox = _mm256_loadu_ps(rays.originX + i), oy = _mm256_loadu_ps(rays.originY + i), oz = _mm256_loadu_ps(rays.originZ + i);
+    const __m256 dx = _mm256_loadu_ps(rays.directionX + i), dy = _mm256_loadu_ps(rays.directionY + i), dz = _mm256_loadu_ps(rays.directionZ + i);
+    // Choose kz as the largest component of each direction, as Ray4f_Shear does
+    const __m256 mx = _mm256_andnot_ps(signMask, dx), my = _mm256_andnot_ps(signMask, dy), mz = _mm256_andnot_ps(signMask, dz);
+    const __m256 xOverY = _mm256_cmp_ps(mx, my, _CMP_GT_OQ);
+    const __m256 zIsX = _mm256_and_ps(xOverY, _mm256_cmp_ps(mx, mz, _CMP_GT_OQ));
+    const __m256 zIsY = _mm256_andnot_ps(xOverY, _mm256_cmp_ps(my, mz, _CMP_GT_OQ));
+    __m256 dkx, dky, dkz;
+    Ray4f_AVX2Permute(zIsX, zIsY, zero, dx, dy, dz, dkx, dky, dkz);
+    const __m256 swap = _mm256_cmp_ps(dkz, zero, _CMP_LT_OQ);
+    Ray4f_AVX2Permute(zIsX, zIsY, swap, dx, dy, dz, dkx, dky, dkz);
+    const __m256 sz = Vector4f_AVX2ExactDivide(_mm256_set1_ps(1.0f), dkz);
+    const __m256 sx = _mm256_mul_ps(dkx, sz), sy = _mm256_mul_ps(dky, sz);
+    __m256 akx, aky, akz, bkx, bky, bkz, ckx, cky, ckz;
+    Ray4f_AVX2Permute(zIsX, zIsY, swap, _mm256_sub_ps(_mm256_set1_ps(a.x), ox), _mm256_sub_ps(_mm256_set1_ps(a.y), oy),
+                      _mm256_sub_ps(_mm256_set1_ps(a.z), oz), akx, aky, akz);
+    Ray4f_AVX2Permute(zIsX, zIsY, swap, _mm256_sub_ps(_mm256_set1_ps(b.x), ox), _mm256_sub_ps(_mm256_set1_ps(b.y), oy),
+                      _mm256_sub_ps(_mm256_set1_ps(b.z), oz), bkx, bky, bkz);
+    Ray4f_AVX2Permute(zIsX, zIsY, swap, _mm256_sub_ps(_mm256_set1_ps(c.x), ox), _mm256_sub_ps(_mm256_set1_ps(c.y), oy),
+                      _mm256_sub_ps(_mm256_set1_ps(c.z), oz), ckx, cky, ckz);
+    __m256 t, u, v;
+    const __m256 mask = Ray4f_AVX2IntersectTriangleLanes(sx, sy, sz, akx, aky, akz, bkx, bky, bkz, ckx, cky, ckz, _mm256_loadu_ps(hits.t + i), t, u, v);
+    RayHitsSoA_AVX2Update(hits, i, mask, t, primitives, u, v);
+  }
+  for (; i < count; ++i)
+  {
+    RayHit4f hit = RayHitsSoA_Hit(hits, i);
+    if (Ray4f_IntersectTriangle(RayPacketSoA_Ray(rays, i), a, b, c, primitive, hit))
+    {
+      RayHitsSoA_SetHit(hits, i, hit);
+    }
+  }
+}
+
+#endif // MATHS3D_X86
+
+/// Function pointer type for the implementations of the ray sphere stream.
+using Ray4f_IntersectSpheresStreamFunc = bool (*)(const Ray4f& ray, const float* centerX, const float* centerY, const float* centerZ,
+                                                   const float* radius, unsigned count, RayHit4f& hit);
+
+/// Function pointer type for the implementations of the ray box stream.
+using Ray4f_IntersectAabbsStreamFunc = bool (*)(const Ray4f& ray, const float* minX, const float* minY, const float* minZ,
+                                                 const float* maxX, const float* maxY, const float* maxZ, unsigned count, RayHit4f& hit);
+
+/// Function pointer type for the implementations of the ray triangle stream.
+using Ray4f_IntersectTrianglesStreamFunc = bool (*)(const Ray4f& ray, const TrianglesSoA& triangles, unsigned count, RayHit4f& hit);
+
+/// Function pointer type for the implementations of the ray packet sphere intersection.
+using RayPacketSoA_IntersectSphereFunc = void (*)(const RayPacketSoA& rays, unsigned count, const BoundingSphere4f& sphere, uint32_t primitive, const RayHitsSoA& hits);
+
+/// Function pointer type for the implementations of the ray packet box intersection.
+using RayPacketSoA_IntersectAabbFunc = void (*)(const RayPacketSoA& rays, unsigned count, const Aabb4f& box, uint32_t primitive, const RayHitsSoA& hits);
+
+/// Function pointer type for the implementations of the ray packet triangle intersection.
+using RayPacketSoA_IntersectTriangleFunc = void (*)(const RayPacketSoA& rays, unsigned count, const Vector4f& a, const Vector4f& b, const Vector4f& c,
+                                                     uint32_t primitive, const RayHitsSoA& hits);
+
+/// Returns the implementation of the ray sphere stream for the given instruction set. AVX-512 uses the AVX2 version.
+inline Ray4f_IntersectSpheresStreamFunc Ray4f_SelectIntersectSpheresStream(InstructionSet isa)
+{
+  switch (isa)
+  {
+#if MATHS3D_X86
+    case InstructionSet::AVX512:
+    case InstructionSet::AVX2:
+      return &Ray4f_AVX2IntersectSpheresStream;
+    case InstructionSet::SSE:
+      return &Ray4f_SSEIntersectSpheresStream;
+#endif
+    default:
+      return &Ray4f_IntersectSpheresStreamGeneric;
+  }
+}
+
+/// Returns the implementation of the ray box stream for the given instruction set. AVX-512 uses the AVX2 version.
+inline Ray4f_IntersectAabbsStreamFunc Ray4f_SelectIntersectAabbsStream(InstructionSet isa)
+{
+  switch (isa)
+  {
+#if MATHS3D_X86
+    case InstructionSet::AVX512:
+    case InstructionSet::AVX2:
+      return &Ray4f_AVX2IntersectAabbsStream;
+    case InstructionSet::SSE:
+      return &Ray4f_SSEIntersectAabbsStream;
+#endif
+    default:
+      return &Ray4f_IntersectAabbsStreamGeneric;
+  }
+}
+
+/// Returns the implementation of the ray triangle stream for the given instruction set. AVX-512 uses the AVX2 version.
+inline Ray4f_IntersectTrianglesStreamFunc Ray4f_SelectIntersectTrianglesStream(InstructionSet isa)
+{
+  switch (isa)
+  {
+#if MATHS3D_X86
+    case InstructionSet::AVX512:
+    case InstructionSet::AVX2:
+      return &Ray4f_AVX2IntersectTrianglesStream;
+    case InstructionSet::SSE:
+      return &Ray4f_SSEIntersectTrianglesStream;
+#endif
+    default:
+      return &Ray4f_IntersectTrianglesStreamGeneric;
+  }
+}
+
+/// Returns the implementation of the ray packet sphere intersection for the given instruction set. AVX-512 uses the AVX2 version.
+inline RayPacketSoA_IntersectSphereFunc RayPacketSoA_SelectIntersectSphere(InstructionSet isa)
+{
+  switch (isa)
+  {
+#if MATHS3D_X86
+    case InstructionSet::AVX512:
+    case InstructionSet::AVX2:
+      return &RayPacketSoA_AVX2IntersectSphere;
+    case InstructionSet::SSE:
+      return &RayPacketSoA_SSEIntersectSphere;
+#endif
+    default:
+      return &RayPacketSoA_IntersectSphereGeneric;
+  }
+}
+
+/// Returns the implementation of the ray packet box intersection for the given instruction set. AVX-512 uses the AVX2 version.
+inline RayPacketSoA_IntersectAabbFunc RayPacketSoA_SelectIntersectAabb(InstructionSet isa)
+{
+  switch (isa)
+  {
+#if MATHS3D_X86
+    case InstructionSet::AVX512:
+    case InstructionSet::AVX2:
+      return &RayPacketSoA_AVX2IntersectAabb;
+    case InstructionSet::SSE:
+      return &RayPacketSoA_SSEIntersectAabb;
+#endif
+    default:
+      return &RayPacketSoA_IntersectAabbGeneric;
+  }
+}
+
+/// Returns the implementation of the ray packet triangle intersection for the given instruction set. AVX-512 uses the AVX2 version.
+inline RayPacketSoA_IntersectTriangleFunc RayPacketSoA_SelectIntersectTriangle(InstructionSet isa)
+{
+  switch (isa)
+  {
+#if MATHS3D_X86
+    case InstructionSet::AVX512:
+    case InstructionSet::AVX2:
+      return &RayPacketSoA_AVX2IntersectTriangle;
+    case InstructionSet::SSE:
+      return &RayPacketSoA_SSEIntersectTriangle;
+#endif
+    default:
+      return &RayPacketSoA_IntersectTriangleGeneric;
+  }
+}
+
+/// Intersects ray with count spheres stored as a structure of arrays, keeping the nearest hit, using the best
+/// implementation for the CPU. \see Ray4f_IntersectSpheresStreamGeneric for a description of the parameters and
+/// the return value.
+inline bool Ray4f_IntersectSpheresStream(const Ray4f& ray, const float* centerX, const float* centerY, const float* centerZ,
+                                         const float* radius, unsigned count, RayHit4f& hit)
+{
+  static const Ray4f_IntersectSpheresStreamFunc kernel = Ray4f_SelectIntersectSpheresStream(InstructionSet_Active());
+  return kernel(ray, centerX, centerY, centerZ, radius, count, hit);
+}
+
+/// Intersects ray with count axis aligned boxes stored as a structure of arrays, keeping the nearest hit, using
+/// the best implementation for the CPU. \see Ray4f_IntersectAabbsStreamGeneric for a description of the parameters
+/// and the return value.
+inline bool Ray4f_IntersectAabbsStream(const Ray4f& ray, const float* minX, const float* minY, const float* minZ,
+                                       const float* maxX, const float* maxY, const float* maxZ, unsigned count, RayHit4f& hit)
+{
+  static const Ray4f_IntersectAabbsStreamFunc kernel = Ray4f_SelectIntersectAabbsStream(InstructionSet_Active());
+  return kernel(ray, minX, minY, minZ, maxX, maxY, maxZ, count, hit);
+}
+
+/// Intersects ray with count triangles stored as a structure of arrays, keeping the nearest hit, using the best
+/// implementation for the CPU. \see Ray4f_IntersectTrianglesStreamGeneric for a description of the parameters and
+/// the return value.
+inline bool Ray4f_IntersectTrianglesStream(const Ray4f& ray, const TrianglesSoA& triangles, unsigned count, RayHit4f& hit)
+{
+  static const Ray4f_IntersectTrianglesStreamFunc kernel = Ray4f_SelectIntersectTrianglesStream(InstructionSet_Active());
+  return kernel(ray, triangles, count, hit);
+}
+
+/// Intersects count rays stored as a structure of arrays with the sphere, keeping the nearest hit of each ray,
+/// using the best implementation for the CPU. \see RayPacketSoA_IntersectSphereGeneric for a description of the
+/// parameters.
+inline void RayPacketSoA_IntersectSphere(const RayPacketSoA& rays, unsigned count, const BoundingSphere4f& sphere, uint32_t primitive, const RayHitsSoA& hits)
+{
+  static const RayPacketSoA_IntersectSphereFunc kernel = RayPacketSoA_SelectIntersectSphere(InstructionSet_Active());
+  kernel(rays, count, sphere, primitive, hits);
+}
+
+/// Intersects count rays stored as a structure of arrays with the box, keeping the nearest hit of each ray, using
+/// the best implementation for the CPU. \see RayPacketSoA_IntersectSphereGeneric for a description of the parameters.
+inline void RayPacketSoA_IntersectAabb(const RayPacketSoA& rays, unsigned count, const Aabb4f& box, uint32_t primitive, const RayHitsSoA& hits)
+{
+  static const RayPacketSoA_IntersectAabbFunc kernel = RayPacketSoA_SelectIntersectAabb(InstructionSet_Active());
+  kernel(rays, count, box, primitive, hits);
+}
+
+/// Intersects count rays stored as a structure of arrays with the triangle a, b, c, keeping the nearest hit of
+/// each ray, using the best implementation for the CPU. \see RayPacketSoA_IntersectSphereGeneric for a description
+/// of the parameters.
+inline void RayPacketSoA_IntersectTriangle(const RayPacketSoA& rays, unsigned count, const Vector4f& a, const Vector4f& b, const Vector4f& c,
+                                           uint32_t primitive, const RayHitsSoA& hits)
+{
+  static const RayPacketSoA_IntersectTriangleFunc kernel = RayPacketSoA_SelectIntersectTriangle(InstructionSet_Active());
+  kernel(rays, count, a, b, c, primitive, hits);
+}
+
+#if MATHS3D_X86
+
 /// Specialization of Vector4f_SSETransformStreamGeneric for transforming an array of vectors without applying perspective.
 /// \see Vector4f_SSETransformStreamGeneric
 /// \note the w component of the vectors are ignored but treated as if they were set to 1 so that the translation component
@@ -256,3 +5683,4 @@ void Vector4f_SSETransformNormalStreamAligned(Vector4f (&outputStream)[N], const
   Vector4f_SSETransformStreamGeneric<false,false,true,4,true,4>((float*)outputStream, (float*)inputStream, N, transform);
 }
 
+#endif // MATHS3D_X86
@@ -52,7 +52,10 @@
 ///
 /// This code requires a modern C++ compiler.
 ///
-/// \see Scalar1f, Vector4f, Matrix4x4f
+/// When MATHS3D_EXPRESSION_TEMPLATES is defined the vector operators build expressions which are
+/// evaluated in one pass when assigned to a Vector4f, rather than returning a temporary per operator.
+///
+/// \see Scalar1f, Vector4f, Matrix4x4f, Matrix3x4f
 
 
 ///////////////////////////////////////////////////////////////////////////////////
@@ -64,6 +67,8 @@
 ///////////////////////////////////////////////////////////////////////////////////
 // Types
 
+#if !defined(MATHS3D_EXPRESSION_TEMPLATES)
+
 class VectorProduct4f
 {
 public:
@@ -83,6 +88,137 @@ inline VectorProduct4f::operator Vector4f()
   return Vector4f_CrossProduct(lhs, rhs);
 }
 
+#else
+
+/// Base of the vector expressions used when MATHS3D_EXPRESSION_TEMPLATES is defined. Instead of returning a
+/// Vector4f, each vector operator returns a node holding its operands, so that a whole expression is a single
+/// value. Converting it to a Vector4f walks the tree once, with each node combining the SSE registers Load returns
+/// for its operands (or the components Lane returns without SSE), and stores the result once. The operands are held
+/// by value, so an expression is still valid after the vectors it was made from have gone.
+template <typename Expression>
+struct VectorExpression4f
+{
+  const Expression& Self() const { return static_cast<const Expression&>(*this); }
+  Vector4f Eval() const;
+  operator Vector4f() const { return Eval(); }
+  operator Scalar1f() const { return Vector4f_Length(Eval()); }   /// The length, as for a Vector4f.
+};
+
+template <typename Expression>
+inline Vector4f VectorExpression4f<Expression>::Eval() const
+{
+#if MATHS3D_SSE
+  return Vectori4f_FromSSE(Self().Load());
+#else
+  return Vector4f_Set(Self().Lane(0), Self().Lane(1), Self().Lane(2), Self().Lane(3));
+#endif
+}
+
+/// A Vector4f operand of an expression. With SSE it is held as a register rather than the union, which compilers
+/// keep in memory when it is copied in to the nodes.
+struct VectorTerm4f : VectorExpression4f<VectorTerm4f>
+{
+#if MATHS3D_SSE
+  __m128 m;
+  explicit VectorTerm4f(const Vector4f& v) : m(v.m) {}
+  __m128 Load() const { return m; }
+  Scalar1f Lane(int i) const { return Vectori4f_FromSSE(m).v[i]; }
+#else
+  Vector4f vec;
+  explicit VectorTerm4f(const Vector4f& v) : vec(v) {}
+  Scalar1f Lane(int i) const { return vec.v[i]; }
+#endif
+};
+
+/// The type an operand is held as in an expression. Vector4f operands are held in a VectorTerm4f and expressions
+/// as they are. Other types have no type member, so the vector operators don't match them.
+template <typename T, typename Enable = void> struct VectorOperand4f {};
+template <> struct VectorOperand4f<Vector4f> { using type = VectorTerm4f; };
+template <typename T> struct VectorOperand4f<T, typename std::enable_if<std::is_base_of<VectorExpression4f<T>, T>::value>::type> { using type = T; };
+template <typename T> using VectorOperand4f_t = typename VectorOperand4f<T>::type;
+
+/// Sum of two vector expressions.
+template <typename L, typename R>
+struct VectorSum4f : VectorExpression4f<VectorSum4f<L,R>>
+{
+  L lhs;
+  R rhs;
+  VectorSum4f(const L& l, const R& r) : lhs(l), rhs(r) {}
+#if MATHS3D_SSE
+  __m128 Load() const { return _mm_add_ps(lhs.Load(), rhs.Load()); }
+#endif
+  Scalar1f Lane(int i) const { return lhs.Lane(i) + rhs.Lane(i); }
+};
+
+/// Difference of two vector expressions.
+template <typename L, typename R>
+struct VectorDifference4f : VectorExpression4f<VectorDifference4f<L,R>>
+{
+  L lhs;
+  R rhs;
+  VectorDifference4f(const L& l, const R& r) : lhs(l), rhs(r) {}
+#if MATHS3D_SSE
+  __m128 Load() const { return _mm_sub_ps(lhs.Load(), rhs.Load()); }
+#endif
+  Scalar1f Lane(int i) const { return lhs.Lane(i) - rhs.Lane(i); }
+};
+
+/// Component-wise product of two vector expressions.
+template <typename L, typename R>
+struct VectorMultiplied4f : VectorExpression4f<VectorMultiplied4f<L,R>>
+{
+  L lhs;
+  R rhs;
+  VectorMultiplied4f(const L& l, const R& r) : lhs(l), rhs(r) {}
+#if MATHS3D_SSE
+  __m128 Load() const { return _mm_mul_ps(lhs.Load(), rhs.Load()); }
+#endif
+  Scalar1f Lane(int i) const { return lhs.Lane(i) * rhs.Lane(i); }
+};
+
+/// A vector expression multiplied by a scalar.
+template <typename L>
+struct VectorScaled4f : VectorExpression4f<VectorScaled4f<L>>
+{
+  L lhs;
+  Scalar1f scale;
+  VectorScaled4f(const L& l, Scalar1f s) : lhs(l), scale(s) {}
+#if MATHS3D_SSE
+  __m128 Load() const { return _mm_mul_ps(lhs.Load(), _mm_set1_ps(scale)); }
+#endif
+  Scalar1f Lane(int i) const { return lhs.Lane(i) * scale; }
+};
+
+/// The normalized vector of a vector expression. The length needs all of the operand, so it is evaluated when the
+/// node is made, and the expression it is part of then uses the result like a VectorTerm4f.
+template <typename L>
+struct VectorNormalized4f : VectorTerm4f
+{
+  explicit VectorNormalized4f(const L& l) : VectorTerm4f(Vector4f_Normalized(l.Eval())) {}
+};
+
+/// Product of two vector expressions. As a Scalar1f it is the dot-product, and otherwise it is an expression for
+/// the cross-product, so that it can be used in larger expressions. \see VectorProduct4f
+template <typename L, typename R>
+struct VectorProductExpression4f : VectorExpression4f<VectorProductExpression4f<L,R>>
+{
+  L lhs;
+  R rhs;
+  VectorProductExpression4f(const L& l, const R& r) : lhs(l), rhs(r) {}
+  operator Scalar1f() const { return Vector4f_DotProduct(lhs.Eval(), rhs.Eval()); }
+#if MATHS3D_SSE
+  __m128 Load() const { return Vectori4f_CrossProduct(Vectori4f_FromSSE(lhs.Load()), Vectori4f_FromSSE(rhs.Load())).m; }
+#endif
+  Scalar1f Lane(int i) const
+  {
+    // As Vector4f_CrossProduct, w is one
+    const int j = (i + 1) % 3, k = (i + 2) % 3;
+    return (i == 3) ? Scalar1f_One() : lhs.Lane(j) * rhs.Lane(k) - lhs.Lane(k) * rhs.Lane(j);
+  }
+};
+
+#endif // MATHS3D_EXPRESSION_TEMPLATES
+
 
 ///////////////////////////////////////////////////////////////////////////////////
 // 3D Maths - Vector
@@ -94,6 +230,8 @@ inline Vector4f& Vector4f::operator=(Scalar1f value)
   return *this;
 }
 
+#if !defined(MATHS3D_EXPRESSION_TEMPLATES)
+
 /// Product of two vectors.
 /// When the result is used as a Scalar1f, the dot-product (inner product) is returned.
 /// When the result is used as a Vector4f, the cross-product (wedge/exterior product) is returned.
@@ -126,18 +264,76 @@ inline Vector4f operator-(const Vector4f& vec1, const Vector4f& vec2)
   return Vector4f_Subtract(vec1, vec2);
 }
 
+#else
+
+/// Product of two vectors. \see VectorProductExpression4f
+template <typename L, typename R>
+inline VectorProductExpression4f<VectorOperand4f_t<L>,VectorOperand4f_t<R>> operator^(const L& vec1, const R& vec2)
+{
+  return { VectorOperand4f_t<L>(vec1), VectorOperand4f_t<R>(vec2) };
+}
+
+/// Multiply two vectors.
+template <typename L, typename R>
+inline VectorMultiplied4f<VectorOperand4f_t<L>,VectorOperand4f_t<R>> operator*(const L& vec1, const R& vec2)
+{
+  return { VectorOperand4f_t<L>(vec1), VectorOperand4f_t<R>(vec2) };
+}
+
+/// Multiply by a scalar.
+template <typename L>
+inline VectorScaled4f<VectorOperand4f_t<L>> operator*(const L& vec1, const Scalar1f& scale)
+{
+  return { VectorOperand4f_t<L>(vec1), scale };
+}
+
+/// Add two vectors.
+template <typename L, typename R>
+inline VectorSum4f<VectorOperand4f_t<L>,VectorOperand4f_t<R>> operator+(const L& vec1, const R& vec2)
+{
+  return { VectorOperand4f_t<L>(vec1), VectorOperand4f_t<R>(vec2) };
+}
+
+/// Subtract two vectors.
+template <typename L, typename R>
+inline VectorDifference4f<VectorOperand4f_t<L>,VectorOperand4f_t<R>> operator-(const L& vec1, const R& vec2)
+{
+  return { VectorOperand4f_t<L>(vec1), VectorOperand4f_t<R>(vec2) };
+}
+
+/// Normalized vector of a vector.
+template <typename L>
+inline VectorNormalized4f<VectorOperand4f_t<L>> operator~(const L& vec)
+{
+  return VectorNormalized4f<VectorOperand4f_t<L>>(VectorOperand4f_t<L>(vec));
+}
+
+/// Assign the result of an expression.
+template <typename Expression>
+inline Vector4f& Vector4f::operator=(const VectorExpression4f<Expression>& expression)
+{
+  *this = expression.Eval();
+  return *this;
+}
+
+#endif // MATHS3D_EXPRESSION_TEMPLATES
+
 /// Length of a vector.
 inline Vector4f::operator Scalar1f() const
 {
   return Vector4f_Length(*this);
 }
 
+#if !defined(MATHS3D_EXPRESSION_TEMPLATES)
+
 /// Normalized vector of a vector.
 inline Vector4f operator~(const Vector4f& vec)
 {
   return Vector4f_Normalized(vec);
 }
 
+#endif
+
 
 ///////////////////////////////////////////////////////////////////////////////////
 // Matrix operators
@@ -173,3 +369,256 @@ inline Vector4f operator*(const Matrix4x4f& m, const Vector4f& vec)
   return Vector4f_Transform(m, vec);
 }
 
+#if defined(MATHS3D_EXPRESSION_TEMPLATES)
+/// Multiply matrix by a vector expression (transform).
+template <typename Expression>
+inline Vector4f operator*(const Matrix4x4f& m, const VectorExpression4f<Expression>& vec)
+{
+  return Vector4f_Transform(m, vec.Eval());
+}
+#endif
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// Affine matrix operators
+
+/// Multiply two affine matrices.
+inline Matrix3x4f operator*(const Matrix3x4f& m1, const Matrix3x4f& m2)
+{
+  return Matrix3x4f_Multiply(m1, m2);
+}
+
+/// Multiply affine matrix by a vector (transform).
+inline Vector4f operator*(const Matrix3x4f& m, const Vector4f& vec)
+{
+  return Vector4f_Transform(m, vec);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// Prepared transform operators
+
+/// Multiply prepared transform by a vector (transform).
+inline Vector4f operator*(const PreparedTransform4f& prepared, const Vector4f& vec)
+{
+  return PreparedTransform4f_Transform(prepared, vec);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// Structured matrices
+
+/// A translation, which as a Matrix4x4f is the identity with the translation in the last row.
+/// Products with it only need the translation, so skip the known zeros and ones.
+struct TranslationMatrix
+{
+  Vector4f translation;           /// The x, y and z translation. The w component is ignored.
+  operator Matrix4x4f() const;
+};
+
+/// A matrix which only has values on the diagonal, such as a scale.
+struct DiagonalMatrix
+{
+  Vector4f diagonal;              /// The 4 values on the diagonal.
+  operator Matrix4x4f() const;
+};
+
+/// A perspective projection as created by Matrix4x4f_PerspectiveFrustum, which only has 5 non-zero values.
+struct PerspectiveMatrix
+{
+  Scalar1f xScale;                /// m[0][0]
+  Scalar1f yScale;                /// m[1][1]
+  Scalar1f depthScale;            /// m[2][2]
+  Scalar1f depthOffset;           /// m[3][2]. m[2][3] is always -1.
+  operator Matrix4x4f() const;
+};
+
+/// An affine transform stored as a Matrix3x4f. \see Matrix3x4f
+struct AffineMatrix
+{
+  Matrix3x4f affine;
+  operator Matrix4x4f() const;
+};
+
+/// Creates a translation matrix. \see Matrix4x4f_TranslateXYZ
+inline TranslationMatrix TranslationMatrix_TranslateXYZ(const Vector4f& vec)
+{
+  return { Vector4f_SetW(vec, Scalar1f_Zero()) };
+}
+
+/// Creates a scaling matrix. \see Matrix4x4f_ScaleXYZ
+inline DiagonalMatrix DiagonalMatrix_ScaleXYZ(const Vector4f& scale)
+{
+  return { scale };
+}
+
+/// Creates a perspective projection matrix. \see Matrix4x4f_PerspectiveFrustum
+inline PerspectiveMatrix PerspectiveMatrix_PerspectiveFrustum(Radians fieldOfView, Scalar1f aspectRatio, Scalar1f near, Scalar1f far)
+{
+  const Matrix4x4f perspective = Matrix4x4f_PerspectiveFrustum(fieldOfView, aspectRatio, near, far);
+  return { perspective.m[0][0], perspective.m[1][1], perspective.m[2][2], perspective.m[3][2] };
+}
+
+/// Creates an affine matrix from a Matrix4x4f whose last column is (0,0,0,1). \see Matrix3x4f_FromMatrix4x4f
+inline AffineMatrix AffineMatrix_FromMatrix4x4f(const Matrix4x4f& a)
+{
+  return { Matrix3x4f_FromMatrix4x4f(a) };
+}
+
+/// Convert to a general matrix.
+inline TranslationMatrix::operator Matrix4x4f() const
+{
+  return Matrix4x4f_TranslateXYZ(translation);
+}
+
+/// Convert to a general matrix.
+inline DiagonalMatrix::operator Matrix4x4f() const
+{
+  return Matrix4x4f_ScaleXYZ(diagonal);
+}
+
+/// Convert to a general matrix.
+inline PerspectiveMatrix::operator Matrix4x4f() const
+{
+  Matrix4x4f ret = Matrix4x4f_Zero();
+  ret.m[0][0] = xScale;
+  ret.m[1][1] = yScale;
+  ret.m[2][2] = depthScale;
+  ret.m[2][3] = -Scalar1f_One();
+  ret.m[3][2] = depthOffset;
+  return ret;
+}
+
+/// Convert to a general matrix.
+inline AffineMatrix::operator Matrix4x4f() const
+{
+  return Matrix4x4f_FromMatrix3x4f(affine);
+}
+
+/// Combine two translations.
+inline TranslationMatrix operator*(const TranslationMatrix& m1, const TranslationMatrix& m2)
+{
+  return { Vector4f_Add(m1.translation, m2.translation) };
+}
+
+/// Combine two diagonal matrices.
+inline DiagonalMatrix operator*(const DiagonalMatrix& m1, const DiagonalMatrix& m2)
+{
+  return { Vector4f_Multiply(m1.diagonal, m2.diagonal) };
+}
+
+/// Combine two affine matrices.
+inline AffineMatrix operator*(const AffineMatrix& m1, const AffineMatrix& m2)
+{
+  return { Matrix3x4f_Multiply(m1.affine, m2.affine) };
+}
+
+// In the products below, as for Matrix4x4f_Multiply, row i of m1 * m2 is the rows of m1 weighted by row i of m2.
+
+/// Multiply a translation with a matrix, which only adds the translation weighted by the last column of m2.
+inline Matrix4x4f operator*(const TranslationMatrix& m1, const Matrix4x4f& m2)
+{
+  Matrix4x4f ret;
+  const Vector4f t = Vector4f_SetW(m1.translation, Scalar1f_Zero());
+  for (int i = 0; i < 4; ++i)
+  {
+    ret.row[i] = Vector4f_Add(m2.row[i], Vector4f_Scaled(t, m2.m[i][3]));
+  }
+  return ret;
+}
+
+/// Multiply a matrix with a translation, which only changes the last row.
+inline Matrix4x4f operator*(const Matrix4x4f& m1, const TranslationMatrix& m2)
+{
+  Matrix4x4f ret = m1;
+  const Vector4f& t = m2.translation;
+  ret.row[3] = Vector4f_Add(Vector4f_Add(Vector4f_Scaled(m1.row[0], t.x), Vector4f_Scaled(m1.row[1], t.y)),
+                            Vector4f_Add(Vector4f_Scaled(m1.row[2], t.z), m1.row[3]));
+  return ret;
+}
+
+/// Multiply a diagonal matrix with a matrix, which scales the columns of m2.
+inline Matrix4x4f operator*(const DiagonalMatrix& m1, const Matrix4x4f& m2)
+{
+  Matrix4x4f ret;
+  for (int i = 0; i < 4; ++i)
+  {
+    ret.row[i] = Vector4f_Multiply(m2.row[i], m1.diagonal);
+  }
+  return ret;
+}
+
+/// Multiply a matrix with a diagonal matrix, which scales the rows of m1.
+inline Matrix4x4f operator*(const Matrix4x4f& m1, const DiagonalMatrix& m2)
+{
+  Matrix4x4f ret;
+  for (int i = 0; i < 4; ++i)
+  {
+    ret.row[i] = Vector4f_Scaled(m1.row[i], m2.diagonal.v[i]);
+  }
+  return ret;
+}
+
+/// Multiply a perspective projection with a matrix.
+inline Matrix4x4f operator*(const PerspectiveMatrix& m1, const Matrix4x4f& m2)
+{
+  Matrix4x4f ret;
+  for (int i = 0; i < 4; ++i)
+  {
+    ret.row[i] = Vector4f_Set(m2.m[i][0] * m1.xScale, m2.m[i][1] * m1.yScale,
+                              m2.m[i][2] * m1.depthScale + m2.m[i][3] * m1.depthOffset, -m2.m[i][2]);
+  }
+  return ret;
+}
+
+/// Multiply a matrix with a perspective projection.
+inline Matrix4x4f operator*(const Matrix4x4f& m1, const PerspectiveMatrix& m2)
+{
+  Matrix4x4f ret;
+  ret.row[0] = Vector4f_Scaled(m1.row[0], m2.xScale);
+  ret.row[1] = Vector4f_Scaled(m1.row[1], m2.yScale);
+  ret.row[2] = Vector4f_Subtract(Vector4f_Scaled(m1.row[2], m2.depthScale), m1.row[3]);
+  ret.row[3] = Vector4f_Scaled(m1.row[2], m2.depthOffset);
+  return ret;
+}
+
+/// Multiply an affine matrix with a matrix, which doesn't change the last column of m2.
+inline Matrix4x4f operator*(const AffineMatrix& m1, const Matrix4x4f& m2)
+{
+  Matrix4x4f ret;
+  for (int i = 0; i < 4; ++i)
+  {
+    ret.row[i] = Vector4f_Set(Vector4f_DotProduct(m2.row[i], m1.affine.row[0]), Vector4f_DotProduct(m2.row[i], m1.affine.row[1]),
+                              Vector4f_DotProduct(m2.row[i], m1.affine.row[2]), m2.m[i][3]);
+  }
+  return ret;
+}
+
+/// Multiply a matrix with an affine matrix, where only the last row of the result includes the last row of m1.
+inline Matrix4x4f operator*(const Matrix4x4f& m1, const AffineMatrix& m2)
+{
+  Matrix4x4f ret;
+  for (int i = 0; i < 4; ++i)
+  {
+    ret.row[i] = Vector4f_Add(Vector4f_Add(Vector4f_Scaled(m1.row[0], m2.affine.m[0][i]), Vector4f_Scaled(m1.row[1], m2.affine.m[1][i])),
+                              Vector4f_Scaled(m1.row[2], m2.affine.m[2][i]));
+  }
+  ret.row[3] = Vector4f_Add(ret.row[3], m1.row[3]);
+  return ret;
+}
+
+/// Whether T is one of the structured matrix types.
+template <typename T> struct StructuredMatrix : std::false_type {};
+template <> struct StructuredMatrix<TranslationMatrix> : std::true_type {};
+template <> struct StructuredMatrix<DiagonalMatrix> : std::true_type {};
+template <> struct StructuredMatrix<PerspectiveMatrix> : std::true_type {};
+template <> struct StructuredMatrix<AffineMatrix> : std::true_type {};
+
+/// Multiply two different structured matrices. The first is expanded to a Matrix4x4f, which is cheap as they
+/// are mostly zeros, and then the product specialized for the second is used.
+template <typename Structured1, typename Structured2>
+inline typename std::enable_if<StructuredMatrix<Structured1>::value && StructuredMatrix<Structured2>::value, Matrix4x4f>::type
+operator*(const Structured1& m1, const Structured2& m2)
+{
+  return Matrix4x4f(m1) * m2;
+}
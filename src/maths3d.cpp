@@ -44,58 +44,38 @@
 // Includes
 
 #include <cstdint>
+#include <cstring>
 #include "maths3d.h"
 
 
-Matrix4x4f Matrix4x4f_Multiply(const Matrix4x4f& m1, const Matrix4x4f& m2)
-{
-  Matrix4x4f ret = Matrix4x4f_Zero();
-  for (int i = 0; i < 4; i++)
-    for (int j = 0; j < 4; j++)
-      for (int k = 0; k < 4; k++)
-        ret.m[i][j] += m1.m[k][j] * m2.m[i][k];
-  return ret;
-}
-
-Matrix4x4f Matrix4x4f_Transposed(const Matrix4x4f& a)
+#if MATHS3D_SSE
+Matrix4x4f Matrixi4x4f_Multiply(const Matrix4x4f& m1, const Matrix4x4f& m2)
 {
+  // Each row of the result is the rows of m1 weighted by the components of the same row of m2
   Matrix4x4f ret;
   for (int i = 0; i < 4; i++)
-    for (int j = 0; j < 4; j++)
-      ret.m[i][j] = a.m[j][i];
-  return ret;
-}
-
-Matrix4x4f Matrix4x4f_Scaled(const Matrix4x4f& m, Scalar1f scale)
-{
-  Matrix4x4f ret = m;
-  for (int i = 0; i < 16; i++)
-    ret.v[i] = m.v[i] * scale;
+  {
+    __m128 row = _mm_mul_ps(m1.row[0].m, _mm_set1_ps(m2.m[i][0]));
+    for (int k = 1; k < 4; k++)
+      row = _mm_add_ps(row, _mm_mul_ps(m1.row[k].m, _mm_set1_ps(m2.m[i][k])));
+    ret.row[i].m = row;
+  }
   return ret;
 }
 
-Matrix4x4f Matrix4x4f_ScaleXYZ(const Vector4f& scale)
+Vector4f Vectori4f_Transform(const Matrix4x4f& m, const Vector4f& vec)
 {
-  Matrix4x4f ret = Matrix4x4f_Zero();
-  ret.m[0][0] = scale.x;
-  ret.m[1][1] = scale.y;
-  ret.m[2][2] = scale.z;
-  ret.m[3][3] = scale.w;
+  // Rather than transposing and doing dot products, the rows are weighted by the components of vec
+  Vector4f ret;
+  ret.m = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m.row[0].m, _mm_set1_ps(vec.x)), _mm_mul_ps(m.row[1].m, _mm_set1_ps(vec.y))),
+                     _mm_add_ps(_mm_mul_ps(m.row[2].m, _mm_set1_ps(vec.z)), _mm_mul_ps(m.row[3].m, _mm_set1_ps(vec.w))));
   return ret;
 }
+#endif
 
 Matrix4x4f Matrix4x4f_RotateCommon(Radians angle, int axis)
 {
-  const Scalar1f sx = ::sin(angle.value);
-  const Scalar1f cx = ::cos(angle.value);
-  Matrix4x4f ret = Matrix4x4f_Zero();
-  ret.m[0][2]    = ret.m[1][0]    = ret.m[2][1]    = sx;
-  ret.m[0][1]    = ret.m[1][2]    = ret.m[2][0]    = -sx;
-  ret.m[axis][0] = ret.m[axis][1] = ret.m[axis][2] = Scalar1f_Zero();
-  ret.m[0][axis] = ret.m[1][axis] = ret.m[2][axis] = Scalar1f_Zero();
-  ret.m[0][0]    = ret.m[1][1]    = ret.m[2][2]    = cx;
-  ret.m[axis][axis] = ret.m[3][3] = Scalar1f_One();
-  return ret;
+  return Matrix4x4f_RotateSinCos(Radians_SinCos(angle), axis);
 }
 
 /*
@@ -156,7 +136,8 @@ Matrix4x4f Matrix4x4f_PerspectiveFrustum(Radians fieldOfView, Scalar1f aspectRat
   const Scalar1f one = Scalar1f_One();
   const Scalar1f two = Scalar1f_Two();
   const Scalar1f fov = fieldOfView.value;
-  const Scalar1f invTan = one / ::tanf(fov / two);
+  const SinCos1f sinCos = Radians_SinCos(Radians{ fov / two });
+  const Scalar1f invTan = sinCos.cos / sinCos.sin;
   const Scalar1f negInvDepth = one / (near - far);
 
   Matrix4x4f perspective = Matrix4x4f_Zero();
@@ -183,47 +164,324 @@ Matrix4x4f Matrix4x4f_OrthographicFrustum(Scalar1f left, Scalar1f right, Scalar1
   return ortho;
 }
 
-// Helper function for getting the 3x3 sub-matrix of a 4x4 and calculating the determinant of the 3x3 matrix
-Scalar1f Matrixi4x4f_3x3_Determinant(const Matrix4x4f& a, int row0, int row1, int row2, int col0, int col1, int col2)
+// The 2x2 minors of the top two rows (s) and of the bottom two rows (c) of a 4x4. Each 3x3 cofactor is a
+// combination of three of these, so the 12 minors are shared between the determinant and all 16 cofactors.
+// The c minors are stored in reverse order so that s[i] and c[i] cover complementary columns.
+struct Matrixi4x4f_Minors
+{
+  Scalar1f s[6];
+  Scalar1f c[6];
+};
+
+static Matrixi4x4f_Minors Matrixi4x4f_2x2_Minors(const Matrix4x4f& a)
 {
-  return a.m[row0][col0] * a.m[row1][col1] * a.m[row2][col2]
-       + a.m[row0][col1] * a.m[row1][col2] * a.m[row2][col0]
-       + a.m[row0][col2] * a.m[row1][col0] * a.m[row2][col1]
-       - a.m[row0][col2] * a.m[row1][col1] * a.m[row2][col0]
-       - a.m[row0][col1] * a.m[row1][col0] * a.m[row2][col2]
-       - a.m[row0][col0] * a.m[row1][col2] * a.m[row2][col1];
+  const int pairs[6][2] = { { 0,1 }, { 0,2 }, { 0,3 }, { 1,2 }, { 1,3 }, { 2,3 } };
+  Matrixi4x4f_Minors minors;
+  for (int i = 0; i < 6; ++i)
+  {
+    const int p = pairs[i][0], q = pairs[i][1];
+    minors.s[i] = a.m[0][p] * a.m[1][q] - a.m[1][p] * a.m[0][q];
+    minors.c[5 - i] = a.m[2][p] * a.m[3][q] - a.m[3][p] * a.m[2][q];
+  }
+  return minors;
 }
 
 Scalar1f Matrix4x4f_Determinant(const Matrix4x4f& a)
 {
-  return a.m[0][0] * Matrixi4x4f_3x3_Determinant(a, 1, 2, 3,  1, 2, 3)
-       - a.m[1][0] * Matrixi4x4f_3x3_Determinant(a, 0, 2, 3,  1, 2, 3)
-       + a.m[2][0] * Matrixi4x4f_3x3_Determinant(a, 0, 1, 3,  1, 2, 3)
-       - a.m[3][0] * Matrixi4x4f_3x3_Determinant(a, 0, 1, 2,  1, 2, 3);
+  const Matrixi4x4f_Minors x = Matrixi4x4f_2x2_Minors(a);
+  return x.s[0] * x.c[0] - x.s[1] * x.c[1] + x.s[2] * x.c[2] + x.s[3] * x.c[3] - x.s[4] * x.c[4] + x.s[5] * x.c[5];
+}
+
+// Calculates the adjugate into ret and returns the determinant, from one shared set of 2x2 minors
+static Scalar1f Matrixi4x4f_Cofactors(const Matrix4x4f& a, Matrix4x4f& ret)
+{
+#if MATHS3D_SSE
+  // Columns of a with the rows swapped in pairs, (a1k, a0k, a3k, a2k), which is the order they are needed in
+  __m128 col0 = a.row[0].m, col1 = a.row[1].m, col2 = a.row[2].m, col3 = a.row[3].m;
+  _MM_TRANSPOSE4_PS(col0, col1, col2, col3);
+  const __m128 c0 = _mm_shuffle_ps(col0, col0, _MM_SHUFFLE(2,3,0,1));
+  const __m128 c1 = _mm_shuffle_ps(col1, col1, _MM_SHUFFLE(2,3,0,1));
+  const __m128 c2 = _mm_shuffle_ps(col2, col2, _MM_SHUFFLE(2,3,0,1));
+  const __m128 c3 = _mm_shuffle_ps(col3, col3, _MM_SHUFFLE(2,3,0,1));
+
+  // Each minor vector holds the bottom-rows minor twice then the top-rows minor twice, (c,c,s,s), so that
+  // one multiply gives a term for all four cofactors of a row of the adjugate
+  const __m128 u0 = _mm_shuffle_ps(col0, col0, _MM_SHUFFLE(0,0,2,2)), v0 = _mm_shuffle_ps(col0, col0, _MM_SHUFFLE(1,1,3,3));
+  const __m128 u1 = _mm_shuffle_ps(col1, col1, _MM_SHUFFLE(0,0,2,2)), v1 = _mm_shuffle_ps(col1, col1, _MM_SHUFFLE(1,1,3,3));
+  const __m128 u2 = _mm_shuffle_ps(col2, col2, _MM_SHUFFLE(0,0,2,2)), v2 = _mm_shuffle_ps(col2, col2, _MM_SHUFFLE(1,1,3,3));
+  const __m128 u3 = _mm_shuffle_ps(col3, col3, _MM_SHUFFLE(0,0,2,2)), v3 = _mm_shuffle_ps(col3, col3, _MM_SHUFFLE(1,1,3,3));
+  const __m128 m01 = _mm_sub_ps(_mm_mul_ps(u0, v1), _mm_mul_ps(v0, u1));
+  const __m128 m02 = _mm_sub_ps(_mm_mul_ps(u0, v2), _mm_mul_ps(v0, u2));
+  const __m128 m03 = _mm_sub_ps(_mm_mul_ps(u0, v3), _mm_mul_ps(v0, u3));
+  const __m128 m12 = _mm_sub_ps(_mm_mul_ps(u1, v2), _mm_mul_ps(v1, u2));
+  const __m128 m13 = _mm_sub_ps(_mm_mul_ps(u1, v3), _mm_mul_ps(v1, u3));
+  const __m128 m23 = _mm_sub_ps(_mm_mul_ps(u2, v3), _mm_mul_ps(v2, u3));
+
+  // The cofactor signs alternate in a checkerboard, so are applied a whole row at a time
+  const __m128 evenSigns = _mm_setr_ps(1.0f, -1.0f, 1.0f, -1.0f);
+  const __m128 oddSigns = _mm_setr_ps(-1.0f, 1.0f, -1.0f, 1.0f);
+  ret.row[0].m = _mm_mul_ps(evenSigns, _mm_add_ps(_mm_sub_ps(_mm_mul_ps(c1, m23), _mm_mul_ps(c2, m13)), _mm_mul_ps(c3, m12)));
+  ret.row[1].m = _mm_mul_ps(oddSigns,  _mm_add_ps(_mm_sub_ps(_mm_mul_ps(c0, m23), _mm_mul_ps(c2, m03)), _mm_mul_ps(c3, m02)));
+  ret.row[2].m = _mm_mul_ps(evenSigns, _mm_add_ps(_mm_sub_ps(_mm_mul_ps(c0, m13), _mm_mul_ps(c1, m03)), _mm_mul_ps(c3, m01)));
+  ret.row[3].m = _mm_mul_ps(oddSigns,  _mm_add_ps(_mm_sub_ps(_mm_mul_ps(c0, m12), _mm_mul_ps(c1, m02)), _mm_mul_ps(c2, m01)));
+
+  // Expanding along the first column of a gives the determinant from the first row of the adjugate
+  const __m128 products = _mm_mul_ps(col0, ret.row[0].m);
+  const __m128 pairSums = _mm_add_ps(products, _mm_movehl_ps(products, products));
+  return _mm_cvtss_f32(_mm_add_ss(pairSums, _mm_shuffle_ps(pairSums, pairSums, _MM_SHUFFLE(1,1,1,1))));
+#else
+  const Matrixi4x4f_Minors x = Matrixi4x4f_2x2_Minors(a);
+  const Scalar1f (&s)[6] = x.s;
+  const Scalar1f (&c)[6] = x.c;
+  const Scalar1f (&m)[4][4] = a.m;
+  ret.m[0][0] =  m[1][1] * c[0] - m[1][2] * c[1] + m[1][3] * c[2];
+  ret.m[0][1] = -m[0][1] * c[0] + m[0][2] * c[1] - m[0][3] * c[2];
+  ret.m[0][2] =  m[3][1] * s[5] - m[3][2] * s[4] + m[3][3] * s[3];
+  ret.m[0][3] = -m[2][1] * s[5] + m[2][2] * s[4] - m[2][3] * s[3];
+  ret.m[1][0] = -m[1][0] * c[0] + m[1][2] * c[3] - m[1][3] * c[4];
+  ret.m[1][1] =  m[0][0] * c[0] - m[0][2] * c[3] + m[0][3] * c[4];
+  ret.m[1][2] = -m[3][0] * s[5] + m[3][2] * s[2] - m[3][3] * s[1];
+  ret.m[1][3] =  m[2][0] * s[5] - m[2][2] * s[2] + m[2][3] * s[1];
+  ret.m[2][0] =  m[1][0] * c[1] - m[1][1] * c[3] + m[1][3] * c[5];
+  ret.m[2][1] = -m[0][0] * c[1] + m[0][1] * c[3] - m[0][3] * c[5];
+  ret.m[2][2] =  m[3][0] * s[4] - m[3][1] * s[2] + m[3][3] * s[0];
+  ret.m[2][3] = -m[2][0] * s[4] + m[2][1] * s[2] - m[2][3] * s[0];
+  ret.m[3][0] = -m[1][0] * c[2] + m[1][1] * c[4] - m[1][2] * c[5];
+  ret.m[3][1] =  m[0][0] * c[2] - m[0][1] * c[4] + m[0][2] * c[5];
+  ret.m[3][2] = -m[3][0] * s[3] + m[3][1] * s[1] - m[3][2] * s[0];
+  ret.m[3][3] =  m[2][0] * s[3] - m[2][1] * s[1] + m[2][2] * s[0];
+  return m[0][0] * ret.m[0][0] + m[1][0] * ret.m[0][1] + m[2][0] * ret.m[0][2] + m[3][0] * ret.m[0][3];
+#endif
 }
 
 Matrix4x4f Matrix4x4f_Adjugate(const Matrix4x4f& a)
 {
-  Matrix4x4f ret = Matrix4x4f_Zero();
-  int rowsCols[4][3] = { { 1,2,3 }, { 0,2,3 }, { 0,1,3 }, { 0,1,2 } };
-  for (int j = 0; j < 4; ++j)
+  Matrix4x4f ret;
+  Matrixi4x4f_Cofactors(a, ret);
+  return ret;
+}
+
+Matrix4x4f Matrix4x4f_Inversed(const Matrix4x4f& a)
+{
+  Matrix4x4f ret;
+  const Scalar1f det = Matrixi4x4f_Cofactors(a, ret);
+  if (det != Scalar1f_Zero())
+  {
+    return Matrix4x4f_Scaled(ret, Scalar1f_One() / det);
+  }
+  return Matrix4x4f_Zero();
+}
+
+// The half precision conversions are done with integer operations on the bits of the float, so that these are
+// exact and don't depend on denormal floats, which -ffast-math may flush to zero.
+Half1h Half1h_FromScalar1f(Scalar1f value)
+{
+  uint32_t f;
+  ::memcpy(&f, &value, sizeof(f));
+  const uint32_t sign = (f >> 16) & 0x8000;
+  f &= 0x7FFFFFFF;
+  uint32_t h;
+  if (f >= 0x47800000)                      // too large for a half, or infinity or NaN
+  {
+    h = (f > 0x7F800000) ? (0x7E00 | ((f >> 13) & 0x3FF)) : 0x7C00; // NaNs are quietened and keep the top of their payload
+  }
+  else if (f < 0x38800000)                  // smaller than the smallest normal half, so make a denormal
+  {
+    const uint32_t shift = 113 - (f >> 23); // how much smaller the exponent is than the smallest half exponent
+    if (shift > 11)
+    {
+      h = 0;                                // rounds to zero
+    }
+    else
+    {
+      const uint32_t mantissa = (f & 0x7FFFFF) | 0x800000;
+      const uint32_t totalShift = shift + 13;
+      h = mantissa >> totalShift;
+      const uint32_t remainder = mantissa & ((1u << totalShift) - 1);
+      const uint32_t halfway = 1u << (totalShift - 1);
+      h += (remainder > halfway || (remainder == halfway && (h & 1))) ? 1 : 0;
+    }
+  }
+  else
+  {
+    // Rebias the exponent and round the mantissa to nearest, ties to even. Rounding may carry in to the exponent
+    // which correctly gives the next power of two, or infinity.
+    h = ((f - 0x38000000) + 0xFFF + ((f >> 13) & 1)) >> 13;
+  }
+  return Half1h(sign | h);
+}
+
+Scalar1f Scalar1f_FromHalf1h(Half1h value)
+{
+  const uint32_t sign = uint32_t(value & 0x8000) << 16;
+  const uint32_t expMantissa = value & 0x7FFF;
+  uint32_t f;
+  if (expMantissa >= 0x7C00)                // infinity or NaN
+  {
+    f = (expMantissa << 13) | 0x7F800000 | ((expMantissa > 0x7C00) ? 0x400000 : 0); // NaNs are quietened
+  }
+  else if (expMantissa >= 0x0400)           // normal, so just rebias the exponent
+  {
+    f = (expMantissa << 13) + 0x38000000;
+  }
+  else                                      // denormal or zero, which is the mantissa times 2^-24
+  {
+    Scalar1f denormal = Scalar1f(expMantissa) * 5.9604644775390625e-8f;
+    ::memcpy(&f, &denormal, sizeof(f));
+  }
+  f |= sign;
+  Scalar1f ret;
+  ::memcpy(&ret, &f, sizeof(ret));
+  return ret;
+}
+
+Vector2s Vector2s_OctahedralEncode(const Vector4f& normal)
+{
+  // Project on to the octahedron |x| + |y| + |z| = 1, and fold the lower half over the diagonals of the upper half
+  const Scalar1f invL1 = Scalar1f_One() / (::fabs(normal.x) + ::fabs(normal.y) + ::fabs(normal.z));
+  Scalar1f x = normal.x * invL1;
+  Scalar1f y = normal.y * invL1;
+  if (normal.z < Scalar1f_Zero())
+  {
+    const Scalar1f foldedX = (Scalar1f_One() - ::fabs(y)) * ((x >= Scalar1f_Zero()) ? 1.0f : -1.0f);
+    const Scalar1f foldedY = (Scalar1f_One() - ::fabs(x)) * ((y >= Scalar1f_Zero()) ? 1.0f : -1.0f);
+    x = foldedX;
+    y = foldedY;
+  }
+  return Vector2s{ { { int16_t(::lrintf(x * 32767.0f)), int16_t(::lrintf(y * 32767.0f)) } } };
+}
+
+SinCos1f Radians_SinCos(Radians angle)
+{
+  return Radians_SinCos<Precision::Exact>(angle);
+}
+
+Matrix3x4f Matrix3x4f_Multiply(const Matrix3x4f& m1, const Matrix3x4f& m2)
+{
+  Matrix3x4f ret;
+#if MATHS3D_SSE
+  // As for Matrix4x4f_Multiply, but the implied 4th row of m2 is (0,0,0,1), so only adds the translation
+  for (int i = 0; i < 3; i++)
+  {
+    __m128 row = _mm_add_ps(_mm_mul_ps(m2.row[0].m, _mm_set1_ps(m1.m[i][0])), _mm_setr_ps(0.0f, 0.0f, 0.0f, m1.m[i][3]));
+    row = _mm_add_ps(row, _mm_mul_ps(m2.row[1].m, _mm_set1_ps(m1.m[i][1])));
+    row = _mm_add_ps(row, _mm_mul_ps(m2.row[2].m, _mm_set1_ps(m1.m[i][2])));
+    ret.row[i].m = row;
+  }
+#else
+  for (int i = 0; i < 3; i++)
   {
-    for (int i = 0; i < 4; ++i)
+    for (int j = 0; j < 4; j++)
     {
-      ret.m[j][i] = Matrixi4x4f_3x3_Determinant(a,
-          rowsCols[j][0], rowsCols[j][1], rowsCols[j][2],
-          rowsCols[i][0], rowsCols[i][1], rowsCols[i][2]);
+      ret.m[i][j] = m1.m[i][0] * m2.m[0][j] + m1.m[i][1] * m2.m[1][j] + m1.m[i][2] * m2.m[2][j];
     }
+    ret.m[i][3] += m1.m[i][3];
+  }
+#endif
+  return ret;
+}
+
+// Calculates the inverse of a into ret and returns the determinant of the 3x3 part, or returns 0 if it is singular
+static Scalar1f Matrixi3x4f_Inverse(const Matrix3x4f& a, Matrix3x4f& ret)
+{
+  // The inverse of the 3x3 part has the cross products of pairs of its columns as its rows
+  const Scalar1f (&m)[3][4] = a.m;
+  const Scalar1f x[3] = { m[1][1] * m[2][2] - m[2][1] * m[1][2], m[2][1] * m[0][2] - m[0][1] * m[2][2], m[0][1] * m[1][2] - m[1][1] * m[0][2] };
+  const Scalar1f y[3] = { m[1][2] * m[2][0] - m[2][2] * m[1][0], m[2][2] * m[0][0] - m[0][2] * m[2][0], m[0][2] * m[1][0] - m[1][2] * m[0][0] };
+  const Scalar1f z[3] = { m[1][0] * m[2][1] - m[2][0] * m[1][1], m[2][0] * m[0][1] - m[0][0] * m[2][1], m[0][0] * m[1][1] - m[1][0] * m[0][1] };
+  const Scalar1f det = m[0][0] * x[0] + m[1][0] * x[1] + m[2][0] * x[2];
+  if (det == Scalar1f_Zero())
+  {
+    return det;
+  }
+  const Scalar1f invDet = Scalar1f_One() / det;
+  ret.row[0] = Vector4f_Set(x[0] * invDet, x[1] * invDet, x[2] * invDet, Scalar1f_Zero());
+  ret.row[1] = Vector4f_Set(y[0] * invDet, y[1] * invDet, y[2] * invDet, Scalar1f_Zero());
+  ret.row[2] = Vector4f_Set(z[0] * invDet, z[1] * invDet, z[2] * invDet, Scalar1f_Zero());
+  // The translation is moved back by the inverse of the 3x3 part
+  for (int i = 0; i < 3; ++i)
+  {
+    ret.m[i][3] = -(ret.m[i][0] * m[0][3] + ret.m[i][1] * m[1][3] + ret.m[i][2] * m[2][3]);
+  }
+  return det;
+}
+
+Matrix3x4f Matrix3x4f_Inversed(const Matrix3x4f& a)
+{
+  Matrix3x4f ret;
+  if (Matrixi3x4f_Inverse(a, ret) == Scalar1f_Zero())
+  {
+    ret.row[0] = ret.row[1] = ret.row[2] = Vector4f_Zero();
   }
   return ret;
 }
 
-Vector4f Vector4f_Transform(const Matrix4x4f& m, const Vector4f& vec)
+Matrix4x4f Matrix4x4f_AffineInversed(const Matrix4x4f& a)
+{
+  Matrix3x4f ret;
+  if (Matrixi3x4f_Inverse(Matrix3x4f_FromMatrix4x4f(a), ret) == Scalar1f_Zero())
+  {
+    return Matrix4x4f_Zero();
+  }
+  return Matrix4x4f_FromMatrix3x4f(ret);
+}
+
+Vector4f Vector4f_Transform(const Matrix3x4f& m, const Vector4f& vec)
+{
+  return Vector4f_Set(Vector4f_DotProduct(m.row[0], vec), Vector4f_DotProduct(m.row[1], vec), Vector4f_DotProduct(m.row[2], vec), vec.w);
+}
+
+Quaternion4f Quaternion4f_FromRotation(const Rotation& rotation)
 {
-  Matrix4x4f trans = Matrix4x4f_Transposed(m);
-  return Vector4f_Set(Vector4f_DotProduct(trans.row[0], vec),
-                      Vector4f_DotProduct(trans.row[1], vec),
-                      Vector4f_DotProduct(trans.row[2], vec),
-                      Vector4f_DotProduct(trans.row[3], vec));
+  // The same order as Matrix4x4f_RotateXYZ, which applies the z rotation, then y and then x
+  const Quaternion4f x = Quaternion4f_FromAxisAngle(Vector4f_Set(1.0f, 0.0f, 0.0f, 0.0f), rotation.x);
+  const Quaternion4f y = Quaternion4f_FromAxisAngle(Vector4f_Set(0.0f, 1.0f, 0.0f, 0.0f), rotation.y);
+  const Quaternion4f z = Quaternion4f_FromAxisAngle(Vector4f_Set(0.0f, 0.0f, 1.0f, 0.0f), rotation.z);
+  return Quaternion4f_Multiply(Quaternion4f_Multiply(x, y), z);
 }
 
+Quaternion4f Quaternion4f_Slerp(const Quaternion4f& q1, const Quaternion4f& q2, Scalar1f t)
+{
+  // q2 and -q2 are the same rotation, the one closest to q1 is the shortest path
+  Scalar1f cosAngle = Quaternion4f_DotProduct(q1, q2);
+  const Vector4f b = (cosAngle < 0.0f) ? Vector4f_Scaled(q2.vec, -1.0f) : q2.vec;
+  cosAngle = ::fabs(cosAngle);
+  if (cosAngle > 0.9995f)
+  {
+    return Quaternion4f_Nlerp(q1, Quaternion4f{ b }, t);
+  }
+  // acos from Abramowitz and Stegun 4.4.46, which is within 2e-8 for 0 <= x <= 1
+  Scalar1f poly = -0.0012624911f;
+  poly = poly * cosAngle + 0.0066700901f;
+  poly = poly * cosAngle - 0.0170881256f;
+  poly = poly * cosAngle + 0.0308918810f;
+  poly = poly * cosAngle - 0.0501743046f;
+  poly = poly * cosAngle + 0.0889789874f;
+  poly = poly * cosAngle - 0.2145988016f;
+  poly = poly * cosAngle + 1.5707963050f;
+  const Scalar1f angle = ::sqrt(1.0f - cosAngle) * poly;
+  const Scalar1f invSinAngle = 1.0f / ::sqrt(1.0f - cosAngle * cosAngle);
+  const Scalar1f a = Radians_Sin(Radians{ (1.0f - t) * angle }) * invSinAngle;
+  const Scalar1f c = Radians_Sin(Radians{ t * angle }) * invSinAngle;
+  return Quaternion4f{ Vector4f_Add(Vector4f_Scaled(q1.vec, a), Vector4f_Scaled(b, c)) };
+}
+
+Frustum4f Frustum4f_FromMatrix4x4f(const Matrix4x4f& viewProjection)
+{
+  // A point is inside when -w <= x, y, z <= w in clip space. As clip = x*row[0] + y*row[1] + z*row[2] + row[3], each
+  // of those is a dot-product with a column of the matrix, so the planes are the sums and differences of the columns.
+  const Matrix4x4f columns = Matrix4x4f_Transposed(viewProjection);
+  Frustum4f frustum;
+  for (int i = 0; i < 3; ++i)
+  {
+    frustum.planes[2*i+0] = Vector4f_Add(columns.row[3], columns.row[i]);
+    frustum.planes[2*i+1] = Vector4f_Subtract(columns.row[3], columns.row[i]);
+  }
+  for (int i = 0; i < 6; ++i)
+  {
+    const Vector4f& plane = frustum.planes[i];
+    const Scalar1f normalLength = ::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+    frustum.planes[i] = Vector4f_Scaled(plane, Scalar1f_One() / normalLength);
+  }
+  return frustum;
+}
@@ -32,8 +32,11 @@
 
 
 #include <cstdio>
+#include <chrono>
 #include <cmath>
+#include <vector>
 #include "maths3d_ext.h"
+#include "maths3d_pp.h"
 #include "test.h"
 
 
@@ -151,6 +154,159 @@ TEST(Maths3DTest, Matrix)
   }
 }
 
+// Check the vector backend against the plain formulas. The tests are also built with MATHS3D_SCALAR defined so
+// that both backends are tested.
+TEST(Maths3DTest, Backend)
+{
+  const Vector4f a = Vector4f_Set(1.0f, -2.0f, 3.0f, 0.5f);
+  const Vector4f b = Vector4f_Set(4.0f, 5.0f, -6.0f, 2.0f);
+  const Vector4f sum = Vector4f_Add(a, b);
+  const Vector4f difference = Vector4f_Subtract(a, b);
+  const Vector4f product = Vector4f_Multiply(a, b);
+  const Vector4f scaled = Vector4f_Scaled(a, 3.0f);
+  const Vector4f cross = Vector4f_CrossProduct(a, b);
+  const float crossCmp[4] = { -3.0f, 18.0f, 13.0f, 1.0f };
+  for (int i = 0; i < 4; ++i)
+  {
+    EXPECT_EQ(sum.v[i], a.v[i] + b.v[i]);
+    EXPECT_EQ(difference.v[i], a.v[i] - b.v[i]);
+    EXPECT_EQ(product.v[i], a.v[i] * b.v[i]);
+    EXPECT_EQ(scaled.v[i], a.v[i] * 3.0f);
+    EXPECT_EQ(Vector4f_Replicate(2.5f).v[i], 2.5f);
+    EXPECT_EQ(cross.v[i], crossCmp[i]);
+  }
+  EXPECT_EQ(Vector4f_DotProduct(a, b), -23.0f);
+
+  const Matrix4x4f m1 = Matrix4x4f_Multiply(Matrix4x4f_RotateX(Degrees{30.0f}), Matrix4x4f_TranslateXYZ(a));
+  const Matrix4x4f m2 = Matrix4x4f_Multiply(Matrix4x4f_ScaleXYZ(b), Matrix4x4f_RotateY(Degrees{-20.0f}));
+  const Matrix4x4f m = Matrix4x4f_Multiply(m1, m2);
+  const Vector4f transformed = Vector4f_Transform(m, b);
+  for (int i = 0; i < 4; ++i)
+  {
+    float expected = 0.0f;
+    for (int j = 0; j < 4; ++j)
+    {
+      float expectedM = 0.0f;
+      for (int k = 0; k < 4; ++k)
+      {
+        expectedM += m1.m[k][j] * m2.m[i][k];
+      }
+      EXPECT_NEAR(m.m[i][j], expectedM, epsilon);
+      expected += m.m[j][i] * b.v[j];
+    }
+    EXPECT_NEAR(transformed.v[i], expected, 0.0001f);
+  }
+}
+
+// Check the functions which are constexpr when built as C++17 give the same values at compile time as at runtime.
+// The tests are also built as C++17 so that these are tested.
+TEST(Maths3DTest, Constexpr)
+{
+#if MATHS3D_HAS_CONSTEXPR
+  constexpr Vector4f a = Vector4f_Set(1.0f, -2.0f, 3.0f, 0.5f);
+  constexpr Vector4f b = Vector4f_Set(4.0f, 5.0f, -6.0f, 2.0f);
+  constexpr Vector4f cross = Vector4f_CrossProduct(a, b);
+  static_assert(cross.x == -3.0f && cross.y == 18.0f && cross.z == 13.0f && cross.w == 1.0f, "constexpr cross-product");
+  static_assert(Vector4f_DotProduct(a, b) == -23.0f, "constexpr dot-product");
+
+  constexpr Radians halfTurn = Degrees{ 180.0f };
+  static_assert(halfTurn.value > 3.1415f && halfTurn.value < 3.1416f, "constexpr degrees to radians");
+
+  constexpr Matrix4x4f m = Matrix4x4f_Multiply(Matrix4x4f_Multiply(Matrix4x4f_TranslateXYZ(a), Matrix4x4f_YZSwap()),
+                                               Matrix4x4f_Multiply(Matrix4x4f_ScaleXYZ(b), Matrix4x4f_YFlip()));
+  constexpr Vector4f transformed = Vector4f_Transform(m, b);
+  static_assert(Matrix4x4f_Transposed(m).row[3].y == m.row[1].w, "constexpr transpose");
+
+  // The same at runtime, which uses the SSE versions when those are available
+  volatile float one = 1.0f;
+  const Vector4f runtimeA = Vector4f_Scaled(a, one);
+  const Vector4f runtimeB = Vector4f_Scaled(b, one);
+  const Matrix4x4f runtimeM = Matrix4x4f_Multiply(Matrix4x4f_Multiply(Matrix4x4f_TranslateXYZ(runtimeA), Matrix4x4f_YZSwap()),
+                                                  Matrix4x4f_Multiply(Matrix4x4f_ScaleXYZ(runtimeB), Matrix4x4f_YFlip()));
+  const Vector4f runtimeTransformed = Vector4f_Transform(runtimeM, runtimeB);
+  const Vector4f runtimeCross = Vector4f_CrossProduct(runtimeA, runtimeB);
+  for (int i = 0; i < 4; ++i)
+  {
+    EXPECT_EQ(cross.v[i], runtimeCross.v[i]);
+    EXPECT_NEAR(transformed.v[i], runtimeTransformed.v[i], epsilon);
+  }
+  for (int i = 0; i < 16; ++i)
+  {
+    EXPECT_NEAR(m.v[i], runtimeM.v[i], epsilon);
+  }
+#endif
+}
+
+// Check the reciprocals, normalize, projection and trigonometry are within the stated error bounds of each precision
+template <Precision precision>
+void CheckPrecision(double bound, double trigBound, double tanBound)
+{
+  // Every mantissa in the leading bits over a range of exponents
+  for (int i = 1; i < 4000; ++i)
+  {
+    const float x = float(i) * 0.37f * ::powf(2.0f, float(i % 31) - 15.0f);
+    EXPECT_NEAR(Scalar1f_Reciprocal<precision>(x) * double(x), 1.0, bound);
+    EXPECT_NEAR(Scalar1f_ReciprocalSqrt<precision>(x) * ::sqrt(double(x)), 1.0, bound);
+    EXPECT_NEAR(Scalar1f_Reciprocal<precision>(-x) * double(x), -1.0, bound);
+  }
+  for (int i = 0; i < 100; ++i)
+  {
+    const Vector4f vec = Vector4f_Set(float(i % 7) - 3.0f, float(i) * 0.125f, 1.0f + float(i % 3), 0.0f);
+    const double length = ::sqrt(double(Vector4f_LengthSquared(vec)));
+    EXPECT_NEAR(Vector4f_Length<precision>(vec) / length, 1.0, bound);
+    EXPECT_NEAR(Vector4f_ReciprocalLength<precision>(vec) * length, 1.0, bound);
+    EXPECT_NEAR(Vector4f_Length<precision>(Vector4f_Normalized<precision>(vec)), 1.0, 2.0 * bound + 1e-6);
+  }
+  EXPECT_EQ(Vector4f_Length<precision>(Vector4f_Zero()), 0.0f);
+
+  const Matrix4x4f projection = Matrix4x4f_PerspectiveFrustum(Degrees{ 60.0f }, 1.5f, 0.1f, 1000.0f);
+  for (int i = 0; i < 100; ++i)
+  {
+    const Vector4f vec = Vector4f_Set(float(i % 11) - 5.0f, float(i % 7) - 3.0f, -1.0f - float(i), 1.0f);
+    const Vector4f clip = Vector4f_Transform(projection, vec);
+    const Vector4f ndc = Vector4f_TransformCoord<precision>(projection, vec);
+    for (int j = 0; j < 4; ++j)
+    {
+      EXPECT_NEAR(ndc.v[j], clip.v[j] / double(clip.w), (bound + 1e-7) * ::fabs(clip.v[j] / clip.w));
+    }
+  }
+
+  // The sine and cosine have an absolute bound, and the tangent a relative one away from the poles
+  for (int i = -20000; i <= 20000; ++i)
+  {
+    const float angle = float(i) * ((i % 2) ? 0.4096f : 0.00035f);
+    const double exactSin = ::sin(double(angle));
+    const double exactCos = ::cos(double(angle));
+    const SinCos1f sinCos = Radians_SinCos<precision>(Radians{ angle });
+    const SinCos4f sinCos4 = Vector4f_SinCos<precision>(Vector4f_Set(angle, -angle, angle, angle));
+    EXPECT_NEAR(sinCos.sin, exactSin, trigBound);
+    EXPECT_NEAR(sinCos.cos, exactCos, trigBound);
+    EXPECT_NEAR(Radians_Sin<precision>(Radians{ angle }), exactSin, trigBound);
+    EXPECT_NEAR(Radians_Cos<precision>(Radians{ angle }), exactCos, trigBound);
+    EXPECT_NEAR(sinCos4.sin.x, exactSin, trigBound);
+    EXPECT_NEAR(sinCos4.sin.y, -exactSin, trigBound);
+    EXPECT_NEAR(sinCos4.cos.y, exactCos, trigBound);
+    if (::fabs(exactCos) > 0.01)
+    {
+      EXPECT_NEAR(Radians_Tan<precision>(Radians{ angle }) / (exactSin / exactCos), 1.0, tanBound);
+      EXPECT_NEAR(Vector4f_Tan<precision>(Vector4f_Set(angle, angle, angle, angle)).w / (exactSin / exactCos), 1.0, tanBound);
+    }
+  }
+}
+
+TEST(Maths3DTest, Precision)
+{
+  CheckPrecision<Precision::Exact>(1.2e-7, 1e-7, 4.8e-7);
+  CheckPrecision<Precision::Fast>(0.5 / (1 << 20), 2e-6, 4e-6);
+  CheckPrecision<Precision::Fastest>(1.5 / (1 << 12), 4e-4, 1e-3);
+  // The defaults are exact
+  const Matrix4x4f projection = Matrix4x4f_PerspectiveFrustum(Degrees{ 60.0f }, 1.5f, 0.1f, 1000.0f);
+  const Vector4f vec = Vector4f_Set(1.0f, 2.0f, -3.0f, 1.0f);
+  EXPECT_EQ(Vector4f_TransformCoord(projection, vec).x, Vector4f_TransformCoord<Precision::Exact>(projection, vec).x);
+  EXPECT_EQ(Radians_SinCos(Radians{ 2.5f }).sin, Radians_SinCos<Precision::Exact>(Radians{ 2.5f }).sin);
+  EXPECT_EQ(Vector4f_Tan(vec).x, Vector4f_Tan<Precision::Exact>(vec).x);
+}
+
 // Test the inverse function
 TEST(Maths3DTest, Inverse)
 {
@@ -177,6 +333,535 @@ TEST(Maths3DTest, Inverse)
   {
     EXPECT_NEAR(modelViewProjection.v[i], invinv.v[i], epsilon);
   }
+
+  // A general matrix multiplied by its inverse should give the identity, and the adjugate should
+  // be the inverse scaled by the determinant
+  const Matrix4x4f affine = Matrix4x4f_Multiply(Matrix4x4f_Multiply(Matrix4x4f_ScaleXYZ(Vector4f_Set(2.0f, 0.5f, 4.0f, 1.0f)),
+                                                                    Matrix4x4f_RotateXYZ(Rotation{ Degrees{ 30.0f }, Degrees{ -60.0f }, Degrees{ 10.0f } })),
+                                                Matrix4x4f_TranslateXYZ(Vector4f_Set(3.0f, -4.0f, 5.0f, 1.0f)));
+  const Matrix4x4f general = Matrix4x4f_Multiply(affine, Matrix4x4f_PerspectiveFrustum(Degrees{ 60.0f }, 1.5f, 1.0f, 100.0f));
+  const Matrix4x4f generalInv = Matrix4x4f_Inversed(general);
+  const Matrix4x4f generalIdentity = Matrix4x4f_Multiply(general, generalInv);
+  const Matrix4x4f adjugate = Matrix4x4f_Scaled(Matrix4x4f_Adjugate(general), 1.0f / Matrix4x4f_Determinant(general));
+  const Matrix4x4f affineInv = Matrix4x4f_AffineInversed(affine);
+  const Matrix4x4f affineIdentity1 = Matrix4x4f_Multiply(affine, affineInv);
+  const Matrix4x4f affineIdentity2 = Matrix4x4f_Multiply(affineInv, affine);
+  const Matrix4x4f affineGeneralInv = Matrix4x4f_Inversed(affine);
+  for (int i = 0; i < 16; ++i)
+  {
+    EXPECT_NEAR(generalIdentity.v[i], ident.v[i], 0.0001f);
+    EXPECT_NEAR(adjugate.v[i], generalInv.v[i], 0.0001f);
+    EXPECT_NEAR(affineIdentity1.v[i], ident.v[i], 0.0001f);
+    EXPECT_NEAR(affineIdentity2.v[i], ident.v[i], 0.0001f);
+    EXPECT_NEAR(affineInv.v[i], affineGeneralInv.v[i], 0.0001f);
+  }
+  EXPECT_NEAR(Matrix4x4f_Determinant(Matrix4x4f_ScaleXYZ(Vector4f_Set(2.0f, 3.0f, 4.0f, 1.0f))), 24.0f, epsilon);
+
+  // Singular matrices have no inverse, so give a zero matrix
+  const Matrix4x4f singular = Matrix4x4f_ScaleXYZ(Vector4f_Set(2.0f, 0.0f, 4.0f, 1.0f));
+  for (int i = 0; i < 16; ++i)
+  {
+    EXPECT_EQ(Matrix4x4f_Inversed(singular).v[i], 0.0f);
+    EXPECT_EQ(Matrix4x4f_AffineInversed(singular).v[i], 0.0f);
+  }
+}
+
+// Check the affine matrices give the same results as the equivalent Matrix4x4f
+TEST(Maths3DTest, AffineMatrix)
+{
+  const unsigned count = 7;
+  Matrix4x4f full[count];
+  Matrix3x4f affine[count];
+  for (unsigned i = 0; i < count; ++i)
+  {
+    const Rotation rotation = Rotation{ Degrees{ 37.0f * i }, Degrees{ -23.0f * i + 45.0f }, Degrees{ 71.0f * i } };
+    full[i] = Matrix4x4f_Multiply(Matrix4x4f_Multiply(Matrix4x4f_ScaleXYZ(Vector4f_Set(1.0f + i, 2.0f, 0.5f, 1.0f)), Matrix4x4f_RotateXYZ(rotation)),
+                                  Matrix4x4f_TranslateXYZ(Vector4f_Set(3.0f, -4.0f * i, 5.0f, 1.0f)));
+    affine[i] = Matrix3x4f_FromMatrix4x4f(full[i]);
+  }
+  Matrix3x4f products[count];
+  Matrix3x4f_MultiplyStream(products, affine, affine + 1, count - 1);
+  for (unsigned i = 0; i < count - 1; ++i)
+  {
+    const Matrix4x4f roundTrip = Matrix4x4f_FromMatrix3x4f(affine[i]);
+    const Matrix4x4f product = Matrix4x4f_FromMatrix3x4f(Matrix3x4f_Multiply(affine[i], affine[i+1]));
+    const Matrix4x4f expectedProduct = Matrix4x4f_Multiply(full[i], full[i+1]);
+    const Matrix4x4f inverse = Matrix4x4f_FromMatrix3x4f(Matrix3x4f_Inversed(affine[i]));
+    const Matrix4x4f expectedInverse = Matrix4x4f_Inversed(full[i]);
+    const Matrix3x4f identity = Matrix3x4f_Multiply(affine[i], Matrix3x4f_Inversed(affine[i]));
+    for (int j = 0; j < 16; ++j)
+    {
+      EXPECT_NEAR(roundTrip.v[j], full[i].v[j], epsilon);
+      EXPECT_NEAR(product.v[j], expectedProduct.v[j], 0.0001f);
+      EXPECT_NEAR(Matrix4x4f_FromMatrix3x4f(products[i]).v[j], expectedProduct.v[j], 0.0001f);
+      EXPECT_NEAR(inverse.v[j], expectedInverse.v[j], 0.0001f);
+    }
+    for (int j = 0; j < 12; ++j)
+    {
+      EXPECT_NEAR(identity.v[j], Matrix3x4f_Identity().v[j], 0.0001f);
+    }
+    const Vector4f point = Vector4f_Set(1.0f, -2.0f, 3.0f, 1.0f);
+    const Vector4f transformed = Vector4f_Transform(affine[i], point);
+    const Vector4f expectedTransformed = Vector4f_Transform(full[i], point);
+    for (int j = 0; j < 4; ++j)
+    {
+      EXPECT_NEAR(transformed.v[j], expectedTransformed.v[j], 0.0001f);
+    }
+  }
+  // Every tier of the batch multiply, with a broadcast second matrix
+  for (int isa = 0; isa <= int(InstructionSet::AVX512); ++isa)
+  {
+    if (InstructionSet_IsSupported(InstructionSet(isa)))
+    {
+      Matrix3x4f_SelectMultiplyStream(InstructionSet(isa))(products[0].v, 12, affine[0].v, 12, affine[count-1].v, 0, count);
+      for (unsigned i = 0; i < count; ++i)
+      {
+        const Matrix4x4f expectedProduct = Matrix4x4f_Multiply(full[i], full[count-1]);
+        for (int j = 0; j < 16; ++j)
+        {
+          EXPECT_NEAR(Matrix4x4f_FromMatrix3x4f(products[i]).v[j], expectedProduct.v[j], 0.001f);
+        }
+      }
+    }
+  }
+  const Matrix3x4f singular = Matrix3x4f_FromMatrix4x4f(Matrix4x4f_ScaleXYZ(Vector4f_Set(2.0f, 0.0f, 4.0f, 1.0f)));
+  for (int j = 0; j < 12; ++j)
+  {
+    EXPECT_EQ(Matrix3x4f_Inversed(singular).v[j], 0.0f);
+  }
+}
+
+// Checks the matrices a and b are the same within the rounding of the different ways of calculating them
+void CheckMatrixNear(const Matrix4x4f& a, const Matrix4x4f& b)
+{
+  for (int i = 0; i < 16; ++i)
+  {
+    EXPECT_NEAR(a.v[i], b.v[i], 0.0001f);
+  }
+}
+
+// Checks the vectors a and b are the same within the rounding of the different ways of calculating them
+void CheckVectorNear(const Vector4f& a, const Vector4f& b)
+{
+  for (int i = 0; i < 4; ++i)
+  {
+    EXPECT_NEAR(a.v[i], b.v[i], 0.0001f);
+  }
+}
+
+// Check the quaternions rotate the same as the matrices
+TEST(Maths3DTest, Quaternion)
+{
+  const Vector4f vec = Vector4f_Set(1.0f, -2.0f, 3.0f, 0.5f);
+  const Vector4f axes[3] = { Vector4f_Set(1.0f, 0.0f, 0.0f, 0.0f), Vector4f_Set(0.0f, 1.0f, 0.0f, 0.0f), Vector4f_Set(0.0f, 0.0f, 1.0f, 0.0f) };
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    const Quaternion4f q = Quaternion4f_FromAxisAngle(axes[axis], Degrees{ 40.0f });
+    CheckMatrixNear(Matrix4x4f_FromQuaternion4f(q), Matrix4x4f_RotateSinCos(Radians_SinCos(Degrees{ 40.0f }), axis));
+  }
+
+  const Rotation rotation = { { 10.0f }, { -70.0f }, { 130.0f } };
+  const Quaternion4f q1 = Quaternion4f_FromRotation(rotation);
+  const Matrix4x4f m1 = Matrix4x4f_RotateXYZ(rotation);
+  CheckMatrixNear(Matrix4x4f_FromQuaternion4f(q1), m1);
+  const Vector4f rotated = Quaternion4f_Rotate(q1, vec);
+  const Vector4f expectedRotated = Vector4f_Transform(m1, vec);
+  for (int i = 0; i < 4; ++i)
+  {
+    EXPECT_NEAR(rotated.v[i], expectedRotated.v[i], 0.0001f);
+  }
+
+  // Composing and inverting the rotations matches the matrices
+  const Quaternion4f q2 = Quaternion4f_FromAxisAngle(Vector4f_Normalized(Vector4f_Set(1.0f, 2.0f, -1.0f, 0.0f)), Degrees{ 75.0f });
+  const Matrix4x4f m2 = Matrix4x4f_FromQuaternion4f(q2);
+  CheckMatrixNear(Matrix4x4f_FromQuaternion4f(Quaternion4f_Multiply(q1, q2)), Matrix4x4f_Multiply(m1, m2));
+  CheckMatrixNear(Matrix4x4f_FromQuaternion4f(Quaternion4f_Conjugate(q1)), Matrix4x4f_Transposed(m1));
+  const Quaternion4f identity = Quaternion4f_Multiply(q1, Quaternion4f_Conjugate(q1));
+  const Quaternion4f expectedIdentity = Quaternion4f_Identity();
+  for (int i = 0; i < 4; ++i)
+  {
+    EXPECT_NEAR(identity.v[i], expectedIdentity.v[i], epsilon);
+  }
+
+  // The interpolations go from q1 to q2, and halfway the slerp is the same angle from both
+  const Quaternion4f slerpStart = Quaternion4f_Slerp(q1, q2, 0.0f);
+  const Quaternion4f slerpEnd = Quaternion4f_Slerp(q1, q2, 1.0f);
+  const Quaternion4f nlerpEnd = Quaternion4f_Nlerp(q1, q2, 1.0f);
+  const Scalar1f sign = (Quaternion4f_DotProduct(q1, q2) < 0.0f) ? -1.0f : 1.0f;
+  for (int i = 0; i < 4; ++i)
+  {
+    EXPECT_NEAR(slerpStart.v[i], q1.v[i], epsilon);
+    EXPECT_NEAR(slerpEnd.v[i], sign * q2.v[i], epsilon);
+    EXPECT_NEAR(nlerpEnd.v[i], sign * q2.v[i], epsilon);
+  }
+  const Quaternion4f halfway = Quaternion4f_Slerp(q1, q2, 0.5f);
+  EXPECT_NEAR(Vector4f_Length(halfway.vec), 1.0f, epsilon);
+  EXPECT_NEAR(fabsf(Quaternion4f_DotProduct(halfway, q1)), fabsf(Quaternion4f_DotProduct(halfway, q2)), epsilon);
+  const Scalar1f angle = acosf(fabsf(Quaternion4f_DotProduct(q1, q2)));
+  EXPECT_NEAR(fabsf(Quaternion4f_DotProduct(Quaternion4f_Slerp(q1, q2, 0.25f), q1)), cosf(0.25f * angle), 0.000001f);
+
+  // The combined transform is the same as multiplying the matrices
+  const Vector4f translation = Vector4f_Set(4.0f, 5.0f, -6.0f, 0.0f);
+  const Vector4f scale = Vector4f_Set(2.0f, 0.5f, 3.0f, 0.0f);
+  const Matrix4x4f trs = Matrix4x4f_TranslateRotateScale(translation, q1, scale);
+  CheckMatrixNear(trs, Matrix4x4f_Multiply(Matrix4x4f_Multiply(Matrix4x4f_TranslateXYZ(translation), m1),
+                                           Matrix4x4f_ScaleXYZ(Vector4f_SetW(scale, 1.0f))));
+  CheckMatrixNear(Matrix4x4f_FromMatrix3x4f(Matrix3x4f_TranslateRotateScale(translation, q1, scale)), trs);
+}
+
+// Check the prepared transforms give the same results as Vector4f_Transform
+TEST(Maths3DTest, PreparedTransform)
+{
+  const Matrix4x4f xform = Matrix4x4f_Multiply(Matrix4x4f_Multiply(Matrix4x4f_TranslateXYZ(Vector4f_Set(1.0f, -2.0f, 3.0f, 1.0f)),
+                                                                   Matrix4x4f_RotateXYZ(Rotation{ { 10.0f }, { 20.0f }, { 30.0f } })),
+                                               Matrix4x4f_PerspectiveFrustum(Degrees{ 60.0f }, 1.5f, 1.0f, 100.0f));
+  const PreparedTransform4f prepared = PreparedTransform4f_Prepare(xform);
+  const Matrix4x4f unprepared = PreparedTransform4f_Matrix(prepared);
+  for (int i = 0; i < 16; ++i)
+  {
+    EXPECT_EQ(unprepared.v[i], xform.v[i]);
+  }
+
+  const unsigned count = 7;
+  Vector4f input[count];
+  Vector4f batch[count];
+  Vector4f stream[count];
+  Vector4f coordStream[count];
+  Vector4f normalStream[count];
+  for (unsigned i = 0; i < count; ++i)
+  {
+    input[i] = Vector4f_Set(float(i), 2.0f - float(i), 0.5f * float(i), 1.0f);
+  }
+  PreparedTransform4f_TransformBatch(prepared, batch, input, count);
+  PreparedTransform4f_TransformStream(prepared, stream, input, count);
+  PreparedTransform4f_TransformCoordStream(prepared, coordStream, input, count);
+  PreparedTransform4f_TransformNormalStream(prepared, normalStream, input, count);
+  for (unsigned i = 0; i < count; ++i)
+  {
+    const Vector4f expected = Vector4f_Transform(xform, input[i]);
+    const Vector4f expectedNormal = Vector4f_Transform(xform, Vector4f_SetW(input[i], 0.0f));
+    const Vector4f single = PreparedTransform4f_Transform(prepared, input[i]);
+    const Vector4f normal = PreparedTransform4f_TransformNormal(prepared, input[i]);
+    const Vector4f product = prepared * input[i];
+    for (int j = 0; j < 4; ++j)
+    {
+      EXPECT_NEAR(single.v[j], expected.v[j], epsilon);
+      EXPECT_NEAR(product.v[j], expected.v[j], epsilon);
+      EXPECT_NEAR(batch[i].v[j], expected.v[j], epsilon);
+      EXPECT_NEAR(stream[i].v[j], expected.v[j], epsilon);
+      EXPECT_NEAR(normal.v[j], expectedNormal.v[j], epsilon);
+    }
+    for (int j = 0; j < 3; ++j)
+    {
+      EXPECT_NEAR(coordStream[i].v[j], expected.v[j] / expected.w, epsilon);
+      EXPECT_NEAR(normalStream[i].v[j], expectedNormal.v[j], epsilon);
+    }
+  }
+}
+
+// Check the vector operators give the same results as the functions. With MATHS3D_EXPRESSION_TEMPLATES defined
+// these are the lazily evaluated expressions. \see check_expression_templates in Maths3D.pro
+TEST(Maths3DTest, VectorOperators)
+{
+  const Vector4f a = Vector4f_Set(1.0f, -2.0f, 3.0f, 0.0f);
+  const Vector4f b = Vector4f_Set(-4.0f, 5.0f, 0.5f, 0.0f);
+  const Vector4f point = Vector4f_Set(2.0f, 7.0f, -1.0f, 0.0f);
+  const Vector4f sum = a + b;
+  const Vector4f difference = a - b;
+  const Vector4f product = a * b;
+  const Vector4f scaled = a * 2.5f;
+  const Vector4f normalized = ~(a - b);
+  const Vector4f cross = a ^ b;
+  const Scalar1f dot = a ^ b;
+  const Scalar1f length = a - b;
+  const Vector4f direction = ~b;
+  const Vector4f intercept = a + (direction * Scalar1f(direction ^ (point - a)));
+  Vector4f assigned = a;
+  assigned = assigned + b * 2.0f;
+  const Vector4f expectedIntercept = Vector4f_Add(a, Vector4f_Scaled(direction, Vector4f_DotProduct(direction, Vector4f_Subtract(point, a))));
+  for (int i = 0; i < 4; ++i)
+  {
+    EXPECT_NEAR(sum.v[i], Vector4f_Add(a, b).v[i], epsilon);
+    EXPECT_NEAR(difference.v[i], Vector4f_Subtract(a, b).v[i], epsilon);
+    EXPECT_NEAR(product.v[i], Vector4f_Multiply(a, b).v[i], epsilon);
+    EXPECT_NEAR(scaled.v[i], Vector4f_Scaled(a, 2.5f).v[i], epsilon);
+    EXPECT_NEAR(normalized.v[i], Vector4f_Normalized(Vector4f_Subtract(a, b)).v[i], 0.001f);
+    EXPECT_NEAR(cross.v[i], Vector4f_CrossProduct(a, b).v[i], epsilon);
+    EXPECT_NEAR(intercept.v[i], expectedIntercept.v[i], 0.001f);
+    EXPECT_NEAR(assigned.v[i], Vector4f_Add(a, Vector4f_Scaled(b, 2.0f)).v[i], epsilon);
+  }
+  EXPECT_NEAR(dot, Vector4f_DotProduct(a, b), epsilon);
+  EXPECT_NEAR(length, Vector4f_Length(Vector4f_Subtract(a, b)), 0.001f);
+
+  // The cross-product inside larger expressions, and mixed with scalars and matrices
+  const Matrix4x4f m4x4 = Matrix4x4f_RotateXYZ(Rotation{ { 10.0f }, { 20.0f }, { 30.0f } });
+  const Matrix3x4f m3x4 = Matrix3x4f_FromMatrix4x4f(m4x4);
+  const Vector4f crossSum = (a ^ b) + point;
+  const Vector4f crossDifference = point - (b ^ (a - point));
+  const Vector4f crossScaled = (a - b) * Scalar1f(a ^ point) + (a ^ b) * b;
+  const Vector4f crossTransformed = m4x4 * ((a ^ b) + point);
+  const Vector4f crossAffine = m3x4 * ((a ^ b) - point);
+  const Vector4f crossNormalized = ~((a ^ b) + a * 2.0f);
+  const Scalar1f crossLength = (a ^ b) - point;
+  assigned = a;
+  assigned = (assigned ^ b) + assigned * 0.5f;
+  const Vector4f cross1 = Vector4f_CrossProduct(a, b);
+  const Vector4f expectedScaled = Vector4f_Add(Vector4f_Scaled(Vector4f_Subtract(a, b), Vector4f_DotProduct(a, point)), Vector4f_Multiply(cross1, b));
+  const Vector4f expectedNormalized = Vector4f_Normalized(Vector4f_Add(cross1, Vector4f_Scaled(a, 2.0f)));
+  for (int i = 0; i < 4; ++i)
+  {
+    EXPECT_NEAR(crossSum.v[i], Vector4f_Add(cross1, point).v[i], epsilon);
+    EXPECT_NEAR(crossDifference.v[i], Vector4f_Subtract(point, Vector4f_CrossProduct(b, Vector4f_Subtract(a, point))).v[i], epsilon);
+    EXPECT_NEAR(crossScaled.v[i], expectedScaled.v[i], 0.001f);
+    EXPECT_NEAR(crossTransformed.v[i], Vector4f_Transform(m4x4, Vector4f_Add(cross1, point)).v[i], 0.001f);
+    EXPECT_NEAR(crossAffine.v[i], Vector4f_Transform(m3x4, Vector4f_Subtract(cross1, point)).v[i], 0.001f);
+    EXPECT_NEAR(crossNormalized.v[i], expectedNormalized.v[i], 0.001f);
+    EXPECT_NEAR(assigned.v[i], Vector4f_Add(cross1, Vector4f_Scaled(a, 0.5f)).v[i], epsilon);
+  }
+  EXPECT_NEAR(crossLength, Vector4f_Length(Vector4f_Subtract(cross1, point)), 0.001f);
+
+#if defined(MATHS3D_EXPRESSION_TEMPLATES)
+  // The operators build expressions, which are only evaluated when converted, and can be kept with auto
+  static_assert(!std::is_same<decltype(a + b * 2.0f), Vector4f>::value, "the operators should return expressions");
+  static_assert(!std::is_same<decltype((a ^ b) + point), Vector4f>::value, "the products should be expressions too");
+  const auto kept = (a ^ b) * 2.0f - point;
+  const Vector4f evaluated = kept;
+  for (int i = 0; i < 4; ++i)
+  {
+    EXPECT_NEAR(evaluated.v[i], Vector4f_Subtract(Vector4f_Scaled(cross1, 2.0f), point).v[i], epsilon);
+  }
+#endif
+}
+
+// Check the products of the structured matrices match the products of the equivalent Matrix4x4f
+TEST(Maths3DTest, StructuredMatrix)
+{
+  const TranslationMatrix translation = TranslationMatrix_TranslateXYZ(Vector4f_Set(150.0f, 100.0f, 0.0f, 1.0f));
+  const DiagonalMatrix scale = DiagonalMatrix_ScaleXYZ(Vector4f_Set(300.0f, -200.0f, 1.0f, 1.0f));
+  const PerspectiveMatrix perspective = PerspectiveMatrix_PerspectiveFrustum(Degrees{ 90.0f }, 1.5f, 0.1f, 100.0f);
+  const AffineMatrix affine = AffineMatrix_FromMatrix4x4f(Matrix4x4f_Multiply(Matrix4x4f_RotateXYZ(Rotation{ Degrees{ 10.0f }, Degrees{ 45.0f }, Degrees{ 10.0f } }),
+                                                                              Matrix4x4f_TranslateXYZ(Vector4f_Set(12.0f, -1.0f, -10.0f, 1.0f))));
+  const Matrix4x4f general = Matrix4x4f_Multiply(Matrix4x4f(affine), Matrix4x4f_PerspectiveFrustum(Degrees{ 60.0f }, 1.0f, 1.0f, 10.0f));
+  const Matrix4x4f T = translation, S = scale, P = perspective, A = affine;
+
+  CheckMatrixNear(P, Matrix4x4f_PerspectiveFrustum(Degrees{ 90.0f }, 1.5f, 0.1f, 100.0f));
+  CheckMatrixNear(translation * general, Matrix4x4f_Multiply(T, general));
+  CheckMatrixNear(general * translation, Matrix4x4f_Multiply(general, T));
+  CheckMatrixNear(scale * general, Matrix4x4f_Multiply(S, general));
+  CheckMatrixNear(general * scale, Matrix4x4f_Multiply(general, S));
+  CheckMatrixNear(perspective * general, Matrix4x4f_Multiply(P, general));
+  CheckMatrixNear(general * perspective, Matrix4x4f_Multiply(general, P));
+  CheckMatrixNear(affine * general, Matrix4x4f_Multiply(A, general));
+  CheckMatrixNear(general * affine, Matrix4x4f_Multiply(general, A));
+  CheckMatrixNear(translation * translation, Matrix4x4f_Multiply(T, T));
+  CheckMatrixNear(scale * scale, Matrix4x4f_Multiply(S, S));
+  CheckMatrixNear(affine * affine, Matrix4x4f_Multiply(A, A));
+  CheckMatrixNear(translation * scale, Matrix4x4f_Multiply(T, S));
+  CheckMatrixNear(scale * translation, Matrix4x4f_Multiply(S, T));
+  CheckMatrixNear(affine * perspective, Matrix4x4f_Multiply(A, P));
+  CheckMatrixNear(perspective * affine, Matrix4x4f_Multiply(P, A));
+  // The chain from example4, which is all specialized products apart from the last
+  CheckMatrixNear(translation * scale * perspective * general,
+                  Matrix4x4f_Multiply(Matrix4x4f_Multiply(Matrix4x4f_Multiply(T, S), P), general));
+}
+
+// Check the frustum planes agree with the clip space of the matrix they are extracted from, and the classifications
+TEST(Maths3DTest, Frustum)
+{
+  const Matrix4x4f view = Matrix4x4f_Multiply(Matrix4x4f_RotateXYZ(Rotation{ Degrees{ 10.0f }, Degrees{ 45.0f }, Degrees{ 10.0f } }),
+                                              Matrix4x4f_TranslateXYZ(Vector4f_Set(12.0f, -1.0f, -10.0f, 1.0f)));
+  const Matrix4x4f viewProjection = Matrix4x4f_Multiply(Matrix4x4f_PerspectiveFrustum(Degrees{ 60.0f }, 1.5f, 1.0f, 50.0f), view);
+  const Frustum4f frustum = Frustum4f_FromMatrix4x4f(viewProjection);
+  for (int i = 0; i < 6; ++i)
+  {
+    const Vector4f& plane = frustum.planes[i];
+    EXPECT_NEAR(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z, 1.0f, 0.0001f);
+  }
+
+  // A point is inside all of the planes exactly when it is inside the clip volume
+  for (int z = -30; z <= 30; z += 3)
+  {
+    for (int y = -20; y <= 20; y += 4)
+    {
+      for (int x = -20; x <= 20; x += 4)
+      {
+        const Vector4f point = Vector4f_Set(float(x) + 0.25f, float(y) + 0.5f, float(z) + 0.75f, 1.0f);
+        const Vector4f clip = Vector4f_Transform(viewProjection, point);
+        Scalar1f nearestPlane = 1000.0f;
+        for (int i = 0; i < 6; ++i)
+        {
+          nearestPlane = fminf(nearestPlane, Frustum4f_PlaneDistance(frustum.planes[i], point));
+        }
+        const Scalar1f nearestClip = fminf(fminf(clip.w - fabsf(clip.x), clip.w - fabsf(clip.y)), clip.w - fabsf(clip.z));
+        if (fabsf(nearestPlane) > 0.01f)
+        {
+          EXPECT_EQ(nearestPlane > 0.0f, nearestClip > 0.0f);
+        }
+        // A sphere inside the frustum with the distance to the nearest plane as its radius just touches that plane
+        if (nearestPlane > 0.01f)
+        {
+          EXPECT_EQ(int(Frustum4f_ClassifySphere(frustum, point, nearestPlane * 0.9f)), int(Containment::Inside));
+          EXPECT_EQ(int(Frustum4f_ClassifySphere(frustum, point, nearestPlane * 1.1f)), int(Containment::Intersecting));
+        }
+        else if (nearestPlane < -0.01f)
+        {
+          EXPECT_EQ(int(Frustum4f_ClassifySphere(frustum, point, -nearestPlane * 0.9f)), int(Containment::Outside));
+        }
+      }
+    }
+  }
+
+  // Boxes centered on the camera axis, across the far plane and past the far plane, with an identity view
+  const Frustum4f camera = Frustum4f_FromMatrix4x4f(Matrix4x4f_PerspectiveFrustum(Degrees{ 90.0f }, 1.0f, 1.0f, 50.0f));
+  EXPECT_EQ(int(Frustum4f_ClassifyAabb(camera, Vector4f_Set(-1.0f, -1.0f, -11.0f, 1.0f), Vector4f_Set(1.0f, 1.0f, -9.0f, 1.0f))), int(Containment::Inside));
+  EXPECT_EQ(int(Frustum4f_ClassifyAabb(camera, Vector4f_Set(-1.0f, -1.0f, -51.0f, 1.0f), Vector4f_Set(1.0f, 1.0f, -49.0f, 1.0f))), int(Containment::Intersecting));
+  EXPECT_EQ(int(Frustum4f_ClassifyAabb(camera, Vector4f_Set(-1.0f, -1.0f, -55.0f, 1.0f), Vector4f_Set(1.0f, 1.0f, -53.0f, 1.0f))), int(Containment::Outside));
+  EXPECT_EQ(int(Frustum4f_ClassifyAabb(camera, Vector4f_Set(12.0f, -1.0f, -11.0f, 1.0f), Vector4f_Set(14.0f, 1.0f, -9.0f, 1.0f))), int(Containment::Outside));
+  EXPECT_EQ(int(Frustum4f_ClassifyAabb(camera, Vector4f_Set(-1.0f, -1.0f, 1.0f, 1.0f), Vector4f_Set(1.0f, 1.0f, 2.0f, 1.0f))), int(Containment::Outside));
+  EXPECT_EQ(int(Frustum4f_ClassifySphere(camera, Vector4f_Set(10.0f, 0.0f, -10.0f, 1.0f), 1.0f)), int(Containment::Intersecting));
+}
+
+// Check the bounding volumes contain what they bound, and the transformed boxes match transforming the corners
+TEST(Maths3DTest, BoundingVolume)
+{
+  const Vector4f a = Vector4f_Set(1.0f, -2.0f, 3.0f, -4.0f);
+  const Vector4f b = Vector4f_Set(-1.0f, 2.0f, 5.0f, -6.0f);
+  CheckVectorNear(Vector4f_Minimum(a, b), Vector4f_Set(-1.0f, -2.0f, 3.0f, -6.0f));
+  CheckVectorNear(Vector4f_Maximum(a, b), Vector4f_Set(1.0f, 2.0f, 5.0f, -4.0f));
+  CheckVectorNear(Vector4f_Absolute(a), Vector4f_Set(1.0f, 2.0f, 3.0f, 4.0f));
+
+  Aabb4f box = Aabb4f_Empty();
+  box = Aabb4f_AddPoint(box, Vector4f_Set(1.0f, 2.0f, -3.0f, 1.0f));
+  CheckVectorNear(box.minimum, box.maximum);
+  box = Aabb4f_Merge(box, Aabb4f_Set(Vector4f_Set(-1.0f, 3.0f, -4.0f, 1.0f), Vector4f_Set(0.0f, 5.0f, -2.0f, 1.0f)));
+  CheckVectorNear(box.minimum, Vector4f_Set(-1.0f, 2.0f, -4.0f, 1.0f));
+  CheckVectorNear(box.maximum, Vector4f_Set(1.0f, 5.0f, -2.0f, 1.0f));
+  CheckVectorNear(Aabb4f_Center(box), Vector4f_Set(0.0f, 3.5f, -3.0f, 1.0f));
+  CheckVectorNear(Aabb4f_Extent(box), Vector4f_Set(1.0f, 1.5f, 1.0f, 0.0f));
+
+  // The transformed box is exactly the bounds of the transformed corners
+  const Matrix4x4f transform = Matrix4x4f_Multiply(Matrix4x4f_TranslateXYZ(Vector4f_Set(12.0f, -1.0f, -10.0f, 1.0f)),
+                                                   Matrix4x4f_Multiply(Matrix4x4f_RotateXYZ(Rotation{ Degrees{ 10.0f }, Degrees{ 45.0f }, Degrees{ 30.0f } }),
+                                                                       Matrix4x4f_ScaleXYZ(Vector4f_Set(2.0f, 3.0f, 0.5f, 1.0f))));
+  Aabb4f corners = Aabb4f_Empty();
+  for (int i = 0; i < 8; ++i)
+  {
+    const Vector4f corner = Vector4f_Set((i & 1) ? box.maximum.x : box.minimum.x, (i & 2) ? box.maximum.y : box.minimum.y,
+                                         (i & 4) ? box.maximum.z : box.minimum.z, 1.0f);
+    corners = Aabb4f_AddPoint(corners, Vector4f_Transform(transform, corner));
+  }
+  const Aabb4f transformed = Aabb4f_Transform(transform, box);
+  CheckVectorNear(transformed.minimum, corners.minimum);
+  CheckVectorNear(transformed.maximum, corners.maximum);
+
+  // The sphere of a box passes through its corners, and is scaled by the largest scale of the transform
+  const BoundingSphere4f sphere = BoundingSphere4f_FromAabb4f(box);
+  EXPECT_NEAR(sphere.radius, sqrtf(1.0f + 2.25f + 1.0f), epsilon);
+  const BoundingSphere4f transformedSphere = BoundingSphere4f_Transform(transform, sphere);
+  EXPECT_NEAR(transformedSphere.radius, sphere.radius * 3.0f, 0.0001f);
+  CheckVectorNear(transformedSphere.center, Vector4f_Transform(transform, sphere.center));
+
+  // A non-uniform scale after a rotation stretches diagonals by more than any row length, and the transformed
+  // sphere still contains the transformed points on the surface of the sphere
+  const Matrix4x4f scaleAfterRotate = Matrix4x4f_Multiply(Matrix4x4f_ScaleXYZ(Vector4f_Set(2.0f, 1.0f, 1.0f, 1.0f)),
+                                                          Matrix4x4f_RotateXYZ(Rotation{ Degrees{ 0.0f }, Degrees{ 0.0f }, Degrees{ 45.0f } }));
+  EXPECT_TRUE(BoundingSphere4f_MaximumScale(scaleAfterRotate) >= 2.0f - epsilon);
+  const BoundingSphere4f unitSphere = BoundingSphere4f_Set(Vector4f_Set(1.0f, -2.0f, 0.5f, 1.0f), 1.0f);
+  const BoundingSphere4f stretchedSphere = BoundingSphere4f_Transform(scaleAfterRotate, unitSphere);
+  for (int i = 0; i < 64; ++i)
+  {
+    const Scalar1f angle = float(i) * 0.1f, elevation = float(i % 7) * 0.4f - 1.2f;
+    const Vector4f direction = Vector4f_Set(cosf(angle) * cosf(elevation), sinf(angle) * cosf(elevation), sinf(elevation), 0.0f);
+    const Vector4f point = Vector4f_Transform(scaleAfterRotate, Vector4f_Add(unitSphere.center, direction));
+    EXPECT_TRUE(Vector4f_Length(Vector4f_Subtract(point, stretchedSphere.center)) <= stretchedSphere.radius + epsilon);
+  }
+  // Rotations and uniform scales are still exact
+  const Matrix4x4f uniform = Matrix4x4f_Multiply(Matrix4x4f_ScaleXYZ(Vector4f_Set(3.0f, 3.0f, 3.0f, 1.0f)),
+                                                 Matrix4x4f_RotateXYZ(Rotation{ Degrees{ 20.0f }, Degrees{ 45.0f }, Degrees{ 70.0f } }));
+  EXPECT_NEAR(BoundingSphere4f_MaximumScale(uniform), 3.0f, 0.0001f);
+
+  // A merged sphere contains both, and a sphere inside another merges to the outer one
+  const BoundingSphere4f sphere1 = BoundingSphere4f_Set(Vector4f_Set(1.0f, 2.0f, 3.0f, 1.0f), 2.0f);
+  const BoundingSphere4f sphere2 = BoundingSphere4f_Set(Vector4f_Set(-4.0f, 2.0f, 3.0f, 1.0f), 1.0f);
+  const BoundingSphere4f merged = BoundingSphere4f_Merge(sphere1, sphere2);
+  EXPECT_NEAR(merged.radius, 4.0f, epsilon);
+  CheckVectorNear(merged.center, Vector4f_Set(-1.0f, 2.0f, 3.0f, 1.0f));
+  const BoundingSphere4f inner = BoundingSphere4f_Set(Vector4f_Set(1.5f, 2.0f, 3.0f, 1.0f), 0.5f);
+  EXPECT_NEAR(BoundingSphere4f_Merge(inner, sphere1).radius, sphere1.radius, epsilon);
+  EXPECT_NEAR(BoundingSphere4f_Merge(sphere1, inner).radius, sphere1.radius, epsilon);
+
+  const Frustum4f frustum = Frustum4f_FromMatrix4x4f(Matrix4x4f_PerspectiveFrustum(Degrees{ 90.0f }, 1.0f, 1.0f, 50.0f));
+  EXPECT_EQ(int(Frustum4f_ClassifySphere(frustum, BoundingSphere4f_Set(Vector4f_Set(0.0f, 0.0f, -10.0f, 1.0f), 1.0f))), int(Containment::Inside));
+  EXPECT_EQ(int(Frustum4f_ClassifyAabb(frustum, box)), int(Containment::Intersecting));
+}
+
+// Check the ray intersections, including rays which start inside and the watertightness of the triangle test
+TEST(Maths3DTest, Ray)
+{
+  const Vector4f axisZ = Vector4f_Set(0.0f, 0.0f, 1.0f, 0.0f);
+  const BoundingSphere4f sphere = BoundingSphere4f_Set(Vector4f_Set(0.0f, 0.0f, 0.0f, 1.0f), 2.0f);
+  RayHit4f hit = RayHit4f_None();
+  EXPECT_TRUE(Ray4f_IntersectSphere(Ray4f_Set(Vector4f_Set(0.0f, 0.0f, -10.0f, 1.0f), axisZ), sphere, 3, hit));
+  EXPECT_NEAR(hit.t, 8.0f, 0.0001f);
+  EXPECT_EQ(hit.primitive, 3u);
+  // A farther hit doesn't replace a nearer one
+  hit.t = 5.0f;
+  EXPECT_FALSE(Ray4f_IntersectSphere(Ray4f_Set(Vector4f_Set(0.0f, 0.0f, -10.0f, 1.0f), axisZ), sphere, 4, hit));
+  EXPECT_EQ(hit.primitive, 3u);
+  hit = RayHit4f_None();
+  EXPECT_TRUE(Ray4f_IntersectSphere(Ray4f_Set(Vector4f_Set(0.0f, 0.5f, 0.0f, 1.0f), axisZ), sphere, 1, hit));
+  CheckVectorNear(Ray4f_PointAt(Ray4f_Set(Vector4f_Set(0.0f, 0.5f, 0.0f, 1.0f), axisZ), hit.t), Vector4f_Set(0.0f, 0.5f, sqrtf(3.75f), 1.0f));
+  hit = RayHit4f_None();
+  EXPECT_FALSE(Ray4f_IntersectSphere(Ray4f_Set(Vector4f_Set(0.0f, 0.0f, 10.0f, 1.0f), axisZ), sphere, 1, hit));
+  EXPECT_FALSE(Ray4f_IntersectSphere(Ray4f_Set(Vector4f_Set(0.0f, 2.5f, -10.0f, 1.0f), axisZ), sphere, 1, hit));
+  EXPECT_EQ(hit.primitive, RayHit4f_NoPrimitive);
+
+  // Boxes, including rays parallel to the slabs and starting inside
+  const Aabb4f box = Aabb4f_Set(Vector4f_Set(-1.0f, -1.0f, -1.0f, 1.0f), Vector4f_Set(1.0f, 1.0f, 1.0f, 1.0f));
+  hit = RayHit4f_None();
+  EXPECT_TRUE(Ray4f_IntersectAabb(Ray4f_Set(Vector4f_Set(0.5f, -0.5f, -5.0f, 1.0f), axisZ), box, 2, hit));
+  EXPECT_NEAR(hit.t, 4.0f, 0.0001f);
+  hit = RayHit4f_None();
+  EXPECT_TRUE(Ray4f_IntersectAabb(Ray4f_Set(Vector4f_Set(-5.0f, 0.5f, 0.0f, 1.0f), Vector4f_Set(2.0f, 0.0f, 0.0f, 0.0f)), box, 2, hit));
+  EXPECT_NEAR(hit.t, 2.0f, 0.0001f);
+  hit = RayHit4f_None();
+  EXPECT_TRUE(Ray4f_IntersectAabb(Ray4f_Set(Vector4f_Set(0.0f, 0.0f, 0.0f, 1.0f), Vector4f_Set(0.0f, -1.0f, 0.0f, 0.0f)), box, 2, hit));
+  EXPECT_NEAR(hit.t, 1.0f, 0.0001f);
+  hit = RayHit4f_None();
+  EXPECT_FALSE(Ray4f_IntersectAabb(Ray4f_Set(Vector4f_Set(0.0f, 2.0f, -5.0f, 1.0f), axisZ), box, 2, hit));
+  EXPECT_FALSE(Ray4f_IntersectAabb(Ray4f_Set(Vector4f_Set(0.0f, 0.0f, 5.0f, 1.0f), axisZ), box, 2, hit));
+  EXPECT_FALSE(Ray4f_IntersectAabb(Ray4f_Set(Vector4f_Set(-5.0f, 0.0f, -5.0f, 1.0f), Vector4f_Set(1.0f, 0.0f, -1.0f, 0.0f)), box, 2, hit));
+
+  // A triangle hit gives the barycentric weights of the second and third vertices
+  const Vector4f a = Vector4f_Set(0.0f, 0.0f, 0.0f, 1.0f);
+  const Vector4f b = Vector4f_Set(1.0f, 0.0f, 0.0f, 1.0f);
+  const Vector4f c = Vector4f_Set(0.0f, 1.0f, 0.0f, 1.0f);
+  const Vector4f d = Vector4f_Set(1.0f, 1.0f, 0.0f, 1.0f);
+  hit = RayHit4f_None();
+  EXPECT_TRUE(Ray4f_IntersectTriangle(Ray4f_Set(Vector4f_Set(0.25f, 0.5f, 5.0f, 1.0f), Vector4f_Set(0.0f, 0.0f, -1.0f, 0.0f)), a, b, c, 7, hit));
+  EXPECT_NEAR(hit.t, 5.0f, 0.0001f);
+  EXPECT_NEAR(hit.u, 0.25f, 0.0001f);
+  EXPECT_NEAR(hit.v, 0.5f, 0.0001f);
+  EXPECT_EQ(hit.primitive, 7u);
+  hit = RayHit4f_None();
+  EXPECT_TRUE(Ray4f_IntersectTriangle(Ray4f_Set(Vector4f_Set(0.25f, 0.5f, -5.0f, 1.0f), axisZ), a, b, c, 7, hit));
+  EXPECT_FALSE(Ray4f_IntersectTriangle(Ray4f_Set(Vector4f_Set(0.75f, 0.5f, 5.0f, 1.0f), Vector4f_Set(0.0f, 0.0f, -1.0f, 0.0f)), a, b, c, 7, hit));
+  EXPECT_FALSE(Ray4f_IntersectTriangle(Ray4f_Set(Vector4f_Set(0.25f, 0.5f, 5.0f, 1.0f), axisZ), a, b, c, 7, hit));
+
+  // Rays through the shared edge of two triangles of a quad hit at least one of them, from any direction
+  int misses = 0;
+  for (int i = 0; i <= 256; ++i)
+  {
+    const Scalar1f s = float(i) / 256.0f;
+    const Vector4f onEdge = Vector4f_Set(1.0f - s, s, 0.0f, 1.0f);
+    const Vector4f direction = Vector4f_Set(0.3f - s * 0.7f, 0.7f * s - 0.2f, -1.0f - s, 0.0f);
+    const Ray4f ray = Ray4f_Set(Vector4f_Subtract(onEdge, Vector4f_Scaled(direction, 3.0f + s)), direction);
+    RayHit4f first = RayHit4f_None(), second = RayHit4f_None();
+    const bool hitFirst = Ray4f_IntersectTriangle(ray, a, b, c, 0, first);
+    const bool hitSecond = Ray4f_IntersectTriangle(ray, b, d, c, 1, second);
+    misses += (hitFirst || hitSecond) ? 0 : 1;
+  }
+  EXPECT_EQ(misses, 0);
 }
 
 // Exercise all the extension functions
@@ -251,20 +936,2219 @@ TEST(Maths3DTest, Extensions)
   }
 }
 
-// Benchmark test designed to measure the performance of the generated code
-BENCHMARK(Maths3DTest, Transform, iterations)
+// Compares each of the implementations of the stream transform against the SSE one for a given set of template switches
+template <bool translate, bool divideByW, bool aligned, int step>
+void CheckTransformStreamImplementations(const Matrix4x4f& xform)
+{
+  const unsigned count = 19; // odd count so the remainder handling is tested too
+  alignas(64) float input[count * step];
+  alignas(64) float expected[count * step];
+  alignas(64) float output[count * step];
+  for (unsigned i = 0; i < count * step; ++i)
+  {
+    input[i] = (i % 4 == 3) ? 1.0f : float(i % 13) - 6.0f;
+    expected[i] = output[i] = 0.0f;
+  }
+  Vector4f_SSETransformStreamGeneric<translate,divideByW,aligned,step,aligned,step>(expected, input, count, xform);
+  for (int isa = 0; isa <= int(InstructionSet::AVX512); ++isa)
+  {
+    if (InstructionSet_IsSupported(InstructionSet(isa)))
+    {
+      Vector4f_SelectTransformStream<translate,divideByW,aligned,step,aligned,step>(InstructionSet(isa))(output, input, count, xform);
+      for (unsigned i = 0; i < count * step; ++i)
+      {
+        EXPECT_NEAR(output[i], expected[i], 0.0001f);
+      }
+    }
+  }
+}
+
+// Check the scalar, AVX2 and AVX-512 implementations give the same results as the SSE implementation
+TEST(Maths3DTest, WideExtensions)
+{
+  Matrix4x4f xform = Matrix4x4f_Multiply(Matrix4x4f_PerspectiveFrustum(Degrees{60.0}, 1.0f, 0.1, 10000.0),
+                                         Matrix4x4f_TranslateXYZ(Vector4f_Set(0.5f, 0.25f, -100.0f, 1.0f)));
+  CheckTransformStreamImplementations<true,false,false,4>(xform);
+  CheckTransformStreamImplementations<true,true,false,4>(xform);
+  CheckTransformStreamImplementations<false,false,false,4>(xform);
+  CheckTransformStreamImplementations<true,false,true,4>(xform);
+  CheckTransformStreamImplementations<true,true,true,8>(xform);
+  CheckTransformStreamImplementations<false,false,false,8>(xform);
+  CheckTransformStreamImplementations<true,false,false,5>(xform);
+}
+
+// Check the dispatch picks a supported instruction set and that the dispatched kernels work
+TEST(Maths3DTest, Dispatch)
 {
+  EXPECT_EQ(InstructionSet_IsSupported(InstructionSet::Scalar), true);
+  EXPECT_EQ(InstructionSet_IsSupported(InstructionSet_Active()), true);
+  EXPECT_EQ(InstructionSet_Active(), InstructionSet_Detect());
+
   Matrix4x4f modelViewProjection = Matrix4x4f_PerspectiveFrustum(Degrees{15.0}, 1.0f, 0.1, 10000.0);
-  Vector4f vecs[256];
-  Vector4f vecOut[256];
-  for (int i = 0; i < 256; ++i)
+  Vector4f vecs[16];
+  Vector4f vecOut[16];
+  for (int i = 0; i < 16; ++i)
   {
     vecs[i] = Vector4f_Set(i, i, i, 1.0);
   }
+  Vector4f_TransformStream(vecOut, vecs, modelViewProjection);
+  for (int i = 0; i < 16; ++i)
+  {
+    EXPECT_NEAR(vecOut[i].x, i * 7.595754, epsilon);
+    EXPECT_NEAR(vecOut[i].y, i * 7.595754, epsilon);
+    EXPECT_NEAR(vecOut[i].z, i * -1.00002 - 0.200002, epsilon);
+    EXPECT_NEAR(vecOut[i].w, i * -1.00000, epsilon);
+  }
+  Vector4f_TransformNormalStream(vecOut, vecs, modelViewProjection);
+  for (int i = 0; i < 16; ++i)
+  {
+    EXPECT_NEAR(vecOut[i].z, i * -1.00002, epsilon);
+  }
+}
 
-  for (int i = 0; i < iterations; ++i)
+// Check the runtime sized stream transforms for different alignments, counts and strides
+TEST(Maths3DTest, RuntimeExtensions)
+{
+  Matrix4x4f xform = Matrix4x4f_Multiply(Matrix4x4f_PerspectiveFrustum(Degrees{60.0}, 1.0f, 0.1, 10000.0),
+                                         Matrix4x4f_TranslateXYZ(Vector4f_Set(0.5f, 0.25f, -100.0f, 1.0f)));
+  const unsigned maxCount = 37;
+  const float guard = 12345.0f;
+  alignas(64) float input[8 * maxCount + 8];
+  alignas(64) float output[8 * maxCount + 8];
+  for (unsigned i = 0; i < 8 * maxCount + 8; ++i)
   {
-    Vector4f_SSETransformStream(vecOut, vecs, modelViewProjection);
+    input[i] = (i % 4 == 3) ? 1.0f : float(i % 11) - 5.0f;
+  }
+  // Try each offset in floats from a cache line boundary for the output and input, and various strides
+  for (unsigned count = 0; count <= maxCount; count += 3)
+  {
+    for (unsigned offset = 0; offset < 8; ++offset)
+    {
+      for (unsigned stride = 4; stride <= 8; stride += 2)
+      {
+        for (unsigned i = 0; i < 8 * maxCount + 8; ++i)
+        {
+          output[i] = guard;
+        }
+        const float* in = input + (offset * 3) % 8;
+        float* out = output + offset;
+        Vector4f_TransformCoordStream(out, stride, in, stride, count, xform);
+        for (unsigned i = 0; i < count; ++i)
+        {
+          Vector4f vec = Vector4f_Set(in[i*stride+0], in[i*stride+1], in[i*stride+2], 1.0f); // w is treated as 1
+          Vector4f expected = Vector4f_Transform(xform, vec);
+          for (int j = 0; j < 4; ++j)
+          {
+            EXPECT_NEAR(out[i*stride+j], expected.v[j] / expected.w, 0.0001f);
+          }
+        }
+        // Check nothing was written to past the end of the output
+        EXPECT_EQ(output[offset + count * stride], guard);
+      }
+    }
+  }
+
+  // Check the pointer overloads with a count not known at compile time
+  std::vector<Vector4f> vecs(maxCount);
+  std::vector<Vector4f> vecOut(maxCount);
+  for (unsigned i = 0; i < maxCount; ++i)
+  {
+    vecs[i] = Vector4f_Set(i, i, i, 1.0);
+  }
+  Vector4f_TransformStream(vecOut.data(), vecs.data(), maxCount, xform);
+  for (unsigned i = 0; i < maxCount; ++i)
+  {
+    Vector4f expected = Vector4f_Transform(xform, vecs[i]);
+    for (int j = 0; j < 4; ++j)
+    {
+      EXPECT_NEAR(vecOut[i].v[j], expected.v[j], 0.001f);
+    }
+  }
+  Vector4f_TransformNormalStream(vecOut.data(), vecs.data(), maxCount, xform);
+  for (unsigned i = 0; i < maxCount; ++i)
+  {
+    Vector4f expected = Vector4f_Transform(xform, Vector4f_SetW(vecs[i], 0.0f));
+    for (int j = 0; j < 4; ++j)
+    {
+      EXPECT_NEAR(vecOut[i].v[j], expected.v[j], 0.001f);
+    }
+  }
+}
+
+// Check the parallel stream transform gives the same results as the serial one
+TEST(Maths3DTest, ParallelExtensions)
+{
+  Matrix4x4f xform = Matrix4x4f_PerspectiveFrustum(Degrees{60.0}, 1.0f, 0.1, 10000.0);
+  const unsigned count = 100003;
+  std::vector<Vector4f> vecs(count);
+  std::vector<Vector4f> expected(count);
+  std::vector<Vector4f> vecOut(count);
+  for (unsigned i = 0; i < count; ++i)
+  {
+    vecs[i] = Vector4f_Set(i % 101, i % 103, i % 107, 1.0);
+  }
+  Vector4f_SSETransformStreamGeneric<true,true,false,4,false,4>(expected[0].v, vecs[0].v, count, xform);
+
+  // Use small chunks and more threads than there may be cores to make sure the chunks get shared out
+  ParallelConfig config = { 1000, 4096, 8 };
+  Vector4f_ParallelTransformStreamGeneric<true,true,false,4,false,4>(vecOut[0].v, vecs[0].v, count, xform, config);
+  for (unsigned i = 0; i < count; ++i)
+  {
+    for (int j = 0; j < 4; ++j)
+    {
+      EXPECT_NEAR(vecOut[i].v[j], expected[i].v[j], 0.0001f);
+    }
+  }
+
+  // Chunks smaller than a vector, or of no size, are still at least 16 vectors
+  for (unsigned chunkBytes = 0; chunkBytes <= 4; chunkBytes += 4)
+  {
+    const ParallelConfig tinyChunks = { 0, chunkBytes, 4 };
+    Vector4f_ParallelTransformStreamGeneric<true,true,false,4,false,4>(vecOut[0].v, vecs[0].v, 1000, xform, tinyChunks);
+    for (unsigned i = 0; i < 1000; i += 7)
+    {
+      EXPECT_NEAR(vecOut[i].x, expected[i].x, 0.0001f);
+    }
+  }
+  EXPECT_EQ(ParallelConfig_ChunkSize(ParallelConfig{ 0, 0, 4 }, sizeof(Vector4f)), 16u);
+  EXPECT_EQ(ParallelConfig_ChunkSize(ParallelConfig{ 0, 4096, 4 }, sizeof(Vector4f)), 256u);
+
+  // Below the threshold it should be done serially, but still give the same results
+  config.serialThreshold = count + 1;
+  Vector4f_ParallelTransformStreamGeneric<true,true,false,4,false,4>(vecOut[0].v, vecs[0].v, count, xform, config);
+  for (unsigned i = 0; i < count; i += 97)
+  {
+    EXPECT_NEAR(vecOut[i].x, expected[i].x, 0.0001f);
+  }
+}
+
+// Check the structure of arrays stream transforms and conversions against the array of structures ones
+TEST(Maths3DTest, SoAExtensions)
+{
+  Matrix4x4f xform = Matrix4x4f_Multiply(Matrix4x4f_PerspectiveFrustum(Degrees{60.0}, 1.0f, 0.1, 10000.0),
+                                         Matrix4x4f_TranslateXYZ(Vector4f_Set(0.5f, 0.25f, -100.0f, 1.0f)));
+  const unsigned count = 21;
+  Vector4f vecs[count];
+  Vector4f expected[count];
+  Vector4f vecOut[count];
+  for (unsigned i = 0; i < count; ++i)
+  {
+    vecs[i] = Vector4f_Set(float(i % 5) - 2.0f, float(i % 7), float(i % 3) + 0.5f, 1.0f);
+  }
+  float x[count], y[count], z[count], w[count];
+  Vector4f_AoSToSoA(x, y, z, w, vecs, count);
+  Vector4f_SoAToAoS(vecOut, x, y, z, w, count);
+  for (unsigned i = 0; i < count; ++i)
+  {
+    for (int j = 0; j < 4; ++j)
+    {
+      EXPECT_EQ(vecOut[i].v[j], vecs[i].v[j]);
+    }
+  }
+
+  Vector4f_SSETransformStreamGeneric<true,true,false,4,false,4>(expected[0].v, vecs[0].v, count, xform);
+  for (int isa = 0; isa <= int(InstructionSet::AVX512); ++isa)
+  {
+    if (InstructionSet_IsSupported(InstructionSet(isa)))
+    {
+      float ox[count], oy[count], oz[count], ow[count];
+      Vector4f_SelectTransformStreamSoA<true,true>(InstructionSet(isa))(ox, oy, oz, ow, x, y, z, count, xform);
+      Vector4f_SoAToAoS(vecOut, ox, oy, oz, ow, count);
+      for (unsigned i = 0; i < count; ++i)
+      {
+        for (int j = 0; j < 4; ++j)
+        {
+          EXPECT_NEAR(vecOut[i].v[j], expected[i].v[j], 0.0001f);
+        }
+      }
+    }
+  }
+
+  // Normals in place, and without the w components
+  Vector4f_SSETransformStreamGeneric<false,false,false,4,false,4>(expected[0].v, vecs[0].v, count, xform);
+  Vector4f_DispatchTransformStreamSoA<false,false>(x, y, z, nullptr, x, y, z, count, xform);
+  Vector4f_SoAToAoS(vecOut, x, y, z, nullptr, count);
+  for (unsigned i = 0; i < count; ++i)
+  {
+    for (int j = 0; j < 3; ++j)
+    {
+      EXPECT_NEAR(vecOut[i].v[j], expected[i].v[j], 0.0001f);
+    }
+    EXPECT_EQ(vecOut[i].w, 1.0f);
+  }
+}
+
+// Check the packed Vector3f stream transforms and conversions against the Vector4f ones
+TEST(Maths3DTest, PackedExtensions)
+{
+  Matrix4x4f xform = Matrix4x4f_Multiply(Matrix4x4f_PerspectiveFrustum(Degrees{60.0}, 1.0f, 0.1, 10000.0),
+                                         Matrix4x4f_TranslateXYZ(Vector4f_Set(0.5f, 0.25f, -100.0f, 1.0f)));
+  const unsigned maxCount = 11;
+  const float guard = 12345.0f;
+  Vector4f vecs[maxCount];
+  Vector4f expected[maxCount];
+  Vector3f packed[maxCount];
+  for (unsigned i = 0; i < maxCount; ++i)
+  {
+    vecs[i] = Vector4f_Set(float(i % 5) - 2.0f, float(i % 7), float(i % 3) + 0.5f, 1.0f);
+    packed[i] = Vector3f_FromVector4f(vecs[i]);
+  }
+  Vector4f_SSETransformStreamGeneric<true,true,false,4,false,4>(expected[0].v, vecs[0].v, maxCount, xform);
+  for (unsigned count = 0; count <= maxCount; ++count)
+  {
+    for (int isa = 0; isa <= int(InstructionSet::AVX512); ++isa)
+    {
+      if (InstructionSet_IsSupported(InstructionSet(isa)))
+      {
+        Vector3f out3[maxCount + 1];
+        Vector4f out4[maxCount + 1];
+        out3[count] = Vector3f_Set(guard, guard, guard);
+        out4[count] = Vector4f_Replicate(guard);
+        Vector3f_SelectTransformStream<true,true,3>(InstructionSet(isa))(out3[0].v, packed[0].v, count, xform);
+        Vector3f_SelectTransformStream<true,true,4>(InstructionSet(isa))(out4[0].v, packed[0].v, count, xform);
+        for (unsigned i = 0; i < count; ++i)
+        {
+          for (int j = 0; j < 3; ++j)
+          {
+            EXPECT_NEAR(out3[i].v[j], expected[i].v[j], 0.0001f);
+          }
+          for (int j = 0; j < 4; ++j)
+          {
+            EXPECT_NEAR(out4[i].v[j], expected[i].v[j], 0.0001f);
+          }
+        }
+        // Check nothing was written to past the end of the outputs
+        EXPECT_EQ(out3[count].x, guard);
+        EXPECT_EQ(out4[count].x, guard);
+      }
+    }
+  }
+
+  // Normals transformed in place
+  Vector3f normals[maxCount];
+  Vector3f_UnpackStream(expected, packed, maxCount, 0.0f);
+  Vector4f_SSETransformStreamGeneric<false,false,false,4,false,4>(expected[0].v, expected[0].v, maxCount, xform);
+  for (unsigned i = 0; i < maxCount; ++i)
+  {
+    normals[i] = packed[i];
+  }
+  Vector3f_TransformNormalStream(normals, normals, maxCount, xform);
+  for (unsigned i = 0; i < maxCount; ++i)
+  {
+    for (int j = 0; j < 3; ++j)
+    {
+      EXPECT_NEAR(normals[i].v[j], expected[i].v[j], 0.0001f);
+    }
+  }
+
+  // Round trip through the conversions
+  Vector4f unpacked[maxCount];
+  Vector3f repacked[maxCount];
+  Vector3f_UnpackStream(unpacked, packed, maxCount, 1.0f);
+  Vector4f_PackStream(repacked, unpacked, maxCount);
+  for (unsigned i = 0; i < maxCount; ++i)
+  {
+    for (int j = 0; j < 4; ++j)
+    {
+      EXPECT_EQ(unpacked[i].v[j], vecs[i].v[j]);
+    }
+    for (int j = 0; j < 3; ++j)
+    {
+      EXPECT_EQ(repacked[i].v[j], packed[i].v[j]);
+    }
+  }
+}
+
+TEST(Maths3DTest, HalfExtensions)
+{
+  // Conversions of some values with known half precision encodings
+  EXPECT_EQ(Half1h_FromScalar1f(1.0f), 0x3C00);
+  EXPECT_EQ(Half1h_FromScalar1f(-2.0f), 0xC000);
+  EXPECT_EQ(Half1h_FromScalar1f(65504.0f), 0x7BFF);        // largest half
+  EXPECT_EQ(Half1h_FromScalar1f(65520.0f), 0x7C00);        // rounds up to infinity
+  EXPECT_EQ(Half1h_FromScalar1f(5.9604644775390625e-8f), 0x0001); // smallest denormal
+  EXPECT_EQ(Half1h_FromScalar1f(1.0f + 1.0f / 2048.0f), 0x3C00);   // ties round to even
+  EXPECT_EQ(Scalar1f_FromHalf1h(0x3555), 0.333251953125f);
+  EXPECT_EQ(Scalar1f_FromHalf1h(0x0200), 3.0517578125e-5f);
+
+  Matrix4x4f xform = Matrix4x4f_Multiply(Matrix4x4f_PerspectiveFrustum(Degrees{60.0}, 1.0f, 0.1, 10000.0),
+                                         Matrix4x4f_TranslateXYZ(Vector4f_Set(0.5f, 0.25f, -100.0f, 1.0f)));
+  const unsigned maxCount = 11;
+  const Half1h guard = 0x1234;
+  Vector4f vecs[maxCount];
+  Vector4h halves[maxCount];
+  Vector4f expected[maxCount];
+  for (unsigned i = 0; i < maxCount; ++i)
+  {
+    vecs[i] = Vector4f_Set(float(i % 5) - 2.0f, float(i % 7) * 0.25f, float(i % 3) + 0.5f, 1.0f);
+    halves[i] = Vector4h_FromVector4f(vecs[i]);  // these values are all exact in half precision
+  }
+  Vector4f_SSETransformStreamGeneric<true,true,false,4,false,4>(expected[0].v, vecs[0].v, maxCount, xform);
+  for (unsigned count = 0; count <= maxCount; ++count)
+  {
+    for (int isa = 0; isa <= int(InstructionSet::AVX512); ++isa)
+    {
+      if (InstructionSet_IsSupported(InstructionSet(isa)))
+      {
+        Vector4h outHH[maxCount + 1];
+        Vector4f outHF[maxCount + 1];
+        Vector4h outFH[maxCount + 1];
+        outHH[count].x = outFH[count].x = guard;
+        outHF[count].x = Scalar1f_FromHalf1h(guard);
+        Vector4h_SelectTransformStream<true,true,true,true>(InstructionSet(isa))(outHH, halves, count, xform);
+        Vector4h_SelectTransformStream<true,true,false,true>(InstructionSet(isa))(outHF, halves, count, xform);
+        Vector4h_SelectTransformStream<true,true,true,false>(InstructionSet(isa))(outFH, vecs, count, xform);
+        for (unsigned i = 0; i < count; ++i)
+        {
+          for (int j = 0; j < 4; ++j)
+          {
+            EXPECT_NEAR(Scalar1f_FromHalf1h(outHH[i].v[j]), expected[i].v[j], 0.001f);
+            EXPECT_NEAR(outHF[i].v[j], expected[i].v[j], 0.0001f);
+            EXPECT_EQ(outFH[i].v[j], Half1h_FromScalar1f(outHF[i].v[j]));
+          }
+        }
+        // Check nothing was written to past the end of the outputs
+        EXPECT_EQ(outHH[count].x, guard);
+        EXPECT_EQ(outHF[count].x, Scalar1f_FromHalf1h(guard));
+        EXPECT_EQ(outFH[count].x, guard);
+      }
+    }
+  }
+
+  // Round trip through the stream conversions
+  Vector4f unpacked[maxCount];
+  Vector4h repacked[maxCount];
+  Vector4h_UnpackStream(unpacked, halves, maxCount);
+  Vector4f_PackHalfStream(repacked, unpacked, maxCount);
+  for (unsigned i = 0; i < maxCount; ++i)
+  {
+    for (int j = 0; j < 4; ++j)
+    {
+      EXPECT_EQ(unpacked[i].v[j], vecs[i].v[j]);
+      EXPECT_EQ(repacked[i].v[j], halves[i].v[j]);
+    }
+  }
+}
+
+TEST(Maths3DTest, QuantizedExtensions)
+{
+  Matrix4x4f xform = Matrix4x4f_Multiply(Matrix4x4f_PerspectiveFrustum(Degrees{60.0}, 1.0f, 0.1, 10000.0),
+                                         Matrix4x4f_TranslateXYZ(Vector4f_Set(0.5f, 0.25f, -100.0f, 1.0f)));
+  const Vector4f scale = Vector4f_Set(1.0f / 256.0f, 1.0f / 512.0f, 1.0f / 128.0f, 1.0f);
+  const Vector4f bias = Vector4f_Set(-2.0f, 1.5f, 0.25f, 0.0f);
+  const unsigned maxCount = 11;
+  const float guard = 12345.0f;
+  Vector4s positions[maxCount];
+  Vector4us upositions[maxCount];
+  Vector4f expected[maxCount];
+  Vector4f uexpected[maxCount];
+  Vector4f dequantized[maxCount];
+  Vector4f udequantized[maxCount];
+  for (unsigned i = 0; i < maxCount; ++i)
+  {
+    positions[i] = Vector4s{ { { int16_t(i * 1000 - 5000), int16_t(i * -731), int16_t(i * 37 + 12), 0 } } };
+    upositions[i] = Vector4us{ { { uint16_t(i * 5000), uint16_t(65535 - i * 731), uint16_t(i * 37), 0 } } };
+    for (int j = 0; j < 3; ++j)
+    {
+      dequantized[i].v[j] = float(positions[i].v[j]) * scale.v[j] + bias.v[j];
+      udequantized[i].v[j] = float(upositions[i].v[j]) * scale.v[j] + bias.v[j];
+    }
+    dequantized[i].w = udequantized[i].w = 1.0f;
+  }
+  Vector4f_SSETransformStreamGeneric<true,true,false,4,false,4>(expected[0].v, dequantized[0].v, maxCount, xform);
+  Vector4f_SSETransformStreamGeneric<true,true,false,4,false,4>(uexpected[0].v, udequantized[0].v, maxCount, xform);
+  const Matrix4x4f folded = Matrix4x4f_Dequantized(xform, scale, bias);
+  for (unsigned count = 0; count <= maxCount; ++count)
+  {
+    for (int isa = 0; isa <= int(InstructionSet::AVX512); ++isa)
+    {
+      if (InstructionSet_IsSupported(InstructionSet(isa)))
+      {
+        Vector4f out[maxCount + 1];
+        Vector4f uout[maxCount + 1];
+        out[count] = uout[count] = Vector4f_Replicate(guard);
+        Vector4s_SelectTransformStream<true,true,Vector4s>(InstructionSet(isa))(out[0].v, positions, count, folded);
+        Vector4s_SelectTransformStream<true,true,Vector4us>(InstructionSet(isa))(uout[0].v, upositions, count, folded);
+        for (unsigned i = 0; i < count; ++i)
+        {
+          for (int j = 0; j < 4; ++j)
+          {
+            EXPECT_NEAR(out[i].v[j], expected[i].v[j], 0.0001f);
+            EXPECT_NEAR(uout[i].v[j], uexpected[i].v[j], 0.001f);
+          }
+        }
+        // Check nothing was written to past the end of the outputs
+        EXPECT_EQ(out[count].x, guard);
+        EXPECT_EQ(uout[count].x, guard);
+      }
+    }
+  }
+  Vector4f out[maxCount];
+  Vector4s_TransformCoordStream(out, positions, maxCount, scale, bias, xform);
+  for (unsigned i = 0; i < maxCount; ++i)
+  {
+    for (int j = 0; j < 4; ++j)
+    {
+      EXPECT_NEAR(out[i].v[j], expected[i].v[j], 0.0001f);
+    }
+  }
+
+  // Octahedral encoded normals, including ones in the lower half which are folded
+  Matrix4x4f normalXform = Matrix4x4f_Multiply(Matrix4x4f_RotateXYZ(Rotation{Degrees{30.0f}, Degrees{-45.0f}, Degrees{60.0f}}),
+                                               Matrix4x4f_ScaleXYZ(Vector4f_Set(2.0f, 3.0f, 0.5f, 1.0f)));
+  Vector2s normals[maxCount];
+  Vector4f expectedNormals[maxCount];
+  for (unsigned i = 0; i < maxCount; ++i)
+  {
+    const Vector4f normal = Vector4f_Normalized(Vector4f_Set(float(i % 5) - 2.0f, float(i % 3) - 0.5f, float(i % 7) - 3.0f, 0.0f));
+    normals[i] = Vector2s_OctahedralEncode(normal);
+    const Vector4f decoded = Vector4f_OctahedralDecode(normals[i]);
+    EXPECT_NEAR(Vector4f_DotProduct(normal, decoded), 1.0f, 0.00001f);
+    EXPECT_EQ(decoded.w, 0.0f);
+    Vector4f_SSETransformStreamGeneric<false,false,false,4,false,4>(expectedNormals[i].v, decoded.v, 1, normalXform);
+    expectedNormals[i] = Vector4f_Normalized(Vector4f_SetW(expectedNormals[i], 0.0f));
+  }
+  for (unsigned count = 0; count <= maxCount; ++count)
+  {
+    for (int isa = 0; isa <= int(InstructionSet::AVX512); ++isa)
+    {
+      if (InstructionSet_IsSupported(InstructionSet(isa)))
+      {
+        Vector4f outNormals[maxCount + 1];
+        outNormals[count] = Vector4f_Replicate(guard);
+        Vector2s_SelectTransformNormalStream(InstructionSet(isa))(outNormals[0].v, normals, count, normalXform);
+        for (unsigned i = 0; i < count; ++i)
+        {
+          for (int j = 0; j < 4; ++j)
+          {
+            EXPECT_NEAR(outNormals[i].v[j], expectedNormals[i].v[j], 0.00001f);
+          }
+        }
+        EXPECT_EQ(outNormals[count].x, guard);
+      }
+    }
+  }
+}
+
+// Returns the error of value from the exact result in units in the last place of the exact result rounded to float
+double UlpError(float value, double exact)
+{
+  const float rounded = std::fabs(float(exact));
+  return std::fabs(double(value) - exact) / (double(nextafterf(rounded, FLT_MAX)) - double(rounded));
+}
+
+TEST(Maths3DTest, TrigExtensions)
+{
+  // The documented bounds in ULP, checked against double precision libm over the whole supported range, and more
+  // densely over the first few turns
+  double sinError = 0.0, cosError = 0.0, tanError = 0.0;
+  for (int range = 0; range < 2; ++range)
+  {
+    const int samples = 100000;
+    const double limit = (range == 0) ? 8192.0 : 7.0;
+    for (int i = 0; i < samples; i += 4)
+    {
+      Vector4f angles4;
+      for (int k = 0; k < 4; ++k)
+      {
+        angles4.v[k] = float(limit * (2.0 * double(i + k) / samples - 1.0));
+      }
+      const SinCos4f sinCos4 = Vector4f_SinCos(angles4);
+      const Vector4f tan4 = Vector4f_Tan(angles4);
+      for (int k = 0; k < 4; ++k)
+      {
+        const Radians angle = Radians{ angles4.v[k] };
+        const double exactSin = std::sin(double(angle.value)), exactCos = std::cos(double(angle.value));
+        const SinCos1f sinCos = Radians_SinCos(angle);
+        sinError = std::fmax(sinError, std::fmax(UlpError(sinCos.sin, exactSin), UlpError(sinCos4.sin.v[k], exactSin)));
+        cosError = std::fmax(cosError, std::fmax(UlpError(sinCos.cos, exactCos), UlpError(sinCos4.cos.v[k], exactCos)));
+        // Away from the poles
+        if (std::fabs(exactCos) > 0.01)
+        {
+          const double exactTan = std::tan(double(angle.value));
+          tanError = std::fmax(tanError, std::fmax(UlpError(Radians_Tan(angle), exactTan), UlpError(tan4.v[k], exactTan)));
+        }
+      }
+    }
+  }
+  EXPECT_TRUE(sinError <= 2.0);
+  EXPECT_TRUE(cosError <= 2.0);
+  EXPECT_TRUE(tanError <= 4.0);
+
+  const unsigned count = 1001;
+  std::vector<Radians> angles(count);
+  for (unsigned i = 0; i < count; ++i)
+  {
+    angles[i] = Radians{ (float(i) - 500.0f) * 0.0731f };
+  }
+  for (unsigned i = 0; i < count; ++i)
+  {
+    const SinCos1f sinCos = Radians_SinCos(angles[i]);
+    EXPECT_NEAR(sinCos.sin, std::sin(double(angles[i].value)), 0.0000002);
+    EXPECT_NEAR(sinCos.cos, std::cos(double(angles[i].value)), 0.0000002);
+    if (std::fabs(sinCos.cos) > 0.01f)
+    {
+      EXPECT_NEAR(Radians_Tan(angles[i]) / std::tan(double(angles[i].value)), 1.0, 0.000001);
+    }
+  }
+
+  std::vector<Scalar1f> sines(count), cosines(count);
+  Radians_SinCosStream(sines.data(), cosines.data(), angles.data(), count);
+  for (unsigned i = 0; i < count; ++i)
+  {
+    EXPECT_NEAR(sines[i], Radians_Sin(angles[i]), 0.0000002f);
+    EXPECT_NEAR(cosines[i], Radians_Cos(angles[i]), 0.0000002f);
+  }
+
+  const unsigned matrixCount = 7;
+  Matrix4x4f rotations[3][matrixCount];
+  Matrix4x4f projections[matrixCount];
+  Matrix4x4f_RotateXStream(rotations[0], angles.data(), matrixCount);
+  Matrix4x4f_RotateYStream(rotations[1], angles.data(), matrixCount);
+  Matrix4x4f_RotateZStream(rotations[2], angles.data(), matrixCount);
+  std::vector<Radians> fieldsOfView(matrixCount);
+  for (unsigned i = 0; i < matrixCount; ++i)
+  {
+    fieldsOfView[i] = Degrees{ 30.0f + 10.0f * i };
+  }
+  Matrix4x4f_PerspectiveFrustumStream(projections, fieldsOfView.data(), matrixCount, 1.5f, 0.1f, 1000.0f);
+  for (unsigned i = 0; i < matrixCount; ++i)
+  {
+    const Matrix4x4f expected[3] = { Matrix4x4f_RotateX(angles[i]), Matrix4x4f_RotateY(angles[i]), Matrix4x4f_RotateZ(angles[i]) };
+    const Matrix4x4f expectedProjection = Matrix4x4f_PerspectiveFrustum(fieldsOfView[i], 1.5f, 0.1f, 1000.0f);
+    for (int j = 0; j < 16; ++j)
+    {
+      for (int axis = 0; axis < 3; ++axis)
+      {
+        EXPECT_NEAR(rotations[axis][i].v[j], expected[axis].v[j], 0.0000002f);
+      }
+      EXPECT_NEAR(projections[i].v[j], expectedProjection.v[j], 0.00001f);
+    }
+  }
+}
+
+TEST(Maths3DTest, RotateXYZExtensions)
+{
+  const unsigned count = 9;
+  Rotation rotations[count];
+  Matrix4x4f batch[count];
+  for (unsigned i = 0; i < count; ++i)
+  {
+    rotations[i] = Rotation{ Degrees{ 37.0f * i - 100.0f }, Degrees{ -23.0f * i + 45.0f }, Degrees{ 71.0f * i } };
+  }
+  Matrix4x4f_RotateXYZStream(batch, rotations, count);
+  for (unsigned i = 0; i < count; ++i)
+  {
+    // Compare the closed form to multiplying the rotations together
+    const Matrix4x4f rotation = Matrix4x4f_RotateXYZ(rotations[i]);
+    const Matrix4x4f expected = Matrix4x4f_Multiply(Matrix4x4f_Multiply(Matrix4x4f_RotateX(rotations[i].x), Matrix4x4f_RotateY(rotations[i].y)),
+                                                    Matrix4x4f_RotateZ(rotations[i].z));
+    // A rotation and translation multiplied by its inverse should give the identity
+    const Matrix4x4f rigid = Matrix4x4f_Multiply(Matrix4x4f_TranslateXYZ(Vector4f_Set(3.0f, -4.0f, 5.0f, 1.0f)), rotation);
+    const Matrix4x4f identity1 = Matrix4x4f_Multiply(rigid, Matrix4x4f_OrthonormalInversed(rigid));
+    const Matrix4x4f identity2 = Matrix4x4f_Multiply(Matrix4x4f_OrthonormalInversed(rigid), rigid);
+    for (int j = 0; j < 16; ++j)
+    {
+      EXPECT_NEAR(rotation.v[j], expected.v[j], epsilon);
+      EXPECT_NEAR(batch[i].v[j], rotation.v[j], epsilon);
+      EXPECT_NEAR(identity1.v[j], Matrix4x4f_Identity().v[j], epsilon);
+      EXPECT_NEAR(identity2.v[j], Matrix4x4f_Identity().v[j], epsilon);
+    }
+  }
+}
+
+// Check each tier of the batch matrix multiply and inverse against the single matrix functions, including the
+// remainders which don't fill a whole SIMD register, strided and broadcast inputs, and singular matrices
+TEST(Maths3DTest, BatchMatrixExtensions)
+{
+  struct Instance
+  {
+    Matrix4x4f world;
+    float extra[4];
+  };
+  const unsigned count = 13;
+  Instance instances[count];
+  Matrix4x4f matrices[count];
+  Matrix4x4f output[count];
+  Matrix4x4f expectedMultiply[count];
+  Matrix4x4f expectedBroadcast[count];
+  Matrix4x4f expectedInverse[count];
+  const Matrix4x4f view = Matrix4x4f_PerspectiveFrustum(Degrees{ 60.0f }, 1.5f, 1.0f, 100.0f);
+  for (unsigned i = 0; i < count; ++i)
+  {
+    const Rotation rotation = Rotation{ Degrees{ 37.0f * i }, Degrees{ -23.0f * i + 45.0f }, Degrees{ 71.0f * i } };
+    instances[i].world = Matrix4x4f_Multiply(Matrix4x4f_ScaleXYZ(Vector4f_Set(1.0f + i, 2.0f, 0.5f, 1.0f)), Matrix4x4f_RotateXYZ(rotation));
+    instances[i].world.m[3][0] = float(i);
+    matrices[i] = Matrix4x4f_Multiply(view, Matrix4x4f_TranslateXYZ(Vector4f_Set(1.0f, float(i), -3.0f, 1.0f)));
+  }
+  // Every tier should give a zero matrix for a singular matrix
+  instances[9].world = Matrix4x4f_ScaleXYZ(Vector4f_Set(2.0f, 0.0f, 4.0f, 1.0f));
+  for (unsigned i = 0; i < count; ++i)
+  {
+    expectedMultiply[i] = Matrix4x4f_Multiply(instances[i].world, matrices[i]);
+    expectedBroadcast[i] = Matrix4x4f_Multiply(instances[i].world, view);
+    expectedInverse[i] = Matrix4x4f_Inversed(instances[i].world);
+  }
+  const unsigned instanceStride = sizeof(Instance) / sizeof(float);
+  for (int isa = 0; isa <= int(InstructionSet::AVX512); ++isa)
+  {
+    if (InstructionSet_IsSupported(InstructionSet(isa)))
+    {
+      Matrix4x4f_SelectMultiplyStream(InstructionSet(isa))(output[0].v, 16, instances[0].world.v, instanceStride, matrices[0].v, 16, count);
+      for (unsigned i = 0; i < count; ++i)
+        for (int j = 0; j < 16; ++j)
+          EXPECT_NEAR(output[i].v[j], expectedMultiply[i].v[j], 0.0001f);
+      Matrix4x4f_SelectMultiplyStream(InstructionSet(isa))(output[0].v, 16, instances[0].world.v, instanceStride, view.v, 0, count);
+      for (unsigned i = 0; i < count; ++i)
+        for (int j = 0; j < 16; ++j)
+          EXPECT_NEAR(output[i].v[j], expectedBroadcast[i].v[j], 0.0001f);
+      Matrix4x4f_SelectInverseStream(InstructionSet(isa))(output[0].v, 16, instances[0].world.v, instanceStride, count);
+      for (unsigned i = 0; i < count; ++i)
+        for (int j = 0; j < 16; ++j)
+          EXPECT_NEAR(output[i].v[j], expectedInverse[i].v[j], 0.0001f);
+    }
+  }
+  // In place with the dispatched kernels
+  for (unsigned i = 0; i < count; ++i)
+  {
+    output[i] = instances[i].world;
+  }
+  Matrix4x4f_MultiplyStream(output, output, matrices, count);
+  for (unsigned i = 0; i < count; ++i)
+  {
+    for (int j = 0; j < 16; ++j)
+    {
+      EXPECT_NEAR(output[i].v[j], expectedMultiply[i].v[j], 0.0001f);
+    }
+    output[i] = instances[i].world;
+  }
+  Matrix4x4f_InverseStream(output, output, count);
+  for (unsigned i = 0; i < count; ++i)
+  {
+    for (int j = 0; j < 16; ++j)
+    {
+      EXPECT_NEAR(output[i].v[j], expectedInverse[i].v[j], 0.0001f);
+    }
+  }
+}
+
+// Check the batch quaternion conversions against converting them one at a time
+TEST(Maths3DTest, QuaternionExtensions)
+{
+  const unsigned count = 11;
+  Vector4f translations[count];
+  Quaternion4f rotations[count];
+  Quaternion4f rotations2[count];
+  Vector4f scales[count];
+  Scalar1f factors[count];
+  for (unsigned i = 0; i < count; ++i)
+  {
+    translations[i] = Vector4f_Set(float(i), -2.0f * float(i), 0.5f, 0.0f);
+    rotations[i] = Quaternion4f_FromRotation(Rotation{ { 10.0f * float(i) }, { 25.0f - float(i) }, { 7.0f * float(i) } });
+    rotations2[i] = Quaternion4f_FromRotation(Rotation{ { -5.0f * float(i) }, { 45.0f }, { 3.0f * float(i) } });
+    scales[i] = Vector4f_Set(1.0f + float(i), 2.0f, 0.25f * float(i + 1), 0.0f);
+    factors[i] = float(i) / float(count);
+  }
+  Matrix4x4f matrices[count];
+  Matrix3x4f affines[count];
+  Quaternion4f blended[count];
+  Matrix4x4f_TranslateRotateScaleStream(matrices, translations, rotations, scales, count);
+  Matrix3x4f_TranslateRotateScaleStream(affines, translations, rotations, scales, count);
+  Quaternion4f_NlerpStream(blended, rotations, rotations2, factors, count);
+  for (unsigned i = 0; i < count; ++i)
+  {
+    const Matrix4x4f expected = Matrix4x4f_TranslateRotateScale(translations[i], rotations[i], scales[i]);
+    const Matrix3x4f expectedAffine = Matrix3x4f_TranslateRotateScale(translations[i], rotations[i], scales[i]);
+    const Quaternion4f expectedBlend = Quaternion4f_Nlerp(rotations[i], rotations2[i], factors[i]);
+    for (int j = 0; j < 16; ++j)
+    {
+      EXPECT_NEAR(matrices[i].v[j], expected.v[j], epsilon);
+    }
+    for (int j = 0; j < 12; ++j)
+    {
+      EXPECT_NEAR(affines[i].v[j], expectedAffine.v[j], epsilon);
+    }
+    for (int j = 0; j < 4; ++j)
+    {
+      EXPECT_NEAR(blended[i].v[j], expectedBlend.v[j], epsilon);
+    }
+  }
+
+  // Each implementation, in place, and with opposite signs so the shortest path needs q2 negated
+  for (int isa = 0; isa <= int(InstructionSet::AVX512); ++isa)
+  {
+    if (InstructionSet_IsSupported(InstructionSet(isa)))
+    {
+      Quaternion4f opposite[count];
+      for (unsigned i = 0; i < count; ++i)
+      {
+        blended[i] = rotations[i];
+        opposite[i] = (i % 2) ? Quaternion4f{ Vector4f_Scaled(rotations2[i].vec, -1.0f) } : rotations2[i];
+      }
+      Quaternion4f_SelectNlerpStream(InstructionSet(isa))(blended, blended, opposite, factors, count);
+      for (unsigned i = 0; i < count; ++i)
+      {
+        const Quaternion4f expectedBlend = Quaternion4f_Nlerp(rotations[i], rotations2[i], factors[i]);
+        for (int j = 0; j < 4; ++j)
+        {
+          EXPECT_NEAR(blended[i].v[j], expectedBlend.v[j], epsilon);
+        }
+      }
+    }
+  }
+}
+
+// Check the skinning kernels against the reference linear blend, and dual quaternion skinning against it for rigid bones
+TEST(Maths3DTest, SkinningExtensions)
+{
+  const unsigned boneCount = 5;
+  Matrix4x4f palette[boneCount];
+  DualQuaternion4f dualPalette[boneCount];
+  for (unsigned b = 0; b < boneCount; ++b)
+  {
+    const Quaternion4f rotation = Quaternion4f_FromRotation(Rotation{ { 15.0f * float(b) }, { 30.0f - 4.0f * float(b) }, { 5.0f * float(b) } });
+    const Vector4f translation = Vector4f_Set(float(b), 0.5f * float(b), -2.0f, 0.0f);
+    palette[b] = Matrix4x4f_TranslateRotateScale(translation, rotation, Vector4f_Replicate(1.0f));
+    dualPalette[b] = DualQuaternion4f_FromRotationTranslation(rotation, translation);
+    CheckMatrixNear(Matrix4x4f_FromDualQuaternion4f(dualPalette[b]), palette[b]);
+  }
+
+  const unsigned count = 23;
+  Vector4f positions[count];
+  Vector4f normals[count];
+  Vector4us boneIndices[count];
+  Vector4f boneWeights[count];
+  Vector4us rigidIndices[count];
+  Vector4f rigidWeights[count];
+  float x[count], y[count], z[count];
+  for (unsigned i = 0; i < count; ++i)
+  {
+    positions[i] = Vector4f_Set(float(i % 5) - 2.0f, float(i % 3), 0.25f * float(i), 1.0f);
+    normals[i] = Vector4f_SetW(Vector4f_Normalized(Vector4f_Set(1.0f, float(i % 4), -float(i % 3), 0.0f)), 7.0f); // w should be ignored
+    boneIndices[i] = Vector4us{ { uint16_t(i % boneCount), uint16_t((i + 1) % boneCount), uint16_t((i + 3) % boneCount), 0 } };
+    boneWeights[i] = Vector4f_Set(0.5f, 0.25f, 0.25f * float(i % 2), 0.25f * float((i + 1) % 2));
+    rigidIndices[i] = Vector4us{ { uint16_t(i % boneCount), 0, 0, 0 } };
+    rigidWeights[i] = Vector4f_Set(1.0f, 0.0f, 0.0f, 0.0f);
+    x[i] = positions[i].x;
+    y[i] = positions[i].y;
+    z[i] = positions[i].z;
+  }
+  Vector4f expectedPositions[count];
+  Vector4f expectedNormals[count];
+  Vector4f_SkinStreamGeneric(expectedPositions, expectedNormals, positions, normals, boneIndices, boneWeights, count, palette);
+  // Blending the matrices is the same as blending the vertex transformed by each of the bones
+  for (unsigned i = 0; i < count; ++i)
+  {
+    Vector4f position = Vector4f_Zero();
+    Vector4f normal = Vector4f_Zero();
+    for (int k = 0; k < 4; ++k)
+    {
+      const Matrix4x4f& bone = palette[boneIndices[i].v[k]];
+      position = Vector4f_Add(position, Vector4f_Scaled(Vector4f_Transform(bone, positions[i]), boneWeights[i].v[k]));
+      normal = Vector4f_Add(normal, Vector4f_Scaled(Vector4f_Transform(bone, Vector4f_SetW(normals[i], 0.0f)), boneWeights[i].v[k]));
+    }
+    CheckVectorNear(expectedPositions[i], position);
+    CheckVectorNear(expectedNormals[i], normal);
+    EXPECT_NEAR(expectedNormals[i].w, 0.0f, epsilon);
+  }
+
+  Vector4f outPositions[count];
+  Vector4f outNormals[count];
+  for (int isa = 0; isa <= int(InstructionSet::AVX512); ++isa)
+  {
+    if (InstructionSet_IsSupported(InstructionSet(isa)))
+    {
+      Vector4f_SelectSkinStream(InstructionSet(isa))(outPositions, outNormals, positions, normals, boneIndices, boneWeights, count, palette);
+      for (unsigned i = 0; i < count; ++i)
+      {
+        for (int j = 0; j < 4; ++j)
+        {
+          EXPECT_NEAR(outPositions[i].v[j], expectedPositions[i].v[j], epsilon);
+          EXPECT_NEAR(outNormals[i].v[j], expectedNormals[i].v[j], epsilon);
+        }
+      }
+    }
+  }
+
+  // Structure of arrays positions and normals
+  float outX[count], outY[count], outZ[count];
+  Vector4f_SkinStreamSoA<true>(outX, outY, outZ, x, y, z, boneIndices, boneWeights, count, palette);
+  for (unsigned i = 0; i < count; ++i)
+  {
+    EXPECT_NEAR(outX[i], expectedPositions[i].x, epsilon);
+    EXPECT_NEAR(outY[i], expectedPositions[i].y, epsilon);
+    EXPECT_NEAR(outZ[i], expectedPositions[i].z, epsilon);
+  }
+  Vector4f_SkinStreamSoA<false>(outX, outY, outZ, x, y, z, boneIndices, boneWeights, count, palette);
+  for (unsigned i = 0; i < count; ++i)
+  {
+    Vector4f expectedNormal;
+    const Vector4f position = Vector4f_SetW(positions[i], 0.0f);
+    Vector4f_SkinStreamGeneric(&expectedNormal, nullptr, &position, nullptr, boneIndices + i, boneWeights + i, 1, palette);
+    EXPECT_NEAR(outX[i], expectedNormal.x, epsilon);
+    EXPECT_NEAR(outY[i], expectedNormal.y, epsilon);
+    EXPECT_NEAR(outZ[i], expectedNormal.z, epsilon);
+  }
+
+  // With one bone per vertex the dual quaternions are the same rigid transforms as the matrices
+  Vector4f_SkinStreamGeneric(expectedPositions, expectedNormals, positions, normals, rigidIndices, rigidWeights, count, palette);
+  Vector4f_DualQuaternionSkinStream(outPositions, outNormals, positions, normals, rigidIndices, rigidWeights, count, dualPalette);
+  for (unsigned i = 0; i < count; ++i)
+  {
+    for (int j = 0; j < 4; ++j)
+    {
+      EXPECT_NEAR(outPositions[i].v[j], expectedPositions[i].v[j], epsilon);
+      EXPECT_NEAR(outNormals[i].v[j], expectedNormals[i].v[j], epsilon);
+    }
+  }
+
+  // Blending dual quaternions keeps the length of normals, and q and -q are the same rotation
+  dualPalette[1].real.vec = Vector4f_Scaled(dualPalette[1].real.vec, -1.0f);
+  dualPalette[1].dual.vec = Vector4f_Scaled(dualPalette[1].dual.vec, -1.0f);
+  Vector4f blendedPositions[count];
+  Vector4f_DualQuaternionSkinStream(blendedPositions, outNormals, positions, normals, boneIndices, boneWeights, count, dualPalette);
+  for (unsigned i = 0; i < count; ++i)
+  {
+    EXPECT_NEAR(Vector4f_Length(outNormals[i]), 1.0f, epsilon);
+  }
+  dualPalette[1].real.vec = Vector4f_Scaled(dualPalette[1].real.vec, -1.0f);
+  dualPalette[1].dual.vec = Vector4f_Scaled(dualPalette[1].dual.vec, -1.0f);
+  Vector4f_DualQuaternionSkinStream(outPositions, outNormals, positions, normals, boneIndices, boneWeights, count, dualPalette);
+  for (unsigned i = 0; i < count; ++i)
+  {
+    for (int j = 0; j < 4; ++j)
+    {
+      EXPECT_NEAR(blendedPositions[i].v[j], outPositions[i].v[j], epsilon);
+    }
+  }
+
+  // Use small chunks and more threads than there may be cores to make sure the chunks get shared out
+  const unsigned parallelCount = 20011;
+  std::vector<Vector4f> parallelPositions(parallelCount);
+  std::vector<Vector4us> parallelIndices(parallelCount);
+  std::vector<Vector4f> parallelWeights(parallelCount);
+  std::vector<Vector4f> parallelExpected(parallelCount);
+  std::vector<Vector4f> parallelOut(parallelCount);
+  for (unsigned i = 0; i < parallelCount; ++i)
+  {
+    parallelPositions[i] = positions[i % count];
+    parallelIndices[i] = boneIndices[i % count];
+    parallelWeights[i] = boneWeights[i % count];
+  }
+  const ParallelConfig config = { 1000, 4096, 8 };
+  Vector4f_SkinStream(parallelExpected.data(), nullptr, parallelPositions.data(), nullptr, parallelIndices.data(), parallelWeights.data(), parallelCount, palette);
+  Vector4f_ParallelSkinStream(parallelOut.data(), nullptr, parallelPositions.data(), nullptr, parallelIndices.data(), parallelWeights.data(), parallelCount, palette, config);
+  for (unsigned i = 0; i < parallelCount; ++i)
+  {
+    EXPECT_NEAR(parallelOut[i].x, parallelExpected[i].x, epsilon);
+    EXPECT_NEAR(parallelOut[i].w, parallelExpected[i].w, epsilon);
+  }
+  Vector4f_DualQuaternionSkinStream(parallelExpected.data(), nullptr, parallelPositions.data(), nullptr, parallelIndices.data(), parallelWeights.data(), parallelCount, dualPalette);
+  Vector4f_ParallelDualQuaternionSkinStream(parallelOut.data(), nullptr, parallelPositions.data(), nullptr, parallelIndices.data(), parallelWeights.data(), parallelCount, dualPalette, config);
+  for (unsigned i = 0; i < parallelCount; ++i)
+  {
+    EXPECT_NEAR(parallelOut[i].y, parallelExpected[i].y, epsilon);
+    EXPECT_NEAR(parallelOut[i].z, parallelExpected[i].z, epsilon);
+  }
+
+  // Chunks smaller than a vertex are still at least 16 vertices
+  const ParallelConfig tinyChunks = { 0, 32, 4 };
+  Vector4f_ParallelSkinStream(parallelOut.data(), nullptr, parallelPositions.data(), nullptr, parallelIndices.data(), parallelWeights.data(), parallelCount, palette, tinyChunks);
+  Vector4f_SkinStream(parallelExpected.data(), nullptr, parallelPositions.data(), nullptr, parallelIndices.data(), parallelWeights.data(), parallelCount, palette);
+  for (unsigned i = 0; i < parallelCount; ++i)
+  {
+    EXPECT_NEAR(parallelOut[i].x, parallelExpected[i].x, epsilon);
+    EXPECT_NEAR(parallelOut[i].z, parallelExpected[i].z, epsilon);
+  }
+}
+
+// Check the transform streams of each instruction set divide by w within the stated error bound of each precision
+template <Precision precision>
+void CheckPrecisionStreams(double bound)
+{
+  const Matrix4x4f xform = Matrix4x4f_Multiply(Matrix4x4f_PerspectiveFrustum(Degrees{60.0}, 1.0f, 0.1, 10000.0),
+                                               Matrix4x4f_TranslateXYZ(Vector4f_Set(0.5f, 0.25f, -100.0f, 1.0f)));
+  const unsigned count = 37;
+  Vector4f vecs[count];
+  Vector4f exact[count];
+  Vector4f approx[count];
+  Vector4f other[count];
+  float x[count], y[count], z[count];
+  float outX[count], outY[count], outZ[count];
+  Vector3f packed[count];
+  Vector4h halves[count];
+  Vector4s quantized[count];
+  for (unsigned i = 0; i < count; ++i)
+  {
+    vecs[i] = Vector4f_Set(float(i % 11) - 5.0f, float(i % 7), float(i) * 3.0f - 50.0f, 1.0f);
+    x[i] = vecs[i].x;
+    y[i] = vecs[i].y;
+    z[i] = vecs[i].z;
+    // The components are small integers, so they are exact as packed, half and quantized vectors too
+    packed[i] = Vector3f_FromVector4f(vecs[i]);
+    halves[i] = Vector4h_FromVector4f(vecs[i]);
+    quantized[i] = Vector4s{ { { int16_t(vecs[i].x), int16_t(vecs[i].y), int16_t(vecs[i].z), 1 } } };
+  }
+  for (int isa = 0; isa <= int(InstructionSet::AVX512); ++isa)
+  {
+    if (InstructionSet_IsSupported(InstructionSet(isa)))
+    {
+      // The only difference from the exact version is the reciprocal of w, so compare the ratio with that
+      Vector4f_SelectTransformStream<true,true,false,4,false,4>(InstructionSet(isa))(exact[0].v, vecs[0].v, count, xform);
+      Vector4f_SelectTransformStream<true,true,false,4,false,4,precision>(InstructionSet(isa))(approx[0].v, vecs[0].v, count, xform);
+      Vector4f_SelectTransformStreamSoA<true,true,precision>(InstructionSet(isa))(outX, outY, outZ, nullptr, x, y, z, count, xform);
+      for (unsigned i = 0; i < count; ++i)
+      {
+        const Vector4f expected = Vector4f_Transform(xform, vecs[i]);
+        for (int j = 0; j < 3; ++j)
+        {
+          EXPECT_NEAR(exact[i].v[j], expected.v[j] / double(expected.w), 1e-6 * ::fabs(expected.v[j] / expected.w) + 1e-6);
+          if (exact[i].v[j] != 0.0f)
+          {
+            EXPECT_NEAR(approx[i].v[j] / exact[i].v[j], 1.0, bound + 2.5e-7);
+          }
+        }
+        EXPECT_NEAR(outX[i], approx[i].x, (bound + 2.5e-7) * ::fabs(exact[i].x) + 1e-6);
+        EXPECT_NEAR(outY[i], approx[i].y, (bound + 2.5e-7) * ::fabs(exact[i].y) + 1e-6);
+        EXPECT_NEAR(outZ[i], approx[i].z, (bound + 2.5e-7) * ::fabs(exact[i].z) + 1e-6);
+      }
+      // The packed, half and quantized streams take the same precision
+      for (int stream = 0; stream < 3; ++stream)
+      {
+        if (stream == 0)
+        {
+          Vector3f_SelectTransformStream<true,true,4,precision>(InstructionSet(isa))(other[0].v, packed[0].v, count, xform);
+        }
+        else if (stream == 1)
+        {
+          Vector4h_SelectTransformStream<true,true,false,true,precision>(InstructionSet(isa))(other, halves, count, xform);
+        }
+        else
+        {
+          Vector4s_SelectTransformStream<true,true,Vector4s,precision>(InstructionSet(isa))(other[0].v, quantized, count, xform);
+        }
+        for (unsigned i = 0; i < count; ++i)
+        {
+          for (int j = 0; j < 3; ++j)
+          {
+            if (exact[i].v[j] != 0.0f)
+            {
+              EXPECT_NEAR(other[i].v[j] / exact[i].v[j], 1.0, bound + 2.5e-7);
+            }
+          }
+        }
+      }
+    }
+  }
+  // The runtime dispatched versions
+  Vector4f_TransformCoordStream<precision>(approx, vecs, count, xform);
+  Vector4f_TransformCoordStream(exact, vecs, count, xform);
+  Vector3f_TransformCoordStream<precision>(packed, packed, count, xform);
+  Vector4h_TransformCoordStream<precision>(other, halves, count, xform);
+  for (unsigned i = 0; i < count; ++i)
+  {
+    if (exact[i].y != 0.0f)
+    {
+      EXPECT_NEAR(approx[i].y / exact[i].y, 1.0, bound + 2.5e-7);
+      EXPECT_NEAR(packed[i].y / exact[i].y, 1.0, bound + 2.5e-7);
+      EXPECT_NEAR(other[i].y / exact[i].y, 1.0, bound + 2.5e-7);
+    }
+  }
+}
+
+TEST(Maths3DTest, PrecisionExtensions)
+{
+  CheckPrecisionStreams<Precision::Exact>(0.0);
+  CheckPrecisionStreams<Precision::Fast>(0.5 / (1 << 20));
+  CheckPrecisionStreams<Precision::Fastest>(1.5 / (1 << 12));
+}
+
+// Check the batch normalize and length streams are within the stated error bound of each precision
+template <Precision precision>
+void CheckNormalizeStreams(double bound)
+{
+  const unsigned count = 1003;
+  std::vector<Vector4f> vecs(count);
+  std::vector<Vector4f> unit(count);
+  std::vector<Scalar1f> lengths(count);
+  std::vector<Scalar1f> reciprocals(count);
+  std::vector<float> x(count), y(count), z(count);
+  for (unsigned i = 0; i < count; ++i)
+  {
+    // Lengths from about 0.001 to 1000 and every mantissa of the leading digits
+    const float scale = ::powf(10.0f, float(i % 7) - 3.0f);
+    vecs[i] = Vector4f_Set(scale * (float(i % 37) - 18.5f), scale * float(i % 11), -scale * float(i % 5), scale * float(i % 3));
+    x[i] = vecs[i].x;
+    y[i] = vecs[i].y;
+    z[i] = vecs[i].z;
+  }
+  Vector4f_NormalizeStream<precision>(unit.data(), vecs.data(), count);
+  Vector4f_LengthStream<precision>(lengths.data(), vecs.data(), count);
+  Vector4f_ReciprocalLengthStream<precision>(reciprocals.data(), vecs.data(), count);
+  Vector4f_NormalizeStreamSoA<precision>(x.data(), y.data(), z.data(), x.data(), y.data(), z.data(), count);
+  for (unsigned i = 0; i < count; ++i)
+  {
+    const Vector4f& v = vecs[i];
+    const double length = ::sqrt(double(v.x) * v.x + double(v.y) * v.y + double(v.z) * v.z + double(v.w) * v.w);
+    const double length3 = ::sqrt(double(v.x) * v.x + double(v.y) * v.y + double(v.z) * v.z);
+    EXPECT_NEAR(lengths[i] / length, 1.0, bound);
+    EXPECT_NEAR(reciprocals[i] * length, 1.0, bound);
+    for (int j = 0; j < 4; ++j)
+    {
+      // The multiply by the reciprocal adds another rounding
+      EXPECT_NEAR(unit[i].v[j], v.v[j] / length, bound + 1e-7);
+    }
+    EXPECT_NEAR(x[i], v.x / length3, bound + 1e-7);
+    EXPECT_NEAR(y[i], v.y / length3, bound + 1e-7);
+    EXPECT_NEAR(z[i], v.z / length3, bound + 1e-7);
+  }
+
+  // Zero length vectors have a length of zero, and every count gets the same results as a full block of four
+  Vector4f zero = Vector4f_Zero();
+  Vector4f_LengthStream<precision>(lengths.data(), &zero, 1);
+  EXPECT_EQ(lengths[0], 0.0f);
+  for (unsigned n = 1; n < 8; ++n)
+  {
+    Vector4f tail[8];
+    Vector4f_NormalizeStream<precision>(tail, vecs.data(), n);
+    for (unsigned i = 0; i < n; ++i)
+    {
+      EXPECT_EQ(tail[i].x, unit[i].x);
+    }
+  }
+}
+
+TEST(Maths3DTest, NormalizeExtensions)
+{
+  CheckNormalizeStreams<Precision::Exact>(2.5e-7);
+  CheckNormalizeStreams<Precision::Fast>(0.5 / (1 << 20));
+  CheckNormalizeStreams<Precision::Fastest>(1.5 / (1 << 12));
+
+  const unsigned count = 19;
+  Vector4f a[count], b[count];
+  Vector4f crosses[count];
+  Scalar1f dots[count];
+  for (unsigned i = 0; i < count; ++i)
+  {
+    a[i] = Vector4f_Set(float(i), 1.0f - float(i % 4), 2.0f, 0.5f);
+    b[i] = Vector4f_Set(-1.0f, float(i % 5), float(i) * 0.25f, 2.0f);
+  }
+  Vector4f_DotProductStream(dots, a, b, count);
+  Vector4f_CrossProductStream(crosses, a, b, count);
+  for (unsigned i = 0; i < count; ++i)
+  {
+    EXPECT_NEAR(dots[i], Vector4f_DotProduct(a[i], b[i]), epsilon);
+    const Vector4f expected = Vector4f_CrossProduct(a[i], b[i]);
+    for (int j = 0; j < 4; ++j)
+    {
+      EXPECT_NEAR(crosses[i].v[j], expected.v[j], epsilon);
+    }
+  }
+}
+
+// Check each implementation of the culling streams against the single volume classifications
+TEST(Maths3DTest, FrustumExtensions)
+{
+  const Frustum4f frustum = Frustum4f_FromMatrix4x4f(Matrix4x4f_PerspectiveFrustum(Degrees{ 60.0f }, 1.5f, 1.0f, 50.0f));
+  const unsigned count = 61;
+  float centerX[count], centerY[count], centerZ[count], radius[count];
+  float minX[count], minY[count], minZ[count], maxX[count], maxY[count], maxZ[count];
+  for (unsigned i = 0; i < count; ++i)
+  {
+    centerX[i] = float(int(i % 9) - 4) * 7.0f + 0.3f;
+    centerY[i] = float(int(i % 5) - 2) * 6.0f - 0.2f;
+    centerZ[i] = -float(i) + 5.1f;
+    radius[i] = float(i % 4) + 0.5f;
+    minX[i] = centerX[i] - radius[i];
+    minY[i] = centerY[i] - 0.5f * radius[i];
+    minZ[i] = centerZ[i] - 2.0f * radius[i];
+    maxX[i] = centerX[i] + radius[i];
+    maxY[i] = centerY[i] + 1.5f;
+    maxZ[i] = centerZ[i] + 0.25f;
+  }
+  Containment sphereExpected[count], aabbExpected[count];
+  unsigned sphereVisible = 0, aabbVisible = 0;
+  for (unsigned i = 0; i < count; ++i)
+  {
+    sphereExpected[i] = Frustum4f_ClassifySphere(frustum, Vector4f_Set(centerX[i], centerY[i], centerZ[i], 1.0f), radius[i]);
+    aabbExpected[i] = Frustum4f_ClassifyAabb(frustum, Vector4f_Set(minX[i], minY[i], minZ[i], 1.0f), Vector4f_Set(maxX[i], maxY[i], maxZ[i], 1.0f));
+    sphereVisible += sphereExpected[i] != Containment::Outside;
+    aabbVisible += aabbExpected[i] != Containment::Outside;
+  }
+  // The test data should have some of each classification
+  EXPECT_TRUE(sphereVisible > 0 && sphereVisible < count);
+  EXPECT_TRUE(aabbVisible > 0 && aabbVisible < count);
+
+  for (int isa = 0; isa <= int(InstructionSet::AVX512); ++isa)
+  {
+    if (!InstructionSet_IsSupported(InstructionSet(isa)))
+    {
+      continue;
+    }
+    // Odd counts so that the tails are tested
+    for (unsigned n = count - 8; n <= count; ++n)
+    {
+      unsigned visibleIndices[count];
+      Containment containments[count];
+      unsigned visibleCount = Frustum4f_SelectCullSpheresStream(InstructionSet(isa))(visibleIndices, containments, frustum, centerX, centerY, centerZ, radius, n);
+      unsigned expectedIndex = 0;
+      for (unsigned i = 0; i < n; ++i)
+      {
+        EXPECT_EQ(int(containments[i]), int(sphereExpected[i]));
+        if (sphereExpected[i] != Containment::Outside)
+        {
+          EXPECT_EQ(visibleIndices[expectedIndex], i);
+          ++expectedIndex;
+        }
+      }
+      EXPECT_EQ(visibleCount, expectedIndex);
+
+      visibleCount = Frustum4f_SelectCullAabbsStream(InstructionSet(isa))(visibleIndices, nullptr, frustum, minX, minY, minZ, maxX, maxY, maxZ, n);
+      expectedIndex = 0;
+      for (unsigned i = 0; i < n; ++i)
+      {
+        if (aabbExpected[i] != Containment::Outside)
+        {
+          EXPECT_EQ(visibleIndices[expectedIndex], i);
+          ++expectedIndex;
+        }
+      }
+      EXPECT_EQ(visibleCount, expectedIndex);
+    }
+  }
+
+  // Transform only the positions of the visible spheres
+  unsigned visibleIndices[count];
+  const unsigned visibleCount = Frustum4f_CullSpheresStream(visibleIndices, nullptr, frustum, centerX, centerY, centerZ, radius, count);
+  EXPECT_EQ(visibleCount, sphereVisible);
+  Vector4f positions[count], transformed[count];
+  for (unsigned i = 0; i < count; ++i)
+  {
+    positions[i] = Vector4f_Set(centerX[i], centerY[i], centerZ[i], 1.0f);
+  }
+  const Matrix4x4f projection = Matrix4x4f_PerspectiveFrustum(Degrees{ 60.0f }, 1.5f, 1.0f, 50.0f);
+  Vector4f_TransformStreamIndexed<true,true>(transformed, positions, visibleIndices, visibleCount, projection);
+  for (unsigned i = 0; i < visibleCount; ++i)
+  {
+    const Vector4f expected = Vector4f_TransformCoord(projection, positions[visibleIndices[i]]);
+    for (int j = 0; j < 4; ++j)
+    {
+      EXPECT_NEAR(transformed[i].v[j], expected.v[j], 0.0001f);
+    }
+  }
+}
+
+// Check the bounding volume streams against the single volume functions
+TEST(Maths3DTest, BoundingVolumeExtensions)
+{
+  const unsigned count = 1003;
+  static Vector4f points[count];
+  Aabb4f expected = Aabb4f_Empty();
+  for (unsigned i = 0; i < count; ++i)
+  {
+    points[i] = Vector4f_Set(float(i % 17) - 8.25f, float(i % 29) * 0.5f, -float(i % 11) * 3.0f, 1.0f);
+    expected = Aabb4f_AddPoint(expected, points[i]);
+  }
+  // Put the extremes near the end, so the tails are tested
+  points[count - 1] = Vector4f_Set(100.0f, -100.0f, 50.0f, 1.0f);
+  expected = Aabb4f_AddPoint(expected, points[count - 1]);
+
+  for (int isa = 0; isa <= int(InstructionSet::AVX512); ++isa)
+  {
+    if (!InstructionSet_IsSupported(InstructionSet(isa)))
+    {
+      continue;
+    }
+    const Aabb4f_FromVector4fStreamFunc kernel = Aabb4f_SelectFromVector4fStream(InstructionSet(isa));
+    for (unsigned n = count - 9; n <= count; ++n)
+    {
+      const Aabb4f bounds = kernel(points, n);
+      const Aabb4f reference = Aabb4f_FromVector4fStreamGeneric(points, n);
+      CheckVectorNear(bounds.minimum, reference.minimum);
+      CheckVectorNear(bounds.maximum, reference.maximum);
+    }
+    const Aabb4f empty = kernel(points, 0);
+    EXPECT_TRUE(empty.minimum.x > empty.maximum.x);
+  }
+
+  // The parallel version with a small threshold and chunks so that it is split up
+  const ParallelConfig config = { 0, 256, 0 };
+  const Aabb4f parallel = Aabb4f_ParallelFromVector4fStream(points, count, config);
+  CheckVectorNear(parallel.minimum, expected.minimum);
+  CheckVectorNear(parallel.maximum, expected.maximum);
+  // And with chunks of no size, which are still bounded 16 points at a time
+  const Aabb4f tinyChunks = Aabb4f_ParallelFromVector4fStream(points, count, ParallelConfig{ 0, 0, 4 });
+  CheckVectorNear(tinyChunks.minimum, expected.minimum);
+  CheckVectorNear(tinyChunks.maximum, expected.maximum);
+
+  // The sphere contains all the points and touches at least one
+  const BoundingSphere4f sphere = BoundingSphere4f_FromVector4fStream(points, count);
+  Scalar1f furthest = 0.0f;
+  for (unsigned i = 0; i < count; ++i)
+  {
+    furthest = fmaxf(furthest, Vector4f_Length(Vector4f_SetW(Vector4f_Subtract(points[i], sphere.center), 0.0f)));
+  }
+  EXPECT_NEAR(furthest, sphere.radius, 0.0001f);
+  CheckVectorNear(sphere.center, Vector4f_SetW(Aabb4f_Center(expected), 1.0f));
+
+  // The transform streams match the single transforms
+  const Matrix4x4f transform = Matrix4x4f_Multiply(Matrix4x4f_TranslateXYZ(Vector4f_Set(12.0f, -1.0f, -10.0f, 1.0f)),
+                                                   Matrix4x4f_Multiply(Matrix4x4f_RotateXYZ(Rotation{ Degrees{ 10.0f }, Degrees{ 45.0f }, Degrees{ 30.0f } }),
+                                                                       Matrix4x4f_ScaleXYZ(Vector4f_Set(2.0f, 3.0f, 0.5f, 1.0f))));
+  const unsigned boxCount = 13;
+  Aabb4f boxes[boxCount], transformedBoxes[boxCount];
+  BoundingSphere4f spheres[boxCount], transformedSpheres[boxCount];
+  for (unsigned i = 0; i < boxCount; ++i)
+  {
+    boxes[i] = Aabb4f_Set(points[i * 7], Vector4f_Add(points[i * 7], Vector4f_Set(1.0f + i, 2.0f, 0.5f * i, 0.0f)));
+    spheres[i] = BoundingSphere4f_FromAabb4f(boxes[i]);
+  }
+  Aabb4f_TransformStream(transformedBoxes, boxes, boxCount, transform);
+  BoundingSphere4f_TransformStream(transformedSpheres, spheres, boxCount, transform);
+  for (unsigned i = 0; i < boxCount; ++i)
+  {
+    const Aabb4f box = Aabb4f_Transform(transform, boxes[i]);
+    CheckVectorNear(transformedBoxes[i].minimum, box.minimum);
+    CheckVectorNear(transformedBoxes[i].maximum, box.maximum);
+    const BoundingSphere4f transformedSphere = BoundingSphere4f_Transform(transform, spheres[i]);
+    CheckVectorNear(transformedSpheres[i].center, transformedSphere.center);
+    EXPECT_NEAR(transformedSpheres[i].radius, transformedSphere.radius, 0.0001f);
+  }
+}
+
+// Check every implementation of the ray intersection streams and packets finds the same hits as the single tests
+TEST(Maths3DTest, RayExtensions)
+{
+  const unsigned count = 45;
+  float centerX[count], centerY[count], centerZ[count], radius[count];
+  float minX[count], minY[count], minZ[count], maxX[count], maxY[count], maxZ[count];
+  float triangleComponents[9][count];
+  for (unsigned i = 0; i < count; ++i)
+  {
+    centerX[i] = float(int(i % 7) - 3) * 1.5f + 0.1f;
+    centerY[i] = float(int(i % 5) - 2) * 1.25f - 0.2f;
+    centerZ[i] = -5.0f - float(i % 11) * 1.3f;
+    radius[i] = float(i % 3) * 0.25f + 0.5f;
+    minX[i] = centerX[i] - radius[i];
+    minY[i] = centerY[i] - 0.5f * radius[i];
+    minZ[i] = centerZ[i] - radius[i];
+    maxX[i] = centerX[i] + 0.75f * radius[i];
+    maxY[i] = centerY[i] + radius[i];
+    maxZ[i] = centerZ[i] + 0.5f;
+    for (int k = 0; k < 3; ++k)
+    {
+      triangleComponents[k * 3 + 0][i] = centerX[i] + (k == 1 ? 1.5f : -0.5f) * radius[i];
+      triangleComponents[k * 3 + 1][i] = centerY[i] + (k == 2 ? 1.5f : -0.75f) * radius[i];
+      triangleComponents[k * 3 + 2][i] = centerZ[i] + float(k) * 0.5f - 0.5f;
+    }
+  }
+  const TrianglesSoA triangles = { triangleComponents[0], triangleComponents[1], triangleComponents[2], triangleComponents[3], triangleComponents[4],
+                                   triangleComponents[5], triangleComponents[6], triangleComponents[7], triangleComponents[8] };
+
+  const unsigned rayCount = 27;
+  float originX[rayCount], originY[rayCount], originZ[rayCount], directionX[rayCount], directionY[rayCount], directionZ[rayCount];
+  for (unsigned i = 0; i < rayCount; ++i)
+  {
+    originX[i] = float(int(i % 3) - 1) * 0.5f;
+    originY[i] = float(int(i % 4) - 2) * 0.25f;
+    originZ[i] = (i % 9 == 4) ? -9.0f : 0.0f;
+    directionX[i] = float(int(i % 9) - 4) * 0.1f;
+    directionY[i] = float(int(i % 7) - 3) * 0.08f;
+    // Include some rays along the other axes and away from the primitives
+    directionZ[i] = (i % 13 == 5) ? 0.0f : ((i % 10 == 3) ? 1.0f : -1.0f);
+  }
+  const RayPacketSoA rays = { originX, originY, originZ, directionX, directionY, directionZ };
+
+  int hits[3] = {}, searches = 0;
+  for (int isa = 0; isa <= int(InstructionSet::AVX512); ++isa)
+  {
+    if (!InstructionSet_IsSupported(InstructionSet(isa)))
+    {
+      continue;
+    }
+    const Ray4f_IntersectSpheresStreamFunc spheresKernel = Ray4f_SelectIntersectSpheresStream(InstructionSet(isa));
+    const Ray4f_IntersectAabbsStreamFunc aabbsKernel = Ray4f_SelectIntersectAabbsStream(InstructionSet(isa));
+    const Ray4f_IntersectTrianglesStreamFunc trianglesKernel = Ray4f_SelectIntersectTrianglesStream(InstructionSet(isa));
+    for (unsigned r = 0; r < rayCount; ++r)
+    {
+      const Ray4f ray = RayPacketSoA_Ray(rays, r);
+      for (unsigned n = count - 8; n <= count; n += 4)
+      {
+        ++searches;
+        RayHit4f expected = RayHit4f_None(), hit = RayHit4f_None();
+        EXPECT_EQ(Ray4f_IntersectSpheresStreamGeneric(ray, centerX, centerY, centerZ, radius, n, expected),
+                  spheresKernel(ray, centerX, centerY, centerZ, radius, n, hit));
+        EXPECT_EQ(hit.primitive, expected.primitive);
+        EXPECT_NEAR(hit.t, expected.t, 0.001f);
+        hits[0] += hit.primitive != RayHit4f_NoPrimitive;
+
+        expected = RayHit4f_None(), hit = RayHit4f_None();
+        EXPECT_EQ(Ray4f_IntersectAabbsStreamGeneric(ray, minX, minY, minZ, maxX, maxY, maxZ, n, expected),
+                  aabbsKernel(ray, minX, minY, minZ, maxX, maxY, maxZ, n, hit));
+        EXPECT_EQ(hit.primitive, expected.primitive);
+        EXPECT_NEAR(hit.t, expected.t, 0.001f);
+        hits[1] += hit.primitive != RayHit4f_NoPrimitive;
+
+        expected = RayHit4f_None(), hit = RayHit4f_None();
+        EXPECT_EQ(Ray4f_IntersectTrianglesStreamGeneric(ray, triangles, n, expected), trianglesKernel(ray, triangles, n, hit));
+        EXPECT_EQ(hit.primitive, expected.primitive);
+        EXPECT_NEAR(hit.t, expected.t, 0.001f);
+        EXPECT_NEAR(hit.u, expected.u, 0.001f);
+        EXPECT_NEAR(hit.v, expected.v, 0.001f);
+        hits[2] += hit.primitive != RayHit4f_NoPrimitive;
+      }
+    }
+
+    // The packets of rays against each primitive in turn find the same nearest hits
+    const RayPacketSoA_IntersectSphereFunc sphereKernel = RayPacketSoA_SelectIntersectSphere(InstructionSet(isa));
+    const RayPacketSoA_IntersectAabbFunc aabbKernel = RayPacketSoA_SelectIntersectAabb(InstructionSet(isa));
+    const RayPacketSoA_IntersectTriangleFunc triangleKernel = RayPacketSoA_SelectIntersectTriangle(InstructionSet(isa));
+    float t[rayCount], u[rayCount], v[rayCount];
+    uint32_t primitive[rayCount];
+    const RayHitsSoA packetHits = { t, primitive, u, v };
+    for (int type = 0; type < 3; ++type)
+    {
+      RayHitsSoA_Clear(packetHits, rayCount);
+      for (unsigned i = 0; i < count; ++i)
+      {
+        const Vector4f center = Vector4f_Set(centerX[i], centerY[i], centerZ[i], 1.0f);
+        if (type == 0)
+        {
+          sphereKernel(rays, rayCount, BoundingSphere4f_Set(center, radius[i]), i, packetHits);
+        }
+        else if (type == 1)
+        {
+          aabbKernel(rays, rayCount, Aabb4f_Set(Vector4f_Set(minX[i], minY[i], minZ[i], 1.0f), Vector4f_Set(maxX[i], maxY[i], maxZ[i], 1.0f)), i, packetHits);
+        }
+        else
+        {
+          triangleKernel(rays, rayCount, TrianglesSoA_A(triangles, i), TrianglesSoA_B(triangles, i), TrianglesSoA_C(triangles, i), i, packetHits);
+        }
+      }
+      for (unsigned r = 0; r < rayCount; ++r)
+      {
+        const Ray4f ray = RayPacketSoA_Ray(rays, r);
+        RayHit4f expected = RayHit4f_None();
+        if (type == 0)
+        {
+          Ray4f_IntersectSpheresStreamGeneric(ray, centerX, centerY, centerZ, radius, count, expected);
+        }
+        else if (type == 1)
+        {
+          Ray4f_IntersectAabbsStreamGeneric(ray, minX, minY, minZ, maxX, maxY, maxZ, count, expected);
+        }
+        else
+        {
+          Ray4f_IntersectTrianglesStreamGeneric(ray, triangles, count, expected);
+        }
+        EXPECT_EQ(primitive[r], expected.primitive);
+        EXPECT_NEAR(t[r], expected.t, 0.001f);
+        EXPECT_NEAR(u[r], expected.u, 0.001f);
+        EXPECT_NEAR(v[r], expected.v, 0.001f);
+      }
+    }
+  }
+  // The test data should have some hits and some misses of each type
+  for (int type = 0; type < 3; ++type)
+  {
+    EXPECT_TRUE(hits[type] > 0 && hits[type] < searches);
+  }
+}
+
+// Benchmark test designed to measure the performance of the generated code
+BENCHMARK(Maths3DTest, Transform, iterations)
+{
+  Matrix4x4f modelViewProjection = Matrix4x4f_PerspectiveFrustum(Degrees{15.0}, 1.0f, 0.1, 10000.0);
+  Vector4f vecs[256];
+  Vector4f vecOut[256];
+  for (int i = 0; i < 256; ++i)
+  {
+    vecs[i] = Vector4f_Set(i, i, i, 1.0);
+  }
+
+  for (int i = 0; i < iterations; ++i)
+  {
+    Vector4f_SSETransformStream(vecOut, vecs, modelViewProjection);
+  }
+}
+
+// Benchmarks of the SSE, AVX2 and AVX-512 stream transforms on the same buffers
+const int wideBenchmarkCount = 4096;
+alignas(64) Vector4f wideBenchmarkInput[wideBenchmarkCount];
+alignas(64) Vector4f wideBenchmarkOutput[wideBenchmarkCount];
+
+Matrix4x4f WideBenchmarkSetup()
+{
+  for (int i = 0; i < wideBenchmarkCount; ++i)
+  {
+    wideBenchmarkInput[i] = Vector4f_Set(i, i, i, 1.0);
+  }
+  return Matrix4x4f_PerspectiveFrustum(Degrees{15.0}, 1.0f, 0.1, 10000.0);
+}
+
+BENCHMARK(Maths3DTest, TransformSSE, iterations)
+{
+  Matrix4x4f xform = WideBenchmarkSetup();
+  for (int i = 0; i < iterations; ++i)
+  {
+    Vector4f_SSETransformStreamGeneric<true,true,true,4,true,4>((float*)wideBenchmarkOutput, (float*)wideBenchmarkInput, wideBenchmarkCount, xform);
+  }
+}
+
+BENCHMARK(Maths3DTest, TransformAVX2, iterations)
+{
+  Matrix4x4f xform = WideBenchmarkSetup();
+  for (int i = 0; i < iterations && InstructionSet_IsSupported(InstructionSet::AVX2); ++i)
+  {
+    Vector4f_AVX2TransformStreamGeneric<true,true,true,4,true,4>((float*)wideBenchmarkOutput, (float*)wideBenchmarkInput, wideBenchmarkCount, xform);
+  }
+}
+
+BENCHMARK(Maths3DTest, TransformAVX512, iterations)
+{
+  Matrix4x4f xform = WideBenchmarkSetup();
+  for (int i = 0; i < iterations && InstructionSet_IsSupported(InstructionSet::AVX512); ++i)
+  {
+    Vector4f_AVX512TransformStreamGeneric<true,true,true,4,true,4>((float*)wideBenchmarkOutput, (float*)wideBenchmarkInput, wideBenchmarkCount, xform);
+  }
+}
+
+BENCHMARK(Maths3DTest, TransformSSEFastest, iterations)
+{
+  Matrix4x4f xform = WideBenchmarkSetup();
+  for (int i = 0; i < iterations; ++i)
+  {
+    Vector4f_SSETransformStreamGeneric<true,true,true,4,true,4,Precision::Fastest>((float*)wideBenchmarkOutput, (float*)wideBenchmarkInput, wideBenchmarkCount, xform);
+  }
+}
+
+BENCHMARK(Maths3DTest, TransformAVX2Fastest, iterations)
+{
+  Matrix4x4f xform = WideBenchmarkSetup();
+  for (int i = 0; i < iterations && InstructionSet_IsSupported(InstructionSet::AVX2); ++i)
+  {
+    Vector4f_AVX2TransformStreamGeneric<true,true,true,4,true,4,Precision::Fastest>((float*)wideBenchmarkOutput, (float*)wideBenchmarkInput, wideBenchmarkCount, xform);
+  }
+}
+
+// Benchmark of the parallel stream transform which reports how it scales with the number of threads
+BENCHMARK(Maths3DTest, ParallelTransformScaling, iterations)
+{
+  const unsigned count = 1 << 22;
+  std::vector<Vector4f> vecs(count, Vector4f_Set(1.0, 2.0, 3.0, 1.0));
+  std::vector<Vector4f> vecOut(count);
+  Matrix4x4f xform = Matrix4x4f_PerspectiveFrustum(Degrees{15.0}, 1.0f, 0.1, 10000.0);
+  const unsigned maxThreads = unsigned(WorkerPool_Get().threads.size() + 1);
+  const int passes = (iterations + 99) / 100;
+  double singleThreaded = 0.0;
+  printf("  threads  ms/pass   speedup\n");
+  std::vector<unsigned> threadCounts;
+  for (unsigned threads = 1; threads < maxThreads; threads *= 2)
+  {
+    threadCounts.push_back(threads);
+  }
+  threadCounts.push_back(maxThreads);
+  for (unsigned threads : threadCounts)
+  {
+    ParallelConfig config = ParallelConfig_Default();
+    config.maxThreads = threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < passes; ++i)
+    {
+      Vector4f_ParallelTransformStreamGeneric<true,true,false,4,false,4>(vecOut[0].v, vecs[0].v, count, xform, config);
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / passes;
+    singleThreaded = (threads == 1) ? ms : singleThreaded;
+    printf("  %7u  %7.3f  %7.2fx\n", threads, ms, singleThreaded / ms);
+  }
+}
+
+// Benchmarks of the array of structures and structure of arrays layouts on the same data
+alignas(64) float soaBenchmarkInput[3][wideBenchmarkCount];
+alignas(64) float soaBenchmarkOutput[4][wideBenchmarkCount];
+
+BENCHMARK(Maths3DTest, TransformAoS, iterations)
+{
+  Matrix4x4f xform = WideBenchmarkSetup();
+  for (int i = 0; i < iterations; ++i)
+  {
+    Vector4f_DispatchTransformStreamGeneric<true,true,false,4,true,4>((float*)wideBenchmarkOutput, (float*)wideBenchmarkInput, wideBenchmarkCount, xform);
+  }
+}
+
+BENCHMARK(Maths3DTest, TransformSoA, iterations)
+{
+  Matrix4x4f xform = WideBenchmarkSetup();
+  float* in[3] = { soaBenchmarkInput[0], soaBenchmarkInput[1], soaBenchmarkInput[2] };
+  float* out[4] = { soaBenchmarkOutput[0], soaBenchmarkOutput[1], soaBenchmarkOutput[2], soaBenchmarkOutput[3] };
+  Vector4f_AoSToSoA(in[0], in[1], in[2], nullptr, wideBenchmarkInput, wideBenchmarkCount);
+  for (int i = 0; i < iterations; ++i)
+  {
+    Vector4f_DispatchTransformStreamSoA<true,true>(out[0], out[1], out[2], out[3], in[0], in[1], in[2], wideBenchmarkCount, xform);
+  }
+}
+
+alignas(64) Vector4h halfBenchmarkInput[wideBenchmarkCount];
+alignas(64) Vector4h halfBenchmarkOutput[wideBenchmarkCount];
+
+BENCHMARK(Maths3DTest, TransformHalf, iterations)
+{
+  Matrix4x4f xform = WideBenchmarkSetup();
+  Vector4f_PackHalfStream(halfBenchmarkInput, wideBenchmarkInput, wideBenchmarkCount);
+  for (int i = 0; i < iterations; ++i)
+  {
+    Vector4h_TransformCoordStream(halfBenchmarkOutput, halfBenchmarkInput, wideBenchmarkCount, xform);
+  }
+}
+
+const unsigned rotationBenchmarkCount = 4096;
+Radians rotationBenchmarkAngles[rotationBenchmarkCount];
+Matrix4x4f rotationBenchmarkOutput[rotationBenchmarkCount];
+
+BENCHMARK(Maths3DTest, RotateLibm, iterations)
+{
+  for (unsigned i = 0; i < rotationBenchmarkCount; ++i)
+  {
+    rotationBenchmarkAngles[i] = Radians{ float(i) * 0.01f };
+  }
+  for (int i = 0; i < iterations; ++i)
+  {
+    for (unsigned j = 0; j < rotationBenchmarkCount; ++j)
+    {
+      const Scalar1f angle = rotationBenchmarkAngles[j].value;
+      rotationBenchmarkOutput[j] = Matrix4x4f_RotateSinCos(SinCos1f{ Scalar1f(::sin(angle)), Scalar1f(::cos(angle)) }, 1);
+    }
+  }
+}
+
+BENCHMARK(Maths3DTest, RotateStream, iterations)
+{
+  for (unsigned i = 0; i < rotationBenchmarkCount; ++i)
+  {
+    rotationBenchmarkAngles[i] = Radians{ float(i) * 0.01f };
+  }
+  for (int i = 0; i < iterations; ++i)
+  {
+    Matrix4x4f_RotateYStream(rotationBenchmarkOutput, rotationBenchmarkAngles, rotationBenchmarkCount);
+  }
+}
+
+Rotation rotationXYZBenchmarkInput[rotationBenchmarkCount];
+
+void RotationXYZBenchmarkSetup()
+{
+  for (unsigned i = 0; i < rotationBenchmarkCount; ++i)
+  {
+    rotationXYZBenchmarkInput[i] = Rotation{ Degrees{ float(i) * 0.3f }, Degrees{ float(i) * 0.5f }, Degrees{ float(i) * 0.7f } };
+  }
+}
+
+// The previous way of making a rotation matrix, with two matrix multiplies and six libm calls
+BENCHMARK(Maths3DTest, RotateXYZMultiply, iterations)
+{
+  RotationXYZBenchmarkSetup();
+  for (int i = 0; i < iterations; ++i)
+  {
+    for (unsigned j = 0; j < rotationBenchmarkCount; ++j)
+    {
+      const Rotation& rotation = rotationXYZBenchmarkInput[j];
+      Matrix4x4f rot[3];
+      for (int axis = 0; axis < 3; ++axis)
+      {
+        const Scalar1f angle = Radians((axis == 0) ? rotation.x : (axis == 1) ? rotation.y : rotation.z).value;
+        rot[axis] = Matrix4x4f_RotateSinCos(SinCos1f{ Scalar1f(::sin(angle)), Scalar1f(::cos(angle)) }, axis);
+      }
+      rotationBenchmarkOutput[j] = Matrix4x4f_Multiply(Matrix4x4f_Multiply(rot[0], rot[1]), rot[2]);
+    }
+  }
+}
+
+BENCHMARK(Maths3DTest, RotateXYZ, iterations)
+{
+  RotationXYZBenchmarkSetup();
+  for (int i = 0; i < iterations; ++i)
+  {
+    for (unsigned j = 0; j < rotationBenchmarkCount; ++j)
+    {
+      rotationBenchmarkOutput[j] = Matrix4x4f_RotateXYZ(rotationXYZBenchmarkInput[j]);
+    }
+  }
+}
+
+BENCHMARK(Maths3DTest, RotateXYZStream, iterations)
+{
+  RotationXYZBenchmarkSetup();
+  for (int i = 0; i < iterations; ++i)
+  {
+    Matrix4x4f_RotateXYZStream(rotationBenchmarkOutput, rotationXYZBenchmarkInput, rotationBenchmarkCount);
+  }
+}
+
+const unsigned inverseBenchmarkCount = 1024;
+Matrix4x4f inverseBenchmarkInput[inverseBenchmarkCount];
+Matrix4x4f inverseBenchmarkOutput[inverseBenchmarkCount];
+
+void InverseBenchmarkSetup()
+{
+  for (unsigned i = 0; i < inverseBenchmarkCount; ++i)
+  {
+    const Rotation rotation = Rotation{ Degrees{ float(i) * 0.3f }, Degrees{ float(i) * 0.5f }, Degrees{ float(i) * 0.7f } };
+    inverseBenchmarkInput[i] = Matrix4x4f_Multiply(Matrix4x4f_TranslateXYZ(Vector4f_Set(float(i), 2.0f, -3.0f, 1.0f)), Matrix4x4f_RotateXYZ(rotation));
+  }
+}
+
+BENCHMARK(Maths3DTest, InverseGeneral, iterations)
+{
+  InverseBenchmarkSetup();
+  for (int i = 0; i < iterations; ++i)
+  {
+    for (unsigned j = 0; j < inverseBenchmarkCount; ++j)
+    {
+      inverseBenchmarkOutput[j] = Matrix4x4f_Inversed(inverseBenchmarkInput[j]);
+    }
+  }
+}
+
+BENCHMARK(Maths3DTest, InverseAffine, iterations)
+{
+  InverseBenchmarkSetup();
+  for (int i = 0; i < iterations; ++i)
+  {
+    for (unsigned j = 0; j < inverseBenchmarkCount; ++j)
+    {
+      inverseBenchmarkOutput[j] = Matrix4x4f_AffineInversed(inverseBenchmarkInput[j]);
+    }
+  }
+}
+
+BENCHMARK(Maths3DTest, InverseStream, iterations)
+{
+  InverseBenchmarkSetup();
+  for (int i = 0; i < iterations; ++i)
+  {
+    Matrix4x4f_InverseStream(inverseBenchmarkOutput, inverseBenchmarkInput, inverseBenchmarkCount);
+  }
+}
+
+BENCHMARK(Maths3DTest, Multiply, iterations)
+{
+  InverseBenchmarkSetup();
+  for (int i = 0; i < iterations; ++i)
+  {
+    for (unsigned j = 0; j < inverseBenchmarkCount; ++j)
+    {
+      inverseBenchmarkOutput[j] = Matrix4x4f_Multiply(inverseBenchmarkInput[j], inverseBenchmarkInput[j]);
+    }
+  }
+}
+
+BENCHMARK(Maths3DTest, MultiplyStream, iterations)
+{
+  InverseBenchmarkSetup();
+  for (int i = 0; i < iterations; ++i)
+  {
+    Matrix4x4f_MultiplyStream(inverseBenchmarkOutput, inverseBenchmarkInput, inverseBenchmarkInput, inverseBenchmarkCount);
+  }
+}
+
+BENCHMARK(Maths3DTest, MultiplyAffineStream, iterations)
+{
+  InverseBenchmarkSetup();
+  static Matrix3x4f affineInput[inverseBenchmarkCount];
+  static Matrix3x4f affineOutput[inverseBenchmarkCount];
+  for (unsigned j = 0; j < inverseBenchmarkCount; ++j)
+  {
+    affineInput[j] = Matrix3x4f_FromMatrix4x4f(inverseBenchmarkInput[j]);
+  }
+  for (int i = 0; i < iterations; ++i)
+  {
+    Matrix3x4f_MultiplyStream(affineOutput, affineInput, affineInput, inverseBenchmarkCount);
+  }
+}
+
+BENCHMARK(Maths3DTest, InverseOrthonormal, iterations)
+{
+  InverseBenchmarkSetup();
+  for (int i = 0; i < iterations; ++i)
+  {
+    for (unsigned j = 0; j < inverseBenchmarkCount; ++j)
+    {
+      inverseBenchmarkOutput[j] = Matrix4x4f_OrthonormalInversed(inverseBenchmarkInput[j]);
+    }
+  }
+}
+
+const unsigned interceptBenchmarkCount = 1024;
+Vector4f interceptBenchmarkPoints[interceptBenchmarkCount];
+
+void InterceptBenchmarkSetup()
+{
+  for (unsigned i = 0; i < interceptBenchmarkCount; ++i)
+  {
+    interceptBenchmarkPoints[i] = Vector4f_Set(float(i), float(i % 7), -float(i % 13), 0.0f);
+  }
+}
+
+// The point of closest intercept from example3 written with the operators, as the benchmark below is from example2.
+// The points are updated in place so that the repeated iterations can't be optimized away.
+BENCHMARK(Maths3DTest, InterceptOperators, iterations)
+{
+  InterceptBenchmarkSetup();
+  const Vector4f origin = Vector4f_Set(0.0f, 0.0f, -10.0f, 0.0f);
+  const Vector4f rayDirection = ~Vector4f_Set(1.0f, 2.0f, 3.0f, 0.0f);
+  for (int i = 0; i < iterations; ++i)
+  {
+    for (unsigned j = 0; j < interceptBenchmarkCount; ++j)
+    {
+      interceptBenchmarkPoints[j] = origin + (rayDirection * Scalar1f(rayDirection ^ (interceptBenchmarkPoints[j] - origin)));
+    }
+  }
+}
+
+BENCHMARK(Maths3DTest, InterceptFunctions, iterations)
+{
+  InterceptBenchmarkSetup();
+  const Vector4f origin = Vector4f_Set(0.0f, 0.0f, -10.0f, 0.0f);
+  const Vector4f rayDirection = Vector4f_Normalized(Vector4f_Set(1.0f, 2.0f, 3.0f, 0.0f));
+  for (int i = 0; i < iterations; ++i)
+  {
+    for (unsigned j = 0; j < interceptBenchmarkCount; ++j)
+    {
+      const Vector4f fromRayToPoint = Vector4f_Subtract(interceptBenchmarkPoints[j], origin);
+      const Scalar1f length = Vector4f_DotProduct(rayDirection, fromRayToPoint);
+      interceptBenchmarkPoints[j] = Vector4f_Add(origin, Vector4f_Scaled(rayDirection, length));
+    }
+  }
+}
+
+// A longer expression with a cross-product in it, which moves the points a little around an axis through the
+// origin, written with the operators and then with the functions.
+BENCHMARK(Maths3DTest, SpinOperators, iterations)
+{
+  InterceptBenchmarkSetup();
+  const Vector4f origin = Vector4f_Set(0.0f, 0.0f, -10.0f, 0.0f);
+  const Vector4f axis = ~Vector4f_Set(1.0f, 2.0f, 3.0f, 0.0f);
+  const Vector4f drift = Vector4f_Set(0.001f, 0.0f, -0.001f, 0.0f);
+  for (int i = 0; i < iterations; ++i)
+  {
+    for (unsigned j = 0; j < interceptBenchmarkCount; ++j)
+    {
+      const Vector4f p = interceptBenchmarkPoints[j];
+      interceptBenchmarkPoints[j] = p + ((axis ^ (p - origin)) - drift) * 0.01f - (p - origin) * drift;
+    }
+  }
+}
+
+BENCHMARK(Maths3DTest, SpinFunctions, iterations)
+{
+  InterceptBenchmarkSetup();
+  const Vector4f origin = Vector4f_Set(0.0f, 0.0f, -10.0f, 0.0f);
+  const Vector4f axis = Vector4f_Normalized(Vector4f_Set(1.0f, 2.0f, 3.0f, 0.0f));
+  const Vector4f drift = Vector4f_Set(0.001f, 0.0f, -0.001f, 0.0f);
+  for (int i = 0; i < iterations; ++i)
+  {
+    for (unsigned j = 0; j < interceptBenchmarkCount; ++j)
+    {
+      const Vector4f p = interceptBenchmarkPoints[j];
+      const Vector4f fromOrigin = Vector4f_Subtract(p, origin);
+      const Vector4f tangent = Vector4f_Scaled(Vector4f_Subtract(Vector4f_CrossProduct(axis, fromOrigin), drift), 0.01f);
+      interceptBenchmarkPoints[j] = Vector4f_Subtract(Vector4f_Add(p, tangent), Vector4f_Multiply(fromOrigin, drift));
+    }
+  }
+}
+
+// Benchmarks of transforming vectors one at a time by the same matrix. The points are rotated in place.
+BENCHMARK(Maths3DTest, TransformSingle, iterations)
+{
+  InterceptBenchmarkSetup();
+  const Matrix4x4f xform = Matrix4x4f_RotateXYZ(Rotation{ { 10.0f }, { 20.0f }, { 30.0f } });
+  for (int i = 0; i < iterations; ++i)
+  {
+    for (unsigned j = 0; j < interceptBenchmarkCount; ++j)
+    {
+      interceptBenchmarkPoints[j] = Vector4f_Transform(xform, interceptBenchmarkPoints[j]);
+    }
+  }
+}
+
+BENCHMARK(Maths3DTest, TransformPrepared, iterations)
+{
+  InterceptBenchmarkSetup();
+  const PreparedTransform4f prepared = PreparedTransform4f_Prepare(Matrix4x4f_RotateXYZ(Rotation{ { 10.0f }, { 20.0f }, { 30.0f } }));
+  for (int i = 0; i < iterations; ++i)
+  {
+    for (unsigned j = 0; j < interceptBenchmarkCount; ++j)
+    {
+      interceptBenchmarkPoints[j] = PreparedTransform4f_Transform(prepared, interceptBenchmarkPoints[j]);
+    }
+  }
+}
+
+// Benchmarks of building the transforms of animated instances from their rotations
+const unsigned quaternionBenchmarkCount = 1024;
+Vector4f quaternionBenchmarkTranslations[quaternionBenchmarkCount];
+Quaternion4f quaternionBenchmarkRotations[quaternionBenchmarkCount];
+Vector4f quaternionBenchmarkScales[quaternionBenchmarkCount];
+Matrix4x4f quaternionBenchmarkOutput[quaternionBenchmarkCount];
+
+void QuaternionBenchmarkSetup()
+{
+  for (unsigned i = 0; i < quaternionBenchmarkCount; ++i)
+  {
+    quaternionBenchmarkTranslations[i] = Vector4f_Set(float(i), float(i % 7), -float(i % 13), 0.0f);
+    quaternionBenchmarkRotations[i] = Quaternion4f_FromRotation(Rotation{ { float(i % 360) }, { float(i % 90) }, { float(i % 45) } });
+    quaternionBenchmarkScales[i] = Vector4f_Replicate(1.0f + float(i % 3));
+  }
+}
+
+BENCHMARK(Maths3DTest, TranslateRotateScale, iterations)
+{
+  QuaternionBenchmarkSetup();
+  for (int i = 0; i < iterations; ++i)
+  {
+    for (unsigned j = 0; j < quaternionBenchmarkCount; ++j)
+    {
+      quaternionBenchmarkOutput[j] = Matrix4x4f_TranslateRotateScale(quaternionBenchmarkTranslations[j], quaternionBenchmarkRotations[j], quaternionBenchmarkScales[j]);
+    }
+  }
+}
+
+BENCHMARK(Maths3DTest, TranslateRotateScaleStream, iterations)
+{
+  QuaternionBenchmarkSetup();
+  for (int i = 0; i < iterations; ++i)
+  {
+    Matrix4x4f_TranslateRotateScaleStream(quaternionBenchmarkOutput, quaternionBenchmarkTranslations, quaternionBenchmarkRotations,
+                                          quaternionBenchmarkScales, quaternionBenchmarkCount);
+  }
+}
+
+// Benchmarks of blending the rotations of the animated instances between two keyframes
+Quaternion4f quaternionBenchmarkBlended[quaternionBenchmarkCount];
+Scalar1f quaternionBenchmarkFactors[quaternionBenchmarkCount];
+
+void NlerpBenchmarkSetup()
+{
+  QuaternionBenchmarkSetup();
+  for (unsigned i = 0; i < quaternionBenchmarkCount; ++i)
+  {
+    quaternionBenchmarkBlended[i] = Quaternion4f_FromRotation(Rotation{ { float(i % 45) }, { float(i % 360) }, { float(i % 90) } });
+    quaternionBenchmarkFactors[i] = float(i % 100) * 0.01f;
+  }
+}
+
+BENCHMARK(Maths3DTest, NlerpGeneric, iterations)
+{
+  NlerpBenchmarkSetup();
+  for (int i = 0; i < iterations; ++i)
+  {
+    Quaternion4f_NlerpStreamGeneric(quaternionBenchmarkBlended, quaternionBenchmarkRotations, quaternionBenchmarkBlended,
+                                    quaternionBenchmarkFactors, quaternionBenchmarkCount);
+  }
+}
+
+BENCHMARK(Maths3DTest, NlerpStream, iterations)
+{
+  NlerpBenchmarkSetup();
+  for (int i = 0; i < iterations; ++i)
+  {
+    Quaternion4f_NlerpStream(quaternionBenchmarkBlended, quaternionBenchmarkRotations, quaternionBenchmarkBlended,
+                             quaternionBenchmarkFactors, quaternionBenchmarkCount);
+  }
+}
+
+// Benchmarks of skinning a character mesh with 4 bones per vertex
+const unsigned skinningBenchmarkCount = 4096;
+const unsigned skinningBenchmarkBones = 64;
+Vector4f skinningBenchmarkPositions[skinningBenchmarkCount];
+Vector4f skinningBenchmarkNormals[skinningBenchmarkCount];
+Vector4us skinningBenchmarkIndices[skinningBenchmarkCount];
+Vector4f skinningBenchmarkWeights[skinningBenchmarkCount];
+Vector4f skinningBenchmarkOutPositions[skinningBenchmarkCount];
+Vector4f skinningBenchmarkOutNormals[skinningBenchmarkCount];
+Matrix4x4f skinningBenchmarkPalette[skinningBenchmarkBones];
+DualQuaternion4f skinningBenchmarkDualPalette[skinningBenchmarkBones];
+
+void SkinningBenchmarkSetup()
+{
+  for (unsigned b = 0; b < skinningBenchmarkBones; ++b)
+  {
+    const Quaternion4f rotation = Quaternion4f_FromRotation(Rotation{ { float(b * 7 % 360) }, { float(b % 90) }, { float(b % 45) } });
+    const Vector4f translation = Vector4f_Set(float(b % 8), float(b / 8), 0.0f, 0.0f);
+    skinningBenchmarkPalette[b] = Matrix4x4f_TranslateRotateScale(translation, rotation, Vector4f_Replicate(1.0f));
+    skinningBenchmarkDualPalette[b] = DualQuaternion4f_FromRotationTranslation(rotation, translation);
+  }
+  for (unsigned i = 0; i < skinningBenchmarkCount; ++i)
+  {
+    skinningBenchmarkPositions[i] = Vector4f_Set(float(i % 17), float(i % 13), float(i % 11), 1.0f);
+    skinningBenchmarkNormals[i] = Vector4f_Set(0.0f, 1.0f, 0.0f, 0.0f);
+    skinningBenchmarkIndices[i] = Vector4us{ { uint16_t(i * 7 % skinningBenchmarkBones), uint16_t(i * 11 % skinningBenchmarkBones),
+                                               uint16_t(i * 13 % skinningBenchmarkBones), uint16_t(i * 17 % skinningBenchmarkBones) } };
+    skinningBenchmarkWeights[i] = Vector4f_Set(0.4f, 0.3f, 0.2f, 0.1f);
+  }
+}
+
+BENCHMARK(Maths3DTest, SkinGeneric, iterations)
+{
+  SkinningBenchmarkSetup();
+  for (int i = 0; i < iterations; ++i)
+  {
+    Vector4f_SkinStreamGeneric(skinningBenchmarkOutPositions, skinningBenchmarkOutNormals, skinningBenchmarkPositions, skinningBenchmarkNormals,
+                               skinningBenchmarkIndices, skinningBenchmarkWeights, skinningBenchmarkCount, skinningBenchmarkPalette);
+  }
+}
+
+BENCHMARK(Maths3DTest, SkinStream, iterations)
+{
+  SkinningBenchmarkSetup();
+  for (int i = 0; i < iterations; ++i)
+  {
+    Vector4f_SkinStream(skinningBenchmarkOutPositions, skinningBenchmarkOutNormals, skinningBenchmarkPositions, skinningBenchmarkNormals,
+                        skinningBenchmarkIndices, skinningBenchmarkWeights, skinningBenchmarkCount, skinningBenchmarkPalette);
+  }
+}
+
+BENCHMARK(Maths3DTest, SkinDualQuaternion, iterations)
+{
+  SkinningBenchmarkSetup();
+  for (int i = 0; i < iterations; ++i)
+  {
+    Vector4f_DualQuaternionSkinStream(skinningBenchmarkOutPositions, skinningBenchmarkOutNormals, skinningBenchmarkPositions, skinningBenchmarkNormals,
+                                      skinningBenchmarkIndices, skinningBenchmarkWeights, skinningBenchmarkCount, skinningBenchmarkDualPalette);
+  }
+}
+
+// Benchmarks of renormalizing normals
+const unsigned normalizeBenchmarkCount = 4096;
+Vector4f normalizeBenchmarkVectors[normalizeBenchmarkCount];
+
+void NormalizeBenchmarkSetup()
+{
+  for (unsigned i = 0; i < normalizeBenchmarkCount; ++i)
+  {
+    normalizeBenchmarkVectors[i] = Vector4f_Set(float(i % 17) + 1.0f, float(i % 13), float(i % 11), 0.0f);
+  }
+}
+
+BENCHMARK(Maths3DTest, Normalize, iterations)
+{
+  NormalizeBenchmarkSetup();
+  for (int i = 0; i < iterations; ++i)
+  {
+    for (unsigned j = 0; j < normalizeBenchmarkCount; ++j)
+    {
+      normalizeBenchmarkVectors[j] = Vector4f_Normalized(normalizeBenchmarkVectors[j]);
+    }
+  }
+}
+
+BENCHMARK(Maths3DTest, NormalizeStreamExact, iterations)
+{
+  NormalizeBenchmarkSetup();
+  for (int i = 0; i < iterations; ++i)
+  {
+    Vector4f_NormalizeStream<Precision::Exact>(normalizeBenchmarkVectors, normalizeBenchmarkVectors, normalizeBenchmarkCount);
+  }
+}
+
+BENCHMARK(Maths3DTest, NormalizeStreamFast, iterations)
+{
+  NormalizeBenchmarkSetup();
+  for (int i = 0; i < iterations; ++i)
+  {
+    Vector4f_NormalizeStream<Precision::Fast>(normalizeBenchmarkVectors, normalizeBenchmarkVectors, normalizeBenchmarkCount);
+  }
+}
+
+BENCHMARK(Maths3DTest, NormalizeStreamFastest, iterations)
+{
+  NormalizeBenchmarkSetup();
+  for (int i = 0; i < iterations; ++i)
+  {
+    Vector4f_NormalizeStream<Precision::Fastest>(normalizeBenchmarkVectors, normalizeBenchmarkVectors, normalizeBenchmarkCount);
+  }
+}
+
+// Benchmarks of culling a scene of objects spread around the camera, so that some of each classification are seen
+const unsigned cullBenchmarkCount = 4096;
+float cullBenchmarkX[cullBenchmarkCount], cullBenchmarkY[cullBenchmarkCount], cullBenchmarkZ[cullBenchmarkCount], cullBenchmarkRadius[cullBenchmarkCount];
+float cullBenchmarkMaxX[cullBenchmarkCount], cullBenchmarkMaxY[cullBenchmarkCount], cullBenchmarkMaxZ[cullBenchmarkCount];
+unsigned cullBenchmarkVisible[cullBenchmarkCount];
+
+Frustum4f CullBenchmarkSetup()
+{
+  for (unsigned i = 0; i < cullBenchmarkCount; ++i)
+  {
+    cullBenchmarkX[i] = float(int(i % 61) - 30);
+    cullBenchmarkY[i] = float(int(i % 37) - 18);
+    cullBenchmarkZ[i] = float(int(i % 101) - 70);
+    cullBenchmarkRadius[i] = float(i % 3) + 0.5f;
+    cullBenchmarkMaxX[i] = cullBenchmarkX[i] + cullBenchmarkRadius[i];
+    cullBenchmarkMaxY[i] = cullBenchmarkY[i] + cullBenchmarkRadius[i];
+    cullBenchmarkMaxZ[i] = cullBenchmarkZ[i] + cullBenchmarkRadius[i];
+  }
+  return Frustum4f_FromMatrix4x4f(Matrix4x4f_PerspectiveFrustum(Degrees{ 60.0f }, 1.5f, 1.0f, 50.0f));
+}
+
+BENCHMARK(Maths3DTest, CullSpheres, iterations)
+{
+  const Frustum4f frustum = CullBenchmarkSetup();
+  for (int i = 0; i < iterations; ++i)
+  {
+    for (unsigned j = 0; j < cullBenchmarkCount; ++j)
+    {
+      cullBenchmarkVisible[j] = unsigned(Frustum4f_ClassifySphere(frustum, Vector4f_Set(cullBenchmarkX[j], cullBenchmarkY[j], cullBenchmarkZ[j], 1.0f), cullBenchmarkRadius[j]));
+    }
+  }
+}
+
+BENCHMARK(Maths3DTest, CullSpheresStream, iterations)
+{
+  const Frustum4f frustum = CullBenchmarkSetup();
+  for (int i = 0; i < iterations; ++i)
+  {
+    Frustum4f_CullSpheresStream(cullBenchmarkVisible, nullptr, frustum, cullBenchmarkX, cullBenchmarkY, cullBenchmarkZ, cullBenchmarkRadius, cullBenchmarkCount);
+  }
+}
+
+BENCHMARK(Maths3DTest, CullAabbsStream, iterations)
+{
+  const Frustum4f frustum = CullBenchmarkSetup();
+  for (int i = 0; i < iterations; ++i)
+  {
+    Frustum4f_CullAabbsStream(cullBenchmarkVisible, nullptr, frustum, cullBenchmarkX, cullBenchmarkY, cullBenchmarkZ,
+                              cullBenchmarkMaxX, cullBenchmarkMaxY, cullBenchmarkMaxZ, cullBenchmarkCount);
+  }
+}
+
+// Benchmarks of bounding a point cloud. This fits in the L2 cache, as larger ones are limited by the memory bandwidth.
+// A point is changed and the bounds are merged each time so that they can't be found once outside of the loop.
+const unsigned boundsBenchmarkCount = 16384;
+std::vector<Vector4f> boundsBenchmarkPoints;
+Aabb4f boundsBenchmarkResult;
+
+void BoundsBenchmarkSetup()
+{
+  boundsBenchmarkPoints.resize(boundsBenchmarkCount);
+  for (unsigned i = 0; i < boundsBenchmarkCount; ++i)
+  {
+    boundsBenchmarkPoints[i] = Vector4f_Set(float(i % 1021), float(i % 509) * 2.0f, -float(i % 2039), 1.0f);
+  }
+}
+
+BENCHMARK(Maths3DTest, BoundsGeneric, iterations)
+{
+  BoundsBenchmarkSetup();
+  for (int i = 0; i < iterations; ++i)
+  {
+    boundsBenchmarkPoints[i % boundsBenchmarkCount].y = float(i);
+    boundsBenchmarkResult = Aabb4f_Merge(boundsBenchmarkResult, Aabb4f_FromVector4fStreamGeneric(boundsBenchmarkPoints.data(), boundsBenchmarkCount));
+  }
+}
+
+BENCHMARK(Maths3DTest, BoundsStream, iterations)
+{
+  BoundsBenchmarkSetup();
+  for (int i = 0; i < iterations; ++i)
+  {
+    boundsBenchmarkPoints[i % boundsBenchmarkCount].y = float(i);
+    boundsBenchmarkResult = Aabb4f_Merge(boundsBenchmarkResult, Aabb4f_FromVector4fStream(boundsBenchmarkPoints.data(), boundsBenchmarkCount));
+  }
+}
+
+BENCHMARK(Maths3DTest, BoundsParallel, iterations)
+{
+  BoundsBenchmarkSetup();
+  for (int i = 0; i < iterations; ++i)
+  {
+    boundsBenchmarkPoints[i % boundsBenchmarkCount].y = float(i);
+    boundsBenchmarkResult = Aabb4f_Merge(boundsBenchmarkResult, Aabb4f_ParallelFromVector4fStream(boundsBenchmarkPoints.data(), boundsBenchmarkCount));
+  }
+}
+
+// Benchmarks of casting rays at a soup of triangles, both one ray at a time against all of them and packets of rays
+// against each triangle. The rays change each time and the distances are summed so the work can't be skipped.
+const unsigned rayBenchmarkTriangleCount = 4096;
+const unsigned rayBenchmarkRayCount = 1024;
+std::vector<float> rayBenchmarkTriangles, rayBenchmarkRays, rayBenchmarkHits;
+std::vector<uint32_t> rayBenchmarkPrimitives;
+Scalar1f rayBenchmarkResult;
+
+TrianglesSoA RayBenchmarkSetup()
+{
+  const unsigned n = rayBenchmarkTriangleCount;
+  rayBenchmarkTriangles.resize(n * 9);
+  for (unsigned i = 0; i < n; ++i)
+  {
+    for (unsigned k = 0; k < 3; ++k)
+    {
+      rayBenchmarkTriangles[(k * 3 + 0) * n + i] = float(int(i % 64) - 32) + (k == 1 ? 1.5f : 0.0f);
+      rayBenchmarkTriangles[(k * 3 + 1) * n + i] = float(int(i / 64) - 32) + (k == 2 ? 1.5f : 0.0f);
+      rayBenchmarkTriangles[(k * 3 + 2) * n + i] = -10.0f - float(i % 7) - float(k) * 0.25f;
+    }
+  }
+  const float* const v = rayBenchmarkTriangles.data();
+  return TrianglesSoA{ v, v + n, v + 2 * n, v + 3 * n, v + 4 * n, v + 5 * n, v + 6 * n, v + 7 * n, v + 8 * n };
+}
+
+Ray4f RayBenchmarkRay(int i)
+{
+  return Ray4f_Set(Vector4f_Set(0.0f, 0.0f, 0.0f, 1.0f), Vector4f_Set(float(i % 61 - 30) * 0.05f, float(i % 53 - 26) * 0.05f, -1.0f, 0.0f));
+}
+
+BENCHMARK(Maths3DTest, RayTrianglesGeneric, iterations)
+{
+  const TrianglesSoA triangles = RayBenchmarkSetup();
+  for (int i = 0; i < iterations; ++i)
+  {
+    RayHit4f hit = RayHit4f_None();
+    Ray4f_IntersectTrianglesStreamGeneric(RayBenchmarkRay(i), triangles, rayBenchmarkTriangleCount, hit);
+    rayBenchmarkResult += hit.t;
+  }
+}
+
+BENCHMARK(Maths3DTest, RayTrianglesStream, iterations)
+{
+  const TrianglesSoA triangles = RayBenchmarkSetup();
+  for (int i = 0; i < iterations; ++i)
+  {
+    RayHit4f hit = RayHit4f_None();
+    Ray4f_IntersectTrianglesStream(RayBenchmarkRay(i), triangles, rayBenchmarkTriangleCount, hit);
+    rayBenchmarkResult += hit.t;
+  }
+}
+
+BENCHMARK(Maths3DTest, RayPacketTriangles, iterations)
+{
+  const TrianglesSoA triangles = RayBenchmarkSetup();
+  const unsigned n = rayBenchmarkRayCount;
+  rayBenchmarkRays.resize(n * 6);
+  rayBenchmarkHits.resize(n * 3);
+  rayBenchmarkPrimitives.resize(n);
+  float* const r = rayBenchmarkRays.data();
+  const RayPacketSoA rays = { r, r + n, r + 2 * n, r + 3 * n, r + 4 * n, r + 5 * n };
+  const RayHitsSoA hits = { rayBenchmarkHits.data(), rayBenchmarkPrimitives.data(), rayBenchmarkHits.data() + n, rayBenchmarkHits.data() + 2 * n };
+  // Each iteration casts the packet at a few of the triangles, so as many ray triangle tests are done as by the streams
+  const unsigned trianglesPerIteration = rayBenchmarkTriangleCount / n;
+  for (int i = 0; i < iterations; ++i)
+  {
+    for (unsigned j = 0; j < n; ++j)
+    {
+      const Ray4f ray = RayBenchmarkRay(i + int(j));
+      for (unsigned k = 0; k < 3; ++k)
+      {
+        r[k * n + j] = ray.origin.v[k];
+        r[(k + 3) * n + j] = ray.direction.v[k];
+      }
+    }
+    RayHitsSoA_Clear(hits, n);
+    for (unsigned k = 0; k < trianglesPerIteration; ++k)
+    {
+      const unsigned triangle = (unsigned(i) * trianglesPerIteration + k) % rayBenchmarkTriangleCount;
+      RayPacketSoA_IntersectTriangle(rays, n, TrianglesSoA_A(triangles, triangle), TrianglesSoA_B(triangles, triangle),
+                                     TrianglesSoA_C(triangles, triangle), triangle, hits);
+    }
+    rayBenchmarkResult += hits.t[unsigned(i) % n];
   }
 }
 